@@ -308,6 +308,76 @@ int Sys_GetCurrentProcessId( void )
 	return getpid();
 }
 
+/*
+* Sys_GetMemoryUsage
+*
+* Resident set size of this process, the part of it no other process maps
+* and the amount of physical memory, in bytes. Pages shared with the binary,
+* libraries or other server instances are not unique. Returns false if the
+* numbers are not available.
+*/
+bool Sys_GetMemoryUsage( size_t *resident, size_t *unique, size_t *physical )
+{
+	FILE *f;
+	long pageSize, physPages;
+	unsigned long size, rss, shr, kb;
+	unsigned long rssKb, privateKb;
+	char line[256];
+	int n;
+
+	pageSize = sysconf( _SC_PAGESIZE );
+	physPages = sysconf( _SC_PHYS_PAGES );
+	if( pageSize <= 0 || physPages <= 0 ) {
+		return false;
+	}
+	*physical = ( size_t )physPages * pageSize;
+
+	// private pages are only accounted for in smaps, smaps_rollup has the
+	// totals since Linux 4.14
+	f = fopen( "/proc/self/smaps_rollup", "r" );
+	if( f ) {
+		rssKb = privateKb = 0;
+		while( fgets( line, sizeof( line ), f ) ) {
+			if( sscanf( line, "Rss: %lu kB", &kb ) == 1 ) {
+				rssKb = kb;
+			} else if( sscanf( line, "Private_Clean: %lu kB", &kb ) == 1 || sscanf( line, "Private_Dirty: %lu kB", &kb ) == 1 ) {
+				privateKb += kb;
+			}
+		}
+		fclose( f );
+
+		if( rssKb ) {
+			*resident = ( size_t )rssKb * 1024;
+			*unique = ( size_t )privateKb * 1024;
+			return true;
+		}
+	}
+
+	// statm only knows about file backed shared pages, so anonymous memory
+	// still shared with the parent after fork is counted as unique
+	f = fopen( "/proc/self/statm", "r" );
+	if( !f ) {
+		return false;
+	}
+	n = fscanf( f, "%lu %lu %lu", &size, &rss, &shr );
+	fclose( f );
+	if( n != 3 ) {
+		return false;
+	}
+
+	*resident = ( size_t )rss * pageSize;
+	*unique = ( size_t )( rss - min( shr, rss ) ) * pageSize;
+	return true;
+}
+
+/*
+* Sys_ForkInstance
+*/
+int Sys_ForkInstance( void )
+{
+	return -1;
+}
+
 void Sys_Quit( void )
 {
 	Qcommon_Shutdown();
@@ -157,6 +157,9 @@ void qasReleaseEngine( asIScriptEngine *engine )
 		contexts.erase( it );
 	}
 
+	qasForgetEngineByteCodeHash( engine );
+	qasProfileRetireEngine( engine );
+
 	engine->Release();
 }
 
@@ -214,12 +217,23 @@ asIScriptContext *qasAcquireContext( asIScriptEngine *engine )
 	for( qasContextList::iterator it = ctxList.begin(); it != ctxList.end(); it++ )
 	{
 		asIScriptContext *ctx = *it;
-		if( ctx->GetState() == asEXECUTION_FINISHED )
+		if( ctx->GetState() == asEXECUTION_FINISHED ) {
+			qasProfileAttachContext( ctx, false );
 			return ctx;
+		}
 	}
 
 	// if no context was available, create a new one
-	return qasCreateContext( engine );
+	asIScriptContext *ctx = qasCreateContext( engine );
+	if( ctx )
+		qasProfileAttachContext( ctx, true );
+	return ctx;
+}
+
+void qasGetAllContexts( std::list<asIScriptContext *> &list )
+{
+	for( qasEngineContextMap::iterator it = contexts.begin(); it != contexts.end(); it++ )
+		list.insert( list.end(), it->second.begin(), it->second.end() );
 }
 
 asIScriptContext *qasGetActiveContext( void )
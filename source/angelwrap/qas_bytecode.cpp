@@ -0,0 +1,328 @@
+/*
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+*/
+
+#include "qas_precompiled.h"
+#include "../qalgo/hash.h"
+
+#include <map>
+
+#define QAS_BYTECODE_MAGIC		"QASB"
+#define QAS_BYTECODE_VERSION	1
+
+typedef struct
+{
+	char magic[4];
+	int version;
+	int apiVersion;
+	int asVersion;
+	unsigned int engineHash;
+	unsigned int sourceHash;
+	unsigned int dataSize;
+	unsigned int dataChecksum;
+} qasByteCodeHeader_t;
+
+// engine -> registered application interface hash
+typedef std::map<asIScriptEngine *, unsigned int> qasEngineHashMap;
+
+static qasEngineHashMap engineHashes;
+
+static cvar_t *as_bytecode_cache;
+
+// ============================================================================
+
+class qasByteCodeStream : public asIBinaryStream
+{
+	uint8_t *data;
+	size_t size;		// size of data stored
+	size_t allocated;	// actual allocated size
+	size_t offset;		// read-head
+	bool overflowed;
+
+public:
+	qasByteCodeStream() : data( NULL ), size( 0 ), allocated( 0 ), offset( 0 ), overflowed( false )
+	{
+	}
+
+	// wraps external data for reading, the stream does not own the memory
+	qasByteCodeStream( uint8_t *_data, size_t _size )
+		: data( _data ), size( _size ), allocated( 0 ), offset( 0 ), overflowed( false )
+	{
+	}
+
+	~qasByteCodeStream()
+	{
+		if( allocated )
+			QAS_Free( data );
+	}
+
+	const uint8_t *getData( void ) const { return data; }
+	size_t getSize( void ) const { return size; }
+	bool hasOverflowed( void ) const { return overflowed; }
+
+	void Read( void *ptr, asUINT _size )
+	{
+		if( offset + _size > size ) {
+			// LoadByteCode has no way to handle short reads, so feed it zeroes
+			// and let the caller discard the module afterwards
+			memset( ptr, 0, _size );
+			overflowed = true;
+			return;
+		}
+
+		memcpy( ptr, data + offset, _size );
+		offset += _size;
+	}
+
+	void Write( const void *ptr, asUINT _size )
+	{
+		if( size + _size > allocated ) {
+			size_t newAllocated = max( allocated * 2, size + _size + 4096 );
+			uint8_t *tmp = ( uint8_t * )QAS_Malloc( newAllocated );
+
+			if( size )
+				memcpy( tmp, data, size );
+			if( allocated )
+				QAS_Free( data );
+
+			data = tmp;
+			allocated = newAllocated;
+		}
+
+		memcpy( data + size, ptr, _size );
+		size += _size;
+	}
+};
+
+// ============================================================================
+
+static unsigned int qasHashString( unsigned int hash, const char *str )
+{
+	if( !str )
+		return hash;
+	return COM_SuperFastHash( ( const unsigned char * )str, strlen( str ) + 1, hash );
+}
+
+/*
+* qasGetEngineHash
+*
+* Hashes everything the application has registered with the engine so that
+* bytecode compiled against a different game or UI API is never loaded.
+*/
+static unsigned int qasGetEngineHash( asIScriptEngine *engine )
+{
+	asUINT i, j;
+	unsigned int hash;
+	qasEngineHashMap::iterator it;
+
+	it = engineHashes.find( engine );
+	if( it != engineHashes.end() )
+		return it->second;
+
+	hash = 0;
+
+	for( i = 0; i < engine->GetEnumCount(); i++ ) {
+		int enumTypeId, value;
+		const char *nameSpace;
+
+		hash = qasHashString( hash, engine->GetEnumByIndex( i, &enumTypeId, &nameSpace ) );
+		hash = qasHashString( hash, nameSpace );
+		for( j = 0; j < (asUINT)engine->GetEnumValueCount( enumTypeId ); j++ ) {
+			hash = qasHashString( hash, engine->GetEnumValueByIndex( enumTypeId, j, &value ) );
+			hash = COM_SuperFastHash( ( const unsigned char * )&value, sizeof( value ), hash );
+		}
+	}
+
+	for( i = 0; i < engine->GetObjectTypeCount(); i++ ) {
+		asIObjectType *ot = engine->GetObjectTypeByIndex( i );
+
+		hash = qasHashString( hash, ot->GetName() );
+		hash = qasHashString( hash, ot->GetNamespace() );
+		for( j = 0; j < ot->GetPropertyCount(); j++ )
+			hash = qasHashString( hash, ot->GetPropertyDeclaration( j, true ) );
+		for( j = 0; j < ot->GetBehaviourCount(); j++ ) {
+			asEBehaviours behaviour;
+			asIScriptFunction *func = ot->GetBehaviourByIndex( j, &behaviour );
+			hash = COM_SuperFastHash( ( const unsigned char * )&behaviour, sizeof( behaviour ), hash );
+			hash = qasHashString( hash, func ? func->GetDeclaration( true, true ) : NULL );
+		}
+		for( j = 0; j < ot->GetMethodCount(); j++ )
+			hash = qasHashString( hash, ot->GetMethodByIndex( j )->GetDeclaration( true, true ) );
+	}
+
+	for( i = 0; i < engine->GetFuncdefCount(); i++ )
+		hash = qasHashString( hash, engine->GetFuncdefByIndex( i )->GetDeclaration( true, true ) );
+
+	for( i = 0; i < engine->GetGlobalFunctionCount(); i++ )
+		hash = qasHashString( hash, engine->GetGlobalFunctionByIndex( i )->GetDeclaration( true, true ) );
+
+	for( i = 0; i < engine->GetGlobalPropertyCount(); i++ ) {
+		int typeId;
+		bool isConst;
+		const char *name, *nameSpace;
+
+		engine->GetGlobalPropertyByIndex( i, &name, &nameSpace, &typeId, &isConst );
+		hash = qasHashString( hash, name );
+		hash = qasHashString( hash, nameSpace );
+		hash = qasHashString( hash, engine->GetTypeDeclaration( typeId, true ) );
+		hash = COM_SuperFastHash( ( const unsigned char * )&isConst, sizeof( isConst ), hash );
+	}
+
+	engineHashes[engine] = hash;
+	return hash;
+}
+
+/*
+* qasForgetEngineByteCodeHash
+*/
+void qasForgetEngineByteCodeHash( asIScriptEngine *engine )
+{
+	qasEngineHashMap::iterator it = engineHashes.find( engine );
+	if( it != engineHashes.end() )
+		engineHashes.erase( it );
+}
+
+/*
+* qasHashScriptSection
+*
+* Accumulates a script section into the source hash used to key the bytecode cache.
+*/
+unsigned int qasHashScriptSection( unsigned int hash, const char *name, const char *code, size_t length )
+{
+	hash = qasHashString( hash, name );
+	hash = COM_SuperFastHash( ( const unsigned char * )&length, sizeof( length ), hash );
+	if( code && length )
+		hash = COM_SuperFastHash( ( const unsigned char * )code, length, hash );
+	return hash;
+}
+
+/*
+* qasLoadByteCode
+*
+* Tries to load the module from the bytecode cache. Returns false on a cache miss,
+* in which case the module is left empty and the caller should build from source.
+*/
+bool qasLoadByteCode( asIScriptModule *module, const char *filename, unsigned int sourceHash )
+{
+	int filenum, length;
+	uint8_t *data;
+	qasByteCodeHeader_t header;
+	bool stale;
+
+	if( !module || !as_bytecode_cache->integer )
+		return false;
+
+	length = trap_FS_FOpenFile( filename, &filenum, FS_READ );
+	if( length < 0 )
+		return false;
+
+	if( length < (int)sizeof( header ) ) {
+		trap_FS_FCloseFile( filenum );
+		return false;
+	}
+
+	trap_FS_Read( &header, sizeof( header ), filenum );
+
+	stale = memcmp( header.magic, QAS_BYTECODE_MAGIC, sizeof( header.magic ) )
+		|| LittleLong( header.version ) != QAS_BYTECODE_VERSION
+		|| LittleLong( header.apiVersion ) != ANGELWRAP_API_VERSION
+		|| LittleLong( header.asVersion ) != ANGELSCRIPT_VERSION
+		|| (unsigned)LittleLong( header.engineHash ) != qasGetEngineHash( module->GetEngine() )
+		|| (unsigned)LittleLong( header.sourceHash ) != sourceHash
+		|| (unsigned)LittleLong( header.dataSize ) != length - sizeof( header );
+	if( stale ) {
+		trap_FS_FCloseFile( filenum );
+		return false;
+	}
+
+	data = ( uint8_t * )QAS_Malloc( length - sizeof( header ) );
+	trap_FS_Read( data, length - sizeof( header ), filenum );
+	trap_FS_FCloseFile( filenum );
+
+	if( COM_SuperFastHash( data, length - sizeof( header ), 0 ) != (unsigned)LittleLong( header.dataChecksum ) ) {
+		QAS_Printf( S_COLOR_YELLOW "Bytecode cache '%s' is corrupt\n", filename );
+		QAS_Free( data );
+		return false;
+	}
+
+	qasByteCodeStream stream( data, length - sizeof( header ) );
+	if( module->LoadByteCode( &stream ) < 0 || stream.hasOverflowed() ) {
+		QAS_Printf( S_COLOR_YELLOW "Failed to load bytecode cache '%s'\n", filename );
+		module->Discard();
+		QAS_Free( data );
+		return false;
+	}
+
+	QAS_Free( data );
+	return true;
+}
+
+/*
+* qasSaveByteCode
+*/
+bool qasSaveByteCode( asIScriptModule *module, const char *filename, unsigned int sourceHash )
+{
+	int filenum;
+	qasByteCodeHeader_t header;
+	qasByteCodeStream stream;
+
+	if( !module || !as_bytecode_cache->integer )
+		return false;
+
+	if( module->SaveByteCode( &stream, false ) < 0 || !stream.getSize() )
+		return false;
+
+	if( trap_FS_FOpenFile( filename, &filenum, FS_WRITE ) == -1 ) {
+		QAS_Printf( S_COLOR_YELLOW "Couldn't write bytecode cache '%s'\n", filename );
+		return false;
+	}
+
+	memcpy( header.magic, QAS_BYTECODE_MAGIC, sizeof( header.magic ) );
+	header.version = LittleLong( QAS_BYTECODE_VERSION );
+	header.apiVersion = LittleLong( ANGELWRAP_API_VERSION );
+	header.asVersion = LittleLong( ANGELSCRIPT_VERSION );
+	header.engineHash = LittleLong( qasGetEngineHash( module->GetEngine() ) );
+	header.sourceHash = LittleLong( sourceHash );
+	header.dataSize = LittleLong( stream.getSize() );
+	header.dataChecksum = LittleLong( COM_SuperFastHash( stream.getData(), stream.getSize(), 0 ) );
+
+	if( trap_FS_Write( &header, sizeof( header ), filenum ) != sizeof( header )
+		|| trap_FS_Write( stream.getData(), stream.getSize(), filenum ) != (int)stream.getSize() ) {
+		trap_FS_FCloseFile( filenum );
+		trap_FS_RemoveFile( filename );
+		return false;
+	}
+
+	trap_FS_FCloseFile( filenum );
+	return true;
+}
+
+/*
+* qasInitByteCodeCache
+*/
+void qasInitByteCodeCache( void )
+{
+	as_bytecode_cache = trap_Cvar_Get( "as_bytecode_cache", "1", CVAR_ARCHIVE );
+}
+
+/*
+* qasShutdownByteCodeCache
+*/
+void qasShutdownByteCodeCache( void )
+{
+	engineHashes.clear();
+}
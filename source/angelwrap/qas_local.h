@@ -23,6 +23,7 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 
 #include <new>
 #include <string>
+#include <list>
 
 #if defined ( _WIN32 ) || ( _WIN64 )
 #include <string.h>
@@ -87,4 +88,19 @@ void qasReleaseDictionaryCpp( CScriptDictionaryInterface *dict );
 CScriptAnyInterface *qasCreateAnyCpp( asIScriptEngine *engine );
 void qasReleaseAnyCpp( CScriptAnyInterface *any );
 
+// bytecode cache
+void qasInitByteCodeCache( void );
+void qasShutdownByteCodeCache( void );
+void qasForgetEngineByteCodeHash( asIScriptEngine *engine );
+unsigned int qasHashScriptSection( unsigned int hash, const char *name, const char *code, size_t length );
+bool qasLoadByteCode( asIScriptModule *module, const char *filename, unsigned int sourceHash );
+bool qasSaveByteCode( asIScriptModule *module, const char *filename, unsigned int sourceHash );
+
+// profiler
+void qasInitProfiler( void );
+void qasShutdownProfiler( void );
+void qasProfileAttachContext( asIScriptContext *ctx, bool created );
+void qasProfileRetireEngine( asIScriptEngine *engine );
+void qasGetAllContexts( std::list<asIScriptContext *> &list );
+
 #endif // __QAS_LOCAL_H__
@@ -54,6 +54,10 @@ void QAS_InitAngelExport( void )
 
 	angelExport.asCreateAnyCpp = qasCreateAnyCpp;
 	angelExport.asReleaseAnyCpp = qasReleaseAnyCpp;
+
+	angelExport.asHashScriptSection = qasHashScriptSection;
+	angelExport.asLoadByteCode = qasLoadByteCode;
+	angelExport.asSaveByteCode = qasSaveByteCode;
 }
 
 int QAS_API( void )
@@ -69,11 +73,17 @@ int QAS_Init( void )
 	srand( time( NULL ) );
 
 	QAS_InitAngelExport();
+
+	qasInitByteCodeCache();
+	qasInitProfiler();
 	return 1;
 }
 
 void QAS_ShutDown( void )
 {
+	qasShutdownProfiler();
+	qasShutdownByteCodeCache();
+
 	QAS_MemFreePool( &angelwrappool );
 }
 
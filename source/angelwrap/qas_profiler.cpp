@@ -0,0 +1,489 @@
+/*
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+*/
+
+#include <map>
+#include <vector>
+#include <algorithm>
+
+#include "qas_precompiled.h"
+
+/*
+* Statement level script profiler.
+*
+* While running, every script context gets a line callback which charges the time
+* elapsed since the previous statement to the call stack that was active then.
+* The time of native functions called from a statement is therefore charged to
+* the statement that called them. Execute calls the line callback once more when the
+* context stops, which ends the last statement of the execution. Nothing is installed
+* while the profiler is stopped.
+*/
+
+#define QAS_PROFILE_MAX_DEPTH		64
+#define QAS_PROFILE_TREE_CUTOFF		0.001	// hide call tree nodes below 0.1% of the total
+
+struct qasProfileNode;
+
+typedef struct
+{
+	uint64_t time;
+	unsigned int samples;
+} qasProfileLine_t;
+
+// function and the line in the calling function it was called from
+typedef std::pair<asIScriptFunction *, int> qasProfileKey;
+typedef std::map<qasProfileKey, qasProfileNode *> qasProfileChildren;
+
+struct qasProfileNode
+{
+	asIScriptEngine *engine;
+	std::string function;
+	std::string section;
+	int callLine;
+
+	uint64_t selfTime;
+	unsigned int samples;
+	std::map<int, qasProfileLine_t> lines;
+
+	qasProfileChildren children;
+	std::vector<qasProfileNode *> retired;	// children whose engine has been released
+};
+
+typedef struct
+{
+	std::string function;
+	std::string section;
+	int line;
+	uint64_t time;
+	unsigned int samples;
+} qasProfileEntry_t;
+
+static bool qasProfiling;
+static uint64_t qasProfileStartTime, qasProfileWallTime, qasProfileTotalTime;
+
+static qasProfileNode qasProfileRoot;
+
+// the statement that is currently executing and when it started
+static qasProfileNode *qasProfileCurrent;
+static int qasProfileCurrentLine;
+static uint64_t qasProfileCurrentTime;
+
+// statements of outer contexts that resume once a nested execution stops
+typedef std::pair<qasProfileNode *, int> qasProfileStatement;
+typedef std::map<asIScriptContext *, qasProfileStatement> qasProfileResumeMap;
+static qasProfileResumeMap qasProfileResume;
+
+// ============================================================================
+
+static qasProfileNode *qasProfileNewNode( asIScriptEngine *engine, asIScriptFunction *func, int callLine )
+{
+	qasProfileNode *node = QAS_NEW( qasProfileNode );
+	const char *section = func->GetScriptSectionName();
+
+	node->engine = engine;
+	node->function = func->GetDeclaration( true, true );
+	node->section = section ? section : "";
+	node->callLine = callLine;
+	node->selfTime = 0;
+	node->samples = 0;
+	return node;
+}
+
+static void qasProfileFreeNode( qasProfileNode *node )
+{
+	for( qasProfileChildren::iterator it = node->children.begin(); it != node->children.end(); ++it ) {
+		qasProfileFreeNode( it->second );
+		QAS_DELETE( it->second, qasProfileNode );
+	}
+	node->children.clear();
+
+	for( size_t i = 0; i < node->retired.size(); i++ ) {
+		qasProfileFreeNode( node->retired[i] );
+		QAS_DELETE( node->retired[i], qasProfileNode );
+	}
+	node->retired.clear();
+}
+
+/*
+* qasProfileCharge
+*
+* Charge the time since the last statement started to it.
+*/
+static void qasProfileCharge( uint64_t now )
+{
+	if( qasProfileCurrent ) {
+		uint64_t time = now - qasProfileCurrentTime;
+		qasProfileLine_t &line = qasProfileCurrent->lines[qasProfileCurrentLine];
+
+		line.time += time;
+		line.samples++;
+		qasProfileCurrent->selfTime += time;
+		qasProfileCurrent->samples++;
+		qasProfileTotalTime += time;
+	}
+	qasProfileCurrentTime = now;
+}
+
+/*
+* qasProfileLineCallback
+*/
+static void qasProfileLineCallback( asIScriptContext *ctx, void *param )
+{
+	int level, callLine;
+	asIScriptFunction *func;
+	asIScriptEngine *engine;
+	qasProfileNode *node;
+	qasProfileChildren::iterator it;
+
+	qasProfileCharge( trap_Microseconds() );
+
+	if( ctx->GetState() != asEXECUTION_ACTIVE ) {
+		// the execution has stopped, further time goes to the statement that
+		// started it if this was a nested execution and nowhere otherwise
+		qasProfileResumeMap::iterator resume = qasProfileResume.find( ctx );
+		if( resume != qasProfileResume.end() ) {
+			qasProfileCurrent = resume->second.first;
+			qasProfileCurrentLine = resume->second.second;
+			qasProfileResume.erase( resume );
+		} else {
+			qasProfileCurrent = NULL;
+		}
+		return;
+	}
+
+	engine = ctx->GetEngine();
+	node = &qasProfileRoot;
+	callLine = 0;
+
+	// walk from the entry function down to the one being executed
+	level = (int)ctx->GetCallstackSize() - 1;
+	if( level >= QAS_PROFILE_MAX_DEPTH )
+		level = QAS_PROFILE_MAX_DEPTH - 1;
+
+	for( ; level >= 0; level-- ) {
+		func = ctx->GetFunction( level );
+		if( !func )
+			continue;
+
+		qasProfileKey key( func, callLine );
+		it = node->children.find( key );
+		if( it == node->children.end() )
+			it = node->children.insert( qasProfileChildren::value_type( key, qasProfileNewNode( engine, func, callLine ) ) ).first;
+		node = it->second;
+
+		callLine = ctx->GetLineNumber( level );
+	}
+
+	qasProfileCurrent = node != &qasProfileRoot ? node : NULL;
+	qasProfileCurrentLine = callLine;
+}
+
+// ============================================================================
+
+/*
+* qasProfileAttachContext
+*
+* Called for every context that is about to run a script function.
+*/
+void qasProfileAttachContext( asIScriptContext *ctx, bool created )
+{
+	if( !qasProfiling )
+		return;
+
+	if( created )
+		ctx->SetLineCallback( asFUNCTION( qasProfileLineCallback ), NULL, asCALL_CDECL );
+
+	// a nested execution returns to the statement that is running now, a new
+	// top level execution must not be charged the time that passed in native
+	// code since the last script ran
+	if( asGetActiveContext() ) {
+		qasProfileResume[ctx] = qasProfileStatement( qasProfileCurrent, qasProfileCurrentLine );
+	} else {
+		qasProfileResume.erase( ctx );
+		qasProfileCurrent = NULL;
+		qasProfileCurrentTime = trap_Microseconds();
+	}
+}
+
+/*
+* qasProfileRetireEngine
+*
+* The functions of a released engine may be reallocated, keep their
+* statistics but stop matching new statements against them.
+*/
+static void qasProfileRetireEngineNodes( qasProfileNode *node, asIScriptEngine *engine )
+{
+	qasProfileChildren::iterator it, next;
+
+	for( it = node->children.begin(); it != node->children.end(); it = next ) {
+		next = it;
+		++next;
+
+		if( it->second->engine == engine ) {
+			node->retired.push_back( it->second );
+			node->children.erase( it );
+		} else {
+			qasProfileRetireEngineNodes( it->second, engine );
+		}
+	}
+}
+
+void qasProfileRetireEngine( asIScriptEngine *engine )
+{
+	qasProfileRetireEngineNodes( &qasProfileRoot, engine );
+	qasProfileCurrent = NULL;
+	qasProfileResume.clear();
+}
+
+// ============================================================================
+
+static bool qasProfileEntryCmp( const qasProfileEntry_t &a, const qasProfileEntry_t &b )
+{
+	return a.time > b.time;
+}
+
+static uint64_t qasProfileInclusiveTime( const qasProfileNode *node )
+{
+	uint64_t time = node->selfTime;
+
+	for( qasProfileChildren::const_iterator it = node->children.begin(); it != node->children.end(); ++it )
+		time += qasProfileInclusiveTime( it->second );
+	for( size_t i = 0; i < node->retired.size(); i++ )
+		time += qasProfileInclusiveTime( node->retired[i] );
+	return time;
+}
+
+static void qasProfileGatherChildren( const qasProfileNode *node, std::vector<const qasProfileNode *> &children )
+{
+	children.clear();
+	for( qasProfileChildren::const_iterator it = node->children.begin(); it != node->children.end(); ++it )
+		children.push_back( it->second );
+	for( size_t i = 0; i < node->retired.size(); i++ )
+		children.push_back( node->retired[i] );
+}
+
+/*
+* qasProfileAccumulate
+*
+* Sums self time per function and per statement over the whole tree.
+*/
+static void qasProfileAccumulate( const qasProfileNode *node, std::map<std::string, qasProfileEntry_t> &functions,
+	std::map<std::string, qasProfileEntry_t> &lines )
+{
+	std::vector<const qasProfileNode *> children;
+
+	qasProfileGatherChildren( node, children );
+
+	for( size_t i = 0; i < children.size(); i++ ) {
+		const qasProfileNode *child = children[i];
+
+		if( child->samples ) {
+			qasProfileEntry_t &func = functions[child->function];
+			func.function = child->function;
+			func.section = child->section;
+			func.time += child->selfTime;
+			func.samples += child->samples;
+		}
+
+		for( std::map<int, qasProfileLine_t>::const_iterator it = child->lines.begin(); it != child->lines.end(); ++it ) {
+			qasProfileEntry_t &line = lines[child->function + va( ":%i", it->first )];
+			line.function = child->function;
+			line.section = child->section;
+			line.line = it->first;
+			line.time += it->second.time;
+			line.samples += it->second.samples;
+		}
+
+		qasProfileAccumulate( child, functions, lines );
+	}
+}
+
+static void qasProfilePrintFlat( std::map<std::string, qasProfileEntry_t> &entries, const char *title, bool printLine, int maxEntries )
+{
+	int count;
+	std::vector<qasProfileEntry_t> sorted;
+
+	for( std::map<std::string, qasProfileEntry_t>::iterator it = entries.begin(); it != entries.end(); ++it )
+		sorted.push_back( it->second );
+	std::sort( sorted.begin(), sorted.end(), qasProfileEntryCmp );
+
+	QAS_Printf( "%s\n", title );
+	QAS_Printf( "    self ms     %%    statements  function\n" );
+
+	count = 0;
+	for( std::vector<qasProfileEntry_t>::iterator it = sorted.begin(); it != sorted.end() && count < maxEntries; ++it, count++ ) {
+		if( printLine ) {
+			QAS_Printf( "%11.3f %5.1f %12u  %s (%s:%i)\n", it->time / 1000.0, 100.0 * it->time / qasProfileTotalTime,
+				it->samples, it->function.c_str(), it->section.c_str(), it->line );
+		} else {
+			QAS_Printf( "%11.3f %5.1f %12u  %s\n", it->time / 1000.0, 100.0 * it->time / qasProfileTotalTime,
+				it->samples, it->function.c_str() );
+		}
+	}
+}
+
+static void qasProfilePrintTree( const qasProfileNode *node, int depth )
+{
+	std::vector<const qasProfileNode *> children;
+	std::vector<std::pair<uint64_t, const qasProfileNode *> > sorted;
+
+	qasProfileGatherChildren( node, children );
+
+	for( size_t i = 0; i < children.size(); i++ )
+		sorted.push_back( std::make_pair( qasProfileInclusiveTime( children[i] ), children[i] ) );
+	std::sort( sorted.rbegin(), sorted.rend() );
+
+	for( size_t i = 0; i < sorted.size(); i++ ) {
+		const qasProfileNode *child = sorted[i].second;
+		uint64_t time = sorted[i].first;
+
+		if( time < qasProfileTotalTime * QAS_PROFILE_TREE_CUTOFF )
+			break;
+
+		if( depth ) {
+			QAS_Printf( "%11.3f %11.3f %5.1f  %*s%s (line %i)\n", time / 1000.0, child->selfTime / 1000.0,
+				100.0 * time / qasProfileTotalTime, depth * 2, "", child->function.c_str(), child->callLine );
+		} else {
+			QAS_Printf( "%11.3f %11.3f %5.1f  %s (%s)\n", time / 1000.0, child->selfTime / 1000.0,
+				100.0 * time / qasProfileTotalTime, child->function.c_str(), child->section.c_str() );
+		}
+
+		qasProfilePrintTree( child, depth + 1 );
+	}
+}
+
+/*
+* qasProfileDump
+*/
+static void qasProfileDump( const char *mode, int maxEntries )
+{
+	std::map<std::string, qasProfileEntry_t> functions, lines;
+	uint64_t wallTime;
+
+	if( !qasProfileTotalTime ) {
+		QAS_Printf( "No script profile data\n" );
+		return;
+	}
+
+	wallTime = qasProfiling ? trap_Microseconds() - qasProfileStartTime : qasProfileWallTime;
+
+	if( !mode[0] || !Q_stricmp( mode, "flat" ) ) {
+		qasProfileAccumulate( &qasProfileRoot, functions, lines );
+		qasProfilePrintFlat( functions, "Functions by self time:", false, maxEntries );
+		QAS_Printf( "\n" );
+		qasProfilePrintFlat( lines, "Statements by self time:", true, maxEntries );
+		QAS_Printf( "\n" );
+	}
+
+	if( !mode[0] || !Q_stricmp( mode, "tree" ) ) {
+		QAS_Printf( "Call tree:\n" );
+		QAS_Printf( "   total ms     self ms     %%  function (calling line)\n" );
+		qasProfilePrintTree( &qasProfileRoot, 0 );
+		QAS_Printf( "\n" );
+	}
+
+	QAS_Printf( "%.3f ms in scripts over %.3f s\n", qasProfileTotalTime / 1000.0, wallTime / 1000000.0 );
+}
+
+/*
+* qasProfileReset
+*/
+static void qasProfileReset( void )
+{
+	qasProfileFreeNode( &qasProfileRoot );
+	qasProfileCurrent = NULL;
+	qasProfileResume.clear();
+	qasProfileTotalTime = 0;
+	qasProfileWallTime = 0;
+	qasProfileStartTime = trap_Microseconds();
+}
+
+/*
+* qasProfileSetEnabled
+*/
+static void qasProfileSetEnabled( bool enable, std::list<asIScriptContext *> *contexts )
+{
+	if( qasProfiling == enable )
+		return;
+
+	qasProfiling = enable;
+	qasProfileCurrent = NULL;
+	qasProfileResume.clear();
+
+	for( std::list<asIScriptContext *>::iterator it = contexts->begin(); it != contexts->end(); ++it ) {
+		if( enable )
+			( *it )->SetLineCallback( asFUNCTION( qasProfileLineCallback ), NULL, asCALL_CDECL );
+		else
+			( *it )->ClearLineCallback();
+	}
+}
+
+/*
+* qasProfile_f
+*/
+static void qasProfile_f( void )
+{
+	const char *cmd = trap_Cmd_Argv( 1 );
+	std::list<asIScriptContext *> contexts;
+
+	qasGetAllContexts( contexts );
+
+	if( !Q_stricmp( cmd, "start" ) ) {
+		if( !qasProfiling )
+			qasProfileReset();
+		qasProfileSetEnabled( true, &contexts );
+		QAS_Printf( "Script profiling started\n" );
+	} else if( !Q_stricmp( cmd, "stop" ) ) {
+		if( qasProfiling )
+			qasProfileWallTime = trap_Microseconds() - qasProfileStartTime;
+		qasProfileSetEnabled( false, &contexts );
+		QAS_Printf( "Script profiling stopped\n" );
+	} else if( !Q_stricmp( cmd, "reset" ) ) {
+		qasProfileReset();
+	} else if( !Q_stricmp( cmd, "dump" ) ) {
+		int maxEntries = trap_Cmd_Argc() > 3 ? atoi( trap_Cmd_Argv( 3 ) ) : 20;
+		qasProfileDump( trap_Cmd_Argc() > 2 ? trap_Cmd_Argv( 2 ) : "", maxEntries > 0 ? maxEntries : 20 );
+	} else {
+		QAS_Printf( "Usage: %s <start|stop|reset|dump [flat|tree] [entries]>\n", trap_Cmd_Argv( 0 ) );
+		QAS_Printf( "Profiling is %s\n", qasProfiling ? "running" : "stopped" );
+	}
+}
+
+/*
+* qasInitProfiler
+*/
+void qasInitProfiler( void )
+{
+	qasProfiling = false;
+	qasProfileCurrent = NULL;
+	qasProfileTotalTime = 0;
+
+	trap_Cmd_AddCommand( "as_profile", qasProfile_f );
+}
+
+/*
+* qasShutdownProfiler
+*/
+void qasShutdownProfiler( void )
+{
+	trap_Cmd_RemoveCommand( "as_profile" );
+
+	qasProfileFreeNode( &qasProfileRoot );
+	qasProfiling = false;
+	qasProfileCurrent = NULL;
+	qasProfileResume.clear();
+}
@@ -21,7 +21,7 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 #ifndef __QAS_PUBLIC_H__
 #define __QAS_PUBLIC_H__
 
-#define	ANGELWRAP_API_VERSION   14
+#define	ANGELWRAP_API_VERSION   15
 
 typedef struct
 {
@@ -29,6 +29,7 @@ typedef struct
 	void ( *Error )( const char *msg );
 
 	unsigned int ( *Milliseconds )( void );
+	uint64_t ( *Microseconds )( void );
 
 	// console variable interaction
 	cvar_t *( *Cvar_Get )( const char *name, const char *value, int flags );
@@ -46,6 +47,13 @@ typedef struct
 	void ( *Cmd_RemoveCommand )( const char *cmd_name );
 	void ( *Cmd_ExecuteText )( int exec_when, const char *text );
 
+	// file system
+	int ( *FS_FOpenFile )( const char *filename, int *filenum, int mode );
+	int ( *FS_Read )( void *buffer, size_t len, int file );
+	int ( *FS_Write )( const void *buffer, size_t len, int file );
+	void ( *FS_FCloseFile )( int file );
+	bool ( *FS_RemoveFile )( const char *filename );
+
 	// managed memory allocation
 	struct mempool_s *( *Mem_AllocPool )( const char *name, const char *filename, int fileline );
 	void *( *Mem_Alloc )( struct mempool_s *pool, size_t size, const char *filename, int fileline );
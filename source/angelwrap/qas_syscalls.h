@@ -42,6 +42,11 @@ static inline unsigned int trap_Milliseconds( void )
 	return ANGELWRAP_IMPORT.Milliseconds();
 }
 
+static inline uint64_t trap_Microseconds( void )
+{
+	return ANGELWRAP_IMPORT.Microseconds();
+}
+
 static inline cvar_t *trap_Cvar_Get( const char *name, const char *value, int flags )
 {
 	return ANGELWRAP_IMPORT.Cvar_Get( name, value, flags );
@@ -87,12 +92,12 @@ static inline char *trap_Cmd_Args( void )
 	return ANGELWRAP_IMPORT.Cmd_Args();
 }
 
-static inline void trap_Cmd_AddCommand( char *name, void ( *cmd )(void) )
+static inline void trap_Cmd_AddCommand( const char *name, void ( *cmd )(void) )
 {
 	ANGELWRAP_IMPORT.Cmd_AddCommand( name, cmd );
 }
 
-static inline void trap_Cmd_RemoveCommand( char *cmd_name )
+static inline void trap_Cmd_RemoveCommand( const char *cmd_name )
 {
 	ANGELWRAP_IMPORT.Cmd_RemoveCommand( cmd_name );
 }
@@ -102,6 +107,31 @@ static inline void trap_Cmd_ExecuteText( int exec_when, char *text )
 	ANGELWRAP_IMPORT.Cmd_ExecuteText( exec_when, text );
 }
 
+static inline int trap_FS_FOpenFile( const char *filename, int *filenum, int mode )
+{
+	return ANGELWRAP_IMPORT.FS_FOpenFile( filename, filenum, mode );
+}
+
+static inline int trap_FS_Read( void *buffer, size_t len, int file )
+{
+	return ANGELWRAP_IMPORT.FS_Read( buffer, len, file );
+}
+
+static inline int trap_FS_Write( const void *buffer, size_t len, int file )
+{
+	return ANGELWRAP_IMPORT.FS_Write( buffer, len, file );
+}
+
+static inline void trap_FS_FCloseFile( int file )
+{
+	ANGELWRAP_IMPORT.FS_FCloseFile( file );
+}
+
+static inline bool trap_FS_RemoveFile( const char *filename )
+{
+	return ANGELWRAP_IMPORT.FS_RemoveFile( filename );
+}
+
 static inline struct mempool_s *trap_MemAllocPool( const char *name, const char *filename, int fileline )
 {
 	return ANGELWRAP_IMPORT.Mem_AllocPool( name, filename, fileline );
@@ -1292,6 +1292,8 @@ static const cgcmd_t cgcmds[] =
 	{ "weaplast", CG_Cmd_LastWeapon_f, true },
 	{ "weapcross", CG_Cmd_WeaponCross_f, true },
 	{ "viewpos", CG_Viewpos_f, true },
+	{ "predictcheck", CG_PredictCheck_f, false },
+	{ "decalstats", CG_DecalStats_f, true },
 	{ "players", NULL, false },
 	{ "spectators", NULL, false },
 
@@ -47,6 +47,28 @@ static vec4_t cg_decal_norms[MAX_DECALS][MAX_DECAL_VERTS];
 static vec2_t cg_decal_stcoords[MAX_DECALS][MAX_DECAL_VERTS];
 static byte_vec4_t cg_decal_colors[MAX_DECALS][MAX_DECAL_VERTS];
 
+// decals waiting for the renderer to clip them on its worker thread
+#define MAX_PENDING_DECALS	128
+
+typedef struct
+{
+	unsigned int ticket;
+	vec3_t origin;
+	vec3_t axis[3];
+	float color[4];
+	unsigned int die;
+	unsigned int fadetime;
+	float fadefreq;
+	bool fadealpha;
+	struct shader_s	*shader;
+} cpendingdecal_t;
+
+static cpendingdecal_t cg_pending_decals[MAX_PENDING_DECALS];
+static int cg_numPendingDecals;
+
+static int cg_decalsThisFrame;
+static unsigned int cg_decalsQueued, cg_decalsClipped, cg_decalsDropped;
+
 /*
 * CG_ClearDecals
 */
@@ -71,6 +93,10 @@ void CG_ClearDecals( void )
 		cg_decals[i].poly->stcoords = cg_decal_stcoords[i];
 		cg_decals[i].poly->colors = cg_decal_colors[i];
 	}
+
+	cg_numPendingDecals = 0;
+	cg_decalsThisFrame = 0;
+	cg_decalsQueued = cg_decalsClipped = cg_decalsDropped = 0;
 }
 
 /*
@@ -120,21 +146,87 @@ static void CG_FreeDecal( cdecal_t *dl )
 }
 
 /*
-* CG_SpawnDecal
+* CG_DecalAxis
 */
-int CG_SpawnDecal( const vec3_t origin, const vec3_t dir, float orient, float radius,
-				   float r, float g, float b, float a, float die, float fadetime, bool fadealpha, struct shader_s *shader )
+static void CG_DecalAxis( const vec3_t dir, float orient, vec3_t axis[3] )
+{
+	VectorNormalize2( dir, axis[0] );
+	PerpendicularVector( axis[1], axis[0] );
+	RotatePointAroundVector( axis[2], axis[0], axis[1], orient );
+	CrossProduct( axis[0], axis[2], axis[1] );
+}
+
+/*
+* CG_AddDecalFragments
+* 
+* Turns clipped fragments into decals, axis[1] and axis[2] must be scaled to texture space
+*/
+static void CG_AddDecalFragments( const vec3_t origin, vec3_t axis[3], const float *rgba, 
+	unsigned int die, unsigned int fadetime, float fadefreq, bool fadealpha, struct shader_s *shader, 
+	int numfragments, const fragment_t *fragments, vec4_t *verts )
 {
 	int i, j;
 	cdecal_t *dl;
 	poly_t *poly;
-	vec3_t axis[3];
-	vec4_t verts[MAX_DECAL_VERTS];
 	vec3_t v;
 	byte_vec4_t color;
-	fragment_t *fr, fragments[MAX_DECAL_FRAGMENTS];
+	const fragment_t *fr;
+
+	color[0] = ( uint8_t )( rgba[0] );
+	color[1] = ( uint8_t )( rgba[1] );
+	color[2] = ( uint8_t )( rgba[2] );
+	color[3] = ( uint8_t )( rgba[3] );
+
+	for( i = 0, fr = fragments; i < numfragments; i++, fr++ )
+	{
+		if( fr->numverts > MAX_DECAL_VERTS )
+			return;
+		else if( fr->numverts <= 0 )
+			continue;
+
+		// allocate decal
+		dl = CG_AllocDecal();
+		dl->die = die;
+		dl->fadetime = fadetime;
+		dl->fadefreq = fadefreq;
+		dl->fadealpha = fadealpha;
+		dl->shader = shader;
+		Vector4Copy( rgba, dl->color );
+
+		// setup polygon for drawing
+		poly = dl->poly;
+		poly->shader = shader;
+		poly->numverts = fr->numverts;
+		poly->fognum = fr->fognum;
+
+		for( j = 0; j < fr->numverts; j++ )
+		{
+			Vector4Copy( verts[fr->firstvert+j], poly->verts[j] );
+			VectorCopy( fr->normal, poly->normals[j] ); poly->normals[j][3] = 0;
+			VectorSubtract( poly->verts[j], origin, v );
+			poly->stcoords[j][0] = DotProduct( v, axis[1] ) + 0.5f;
+			poly->stcoords[j][1] = DotProduct( v, axis[2] ) + 0.5f;
+			*( int * )poly->colors[j] = *( int * )color;
+		}
+	}
+}
+
+/*
+* CG_SpawnDecal_
+*/
+static int CG_SpawnDecal_( const vec3_t origin, const vec3_t dir, float orient, float radius,
+				   float r, float g, float b, float a, float die, float fadetime, bool fadealpha, struct shader_s *shader, 
+				   bool async )
+{
+	vec3_t axis[3];
+	vec4_t verts[MAX_DECAL_VERTS];
+	float rgba[4];
+	fragment_t fragments[MAX_DECAL_FRAGMENTS];
 	int numfragments;
-	float dietime, fadefreq;
+	unsigned int ticket;
+	unsigned int dietime;
+	float fadefreq;
+	cpendingdecal_t *pd;
 
 	// invalid decal
 	if( radius <= 0 || VectorCompare( dir, vec3_origin ) )
@@ -144,32 +236,53 @@ int CG_SpawnDecal( const vec3_t origin, const vec3_t dir, float orient, float ra
 	if( DistanceFast( origin, cg.view.origin ) * cg.view.fracDistFOV > 2048 )
 		return 0;
 
+	if( async && !cg_addDecals->integer )
+		return 0;
+
 	// calculate orientation matrix
-	VectorNormalize2( dir, axis[0] );
-	PerpendicularVector( axis[1], axis[0] );
-	RotatePointAroundVector( axis[2], axis[0], axis[1], orient );
-	CrossProduct( axis[0], axis[2], axis[1] );
+	CG_DecalAxis( dir, orient, axis );
 
-	numfragments = trap_R_GetClippedFragments( origin, radius, axis, // clip it
-		MAX_DECAL_VERTS, verts, MAX_DECAL_FRAGMENTS, fragments );
+	numfragments = 0;
+	ticket = 0;
 
-	// no valid fragments
-	if( !numfragments )
-		return 0;
+	if( async )
+	{
+		if( cg_numPendingDecals == MAX_PENDING_DECALS 
+			|| ( cg_decalBudget->integer > 0 && cg_decalsThisFrame >= cg_decalBudget->integer ) )
+		{
+			cg_decalsDropped++;
+			return 0;
+		}
+
+		ticket = trap_R_QueueClippedFragments( origin, radius, axis );
+		if( !ticket )
+		{
+			cg_decalsDropped++;
+			return 0;
+		}
 
-	if( !cg_addDecals->integer )
-		return numfragments;
+		cg_decalsThisFrame++;
+		cg_decalsQueued++;
+	}
+	else
+	{
+		numfragments = trap_R_GetClippedFragments( origin, radius, axis, // clip it
+			MAX_DECAL_VERTS, verts, MAX_DECAL_FRAGMENTS, fragments );
+
+		// no valid fragments
+		if( !numfragments )
+			return 0;
+
+		if( !cg_addDecals->integer )
+			return numfragments;
+	}
 
 	// clamp and scale colors
 	if( r < 0 ) r = 0;else if( r > 1 ) r = 255;else r *= 255;
 	if( g < 0 ) g = 0;else if( g > 1 ) g = 255;else g *= 255;
 	if( b < 0 ) b = 0;else if( b > 1 ) b = 255;else b *= 255;
 	if( a < 0 ) a = 0;else if( a > 1 ) a = 255;else a *= 255;
-
-	color[0] = ( uint8_t )( r );
-	color[1] = ( uint8_t )( g );
-	color[2] = ( uint8_t )( b );
-	color[3] = ( uint8_t )( a );
+	Vector4Set( rgba, r, g, b, a );
 
 	radius = 0.5f / radius;
 	VectorScale( axis[1], radius, axis[1] );
@@ -179,43 +292,98 @@ int CG_SpawnDecal( const vec3_t origin, const vec3_t dir, float orient, float ra
 	fadefreq = 0.001f / min( fadetime, die );
 	fadetime = cg.time + ( die - min( fadetime, die ) ) * 1000;
 
-	for( i = 0, fr = fragments; i < numfragments; i++, fr++ )
+	if( async )
 	{
-		if( fr->numverts > MAX_DECAL_VERTS )
-			return numfragments;
-		else if( fr->numverts <= 0 )
-			continue;
+		pd = &cg_pending_decals[cg_numPendingDecals++];
+		pd->ticket = ticket;
+		VectorCopy( origin, pd->origin );
+		VectorCopy( axis[0], pd->axis[0] );
+		VectorCopy( axis[1], pd->axis[1] );
+		VectorCopy( axis[2], pd->axis[2] );
+		Vector4Copy( rgba, pd->color );
+		pd->die = dietime;
+		pd->fadetime = fadetime;
+		pd->fadefreq = fadefreq;
+		pd->fadealpha = fadealpha;
+		pd->shader = shader;
+		return 1;
+	}
 
-		// allocate decal
-		dl = CG_AllocDecal();
-		dl->die = dietime;
-		dl->fadetime = fadetime;
-		dl->fadefreq = fadefreq;
-		dl->fadealpha = fadealpha;
-		dl->shader = shader;
-		dl->color[0] = r;
-		dl->color[1] = g;
-		dl->color[2] = b;
-		dl->color[3] = a;
+	CG_AddDecalFragments( origin, axis, rgba, dietime, fadetime, fadefreq, fadealpha, shader, 
+		numfragments, fragments, verts );
 
-		// setup polygon for drawing
-		poly = dl->poly;
-		poly->shader = shader;
-		poly->numverts = fr->numverts;
-		poly->fognum = fr->fognum;
+	return numfragments;
+}
 
-		for( j = 0; j < fr->numverts; j++ )
+/*
+* CG_SpawnDecal
+* 
+* With cg_decalsAsync the decal is clipped on the renderer's worker thread and
+* shows up on one of the next frames, the return value then only tells whether
+* the request has been queued.
+*/
+int CG_SpawnDecal( const vec3_t origin, const vec3_t dir, float orient, float radius,
+				   float r, float g, float b, float a, float die, float fadetime, bool fadealpha, struct shader_s *shader )
+{
+	return CG_SpawnDecal_( origin, dir, orient, radius, r, g, b, a, die, fadetime, fadealpha, shader, 
+		cg_decalsAsync->integer != 0 );
+}
+
+/*
+* CG_SpawnDecalSync
+* 
+* Returns the number of fragments the decal has been clipped into right away,
+* for callers that need to know whether there was anything to stick the decal to.
+*/
+int CG_SpawnDecalSync( const vec3_t origin, const vec3_t dir, float orient, float radius,
+				   float r, float g, float b, float a, float die, float fadetime, bool fadealpha, struct shader_s *shader )
+{
+	return CG_SpawnDecal_( origin, dir, orient, radius, r, g, b, a, die, fadetime, fadealpha, shader, false );
+}
+
+/*
+* CG_AddPendingDecals
+* 
+* Picks up the decals the renderer has finished clipping
+*/
+static void CG_AddPendingDecals( void )
+{
+	int i, numfragments;
+	vec4_t verts[MAX_DECAL_VERTS];
+	fragment_t fragments[MAX_DECAL_FRAGMENTS];
+	cpendingdecal_t *pd;
+
+	for( i = 0; i < cg_numPendingDecals; )
+	{
+		pd = &cg_pending_decals[i];
+
+		numfragments = trap_R_GetQueuedFragments( pd->ticket, MAX_DECAL_VERTS, verts, MAX_DECAL_FRAGMENTS, fragments );
+		if( numfragments < 0 )
 		{
-			Vector4Copy( verts[fr->firstvert+j], poly->verts[j] );
-			VectorCopy( fr->normal, poly->normals[j] ); poly->normals[j][3] = 0;
-			VectorSubtract( poly->verts[j], origin, v );
-			poly->stcoords[j][0] = DotProduct( v, axis[1] ) + 0.5f;
-			poly->stcoords[j][1] = DotProduct( v, axis[2] ) + 0.5f;
-			*( int * )poly->colors[j] = *( int * )color;
+			// still in the queue
+			i++;
+			continue;
 		}
+
+		cg_decalsClipped++;
+
+		if( numfragments > 0 && pd->die > cg.time )
+			CG_AddDecalFragments( pd->origin, pd->axis, pd->color, pd->die, pd->fadetime, pd->fadefreq, 
+				pd->fadealpha, pd->shader, numfragments, fragments, verts );
+
+		*pd = cg_pending_decals[--cg_numPendingDecals];
 	}
 
-	return numfragments;
+	cg_decalsThisFrame = 0;
+}
+
+/*
+* CG_DecalStats_f
+*/
+void CG_DecalStats_f( void )
+{
+	CG_Printf( "decals: %u queued, %u clipped, %u dropped, %i pending\n", 
+		cg_decalsQueued, cg_decalsClipped, cg_decalsDropped, cg_numPendingDecals );
 }
 
 /*
@@ -229,6 +397,8 @@ void CG_AddDecals( void )
 	poly_t *poly;
 	byte_vec4_t color;
 
+	CG_AddPendingDecals();
+
 	// add decals in first-spawed - first-drawn order
 	hnode = &cg_decals_headnode;
 	for( dl = hnode->prev; dl != hnode; dl = next )
@@ -537,7 +537,7 @@ void CG_BoltExplosionMode( const vec3_t pos, const vec3_t dir, int fire_mode, in
 	lentity_t *le;
 	vec3_t angles;
 
-	if( !CG_SpawnDecal( pos, dir, random()*360, 12, 
+	if( !CG_SpawnDecalSync( pos, dir, random()*360, 12, 
 		1, 1, 1, 1, 10, 1, true, CG_MediaShader( cgs.media.shaderElectroboltMark ) ) ) {
 		if( surfFlags & (SURF_SKY|SURF_NOMARKS|SURF_NOIMPACT) ) {
 			return;
@@ -581,7 +581,7 @@ void CG_InstaExplosionMode( const vec3_t pos, const vec3_t dir, int fire_mode, i
 		tcolor[2] *= 0.65f;
 	}
 
-	if( !CG_SpawnDecal( pos, dir, random()*360, 12, 
+	if( !CG_SpawnDecalSync( pos, dir, random()*360, 12, 
 		tcolor[0], tcolor[1], tcolor[2], 1.0f,
 		10, 1, true, CG_MediaShader( cgs.media.shaderInstagunMark ) ) ) {
 		if( surfFlags & (SURF_SKY|SURF_NOMARKS|SURF_NOIMPACT) ) {
@@ -716,6 +716,7 @@ struct sfx_s *CG_RegisterSexedSound( int entnum, const char *name );
 //
 extern cvar_t *cg_predict;
 extern cvar_t *cg_predict_optimize;
+extern cvar_t *cg_predict_tracecache;
 extern cvar_t *cg_showMiss;
 
 void CG_PredictedEvent( int entNum, int ev, int parm );
@@ -726,6 +727,8 @@ void CG_BuildSolidList( void );
 void CG_Trace( trace_t *t, vec3_t start, vec3_t mins, vec3_t maxs, vec3_t end, int ignore, int contentmask );
 int CG_PointContents( const vec3_t point );
 void CG_Predict_TouchTriggers( pmove_t *pm, vec3_t previous_origin );
+void CG_TraceCache_Flush( void );
+void CG_PredictCheck_f( void );
 
 //
 // cg_screen.c
@@ -1103,10 +1106,15 @@ void CG_ExplosionsDust( const vec3_t pos, const vec3_t dir, float radius );
 // cg_decals.c
 //
 extern cvar_t *cg_addDecals;
+extern cvar_t *cg_decalsAsync;
+extern cvar_t *cg_decalBudget;
 
 void CG_ClearDecals( void );
 int CG_SpawnDecal( const vec3_t origin, const vec3_t dir, float orient, float radius,
                     float r, float g, float b, float a, float die, float fadetime, bool fadealpha, struct shader_s *shader );
+int CG_SpawnDecalSync( const vec3_t origin, const vec3_t dir, float orient, float radius,
+                    float r, float g, float b, float a, float die, float fadetime, bool fadealpha, struct shader_s *shader );
+void CG_DecalStats_f( void );
 void CG_AddDecals( void );
 
 //
@@ -26,6 +26,7 @@ centity_t cg_entities[MAX_EDICTS];
 
 cvar_t *cg_predict;
 cvar_t *cg_predict_optimize;
+cvar_t *cg_predict_tracecache;
 cvar_t *cg_showMiss;
 
 cvar_t *cg_model;
@@ -35,6 +36,8 @@ cvar_t *cg_clan;
 cvar_t *cg_handicap;
 
 cvar_t *cg_addDecals;
+cvar_t *cg_decalsAsync;
+cvar_t *cg_decalBudget;
 
 //cvar_t *cg_footSteps;
 
@@ -735,6 +738,7 @@ static void CG_RegisterVariables( void )
 {
 	cg_predict =	    trap_Cvar_Get( "cg_predict", "1", 0 );
 	cg_predict_optimize = trap_Cvar_Get( "cg_predict_optimize", "1", 0 );
+	cg_predict_tracecache = trap_Cvar_Get( "cg_predict_tracecache", "1", 0 );
 	cg_showMiss =	    trap_Cvar_Get( "cg_showMiss", "0", 0 );
 
 	cg_debugPlayerModels =	trap_Cvar_Get( "cg_debugPlayerModels", "0", CVAR_CHEAT|CVAR_ARCHIVE );
@@ -751,6 +755,8 @@ static void CG_RegisterVariables( void )
 	cg_zoomfov =	trap_Cvar_Get( "zoomfov", "30", CVAR_ARCHIVE );
 
 	cg_addDecals =	    trap_Cvar_Get( "cg_decals", "1", CVAR_ARCHIVE );
+	cg_decalsAsync =	trap_Cvar_Get( "cg_decalsAsync", "1", CVAR_ARCHIVE );
+	cg_decalBudget =	trap_Cvar_Get( "cg_decalBudget", "32", CVAR_ARCHIVE );
 	//cg_footSteps =	    trap_Cvar_Get( "cg_footSteps", "1", 0 );
 
 	cg_thirdPerson =	trap_Cvar_Get( "cg_thirdPerson", "0", CVAR_CHEAT );
@@ -1226,6 +1232,7 @@ void CG_Init( const char *serverName, unsigned int playerNum,
 	CG_ClearDecals();
 	CG_ClearPolys();
 	CG_ClearEffects();
+	CG_TraceCache_Flush();
 
 	CG_InitChat( &cg.chat );
 
@@ -29,6 +29,236 @@ static bool	cg_triggersListTriggered[MAX_PARSE_ENTITIES];
 
 static bool ucmdReady = false;
 
+//=================================================================================
+
+/*
+* Prediction trace cache
+*
+* Every render frame the unacknowledged usercmds are replayed through Pmove, and
+* with a new snapshot the replay starts over, so the same traces get issued again
+* and again. Results are memoized by their full input while predicting. When
+* the solid list is rebuilt, only entries whose swept box overlaps the old or new
+* position of an entity that actually changed are dropped.
+*/
+
+#define TRACECACHE_SIZE			4096		// must be a power of two
+#define TRACECACHE_EPSILON		1.0f
+
+typedef struct
+{
+	vec3_t start, end;
+	vec3_t mins, maxs;
+	int ignore;
+	int contentmask;
+} tracecache_key_t;
+
+typedef struct
+{
+	bool valid;
+	tracecache_key_t key;
+	vec3_t absmins, absmaxs;	// swept box of the trace
+	trace_t trace;
+} tracecache_entry_t;
+
+typedef struct
+{
+	bool solid;
+	int type;
+	int solidValue;
+	int modelindex;
+	vec3_t origin, angles;
+	vec3_t absmins, absmaxs;
+} tracecache_ent_t;
+
+static tracecache_entry_t cg_traceCache[TRACECACHE_SIZE];
+static tracecache_ent_t cg_traceCacheEnts[MAX_EDICTS];
+static bool cg_traceCacheActive;
+
+static unsigned cg_traceCacheHits, cg_traceCacheMisses, cg_traceCacheInvalidated;
+
+/*
+* CG_TraceCache_Clear
+*/
+static void CG_TraceCache_Clear( void )
+{
+	memset( cg_traceCache, 0, sizeof( cg_traceCache ) );
+}
+
+/*
+* CG_TraceCache_Flush
+*/
+void CG_TraceCache_Flush( void )
+{
+	CG_TraceCache_Clear();
+	memset( cg_traceCacheEnts, 0, sizeof( cg_traceCacheEnts ) );
+}
+
+/*
+* CG_TraceCache_HashKey
+*/
+static unsigned CG_TraceCache_HashKey( const tracecache_key_t *key )
+{
+	unsigned i, hash = 2166136261u;
+	const uint8_t *p = ( const uint8_t * )key;
+
+	// FNV-1a
+	for( i = 0; i < sizeof( *key ); i++ )
+		hash = ( hash ^ p[i] ) * 16777619u;
+	return hash & ( TRACECACHE_SIZE - 1 );
+}
+
+/*
+* CG_TraceCache_EntityState
+* 
+* Fills in the position of a solid entity as CG_ClipMoveToEntities sees it
+*/
+static void CG_TraceCache_EntityState( const entity_state_t *ent, tracecache_ent_t *out )
+{
+	int i, x, zd, zu;
+	vec3_t mins, maxs;
+
+	memset( out, 0, sizeof( *out ) );
+	out->solid = true;
+	out->type = ent->type;
+	out->solidValue = ent->solid;
+	out->modelindex = ent->modelindex;
+
+	if( ent->solid == SOLID_BMODEL )
+	{
+		struct cmodel_s *cmodel = trap_CM_InlineModel( ent->modelindex );
+
+		if( ent->linearMovement )
+			GS_LinearMovement( ent, cg.frame.serverTime, out->origin );
+		else
+			VectorCopy( ent->origin, out->origin );
+		VectorCopy( ent->angles, out->angles );
+
+		if( !cmodel )
+		{
+			VectorClear( mins );
+			VectorClear( maxs );
+		}
+		else
+		{
+			trap_CM_InlineModelBounds( cmodel, mins, maxs );
+			if( out->angles[0] || out->angles[1] || out->angles[2] )
+			{
+				float radius = RadiusFromBounds( mins, maxs );
+				VectorSet( mins, -radius, -radius, -radius );
+				VectorSet( maxs, radius, radius, radius );
+			}
+		}
+	}
+	else
+	{
+		x = 8 * ( ent->solid & 31 );
+		zd = 8 * ( ( ent->solid>>5 ) & 31 );
+		zu = 8 * ( ( ent->solid>>10 ) & 63 ) - 32;
+
+		VectorSet( mins, -x, -x, -zd );
+		VectorSet( maxs, x, x, zu );
+		VectorCopy( ent->origin, out->origin );
+	}
+
+	for( i = 0; i < 3; i++ )
+	{
+		out->absmins[i] = out->origin[i] + mins[i] - TRACECACHE_EPSILON;
+		out->absmaxs[i] = out->origin[i] + maxs[i] + TRACECACHE_EPSILON;
+	}
+}
+
+/*
+* CG_TraceCache_InvalidateBox
+*/
+static void CG_TraceCache_InvalidateBox( int entNum, const vec3_t mins, const vec3_t maxs )
+{
+	int i;
+	tracecache_entry_t *entry;
+
+	for( i = 0, entry = cg_traceCache; i < TRACECACHE_SIZE; i++, entry++ )
+	{
+		if( !entry->valid )
+			continue;
+
+		// the entity wasn't clipped against by the trace (usually our own player)
+		if( entry->key.ignore == entNum )
+			continue;
+
+		if( BoundsIntersect( entry->absmins, entry->absmaxs, mins, maxs ) )
+		{
+			entry->valid = false;
+			cg_traceCacheInvalidated++;
+		}
+	}
+}
+
+/*
+* CG_TraceCache_UpdateEntities
+* 
+* Compares the new solid list to the previous one
+*/
+static void CG_TraceCache_UpdateEntities( void )
+{
+	int i;
+	tracecache_ent_t *old;
+	static tracecache_ent_t current[MAX_EDICTS];
+
+	memset( current, 0, sizeof( current ) );
+	for( i = 0; i < cg_numSolids; i++ )
+		CG_TraceCache_EntityState( cg_solidList[i], &current[cg_solidList[i]->number] );
+
+	for( i = 0, old = cg_traceCacheEnts; i < MAX_EDICTS; i++, old++ )
+	{
+		if( !old->solid && !current[i].solid )
+			continue;
+		if( !memcmp( old, &current[i], sizeof( *old ) ) )
+			continue;
+
+		if( old->solid )
+			CG_TraceCache_InvalidateBox( i, old->absmins, old->absmaxs );
+		if( current[i].solid )
+			CG_TraceCache_InvalidateBox( i, current[i].absmins, current[i].absmaxs );
+		*old = current[i];
+	}
+}
+
+/*
+* CG_TraceCache_Trace
+*/
+static bool CG_TraceCache_Trace( trace_t *t, const tracecache_key_t *key, unsigned hash )
+{
+	tracecache_entry_t *entry = &cg_traceCache[hash];
+
+	if( !entry->valid || memcmp( &entry->key, key, sizeof( *key ) ) )
+	{
+		cg_traceCacheMisses++;
+		return false;
+	}
+
+	cg_traceCacheHits++;
+	*t = entry->trace;
+	return true;
+}
+
+/*
+* CG_TraceCache_Store
+*/
+static void CG_TraceCache_Store( const trace_t *t, const tracecache_key_t *key, unsigned hash )
+{
+	int i;
+	tracecache_entry_t *entry = &cg_traceCache[hash];
+
+	entry->valid = true;
+	entry->key = *key;
+	entry->trace = *t;
+
+	for( i = 0; i < 3; i++ )
+	{
+		entry->absmins[i] = min( key->start[i], key->end[i] ) + key->mins[i];
+		entry->absmaxs[i] = max( key->start[i], key->end[i] ) + key->maxs[i];
+	}
+}
+
 /*
 * CG_PredictedEvent - shared code can fire events during prediction
 */
@@ -156,6 +386,8 @@ void CG_BuildSolidList( void )
 			}
 		}
 	}
+
+	CG_TraceCache_UpdateEntities();
 }
 
 /*
@@ -312,14 +544,36 @@ static void CG_ClipMoveToEntities( const vec3_t start, const vec3_t mins, const
 */
 void CG_Trace( trace_t *t, vec3_t start, vec3_t mins, vec3_t maxs, vec3_t end, int ignore, int contentmask )
 {
+	tracecache_key_t key;
+	unsigned hash = 0;
+
+	if( cg_traceCacheActive )
+	{
+		memset( &key, 0, sizeof( key ) );
+		VectorCopy( start, key.start );
+		VectorCopy( end, key.end );
+		if( mins )
+			VectorCopy( mins, key.mins );
+		if( maxs )
+			VectorCopy( maxs, key.maxs );
+		key.ignore = ignore;
+		key.contentmask = contentmask;
+
+		hash = CG_TraceCache_HashKey( &key );
+		if( CG_TraceCache_Trace( t, &key, hash ) )
+			return;
+	}
+
 	// check against world
 	trap_CM_TransformedBoxTrace( t, start, end, mins, maxs, NULL, contentmask, NULL, NULL );
 	t->ent = t->fraction < 1.0 ? 0 : -1; // world entity is 0
-	if( t->fraction == 0 )
-		return; // blocked by the world
 
-	// check all other solid models
-	CG_ClipMoveToEntities( start, mins, maxs, end, ignore, contentmask, t );
+	// check all other solid models, unless blocked by the world
+	if( t->fraction != 0 )
+		CG_ClipMoveToEntities( start, mins, maxs, end, ignore, contentmask, t );
+
+	if( cg_traceCacheActive )
+		CG_TraceCache_Store( t, &key, hash );
 }
 
 /*
@@ -457,6 +711,8 @@ void CG_PredictMovement( void )
 	// clear the triggered toggles for this prediction round
 	memset( &cg_triggersListTriggered, false, sizeof( cg_triggersListTriggered ) );
 
+	cg_traceCacheActive = cg_predict_tracecache->integer != 0;
+
 	// run frames
 	while( ++ucmdExecuted <= ucmdHead )
 	{
@@ -498,6 +754,8 @@ void CG_PredictMovement( void )
 		}
 	}
 
+	cg_traceCacheActive = false;
+
 	cg.predictedGroundEntity = pm.groundentity;
 
 	// compensate for ground entity movement
@@ -518,3 +776,124 @@ void CG_PredictMovement( void )
 
 	CG_PredictSmoothSteps();
 }
+
+/*
+* CG_PredictReplay
+* 
+* Runs the unacknowledged usercmds from the last snapshot again, without
+* firing events or touching the prediction state
+*/
+static int CG_PredictReplay( bool cached, vec3_t *origins, vec3_t *velocities, int *groundEntity )
+{
+	int ucmdExecuted, ucmdHead, numFrames;
+	bool oldUcmdReady = ucmdReady;
+	player_state_t playerState;
+	entity_state_t entityState;
+	pmove_t pm;
+
+	trap_NET_GetCurrentState( NULL, &ucmdHead, NULL );
+	ucmdExecuted = cg.frame.ucmdExecuted;
+	if( ucmdHead - ucmdExecuted >= CMD_BACKUP )
+		return 0;
+
+	playerState = cg.frame.playerState;
+	playerState.POVnum = cgs.playerNum + 1;
+	entityState = cg_entities[playerState.POVnum].current;
+
+	memset( &pm, 0, sizeof( pm ) );
+	pm.playerState = &playerState;
+
+	memset( &cg_triggersListTriggered, false, sizeof( cg_triggersListTriggered ) );
+
+	ucmdReady = false; // don't fire predicted events
+	cg_traceCacheActive = cached;
+
+	numFrames = 0;
+	while( ++ucmdExecuted <= ucmdHead )
+	{
+		trap_NET_GetUserCmd( ucmdExecuted & CMD_MASK, &pm.cmd );
+		Pmove( &pm );
+
+		VectorCopy( playerState.pmove.origin, origins[numFrames] );
+		VectorCopy( playerState.pmove.velocity, velocities[numFrames] );
+		groundEntity[numFrames] = pm.groundentity;
+		numFrames++;
+	}
+
+	cg_traceCacheActive = false;
+	ucmdReady = oldUcmdReady;
+	cg_entities[playerState.POVnum].current = entityState;
+
+	return numFrames;
+}
+
+/*
+* CG_PredictCheck_f
+* 
+* Replays the current prediction window with and without the trace cache
+* and verifies that both produce bit-identical results
+*/
+void CG_PredictCheck_f( void )
+{
+	int i, j, pass, numFrames = 0, iterations, passIterations;
+	int mismatches[3];
+	uint64_t start, usec[3];
+	unsigned hits[3], misses[3];
+	static vec3_t origins[3][CMD_BACKUP], velocities[3][CMD_BACKUP];
+	static int groundEntities[3][CMD_BACKUP];
+	const char *passNames[3] = { "uncached", "cold cache", "warm cache" };
+
+	if( !cg.view.playerPrediction )
+	{
+		CG_Printf( "Prediction is not active\n" );
+		return;
+	}
+
+	iterations = trap_Cmd_Argc() > 1 ? atoi( trap_Cmd_Argv( 1 ) ) : 1;
+	iterations = max( iterations, 1 );
+
+	for( pass = 0; pass < 3; pass++ )
+	{
+		// the cold pass starts from an empty cache, the warm one reuses it
+		passIterations = iterations;
+		if( pass == 1 )
+		{
+			CG_TraceCache_Clear();
+			passIterations = 1;
+		}
+
+		hits[pass] = cg_traceCacheHits;
+		misses[pass] = cg_traceCacheMisses;
+
+		start = trap_Microseconds();
+		for( i = 0; i < passIterations; i++ )
+			numFrames = CG_PredictReplay( pass != 0, origins[pass], velocities[pass], groundEntities[pass] );
+		usec[pass] = ( trap_Microseconds() - start ) / passIterations;
+
+		hits[pass] = cg_traceCacheHits - hits[pass];
+		misses[pass] = cg_traceCacheMisses - misses[pass];
+	}
+
+	for( pass = 1; pass < 3; pass++ )
+	{
+		mismatches[pass] = 0;
+		for( j = 0; j < numFrames; j++ )
+		{
+			if( memcmp( origins[pass][j], origins[0][j], sizeof( vec3_t ) ) 
+				|| memcmp( velocities[pass][j], velocities[0][j], sizeof( vec3_t ) )
+				|| groundEntities[pass][j] != groundEntities[0][j] )
+				mismatches[pass]++;
+		}
+	}
+
+	CG_Printf( "Replayed %i usercmds, %i iterations\n", numFrames, iterations );
+	for( pass = 0; pass < 3; pass++ )
+	{
+		CG_Printf( "%-10s: %8.3f ms per replay", passNames[pass], usec[pass] / 1000.0 );
+		if( pass )
+			CG_Printf( ", %u hits, %u misses, %s", hits[pass], misses[pass], 
+				mismatches[pass] ? va( S_COLOR_RED "%i mismatches" S_COLOR_WHITE, mismatches[pass] ) : "identical" );
+		CG_Printf( "\n" );
+	}
+	CG_Printf( "%u entries invalidated by moving entities so far\n", cg_traceCacheInvalidated );
+}
@@ -43,7 +43,7 @@ typedef void ( *fdrawchar_t )( int x, int y, int w, int h, float s1, float t1, f
 
 // cg_public.h -- client game dll information visible to engine
 
-#define	CGAME_API_VERSION   98
+#define	CGAME_API_VERSION   101
 
 //
 // structs and variables shared with the main engine
@@ -146,6 +146,7 @@ typedef struct
 
 	void ( *GetConfigString )( int i, char *str, int size );
 	unsigned int ( *Milliseconds )( void );
+	uint64_t ( *Microseconds )( void );
 	bool ( *DownloadRequest )( const char *filename, bool requestpak );
 
 	unsigned int (* Hash_BlockChecksum )( const uint8_t * data, size_t len );
@@ -156,6 +157,12 @@ typedef struct
 	void ( *NET_GetCurrentState )( int *incomingAcknowledged, int *outgoingSequence, int *outgoingSent );
 	void ( *RefreshMouseAngles )( void );
 
+	// job scheduler, worker 0 is shared by all threads outside the pool
+	qjobhandle_t ( *Jobs_Add )( qjobfunc_t func, void *arg, const qjobhandle_t *deps, int numDeps );
+	void ( *Jobs_Wait )( qjobhandle_t job );
+	void ( *Jobs_ParallelFor )( unsigned int count, unsigned int granularity, qjobrangefunc_t func, void *arg );
+	int ( *Jobs_NumWorkers )( void );
+
 	// Asynchronous HTTP requests
 	void ( *AsyncStream_UrlEncode )( const char *src, char *dst, size_t size );
 	size_t ( *AsyncStream_UrlDecode )( const char *src, char *dst, size_t size );
@@ -166,6 +173,8 @@ typedef struct
 	// refresh system
 	void ( *R_UpdateScreen )( void );
 	int ( *R_GetClippedFragments )( const vec3_t origin, float radius, vec3_t axis[3], int maxfverts, vec4_t *fverts, int maxfragments, struct fragment_s *fragments );
+	unsigned int ( *R_QueueClippedFragments )( const vec3_t origin, float radius, vec3_t axis[3] );
+	int ( *R_GetQueuedFragments )( unsigned int ticket, int maxfverts, vec4_t *fverts, int maxfragments, struct fragment_s *fragments );
 	void ( *R_ClearScene )( void );
 	void ( *R_AddEntityToScene )( const struct entity_s *ent );
 	void ( *R_AddLightToScene )( const vec3_t org, float intensity, float r, float g, float b );
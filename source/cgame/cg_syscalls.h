@@ -242,6 +242,11 @@ static inline unsigned int trap_Milliseconds( void )
 	return CGAME_IMPORT.Milliseconds();
 }
 
+static inline uint64_t trap_Microseconds( void )
+{
+	return CGAME_IMPORT.Microseconds();
+}
+
 static inline bool trap_DownloadRequest( const char *filename, bool requestpak )
 {
 	return CGAME_IMPORT.DownloadRequest( filename, requestpak == true ? true : false ) == true;
@@ -267,6 +272,26 @@ static inline void trap_RefreshMouseAngles( void )
 	CGAME_IMPORT.RefreshMouseAngles();
 }
 
+static inline qjobhandle_t trap_Jobs_Add( qjobfunc_t func, void *arg, const qjobhandle_t *deps, int numDeps )
+{
+	return CGAME_IMPORT.Jobs_Add( func, arg, deps, numDeps );
+}
+
+static inline void trap_Jobs_Wait( qjobhandle_t job )
+{
+	CGAME_IMPORT.Jobs_Wait( job );
+}
+
+static inline void trap_Jobs_ParallelFor( unsigned int count, unsigned int granularity, qjobrangefunc_t func, void *arg )
+{
+	CGAME_IMPORT.Jobs_ParallelFor( count, granularity, func, arg );
+}
+
+static inline int trap_Jobs_NumWorkers( void )
+{
+	return CGAME_IMPORT.Jobs_NumWorkers();
+}
+
 static inline void trap_R_UpdateScreen( void )
 {
 	CGAME_IMPORT.R_UpdateScreen();
@@ -279,6 +304,17 @@ static inline int trap_R_GetClippedFragments( const vec3_t origin, float radius,
 		maxfverts, fverts, maxfragments, fragments );
 }
 
+static inline unsigned int trap_R_QueueClippedFragments( const vec3_t origin, float radius, vec3_t axis[3] )
+{
+	return CGAME_IMPORT.R_QueueClippedFragments( origin, radius, axis );
+}
+
+static inline int trap_R_GetQueuedFragments( unsigned int ticket, int maxfverts, vec4_t *fverts, 
+	int maxfragments, fragment_t *fragments )
+{
+	return CGAME_IMPORT.R_GetQueuedFragments( ticket, maxfverts, fverts, maxfragments, fragments );
+}
+
 static inline struct shader_s *trap_R_GetShaderForOrigin( const vec3_t origin ) {
 	return CGAME_IMPORT.R_GetShaderForOrigin( origin );
 }
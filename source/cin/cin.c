@@ -29,6 +29,7 @@ CINEMATICS PLAYBACK ABSTRACTION LAYER
 #include "cin_local.h"
 #include "cin_theora.h"
 #include "cin_roq.h"
+#include "../gameshared/q_simd.h"
 
 enum
 {
@@ -472,3 +473,150 @@ void CIN_Close( cinematics_t *cin )
 	CIN_Free( cin );
 	CIN_FreePool( &mempool );
 }
+
+/*
+=======================================================================
+
+DECODING BENCHMARK
+
+=======================================================================
+*/
+
+#define CIN_BENCH_STALL_MSEC	10000
+
+/*
+* CIN_BenchFile
+*
+* Decodes the cinematic as fast as possible by feeding it a fake clock and
+* converts every frame to RGB with both the C and the SIMD code.
+*/
+static void CIN_BenchFile( const char *name, int maxFrames )
+{
+	int i, frames = 0, mismatches = 0;
+	int width, height;
+	bool yuv, redraw;
+	float framerate;
+	unsigned int t, lastFrameTime;
+	uint64_t t0, decodeUsec = 0, convertUsec[2] = { 0, 0 };
+	size_t size, rgbSize = 0;
+	uint8_t *rgb[2] = { NULL, NULL };
+	cin_yuv_t *cyuv;
+	cinematics_t *cin;
+
+	cin = CIN_Open( name, 0, CIN_NOAUDIO, &yuv, &framerate );
+	if( !cin ) {
+		Com_Printf( "Couldn't open %s\n", name );
+		return;
+	}
+	if( !yuv ) {
+		Com_Printf( "%s: not a YCbCr cinematic, skipped\n", name );
+		CIN_Close( cin );
+		return;
+	}
+
+	t = lastFrameTime = cin->start_time;
+	while( frames < maxFrames && t - lastFrameTime < CIN_BENCH_STALL_MSEC ) {
+		t++;
+		if( !CIN_NeedNextFrame( cin, t ) ) {
+			continue;
+		}
+
+		redraw = false;
+		t0 = trap_Microseconds();
+		cyuv = CIN_ReadNextFrameYUV( cin, &width, &height, NULL, NULL, &redraw );
+		decodeUsec += trap_Microseconds() - t0;
+
+		if( !cyuv ) {
+			break;
+		}
+		if( !redraw ) {
+			continue;
+		}
+
+		lastFrameTime = t;
+		frames++;
+
+		size = cyuv->width * cyuv->height * 3;
+		if( size > rgbSize ) {
+			for( i = 0; i < 2; i++ ) {
+				if( rgb[i] ) {
+					CIN_Free( rgb[i] );
+				}
+				rgb[i] = CIN_Alloc( cinPool, size );
+			}
+			rgbSize = size;
+		}
+
+		for( i = 0; i < 2; i++ ) {
+			t0 = trap_Microseconds();
+			CIN_YCbCrToRGB_( cyuv, 3, rgb[i], i == 1 );
+			convertUsec[i] += trap_Microseconds() - t0;
+		}
+
+		if( memcmp( rgb[0], rgb[1], size ) ) {
+			mismatches++;
+		}
+	}
+
+	if( frames ) {
+		Com_Printf( "%s: %i frames at %ix%i, decode %.3f ms/frame, YCbCr to RGB C %.3f ms, %s %.3f ms (%.2fx), %i mismatches\n",
+			name, frames, width, height, decodeUsec / 1000.0 / frames, 
+			convertUsec[0] / 1000.0 / frames, QSIMD_NAME, convertUsec[1] / 1000.0 / frames,
+			convertUsec[1] ? (double)convertUsec[0] / convertUsec[1] : 0.0, mismatches );
+	} else {
+		Com_Printf( "%s: no frames decoded\n", name );
+	}
+
+	for( i = 0; i < 2; i++ ) {
+		if( rgb[i] ) {
+			CIN_Free( rgb[i] );
+		}
+	}
+
+	CIN_Close( cin );
+}
+
+/*
+* CIN_Bench_f
+*
+* cinbench [name] [frames]: with no name every cinematic in video/ is benchmarked
+*/
+void CIN_Bench_f( void )
+{
+	int i, j, numFiles, maxFrames;
+	size_t len;
+	const char *ext;
+	char *file, filelist[4096];
+	char extension[16], name[MAX_QPATH];
+
+	maxFrames = trap_Cmd_Argc() > 2 ? atoi( trap_Cmd_Argv( 2 ) ) : INT_MAX;
+	if( maxFrames <= 0 ) {
+		maxFrames = INT_MAX;
+	}
+
+	if( trap_Cmd_Argc() > 1 && *trap_Cmd_Argv( 1 ) ) {
+		Q_strncpyz( name, trap_Cmd_Argv( 1 ), sizeof( name ) );
+		CIN_BenchFile( name, maxFrames );
+		return;
+	}
+
+	// CIN_Open tokenizes with strtok, so split the extension lists by hand
+	for( i = 0; i < CIN_NUM_TYPES; i++ ) {
+		for( ext = cin_types[i].extensions; *ext; ext += len ) {
+			while( *ext == ' ' ) {
+				ext++;
+			}
+			len = strcspn( ext, " " );
+			if( !len ) {
+				break;
+			}
+			Q_strncpyz( extension, ext, min( len + 1, sizeof( extension ) ) );
+
+			numFiles = trap_FS_GetFileList( "video", extension, filelist, sizeof( filelist ), 0, 0 );
+			for( j = 0, file = filelist; j < numFiles && *file; j++, file += strlen( file ) + 1 ) {
+				Q_snprintfz( name, sizeof( name ), "video/%s", file );
+				CIN_BenchFile( name, maxFrames );
+			}
+		}
+	}
+}
@@ -82,6 +82,10 @@ typedef struct cinematics_s
 	struct mempool_s *mempool;
 } cinematics_t;
 
+extern struct mempool_s *cinPool;
+
+extern cvar_t *cin_simd;
+
 void Com_DPrintf( const char *format, ... );
 
 int CIN_API( void );
@@ -118,4 +122,13 @@ void CIN_Reset( cinematics_t *cin, unsigned int cur_time );
 
 void CIN_Close( cinematics_t *cin );
 
+void CIN_Bench_f( void );
+
+//
+// cin_yuv.c
+//
+void CIN_InitYCbCr( void );
+void CIN_YCbCrToRGB_( const cin_yuv_t *cyuv, int bytes, uint8_t *out, bool simd );
+void CIN_YCbCrToRGB( const cin_yuv_t *cyuv, int bytes, uint8_t *out );
+
 #endif
@@ -23,6 +23,8 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 
 struct mempool_s *cinPool;
 
+cvar_t *cin_simd;
+
 /*
 * CIN_API
 */
@@ -38,8 +40,14 @@ bool CIN_Init( bool verbose )
 {
 	cinPool = CIN_AllocPool( "Generic pool" );
 
+	cin_simd = trap_Cvar_Get( "cin_simd", "1", CVAR_ARCHIVE );
+
+	CIN_InitYCbCr();
+
 	Theora_LoadTheoraLibraries();
 
+	trap_Cmd_AddCommand( "cinbench", CIN_Bench_f );
+
 	return true;
 }
 
@@ -48,6 +56,8 @@ bool CIN_Init( bool verbose )
 */
 void CIN_Shutdown( bool verbose )
 {
+	trap_Cmd_RemoveCommand( "cinbench" );
+
 	Theora_UnloadTheoraLibraries();
 
 	CIN_FreePool( &cinPool );
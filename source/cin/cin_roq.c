@@ -32,10 +32,18 @@ Based on work by Dr. Tim Ferguson: http://www.csse.monash.edu.au/~timf/
 #include "cin_roq.h"
 #include "roq.h"
 
+// codebook cell scaled up to 4x4, built once per codebook instead of per block
+typedef struct
+{
+	uint8_t			y[2][4];		// rows 0-1 and 2-3
+	uint8_t			u[2], v[2];		// both chroma rows
+} roq_cell4x4_t;
+
 typedef struct
 {
 	roq_chunk_t		chunk;
 	roq_cell_t		cells[256];
+	roq_cell4x4_t	cells4x4[256];
 	roq_qcell_t		qcells[256];
 
 	int				width_2;
@@ -165,7 +173,7 @@ static void RoQ_ReadInfo( cinematics_t *cin )
 */
 static void RoQ_ReadCodebook( cinematics_t *cin )
 {
-	unsigned int nv1, nv2;
+	unsigned int i, nv1, nv2;
 	roq_info_t *roq = cin->fdata;
 	roq_chunk_t *chunk = &roq->chunk;
 
@@ -179,6 +187,18 @@ static void RoQ_ReadCodebook( cinematics_t *cin )
 
 	trap_FS_Read( roq->cells, sizeof( roq_cell_t )*nv1, cin->file );
 	trap_FS_Read( roq->qcells, sizeof( roq_qcell_t )*nv2, cin->file );
+
+	for( i = 0; i < nv1; i++ ) {
+		const roq_cell_t *cell = roq->cells + i;
+		roq_cell4x4_t *cell4x4 = roq->cells4x4 + i;
+
+		cell4x4->y[0][0] = cell4x4->y[0][1] = cell->y[0];
+		cell4x4->y[0][2] = cell4x4->y[0][3] = cell->y[1];
+		cell4x4->y[1][0] = cell4x4->y[1][1] = cell->y[2];
+		cell4x4->y[1][2] = cell4x4->y[1][3] = cell->y[3];
+		cell4x4->u[0] = cell4x4->u[1] = cell->u;
+		cell4x4->v[0] = cell4x4->v[1] = cell->v;
+	}
 }
 
 /*
@@ -216,11 +236,10 @@ static void RoQ_ApplyVector2x2( cinematics_t *cin, int xpos, int ypos, const roq
 /*
 * RoQ_ApplyVector4x4
 */
-static void RoQ_ApplyVector4x4( cinematics_t *cin, int xpos, int ypos, const roq_cell_t *cell )
+static void RoQ_ApplyVector4x4( cinematics_t *cin, int xpos, int ypos, const roq_cell4x4_t *cell )
 {
 	uint8_t *dst_y0, *dst_y1;
 	uint8_t *dst_u0, *dst_v0;
-	uint8_t p[4], u[2], v[2];
 	roq_info_t *roq = cin->fdata;
 	cin_img_plane_t *y_plane, *u_plane, *v_plane;
 	int xpos_2 = xpos / 2, ypos_2 = ypos / 2;
@@ -230,18 +249,14 @@ static void RoQ_ApplyVector4x4( cinematics_t *cin, int xpos, int ypos, const roq
 	dst_y0 = y_plane->data + ypos * y_plane->stride + xpos;
 	dst_y1 = dst_y0 + y_plane->stride;
 
-	p[0] = p[1] = cell->y[0];
-	p[2] = p[3] = cell->y[1];
-	*(int *)dst_y0 = *(int *)p;
-	*(int *)dst_y1 = *(int *)p;
+	memcpy( dst_y0, cell->y[0], 4 );
+	memcpy( dst_y1, cell->y[0], 4 );
 
 	dst_y0 += y_plane->stride * 2;
 	dst_y1 += y_plane->stride * 2;
 
-	p[0] = p[1] = cell->y[2];
-	p[2] = p[3] = cell->y[3];
-	*(int *)dst_y0 = *(int *)p;
-	*(int *)dst_y1 = *(int *)p;
+	memcpy( dst_y0, cell->y[1], 4 );
+	memcpy( dst_y1, cell->y[1], 4 );
 
 	// U
 	u_plane = &roq->cyuv[0].yuv[1];
@@ -251,17 +266,14 @@ static void RoQ_ApplyVector4x4( cinematics_t *cin, int xpos, int ypos, const roq
 	v_plane = &roq->cyuv[0].yuv[2];
 	dst_v0 = v_plane->data + ypos_2 * v_plane->stride + xpos_2;
 
-	u[0] = u[1] = cell->u;
-	v[0] = v[1] = cell->v;
-
-	*(short *)dst_u0 = *(short *)u;
-	*(short *)dst_v0 = *(short *)v;
+	memcpy( dst_u0, cell->u, 2 );
+	memcpy( dst_v0, cell->v, 2 );
 
 	dst_u0 += u_plane->stride;
 	dst_v0 += v_plane->stride;
 
-	*(short *)dst_u0 = *(short *)u;
-	*(short *)dst_v0 = *(short *)v;
+	memcpy( dst_u0, cell->u, 2 );
+	memcpy( dst_v0, cell->v, 2 );
 }
 
 /*
@@ -291,7 +303,7 @@ static void RoQ_ApplyMotion4x4( cinematics_t *cin, int xpos, int ypos, uint8_t m
 	dst = plane->data  + ( ypos *  plane->stride  + xpos );
 	src = plane1->data + ( ypos1 * plane1->stride + xpos1 );
 	for( j = 0; j < 4; j++ ) {
-		*(int *)dst = *(int *)src;
+		memcpy( dst, src, 4 );
 		src += plane1->stride;
 		dst += plane->stride;
 	}
@@ -303,7 +315,7 @@ static void RoQ_ApplyMotion4x4( cinematics_t *cin, int xpos, int ypos, uint8_t m
 		dst = plane->data  + ( ypos_2 *  plane->stride  + xpos_2 );
 		src = plane1->data + ( ypos1_2 * plane1->stride + xpos1_2 );
 		for( j = 0; j < 2; j++ ) {
-			*(short *)dst = *(short *)src;
+			memcpy( dst, src, 2 );
 			src += plane1->stride;
 			dst += plane->stride;
 		}
@@ -349,7 +361,7 @@ static void RoQ_ApplyMotion8x8( cinematics_t *cin, int xpos, int ypos, uint8_t m
 		dst = plane->data  + ( ypos_2 *  plane->stride  + xpos_2 );
 		src = plane1->data + ( ypos1_2 * plane1->stride + xpos1_2 );
 		for( j = 0; j < 4; j++ ) {
-			*(int *)dst = *(int *)src;
+			memcpy( dst, src, 4 );
 			src += plane1->stride;
 			dst += plane->stride;
 		}
@@ -404,10 +416,10 @@ static cin_yuv_t *RoQ_ReadVideo( cinematics_t *cin )
 				case RoQ_ID_SLD:
 					RoQ_ReadByte( c );
 					qcell = roq->qcells + c;
-					RoQ_ApplyVector4x4( cin, xp, yp, roq->cells + qcell->idx[0] );
-					RoQ_ApplyVector4x4( cin, xp+4, yp, roq->cells + qcell->idx[1] );
-					RoQ_ApplyVector4x4( cin, xp, yp+4, roq->cells + qcell->idx[2] );
-					RoQ_ApplyVector4x4( cin, xp+4, yp+4, roq->cells + qcell->idx[3] );
+					RoQ_ApplyVector4x4( cin, xp, yp, roq->cells4x4 + qcell->idx[0] );
+					RoQ_ApplyVector4x4( cin, xp+4, yp, roq->cells4x4 + qcell->idx[1] );
+					RoQ_ApplyVector4x4( cin, xp, yp+4, roq->cells4x4 + qcell->idx[2] );
+					RoQ_ApplyVector4x4( cin, xp+4, yp+4, roq->cells4x4 + qcell->idx[3] );
 					break;
 
 				case RoQ_ID_CCC:
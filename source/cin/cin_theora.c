@@ -706,234 +706,6 @@ static bool Theora_ReadNextFrame_CIN_( cinematics_t *cin, bool *redraw, bool *eo
 
 #ifdef THEORA_SOFTWARE_YUV2RGB
 
-// taken from http://www.gamedev.ru/code/articles/?id=4252&page=3
-#define Theora_InitYCbCrTable() \
-	int cc = 0; \
-	int b0_[256], b1_[256], b2_[256], b3_[256]; \
- \
-	for( cc = 0; cc < 256; cc++ ) \
-		b0_[cc] = ( 113443 * (cc-128) + 32768 ) >> 16; \
-	for( cc = 0; cc < 256; cc++ ) \
-		b1_[cc] = (  45744 * (cc-128) + 32768 ) >> 16; \
-	for( cc = 0; cc < 256; cc++ ) \
-		b2_[cc] = (  22020 * (cc-128) + 32768 ) >> 16; \
-	for( cc = 0; cc < 256; cc++ ) \
-		b3_[cc] = ( 113508 * (cc-128) + 32768 ) >> 16; \
-
-/*
-* Theora_DecodeYCbCr2RGB_420
-*/
-static void Theora_DecodeYCbCr2RGB_420( cin_yuv_t *cyuv, int bytes, uint8_t *out )
-{
-	int 
-		x_offset = cyuv->x_offset, 
-		y_offset = cyuv->y_offset; 
-	unsigned int 
-		width = cyuv->width, 
-		height = cyuv->height;
-	int 
-		yStride = cyuv->yuv[0].stride,
-		uStride = cyuv->yuv[1].stride,
-		vStride = cyuv->yuv[2].stride,
-		outStride = width * bytes;
-	uint8_t 
-		*yData = cyuv->yuv[0].data + (x_offset     ) + yStride * (y_offset     ), 
-		*uData = cyuv->yuv[1].data + (x_offset >> 1) + uStride * (y_offset >> 1),
-		*vData = cyuv->yuv[2].data + (x_offset >> 1) + vStride * (y_offset >> 1);
-	uint8_t
-		*yRow  = yData,
-		*yRow2 = yData + yStride,
-		*uRow  = uData,
-		*vRow  = vData;
-	uint8_t
-		*oRow  = out,
-		*oRow2 = out + outStride;
-	unsigned int xPos, yPos;
-	int y = 0, u = 0, v = 0, c[3];
-
-	Theora_InitYCbCrTable();
-
-	yStride += yStride - width;
-	uStride += 0 - (width >> 1);
-	vStride += 0 - (width >> 1);
-	outStride += outStride - width * bytes;
- 
-	for( yPos = 1; yPos <= height; yPos += 2 ) {
-		for( xPos = 1; xPos <= width; xPos++ ) {
-			u = *uRow;
-			v = *vRow;
-
-			y = *yRow++;
-			VectorSet( c, y + b0_[v], y - b1_[v] - b2_[u], y + b3_[u] );
-			oRow[0] = bound( 0, c[0], 255 );
-			oRow[1] = bound( 0, c[1], 255 );
-			oRow[2] = bound( 0, c[2], 255 );
-			oRow   += bytes;
-
-			y = *yRow2++;
-			VectorSet( c, y + b0_[v], y - b1_[v] - b2_[u], y + b3_[u] );
-			oRow2[0] = bound( 0, c[0], 255 );
-			oRow2[1] = bound( 0, c[1], 255 );
-			oRow2[2] = bound( 0, c[2], 255 );
-			oRow2   += bytes;
-
-			if( ( xPos & 1 ) != 0 ) {
-				uRow++;
-				vRow++; 
-			}
-		}
-
-		yRow  += yStride;
-		yRow2 += yStride;
-		uRow  += uStride;
-		vRow  += vStride;
-
-		oRow  += outStride;
-		oRow2 += outStride;
-	}
-}
-
-/*
-* Theora_DecodeYCbCr2RGB_422
-*/
-static void Theora_DecodeYCbCr2RGB_422( cin_yuv_t *cyuv, int bytes, uint8_t *out )
-{
-	int 
-		x_offset = cyuv->x_offset, 
-		y_offset = cyuv->y_offset; 
-	unsigned int 
-		width = cyuv->width, 
-		height = cyuv->height;
-	int 
-		yStride = cyuv->yuv[0].stride,
-		uStride = cyuv->yuv[1].stride,
-		vStride = cyuv->yuv[2].stride,
-		outStride = width * bytes;
-	uint8_t 
-		*yData = cyuv->yuv[0].data + (x_offset     ) + yStride * (y_offset), 
-		*uData = cyuv->yuv[1].data + (x_offset >> 1) + uStride * (y_offset),
-		*vData = cyuv->yuv[2].data + (x_offset >> 1) + vStride * (y_offset);
-	uint8_t
-		*yRow  = yData,
-		*uRow  = uData,
-		*vRow  = vData;
-	uint8_t
-		*oRow  = out;
-	unsigned int xPos, yPos;
-	int y = 0, u = 0, v = 0, c[3];
-
-	Theora_InitYCbCrTable();
-
-	yStride -= width;
-	uStride -= width / 2;
-	vStride -= width / 2;
-	outStride -= width * bytes;
- 
-	for( yPos = 1; yPos <= height; yPos++ ) {
-		for( xPos = 1; xPos <= width; xPos += 2 ) {
-			u = *uRow++;
-			v = *vRow++;
-
-			y = *yRow++;
-			VectorSet( c, y + b0_[v], y - b1_[v] - b2_[u], y + b3_[u] );
-			oRow[0] = bound( 0, c[0], 255 );
-			oRow[1] = bound( 0, c[1], 255 );
-			oRow[2] = bound( 0, c[2], 255 );
-			oRow   += bytes;
-
-			y = *yRow++;
-			VectorSet( c, y + b0_[v], y - b1_[v] - b2_[u], y + b3_[u] );
-			oRow[0] = bound( 0, c[0], 255 );
-			oRow[1] = bound( 0, c[1], 255 );
-			oRow[2] = bound( 0, c[2], 255 );
-			oRow   += bytes;
-		}
-
-		yRow  += yStride;
-		uRow  += uStride;
-		vRow  += vStride;
-
-		oRow  += outStride;
-	}
-}
-
-/*
-* Theora_DecodeYCbCr2RGB_444
-*/
-static void Theora_DecodeYCbCr2RGB_444( cin_yuv_t *cyuv, int bytes, uint8_t *out )
-{
-	int 
-		x_offset = cyuv->x_offset, 
-		y_offset = cyuv->y_offset; 
-	unsigned int 
-		width = cyuv->width, 
-		height = cyuv->height;
-	int 
-		yStride = cyuv->yuv[0].stride,
-		uStride = cyuv->yuv[1].stride,
-		vStride = cyuv->yuv[2].stride,
-		outStride = width * bytes;
-	uint8_t 
-		*yData = cyuv->yuv[0].data + x_offset + yStride * y_offset, 
-		*uData = cyuv->yuv[1].data + x_offset + uStride * y_offset,
-		*vData = cyuv->yuv[2].data + x_offset + vStride * y_offset;
-	uint8_t
-		*yRow  = yData,
-		*uRow  = uData,
-		*vRow  = vData;
-	uint8_t
-		*oRow  = out;
-	unsigned int xPos, yPos;
-	int y = 0, u = 0, v = 0, c[3];
-
-	Theora_InitYCbCrTable();
-
-	yStride -= width;
-	uStride -= width;
-	vStride -= width;
-	outStride -= width * bytes;
- 
-	for( yPos = 1; yPos <= height; yPos++ ) {
-		for( xPos = 1; xPos <= width; xPos++ ) {
-			u = *uRow++;
-			v = *vRow++;
-			y = *yRow++;
-
-			VectorSet( c, y + b0_[v], y - b1_[v] - b2_[u], y + b3_[u] );
-			oRow[0] = bound( 0, c[0], 255 );
-			oRow[1] = bound( 0, c[1], 255 );
-			oRow[2] = bound( 0, c[2], 255 );
-			oRow   += bytes;
-		}
-
-		yRow  += yStride;
-		uRow  += uStride;
-		vRow  += vStride;
-
-		oRow  += outStride;
-	}
-}
-
-/*
-* Theora_DecodeYCbCr2RGB
-*/
-static void Theora_DecodeYCbCr2RGB( th_pixel_fmt pfmt, cin_yuv_t *cyuv, int bytes, uint8_t *out )
-{
-	switch( pfmt ) {
-		case TH_PF_444:
-			Theora_DecodeYCbCr2RGB_444( cyuv, bytes, out );
-			break;
-		case TH_PF_422:
-			Theora_DecodeYCbCr2RGB_422( cyuv, bytes, out );
-			break;
-		case TH_PF_420:
-			Theora_DecodeYCbCr2RGB_420( cyuv, bytes, out );
-			break;
-		default:
-			break;
-	}
-}
-
 /*
 * Theora_ReadNextFrame_CIN
 */
@@ -949,8 +721,8 @@ uint8_t *Theora_ReadNextFrame_CIN( cinematics_t *cin, bool *redraw )
 	}
 
 	if( haveVideo ) {
-		// convert YCbCr to RGB	
-		Theora_DecodeYCbCr2RGB( qth->ti.pixel_fmt, &qth->pub_yuv, 3, cin->vid_buffer );
+		// convert YCbCr to RGB
+		CIN_YCbCrToRGB( &qth->pub_yuv, 3, cin->vid_buffer );
 	}
 
 	return cin->vid_buffer;
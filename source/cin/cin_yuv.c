@@ -0,0 +1,227 @@
+/*
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+*/
+
+// cin_yuv.c: software YCbCr to RGB conversion for 4:2:0, 4:2:2 and 4:4:4 frames
+
+#include "cin_local.h"
+#include "../gameshared/q_simd.h"
+
+// taken from http://www.gamedev.ru/code/articles/?id=4252&page=3
+#define YCBCR_RV	113443
+#define YCBCR_GV	45744
+#define YCBCR_GU	22020
+#define YCBCR_BU	113508
+
+#define YCBCR_TERM( k, c )	( ( ( k ) * ( ( c ) - 128 ) + 32768 ) >> 16 )
+
+static int ycbcr_rv[256], ycbcr_gv[256], ycbcr_gu[256], ycbcr_bu[256];
+
+typedef void ( *cin_ycbcrrowfunc_t )( const uint8_t *y, const uint8_t *u, const uint8_t *v,
+	int hshift, int hround, unsigned int width, int bytes, uint8_t *out );
+
+/*
+* CIN_InitYCbCr
+*/
+void CIN_InitYCbCr( void )
+{
+	int c;
+
+	for( c = 0; c < 256; c++ ) {
+		ycbcr_rv[c] = YCBCR_TERM( YCBCR_RV, c );
+		ycbcr_gv[c] = YCBCR_TERM( YCBCR_GV, c );
+		ycbcr_gu[c] = YCBCR_TERM( YCBCR_GU, c );
+		ycbcr_bu[c] = YCBCR_TERM( YCBCR_BU, c );
+	}
+}
+
+/*
+* CIN_YCbCrToRGBRow_C
+*
+* hshift is 1 for horizontally subsampled chroma and 0 otherwise. Pixel x
+* uses chroma sample ( x + hround ) >> hshift.
+*/
+static void CIN_YCbCrToRGBRow_C( const uint8_t *y, const uint8_t *u, const uint8_t *v,
+	int hshift, int hround, unsigned int width, int bytes, uint8_t *out )
+{
+	unsigned int x;
+	int yy, cu, cv, c[3];
+
+	for( x = 0; x < width; x++, out += bytes ) {
+		cu = u[( x + hround ) >> hshift];
+		cv = v[( x + hround ) >> hshift];
+		yy = y[x];
+
+		VectorSet( c, yy + ycbcr_rv[cv], yy - ycbcr_gv[cv] - ycbcr_gu[cu], yy + ycbcr_bu[cu] );
+		out[0] = bound( 0, c[0], 255 );
+		out[1] = bound( 0, c[1], 255 );
+		out[2] = bound( 0, c[2], 255 );
+	}
+}
+
+#if defined( QSIMD_SSE2 ) || defined( QSIMD_NEON )
+
+/*
+* CIN_YCbCrTerm_SIMD
+*
+* Same rounding as YCBCR_TERM for four chroma samples in 32-bit lanes
+*/
+static inline qiv_t CIN_YCbCrTerm_SIMD( qiv_t c, int k )
+{
+	c = qiv_sub32( c, qiv_splat_u32( 128 ) );
+	c = qiv_mullo32( c, qiv_splat_u32( k ) );
+	return qiv_sra32( qiv_add32( c, qiv_splat_u32( 32768 ) ), 16 );
+}
+
+/*
+* CIN_YCbCrToRGBRow_SIMD
+*
+* Converts 8 pixels per iteration, the remainder goes through the C version.
+* For subsampled formats the chroma terms are computed once per chroma
+* sample, even pixels take them from the samples at x / 2 and odd pixels
+* from the ones at ( x + 2 * hround ) / 2.
+*/
+static void CIN_YCbCrToRGBRow_SIMD( const uint8_t *y, const uint8_t *u, const uint8_t *v,
+	int hshift, int hround, unsigned int width, int bytes, uint8_t *out )
+{
+	unsigned int x, i;
+	uint32_t u4, v4;
+	qiv_t y16, ylo, yhi, ulo, uhi, vlo, vhi;
+	qiv_t te[3], to[3];
+	qiv_t rv[2], gc[2], bu[2], r, g, b;
+	uint8_t rg[16], bb[16];
+
+	for( x = 0; x + 8 <= width; x += 8, out += bytes * 8 ) {
+		y16 = qiv_zext8lo( qiv_loadl( y + x ) );
+		ylo = qiv_zext16lo( y16 );
+		yhi = qiv_zext16hi( y16 );
+
+		if( hshift ) {
+			// 4 chroma samples for the even pixels, don't read past them
+			memcpy( &u4, u + ( x >> 1 ), 4 );
+			memcpy( &v4, v + ( x >> 1 ), 4 );
+			ulo = qiv_zext16lo( qiv_zext8lo( qiv_set_u32( u4, 0, 0, 0 ) ) );
+			vlo = qiv_zext16lo( qiv_zext8lo( qiv_set_u32( v4, 0, 0, 0 ) ) );
+
+			te[0] = CIN_YCbCrTerm_SIMD( vlo, YCBCR_RV );
+			te[1] = qiv_add32( CIN_YCbCrTerm_SIMD( vlo, YCBCR_GV ), CIN_YCbCrTerm_SIMD( ulo, YCBCR_GU ) );
+			te[2] = CIN_YCbCrTerm_SIMD( ulo, YCBCR_BU );
+
+			if( hround ) {
+				// odd pixels are one chroma sample ahead
+				memcpy( &u4, u + ( x >> 1 ) + 1, 4 );
+				memcpy( &v4, v + ( x >> 1 ) + 1, 4 );
+				ulo = qiv_zext16lo( qiv_zext8lo( qiv_set_u32( u4, 0, 0, 0 ) ) );
+				vlo = qiv_zext16lo( qiv_zext8lo( qiv_set_u32( v4, 0, 0, 0 ) ) );
+
+				to[0] = CIN_YCbCrTerm_SIMD( vlo, YCBCR_RV );
+				to[1] = qiv_add32( CIN_YCbCrTerm_SIMD( vlo, YCBCR_GV ), CIN_YCbCrTerm_SIMD( ulo, YCBCR_GU ) );
+				to[2] = CIN_YCbCrTerm_SIMD( ulo, YCBCR_BU );
+			} else {
+				to[0] = te[0];
+				to[1] = te[1];
+				to[2] = te[2];
+			}
+
+			rv[0] = qiv_zip32lo( te[0], to[0] );
+			rv[1] = qiv_zip32hi( te[0], to[0] );
+			gc[0] = qiv_zip32lo( te[1], to[1] );
+			gc[1] = qiv_zip32hi( te[1], to[1] );
+			bu[0] = qiv_zip32lo( te[2], to[2] );
+			bu[1] = qiv_zip32hi( te[2], to[2] );
+		} else {
+			qiv_t u16 = qiv_zext8lo( qiv_loadl( u + x ) );
+			qiv_t v16 = qiv_zext8lo( qiv_loadl( v + x ) );
+
+			ulo = qiv_zext16lo( u16 );
+			uhi = qiv_zext16hi( u16 );
+			vlo = qiv_zext16lo( v16 );
+			vhi = qiv_zext16hi( v16 );
+
+			rv[0] = CIN_YCbCrTerm_SIMD( vlo, YCBCR_RV );
+			rv[1] = CIN_YCbCrTerm_SIMD( vhi, YCBCR_RV );
+			gc[0] = qiv_add32( CIN_YCbCrTerm_SIMD( vlo, YCBCR_GV ), CIN_YCbCrTerm_SIMD( ulo, YCBCR_GU ) );
+			gc[1] = qiv_add32( CIN_YCbCrTerm_SIMD( vhi, YCBCR_GV ), CIN_YCbCrTerm_SIMD( uhi, YCBCR_GU ) );
+			bu[0] = CIN_YCbCrTerm_SIMD( ulo, YCBCR_BU );
+			bu[1] = CIN_YCbCrTerm_SIMD( uhi, YCBCR_BU );
+		}
+
+		// saturate to 16 bits, then clamp to 0..255 while packing to bytes
+		r = qiv_packs32to16( qiv_add32( ylo, rv[0] ), qiv_add32( yhi, rv[1] ) );
+		g = qiv_packs32to16( qiv_sub32( ylo, gc[0] ), qiv_sub32( yhi, gc[1] ) );
+		b = qiv_packs32to16( qiv_add32( ylo, bu[0] ), qiv_add32( yhi, bu[1] ) );
+
+		qiv_storeu( rg, qiv_packus16to8( r, g ) );
+		qiv_storeu( bb, qiv_packus16to8( b, b ) );
+
+		for( i = 0; i < 8; i++ ) {
+			out[i * bytes + 0] = rg[i];
+			out[i * bytes + 1] = rg[i + 8];
+			out[i * bytes + 2] = bb[i];
+		}
+	}
+
+	if( x < width ) {
+		CIN_YCbCrToRGBRow_C( y + x, u + ( x >> hshift ), v + ( x >> hshift ), hshift, hround, width - x, bytes, out );
+	}
+}
+
+#else
+
+#define CIN_YCbCrToRGBRow_SIMD CIN_YCbCrToRGBRow_C
+
+#endif
+
+/*
+* CIN_YCbCrToRGB_
+*
+* Writes the cropped picture as tightly packed rows of bytes per pixel,
+* only the first three bytes of each pixel are touched. The chroma
+* subsampling is derived from the plane sizes. 4:2:0 pictures keep the
+* chroma siting of the original Theora converter, which is offset by one
+* pixel to the left of the 4:2:2 one.
+*/
+void CIN_YCbCrToRGB_( const cin_yuv_t *cyuv, int bytes, uint8_t *out, bool simd )
+{
+	int row;
+	int hshift, vshift, hround;
+	int x_offset = cyuv->x_offset, y_offset = cyuv->y_offset;
+	const cin_img_plane_t *yp = &cyuv->yuv[0], *up = &cyuv->yuv[1], *vp = &cyuv->yuv[2];
+	cin_ycbcrrowfunc_t rowFunc = simd ? CIN_YCbCrToRGBRow_SIMD : CIN_YCbCrToRGBRow_C;
+
+	hshift = up->width < yp->width ? 1 : 0;
+	vshift = up->height < yp->height ? 1 : 0;
+	hround = hshift & vshift;
+
+	for( row = 0; row < cyuv->height; row++ ) {
+		int cy = ( y_offset >> vshift ) + ( row >> vshift );
+
+		rowFunc( yp->data + ( y_offset + row ) * yp->stride + x_offset,
+			up->data + cy * up->stride + ( x_offset >> hshift ),
+			vp->data + cy * vp->stride + ( x_offset >> hshift ),
+			hshift, hround, cyuv->width, bytes, out );
+		out += cyuv->width * bytes;
+	}
+}
+
+/*
+* CIN_YCbCrToRGB
+*/
+void CIN_YCbCrToRGB( const cin_yuv_t *cyuv, int bytes, uint8_t *out )
+{
+	CIN_YCbCrToRGB_( cyuv, bytes, out, cin_simd->integer != 0 );
+}
@@ -447,6 +447,7 @@ void CL_GameModule_Init( void )
 
 	import.GetConfigString = CL_GameModule_GetConfigString;
 	import.Milliseconds = Sys_Milliseconds;
+	import.Microseconds = Sys_Microseconds;
 	import.DownloadRequest = CL_DownloadRequest;
 
 	import.NET_GetUserCmd = CL_GameModule_NET_GetUserCmd;
@@ -454,8 +455,15 @@ void CL_GameModule_Init( void )
 	import.NET_GetCurrentState = CL_GameModule_NET_GetCurrentState;
 	import.RefreshMouseAngles = CL_GameModule_RefreshMouseAngles;
 
+	import.Jobs_Add = QJobs_Add;
+	import.Jobs_Wait = QJobs_Wait;
+	import.Jobs_ParallelFor = QJobs_ParallelFor;
+	import.Jobs_NumWorkers = QJobs_NumWorkers;
+
 	import.R_UpdateScreen = SCR_UpdateScreen;
 	import.R_GetClippedFragments = re.GetClippedFragments;
+	import.R_QueueClippedFragments = re.QueueClippedFragments;
+	import.R_GetQueuedFragments = re.GetQueuedFragments;
 	import.R_ClearScene = re.ClearScene;
 	import.R_AddEntityToScene = re.AddEntityToScene;
 	import.R_AddLightToScene = re.AddLightToScene;
@@ -230,10 +230,12 @@ static void CL_SendConnectPacket( void )
 	Com_DPrintf("CL_MM_Initialized: %d, cls.mm_ticket: %u\n", CL_MM_Initialized(), cls.mm_ticket );
 	if( CL_MM_Initialized() && cls.mm_ticket != 0 )
 		Netchan_OutOfBandPrint( cls.socket, &cls.serveraddress, "connect %i %i %i \"%s\" %i %u\n",
-				APP_PROTOCOL_VERSION, Netchan_GamePort(), cls.challenge, Cvar_Userinfo(), 0, cls.mm_ticket );
+				APP_PROTOCOL_VERSION, Netchan_GamePort(), cls.challenge, Cvar_Userinfo(), 
+				NETCHAN_DICTIONARY_VERSION << NETCHAN_DICTIONARY_SHIFT, cls.mm_ticket );
 	else
 		Netchan_OutOfBandPrint( cls.socket, &cls.serveraddress, "connect %i %i %i \"%s\" %i\n",
-				APP_PROTOCOL_VERSION, Netchan_GamePort(), cls.challenge, Cvar_Userinfo(), 0 );
+				APP_PROTOCOL_VERSION, Netchan_GamePort(), cls.challenge, Cvar_Userinfo(), 
+				NETCHAN_DICTIONARY_VERSION << NETCHAN_DICTIONARY_SHIFT );
 }
 
 /*
@@ -1178,6 +1180,10 @@ static void CL_ConnectionlessPacket( const socket_t *socket, const netadr_t *add
 		Q_strncpyz( cls.session, MSG_ReadStringLine( msg ), sizeof( cls.session ) );
 
 		Netchan_Setup( &cls.netchan, socket, address, Netchan_GamePort() );
+
+		// the server echoes the compression dictionary version if it has the same one
+		cls.netchan.dictionaryCompression = ( atoi( MSG_ReadStringLine( msg ) ) == NETCHAN_DICTIONARY_VERSION );
+
 		memset( cl.configstrings, 0, sizeof( cl.configstrings ) );
 		CL_SetClientState( CA_HANDSHAKE );
 		CL_AddReliableCommand( "new" );
@@ -2421,7 +2427,7 @@ void CL_Netchan_Transmit( msg_t *msg )
 	// do not enable client compression until I fix the compression+fragmentation rare case bug
 	if( ( cl_compresspackets->integer && msg->cursize > 60 ) || cl_compresspackets->integer > 1 )
 	{
-		zerror = Netchan_CompressMessage( msg );
+		zerror = Netchan_CompressMessage( &cls.netchan, msg );
 		if( zerror < 0 ) // it's compression error, just send uncompressed
 		{
 			Com_DPrintf( "CL_Netchan_Transmit (ignoring compression): Compression error %i\n", zerror );
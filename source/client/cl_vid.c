@@ -375,6 +375,7 @@ static bool VID_LoadRefresh( const char *name )
 	import.FS_MoveFile = &FS_MoveFile;
 	import.FS_IsUrl = &FS_IsUrl;
 	import.FS_FileMTime = &FS_FileMTime;
+	import.FS_PakChecksumForFile = &FS_PakChecksumForFile;
 	import.FS_RemoveDirectory = &FS_RemoveDirectory;
 	import.FS_GameDirectory = &FS_GameDirectory;
 	import.FS_WriteDirectory = &FS_WriteDirectory;
@@ -403,6 +404,10 @@ static bool VID_LoadRefresh( const char *name )
 	import.Mutex_Destroy = QMutex_Destroy;
 	import.Mutex_Lock = QMutex_Lock;
 	import.Mutex_Unlock = QMutex_Unlock;
+	import.CondVar_Create = QCondVar_Create;
+	import.CondVar_Destroy = QCondVar_Destroy;
+	import.CondVar_Wait = QCondVar_Wait;
+	import.CondVar_Wake = QCondVar_Wake;
 
 	import.BufPipe_Create = QBufPipe_Create;
 	import.BufPipe_Destroy = QBufPipe_Destroy;
@@ -411,6 +416,11 @@ static bool VID_LoadRefresh( const char *name )
 	import.BufPipe_ReadCmds = QBufPipe_ReadCmds;
 	import.BufPipe_Wait = QBufPipe_Wait;
 
+	import.Jobs_Add = QJobs_Add;
+	import.Jobs_Wait = QJobs_Wait;
+	import.Jobs_ParallelFor = QJobs_ParallelFor;
+	import.Jobs_NumWorkers = QJobs_NumWorkers;
+
 	file_size = strlen( LIB_DIRECTORY "/" LIB_PREFIX ) + strlen( name ) + 1 + strlen( ARCH ) + strlen( LIB_SUFFIX ) + 1;
 	file = Mem_TempMalloc( file_size );
 	Q_snprintfz( file, file_size, LIB_DIRECTORY "/" LIB_PREFIX "%s_" ARCH LIB_SUFFIX, name );
@@ -29,6 +29,8 @@ extern angelwrap_api_t *angelExport;
 #define SECTIONS_SEPARATOR					';'
 
 #define SCRIPTS_DIRECTORY					"progs"
+#define SCRIPTS_BYTECODE_CACHE_DIRECTORY	"cache"
+#define SCRIPTS_BYTECODE_EXTENSION			".asb"
 
 #define GAMETYPE_SCRIPTS_MODULE_NAME		"gametype"
 #define GAMETYPE_SCRIPTS_DIRECTORY			"gametypes"
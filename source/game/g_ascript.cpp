@@ -3890,7 +3890,11 @@ static asIScriptModule *G_BuildGameScript( const char *moduleName, const char *d
 {
 	int error;
 	int numSections, sectionNum;
-	char *section;
+	char *section, **sections;
+	unsigned int sourceHash;
+	unsigned int startTime;
+	bool cached;
+	char cacheName[MAX_QPATH];
 	asIScriptModule *asModule;
 	asIScriptEngine *asEngine;
 	
@@ -3902,6 +3906,8 @@ static asIScriptModule *G_BuildGameScript( const char *moduleName, const char *d
 
 	G_Printf( "* Initializing script '%s'\n", scriptName );
 
+	startTime = trap_Milliseconds();
+
 	// count referenced script sections
 	for( numSections = 0; ( section = G_ListNameForPosition( script, numSections, SECTIONS_SEPARATOR ) ) != NULL; numSections++ );
 
@@ -3910,29 +3916,60 @@ static asIScriptModule *G_BuildGameScript( const char *moduleName, const char *d
 		return NULL;
 	}
 
-	// load up the script sections
+	// load up the script sections, hashing them for the bytecode cache as we go
+
+	sections = ( char ** )G_Malloc( numSections * sizeof( char * ) );
+	sourceHash = 0;
+
+	for( sectionNum = 0; sectionNum < numSections && ( section = G_LoadScriptSection( dir, script, sectionNum ) ) != NULL; sectionNum++ ) {
+		const char *sectionName = G_ListNameForPosition( script, sectionNum, SECTIONS_SEPARATOR );
+		sourceHash = angelExport->asHashScriptSection( sourceHash, sectionName, section, strlen( section ) );
+		sections[sectionNum] = section;
+	}
+
+	if( sectionNum != numSections ) {
+		G_Printf( S_COLOR_RED "* Error: couldn't load all script sections.\n" );
+		while( sectionNum-- > 0 )
+			G_Free( sections[sectionNum] );
+		G_Free( sections );
+		return NULL;
+	}
 
 	asModule = asEngine->GetModule( moduleName, asGM_CREATE_IF_NOT_EXISTS );
 	if( asModule == NULL ) {
 		G_Printf( S_COLOR_RED "G_BuildGameScript: GetModule '%s' failed\n", moduleName );
+		for( sectionNum = 0; sectionNum < numSections; sectionNum++ )
+			G_Free( sections[sectionNum] );
+		G_Free( sections );
 		return NULL;
 	}
 
-	for( sectionNum = 0; ( section = G_LoadScriptSection( dir, script, sectionNum ) ) != NULL; sectionNum++ ) {
-		const char *sectionName = G_ListNameForPosition( script, sectionNum, SECTIONS_SEPARATOR );
-		error = asModule->AddScriptSection( sectionName, section, strlen( section ) );
+	Q_snprintfz( cacheName, sizeof( cacheName ), "%s/%s", SCRIPTS_BYTECODE_CACHE_DIRECTORY, scriptName );
+	COM_ReplaceExtension( cacheName, SCRIPTS_BYTECODE_EXTENSION, sizeof( cacheName ) );
+
+	error = 0;
+	cached = angelExport->asLoadByteCode( asModule, cacheName, sourceHash );
+	if( !cached ) {
+		for( sectionNum = 0; sectionNum < numSections; sectionNum++ ) {
+			const char *sectionName = G_ListNameForPosition( script, sectionNum, SECTIONS_SEPARATOR );
+			error = asModule->AddScriptSection( sectionName, sections[sectionNum], strlen( sections[sectionNum] ) );
+			if( error ) {
+				G_Printf( S_COLOR_RED "* Failed to add the script section %s with error %i\n", sectionName, error );
+				break;
+			}
+		}
+	}
 
-		G_Free( section );
+	for( sectionNum = 0; sectionNum < numSections; sectionNum++ )
+		G_Free( sections[sectionNum] );
+	G_Free( sections );
 
-		if( error ) {
-			G_Printf( S_COLOR_RED "* Failed to add the script section %s with error %i\n", sectionName, error );
-			asEngine->DiscardModule( moduleName );
-			return NULL;
-		}
+	if( cached ) {
+		G_Printf( "* Loaded script '%s' from bytecode cache in %u ms\n", scriptName, trap_Milliseconds() - startTime );
+		return asModule;
 	}
 
-	if( sectionNum != numSections ) {
-		G_Printf( S_COLOR_RED "* Error: couldn't load all script sections.\n" );
+	if( error ) {
 		asEngine->DiscardModule( moduleName );
 		return NULL;
 	}
@@ -3944,6 +3981,10 @@ static asIScriptModule *G_BuildGameScript( const char *moduleName, const char *d
 		return NULL;
 	}
 
+	G_Printf( "* Built script '%s' from source in %u ms\n", scriptName, trap_Milliseconds() - startTime );
+
+	angelExport->asSaveByteCode( asModule, cacheName, sourceHash );
+
 	return asModule;
 }
 
@@ -784,6 +784,8 @@ void G_RunFrame( unsigned int msec, unsigned int serverTime )
 
 	G_CallVotes_Think();
 
+	G_MM_CheckPendingReport( false );
+
 	if( GS_MatchPaused() )
 	{
 		// freeze match clock and linear projectiles
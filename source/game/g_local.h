@@ -924,6 +924,13 @@ void G_ScoreboardMessage_AddSpectators( void );
 void G_ScoreboardMessage_AddChasers( int entnum, int entnum_self );
 void G_UpdateScoreBoardMessages( void );
 
+//
+// g_pmovereplay.c
+//
+void G_PmoveReplay_Init( void );
+void G_PmoveReplay_Shutdown( void );
+void G_PmoveReplay_Record( const pmove_t *pm );
+
 //
 // g_phys.c
 //
@@ -973,6 +980,7 @@ bool G_RespawnLevel( void );
 void G_ResetLevel( void );
 void G_InitLevel( char *mapname, char *entities, int entstrlen, unsigned int levelTime, unsigned int serverTime, unsigned int realTime );
 const char *G_GetEntitySpawnKey( const char *key, edict_t *self );
+void G_FreeMapEntityCache( void );
 
 //
 // g_awards.c
@@ -1446,6 +1454,7 @@ static inline edict_t *PLAYERENT( int x ) { return game.edicts + x + 1; }
 
 void G_AddPlayerReport( edict_t *ent, bool final );
 void G_Match_SendReport( void );
+void G_MM_CheckPendingReport( bool wait );
 
 void G_TransferRatings( void );
 clientRating_t *G_AddDefaultRating( edict_t *ent, const char *gametype );
@@ -373,6 +373,7 @@ void G_Init( unsigned int seed, unsigned int framemsec, int protocol, const char
 
 	// server console commands
 	G_AddServerCommands();
+	G_PmoveReplay_Init();
 
 	G_LoadFiredefsFromDisk();
 
@@ -392,6 +393,8 @@ void G_Shutdown( void )
 
 	G_Printf( "==== G_Shutdown ====\n" );
 
+	G_MM_CheckPendingReport( true );
+
 	GT_asCallShutdown();
 	G_asCallMapExit();
 
@@ -406,11 +409,14 @@ void G_Shutdown( void )
 	BOT_RemoveBot( "all" );
 
 	G_RemoveCommands();
+	G_PmoveReplay_Shutdown();
 
 	G_FreeCallvotes();
 
 	G_LevelFreePool();
 
+	G_FreeMapEntityCache();
+
 	for( i = 0; i < game.numentities; i++ )
 	{
 		if( game.edicts[i].r.inuse )
@@ -635,46 +635,167 @@ void G_AddPlayerReport( edict_t *ent, bool final )
 	}
 }
 
+//==========================================================
+//		MM Report serialization
+//==========================================================
+
+// The end-of-match report is snapshotted into plain structures on the game
+// thread, the JSON tree is then built, serialized and compressed on a worker
+// and the finished query is handed to trap_MM_SendQuery on a later frame.
+
+typedef struct
+{
+	char gametype[MAX_CONFIGSTRING_CHARS];
+	char mapname[MAX_CONFIGSTRING_CHARS];
+	char hostname[MAX_CONFIGSTRING_CHARS];
+	char gamedir[MAX_QPATH];
+	char demoname[MAX_QPATH];
+	int timeplayed;
+	int timelimit;
+	int scorelimit;
+	int instagib;
+	int teamgame;
+	int racegame;
+	unsigned int timestamp;
+} g_mm_header_t;
+
+typedef struct
+{
+	char *name;				// copied, level strings may be gone before the report is built
+	int count;
+} g_mm_award_t;
+
+typedef struct
+{
+	char netname[MAX_NAME_BYTES];
+	int team;
+	int mm_session;
+	unsigned int timePlayed;
+	bool final;
+	score_stats_t stats;	// award and frag allocators are not valid here
+
+	int numAwards;
+	g_mm_award_t *awards;
+	int numFrags;
+	loggedFrag_t *frags;
+} g_mm_playerreport_t;
+
+typedef struct
+{
+	stat_query_t *query;
+
+	g_mm_header_t header;
+
+	int numTeams;
+	struct {
+		char name[MAX_CONFIGSTRING_CHARS];
+		int score;
+	} teams[GS_MAX_TEAMS];
+
+	const char *weapnames[WEAP_TOTAL];
+
+	int numPlayers;
+	g_mm_playerreport_t *players;
+
+	// worker state
+	struct qthread_s *thread;
+	struct qmutex_s *lock;
+	bool done;
+	uint64_t snapshotTime;
+	uint64_t buildTime;
+} g_mm_matchreport_t;
+
+static g_mm_matchreport_t *g_mm_pendingReport;
+
+/*
+* G_MM_SnapshotHeader
+*/
+static void G_MM_SnapshotHeader( g_mm_header_t *header, int teamGame )
+{
+	memset( header, 0, sizeof( *header ) );
+
+	Q_strncpyz( header->gametype, gs.gametypeName, sizeof( header->gametype ) );
+	Q_strncpyz( header->mapname, level.mapname, sizeof( header->mapname ) );
+	Q_strncpyz( header->hostname, trap_Cvar_String( "sv_hostname" ), sizeof( header->hostname ) );
+	Q_strncpyz( header->gamedir, trap_Cvar_String( "fs_game" ), sizeof( header->gamedir ) );
+	if( g_autorecord->integer ) {
+		Q_snprintfz( header->demoname, sizeof( header->demoname ), "%s%s", level.autorecord_name, game.demoExtension );
+	}
+	header->timeplayed = level.finalMatchDuration / 1000;
+	header->timelimit = GS_MatchDuration() / 1000;
+	header->scorelimit = g_scorelimit->integer;
+	header->instagib = GS_Instagib() ? 1 : 0;
+	header->teamgame = teamGame;
+	header->racegame = GS_RaceGametype() ? 1 : 0;
+	header->timestamp = trap_Milliseconds();
+}
+
 // common header
-static void g_mm_writeHeader( stat_query_t *query, int teamGame )
+static void g_mm_writeHeader( stat_query_t *query, const g_mm_header_t *header )
 {
 	stat_query_section_t *matchsection = sq_api->CreateSection( query, 0, "match" );
 
 	// Write match properties
 	// sq_api->SetNumber( matchsection, "final", (target_cl==NULL) ? 1 : 0 );
-	sq_api->SetString( matchsection, "gametype", gs.gametypeName );
-	sq_api->SetString( matchsection, "map", level.mapname );
-	sq_api->SetString( matchsection, "hostname", trap_Cvar_String( "sv_hostname" ) );
-	sq_api->SetNumber( matchsection, "timeplayed", level.finalMatchDuration / 1000 );
-	sq_api->SetNumber( matchsection, "timelimit", GS_MatchDuration() / 1000 );
-	sq_api->SetNumber( matchsection, "scorelimit", g_scorelimit->integer );
-	sq_api->SetNumber( matchsection, "instagib", ( GS_Instagib() ? 1 : 0 ));
-	sq_api->SetNumber( matchsection, "teamgame", teamGame );
-	sq_api->SetNumber( matchsection, "racegame", ( GS_RaceGametype() ? 1 : 0 ));
-	sq_api->SetString( matchsection, "gamedir", trap_Cvar_String( "fs_game" ) );
-	sq_api->SetNumber( matchsection, "timestamp", trap_Milliseconds() );
-	if( g_autorecord->integer ) {
-		sq_api->SetString( matchsection, "demo_filename", va( "%s%s", level.autorecord_name, game.demoExtension ) );
+	sq_api->SetString( matchsection, "gametype", header->gametype );
+	sq_api->SetString( matchsection, "map", header->mapname );
+	sq_api->SetString( matchsection, "hostname", header->hostname );
+	sq_api->SetNumber( matchsection, "timeplayed", header->timeplayed );
+	sq_api->SetNumber( matchsection, "timelimit", header->timelimit );
+	sq_api->SetNumber( matchsection, "scorelimit", header->scorelimit );
+	sq_api->SetNumber( matchsection, "instagib", header->instagib );
+	sq_api->SetNumber( matchsection, "teamgame", header->teamgame );
+	sq_api->SetNumber( matchsection, "racegame", header->racegame );
+	sq_api->SetString( matchsection, "gamedir", header->gamedir );
+	sq_api->SetNumber( matchsection, "timestamp", header->timestamp );
+	if( header->demoname[0] ) {
+		sq_api->SetString( matchsection, "demo_filename", header->demoname );
 	}
 }
 
-static stat_query_t *G_Match_GenerateReport( void )
+/*
+* G_MM_FreeMatchReport
+*/
+static void G_MM_FreeMatchReport( g_mm_matchreport_t *report )
 {
-	stat_query_t *query;
-	stat_query_section_t *playersarray;
-	//stat_query_section_t *weapindexarray;
+	int i, j;
+
+	if( report->lock )
+		trap_Mutex_Destroy( &report->lock );
+
+	for( i = 0; i < report->numPlayers; i++ )
+	{
+		g_mm_playerreport_t *player = &report->players[i];
+
+		for( j = 0; j < player->numAwards; j++ )
+			G_Free( player->awards[j].name );
+		if( player->awards )
+			G_Free( player->awards );
+		if( player->frags )
+			G_Free( player->frags );
+	}
+
+	if( report->players )
+		G_Free( report->players );
+	G_Free( report );
+}
+
+/*
+* G_Match_SnapshotReport
+*
+* Copies everything the report needs out of the game state. This is the only
+* part that has to run in the game frame.
+*/
+static g_mm_matchreport_t *G_Match_SnapshotReport( void )
+{
+	g_mm_matchreport_t *report;
 	gclient_quit_t *cl, *potm;
-	int i, teamGame, duelGame;
-	static const char *weapnames[WEAP_TOTAL] = { NULL };
+	int i, j, size, teamGame, duelGame;
 	score_stats_t *stats;
 
 	// Feature: do not report matches with duration less than 1 minute (actually 66 seconds)
 	if( level.finalMatchDuration <= SIGNIFICANT_MATCH_DURATION )
-		return 0;
-
-	query = sq_api->CreateQuery( NULL, "smr", false );
-	if( !query )
-		return 0;
+		return NULL;
 
 	// ch : race properties through GS_RaceGametype()
 
@@ -690,25 +811,30 @@ static stat_query_t *G_Match_GenerateReport( void )
 		teamGame = 1;
 	}
 
-	g_mm_writeHeader( query, teamGame );
+	report = ( g_mm_matchreport_t * )G_Malloc( sizeof( *report ) );
+	memset( report, 0, sizeof( *report ) );
 
-	// Write team properties (if any)
+	G_MM_SnapshotHeader( &report->header, teamGame );
+
+	// team properties (if any)
 	if( teamlist[TEAM_ALPHA].numplayers > 0 && teamGame != 0 )
 	{
-		stat_query_section_t *teamarray = sq_api->CreateArray( query, 0, "teams" );
-
 		for( i = TEAM_ALPHA; i <= TEAM_BETA; i++ )
 		{
-			stat_query_section_t *team = sq_api->CreateSection( query, teamarray, 0 );
-			sq_api->SetString( team, "name", trap_GetConfigString ( CS_TEAM_SPECTATOR_NAME + (i-TEAM_SPECTATOR) ) );
-			sq_api->SetNumber( team, "index", i - TEAM_ALPHA );
-			sq_api->SetNumber( team, "score", teamlist[i].stats.score );
+			Q_strncpyz( report->teams[report->numTeams].name, trap_GetConfigString( CS_TEAM_SPECTATOR_NAME + (i-TEAM_SPECTATOR) ), 
+				sizeof( report->teams[0].name ) );
+			report->teams[report->numTeams].score = teamlist[i].stats.score;
+			report->numTeams++;
 		}
 	}
 
-
-	// TODO: write the weapon indexes
-	// weapindexarray = sq_api->CreateSection( query, 0, "weapindices" );
+	for( i = 0; i < AMMO_WEAK_GUNBLADE-WEAP_TOTAL; i++ )
+	{
+		gsitem_t *it = GS_FindItemByTag( WEAP_GUNBLADE + i );
+		if( it ) {
+			report->weapnames[i] = it->shortname;
+		}
+	}
 
 	// find player of the match (best score)
 	// FIXME: is it the right place for this stuff here?
@@ -717,6 +843,7 @@ static stat_query_t *G_Match_GenerateReport( void )
 		stats = &cl->stats;
 		if( !potm || stats->score > potm->stats.score )
 			potm = cl;
+		report->numPlayers++;
 	}
 
 	// to receieve "Player of the Match" award the player must also have the "Fair Play" award
@@ -738,13 +865,88 @@ static stat_query_t *G_Match_GenerateReport( void )
 		G_PrintMsg( NULL, "Player of the match: %s" S_COLOR_WHITE "\n", potm->netname );
 	}
 
+	// player properties
+	report->players = ( g_mm_playerreport_t * )G_Malloc( sizeof( *report->players ) * report->numPlayers );
+	memset( report->players, 0, sizeof( *report->players ) * report->numPlayers );
+
+	for( cl = game.quits, i = 0; cl; cl = cl->next, i++ )
+	{
+		g_mm_playerreport_t *player = &report->players[i];
+
+		stats = &cl->stats;
+
+		Q_strncpyz( player->netname, cl->netname, sizeof( player->netname ) );
+		player->team = cl->team;
+		player->mm_session = cl->mm_session;
+		player->timePlayed = cl->timePlayed;
+		player->final = cl->final;
+		player->stats = *stats;
+		player->stats.awardAllocator = NULL;
+		player->stats.fragAllocator = NULL;
+
+		if( stats->awardAllocator && ( size = LA_Size( stats->awardAllocator ) ) > 0 )
+		{
+			player->awards = ( g_mm_award_t * )G_Malloc( sizeof( *player->awards ) * size );
+			for( j = 0; j < size; j++ )
+			{
+				gameaward_t *ga = ( gameaward_t * )LA_Pointer( stats->awardAllocator, j );
+				player->awards[j].name = G_CopyString( ga->name );
+				player->awards[j].count = ga->count;
+			}
+			player->numAwards = size;
+		}
+
+		if( stats->fragAllocator && ( size = LA_Size( stats->fragAllocator ) ) > 0 )
+		{
+			player->frags = ( loggedFrag_t * )G_Malloc( sizeof( *player->frags ) * size );
+			for( j = 0; j < size; j++ )
+				player->frags[j] = *( loggedFrag_t * )LA_Pointer( stats->fragAllocator, j );
+			player->numFrags = size;
+		}
+	}
+
+	return report;
+}
+
+/*
+* G_Match_GenerateReport
+*
+* Builds the query JSON out of the snapshot. Runs on the report worker,
+* so it must not touch the game state.
+*/
+static void G_Match_GenerateReport( g_mm_matchreport_t *report )
+{
+	stat_query_t *query = report->query;
+	stat_query_section_t *playersarray;
+	//stat_query_section_t *weapindexarray;
+	int i, j;
+	const score_stats_t *stats;
+
+	g_mm_writeHeader( query, &report->header );
+
+	// Write team properties (if any)
+	if( report->numTeams )
+	{
+		stat_query_section_t *teamarray = sq_api->CreateArray( query, 0, "teams" );
+
+		for( i = 0; i < report->numTeams; i++ )
+		{
+			stat_query_section_t *team = sq_api->CreateSection( query, teamarray, 0 );
+			sq_api->SetString( team, "name", report->teams[i].name );
+			sq_api->SetNumber( team, "index", i );
+			sq_api->SetNumber( team, "score", report->teams[i].score );
+		}
+	}
+
+	// TODO: write the weapon indexes
+	// weapindexarray = sq_api->CreateSection( query, 0, "weapindices" );
+
 	// Write player properties
 	playersarray = sq_api->CreateArray( query, 0, "players" );
-	for( cl = game.quits; cl; cl = cl->next )
+	for( i = 0; i < report->numPlayers; i++ )
 	{
+		const g_mm_playerreport_t *cl = &report->players[i];
 		stat_query_section_t *playersection, *accsection, *awardssection;
-		gameaward_t *ga;
-		int numAwards;
 
 		stats = &cl->stats;
 
@@ -776,49 +978,34 @@ static stat_query_t *G_Match_GenerateReport( void )
 		sq_api->SetNumber( playersection, "bombs_defused", cl->stats.bombs_defused );
 		sq_api->SetNumber( playersection, "flags_capped", cl->stats.flags_capped );
 
-		if( teamGame != 0 )
+		if( report->header.teamgame != 0 )
 			sq_api->SetNumber( playersection, "team", cl->team - TEAM_ALPHA );
 
 		// AWARDS
-		numAwards = 0;
-		if( stats->awardAllocator && LA_Size( stats->awardAllocator ) > 0 )
-			numAwards += LA_Size( stats->awardAllocator );
-
-		if( numAwards )
+		if( cl->numAwards )
 		{
 			stat_query_section_t *gasection;
-			int size;
 
 			awardssection = sq_api->CreateArray( query, playersection, "awards" );
 
-			if( stats->awardAllocator )
+			for( j = 0; j < cl->numAwards; j++ )
 			{
-				size = numAwards;
-				for ( i = 0; i < size; i++ )
-				{
-					ga = (gameaward_t*)LA_Pointer( stats->awardAllocator, i );
-					gasection = sq_api->CreateSection( query, awardssection, 0 );
-					sq_api->SetString( gasection, "name", ga->name );
-					sq_api->SetNumber( gasection, "count", ga->count );
-				}
+				gasection = sq_api->CreateSection( query, awardssection, 0 );
+				sq_api->SetString( gasection, "name", cl->awards[j].name );
+				sq_api->SetNumber( gasection, "count", cl->awards[j].count );
 			}
-
-			// theoretically you could Free() the awards now, but they are from levelpool
-			// so they are deallocated anyway after this
 		}
 
 		// WEAPONS
 
 		// first pass calculate the number of weapons, see if we even need this section
-		for( i = 0; i < (AMMO_TOTAL-WEAP_TOTAL); i++ )
+		for( j = 0; j < (AMMO_TOTAL-WEAP_TOTAL); j++ )
 		{
-			if ( stats->accuracy_shots[i] > 0 )
+			if ( stats->accuracy_shots[j] > 0 )
 				break;
 		}
-		if ( i < (AMMO_TOTAL-WEAP_TOTAL) )
+		if ( j < (AMMO_TOTAL-WEAP_TOTAL) )
 		{
-			int j;
-
 			accsection = sq_api->CreateSection( query, playersection, "weapons" );
 
 			// we only loop thru the lower section of weapons since we put both
@@ -833,13 +1020,7 @@ static stat_query_t *G_Match_GenerateReport( void )
 				if ( stats->accuracy_shots[j] == 0 && stats->accuracy_shots[weak] == 0)
 					continue;
 
-				if( !weapnames[j] ) {
-					gsitem_t *it = GS_FindItemByTag( WEAP_GUNBLADE + j );
-					if( it ) {
-						weapnames[j] = it->shortname;
-					}
-				}
-				weapsection = sq_api->CreateSection( query, accsection, weapnames[j] );
+				weapsection = sq_api->CreateSection( query, accsection, report->weapnames[j] );
 
 				// STRONG
 				hits = stats->accuracy_hits[j];
@@ -868,31 +1049,81 @@ static stat_query_t *G_Match_GenerateReport( void )
 		}
 
 		// duel frags
-		if( /* duelGame && */ stats->fragAllocator != 0 && LA_Size( stats->fragAllocator ) > 0 )
+		if( /* duelGame && */ cl->numFrags > 0 )
 		{
 			stat_query_section_t *fragSection;
-			loggedFrag_t *lfrag;
-			int size;
 
 			fragSection = sq_api->CreateArray( query, playersection, "log_frags" );
-			size = LA_Size( stats->fragAllocator );
-			for( i = 0; i < size; i++ )
+			for( j = 0; j < cl->numFrags; j++ )
 			{
 				stat_query_section_t *sect;
 
-				lfrag = (loggedFrag_t*)LA_Pointer( stats->fragAllocator, i );
-
 				sect = sq_api->CreateSection( query, fragSection, 0 );
-				sq_api->SetNumber( sect, "victim", lfrag->mm_victim );
-				sq_api->SetNumber( sect, "weapon", lfrag->weapon );
-				sq_api->SetNumber( sect, "time", lfrag->time );
+				sq_api->SetNumber( sect, "victim", cl->frags[j].mm_victim );
+				sq_api->SetNumber( sect, "weapon", cl->frags[j].weapon );
+				sq_api->SetNumber( sect, "time", cl->frags[j].time );
 			}
 		}
 
 		sq_api->SetNumber( playersection, "sessionid", cl->mm_session );
 	}
+}
+
+/*
+* G_Match_ReportThread
+*/
+static void *G_Match_ReportThread( void *param )
+{
+	g_mm_matchreport_t *report = ( g_mm_matchreport_t * )param;
+	uint64_t start = trap_Microseconds();
+
+	G_Match_GenerateReport( report );
+
+	// serialize and compress the JSON here too, so that Send has nothing left to do
+	sq_api->Prepare( report->query );
+
+	trap_Mutex_Lock( report->lock );
+	report->buildTime = trap_Microseconds() - start;
+	report->done = true;
+	trap_Mutex_Unlock( report->lock );
 
-	return query;
+	return NULL;
+}
+
+/*
+* G_MM_CheckPendingReport
+*
+* Sends the match report once the worker has finished with it. With wait
+* set, blocks until that happens (level shutdown, next report).
+*/
+void G_MM_CheckPendingReport( bool wait )
+{
+	g_mm_matchreport_t *report = g_mm_pendingReport;
+	bool done;
+
+	if( !report )
+		return;
+
+	trap_Mutex_Lock( report->lock );
+	done = report->done;
+	trap_Mutex_Unlock( report->lock );
+
+	if( !done && !wait )
+		return;
+
+	if( report->thread )
+		trap_Thread_Join( report->thread );
+	g_mm_pendingReport = NULL;
+
+	G_Printf( "Match report: %.2f ms in game frame, %.2f ms in background\n", 
+		report->snapshotTime / 1000.0, report->buildTime / 1000.0 );
+
+	trap_MM_SendQuery( report->query );
+
+	// this will be free'd by callbacks
+	report->query = NULL;
+
+	G_MM_FreeMatchReport( report );
 }
 
 /*
@@ -902,8 +1133,9 @@ void G_Match_SendReport( void )
 {
 	edict_t *ent;
 	gclient_quit_t *qcl, *qnext;
-	stat_query_t *query;
+	g_mm_matchreport_t *report;
 	int numPlayers;
+	uint64_t start;
 
 	// TODO: check if MM is enabled
 
@@ -920,6 +1152,11 @@ void G_Match_SendReport( void )
 	// if( g_isSupportedGametype( gs.gametypeName ) )
 	if( GS_MMCompatible() )
 	{
+		// only one report in flight
+		G_MM_CheckPendingReport( true );
+
+		start = trap_Microseconds();
+
 		// merge game.clients with game.quits
 		for( ent = game.edicts + 1; PLAYERNUM( ent ) < gs.maxclients; ent++ )
 			G_AddPlayerReport( ent, true );
@@ -931,14 +1168,28 @@ void G_Match_SendReport( void )
 
 		if( numPlayers > 1 )
 		{
-			// emit them all
-			query = G_Match_GenerateReport();
-			if( query )
+			report = G_Match_SnapshotReport();
+			if( report )
 			{
-				trap_MM_SendQuery( query );
+				report->query = sq_api->CreateQuery( NULL, "smr", false );
+				if( !report->query )
+				{
+					G_MM_FreeMatchReport( report );
+					report = NULL;
+				}
+			}
 
-				// this will be free'd by callbacks
-				query = NULL;
+			if( report )
+			{
+				report->lock = trap_Mutex_Create();
+				report->snapshotTime = trap_Microseconds() - start;
+				report->thread = trap_Thread_Create( G_Match_ReportThread, report );
+				if( !report->thread )
+				{
+					// no worker, build it right here
+					G_Match_ReportThread( report );
+				}
+				g_mm_pendingReport = report;
 			}
 		}
 	}
@@ -962,6 +1213,7 @@ static void G_Match_RaceReport( void )
 	stat_query_section_t *runsArray;
 	stat_query_section_t *timesArray, *dummy;
 	raceRun_t *prr;
+	g_mm_header_t header;
 	int i, j, size;
 
 	if( !GS_RaceGametype() )
@@ -994,7 +1246,8 @@ static void G_Match_RaceReport( void )
 		return;
 	}
 
-	g_mm_writeHeader( query, false );
+	G_MM_SnapshotHeader( &header, false );
+	g_mm_writeHeader( query, &header );
 
 	// Players array
 	runsArray = sq_api->CreateArray( query, 0, "runs" );
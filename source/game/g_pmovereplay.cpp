@@ -0,0 +1,508 @@
+/*
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+*/
+
+// g_pmovereplay.cpp -- records the movement input of clients and replays it
+// through Pmove against the world alone, to catch changes to the movement code
+// that would break prediction and to measure its cost
+
+#include "g_local.h"
+
+#define PMOVE_RECORD_MAGIC		"QPMR"
+#define PMOVE_BASELINE_MAGIC	"QPMB"
+#define PMOVE_RECORD_VERSION	1
+
+#define PMOVE_RECORD_DIR		"pmove"
+
+// the records are raw structs, so the sizes catch any change to their layout
+typedef struct
+{
+	char magic[4];
+	int version;
+	int psSize, cmdSize, gameStateSize;
+	char mapname[MAX_QPATH];
+	char mapchecksum[MAX_QPATH];
+	int numRecords;
+} pmove_replayheader_t;
+
+typedef struct
+{
+	int playerNum;
+	int snapinitial;
+	usercmd_t cmd;
+	game_state_t gameState;
+	player_state_t ps;
+} pmove_record_t;
+
+typedef struct
+{
+	player_state_t ps;
+	vec3_t mins, maxs;
+	float step;
+	int groundentity;
+	int watertype;
+	int waterlevel;
+	int numtouch;
+} pmove_result_t;
+
+static int pmoveRecordFile;
+static int pmoveNumRecords;
+
+static unsigned int pmoveNumTraces, pmoveNumPointContents;
+
+//==================================================
+// RECORDING
+//==================================================
+
+/*
+* G_PmoveReplay_InitHeader
+*/
+static void G_PmoveReplay_InitHeader( pmove_replayheader_t *header, const char *magic, int numRecords )
+{
+	memset( header, 0, sizeof( *header ) );
+	memcpy( header->magic, magic, sizeof( header->magic ) );
+	header->version = PMOVE_RECORD_VERSION;
+	header->psSize = sizeof( player_state_t );
+	header->cmdSize = sizeof( usercmd_t );
+	header->gameStateSize = sizeof( game_state_t );
+	Q_strncpyz( header->mapname, level.mapname, sizeof( header->mapname ) );
+	Q_strncpyz( header->mapchecksum, trap_GetConfigString( CS_MAPCHECKSUM ), sizeof( header->mapchecksum ) );
+	header->numRecords = numRecords;
+}
+
+/*
+* G_PmoveReplay_CheckHeader
+*/
+static bool G_PmoveReplay_CheckHeader( const pmove_replayheader_t *header, const char *magic, const char *filename )
+{
+	pmove_replayheader_t expected;
+
+	G_PmoveReplay_InitHeader( &expected, magic, header->numRecords );
+
+	if( memcmp( header->magic, expected.magic, sizeof( header->magic ) ) || header->version != expected.version
+		|| header->psSize != expected.psSize || header->cmdSize != expected.cmdSize 
+		|| header->gameStateSize != expected.gameStateSize )
+	{
+		G_Printf( "%s: not a movement recording of this build\n", filename );
+		return false;
+	}
+
+	if( Q_stricmp( header->mapname, expected.mapname ) || strcmp( header->mapchecksum, expected.mapchecksum ) )
+	{
+		G_Printf( "%s: recorded on %s, load that map first\n", filename, header->mapname );
+		return false;
+	}
+
+	return true;
+}
+
+/*
+* G_PmoveReplay_StopRecord
+*/
+static void G_PmoveReplay_StopRecord( void )
+{
+	if( !pmoveRecordFile )
+		return;
+
+	trap_FS_FCloseFile( pmoveRecordFile );
+	pmoveRecordFile = 0;
+
+	G_Printf( "Recorded %i moves\n", pmoveNumRecords );
+}
+
+/*
+* G_PmoveReplay_Record
+*
+* Called by ClientThink right before the move is performed
+*/
+void G_PmoveReplay_Record( const pmove_t *pm )
+{
+	pmove_record_t record;
+
+	if( !pmoveRecordFile )
+		return;
+
+	memset( &record, 0, sizeof( record ) );
+	record.playerNum = pm->playerState->playerNum;
+	record.snapinitial = pm->snapinitial ? 1 : 0;
+	record.cmd = pm->cmd;
+	record.gameState = gs.gameState;
+	record.ps = *pm->playerState;
+
+	if( trap_FS_Write( &record, sizeof( record ), pmoveRecordFile ) != sizeof( record ) )
+	{
+		G_Printf( "Error writing the movement recording\n" );
+		G_PmoveReplay_StopRecord();
+		return;
+	}
+
+	pmoveNumRecords++;
+}
+
+/*
+* G_PmoveRecord_f
+*
+* pmoverecord <name> | stop
+*/
+static void G_PmoveRecord_f( void )
+{
+	char filename[MAX_QPATH];
+	pmove_replayheader_t header;
+
+	if( trap_Cmd_Argc() < 2 )
+	{
+		G_Printf( "Usage: %s <name|stop>\n", trap_Cmd_Argv( 0 ) );
+		return;
+	}
+
+	G_PmoveReplay_StopRecord();
+
+	if( !Q_stricmp( trap_Cmd_Argv( 1 ), "stop" ) )
+		return;
+
+	Q_snprintfz( filename, sizeof( filename ), PMOVE_RECORD_DIR "/%s.pmr", trap_Cmd_Argv( 1 ) );
+	COM_SanitizeFilePath( filename );
+
+	if( trap_FS_FOpenFile( filename, &pmoveRecordFile, FS_WRITE ) == -1 )
+	{
+		G_Printf( "Couldn't open %s for writing\n", filename );
+		pmoveRecordFile = 0;
+		return;
+	}
+
+	// the record count is implied by the file size
+	G_PmoveReplay_InitHeader( &header, PMOVE_RECORD_MAGIC, 0 );
+	trap_FS_Write( &header, sizeof( header ), pmoveRecordFile );
+	pmoveNumRecords = 0;
+
+	G_Printf( "Recording movement to %s\n", filename );
+}
+
+//==================================================
+// REPLAY
+//==================================================
+
+/*
+* G_PmoveReplay_Trace
+*
+* Collides with the world alone, so the replay doesn't depend on entities
+*/
+static void G_PmoveReplay_Trace( trace_t *tr, vec3_t start, vec3_t mins, vec3_t maxs, vec3_t end, int ignore, int contentmask, int timeDelta )
+{
+	pmoveNumTraces++;
+	trap_CM_TransformedBoxTrace( tr, start, end, mins, maxs, NULL, contentmask, NULL, NULL );
+	tr->ent = tr->fraction < 1.0 ? world->s.number : -1;
+}
+
+/*
+* G_PmoveReplay_PointContents
+*/
+static int G_PmoveReplay_PointContents( vec3_t point, int timeDelta )
+{
+	pmoveNumPointContents++;
+	return trap_CM_TransformedPointContents( point, NULL, NULL, NULL );
+}
+
+/*
+* G_PmoveReplay_GetEntityState
+*/
+static entity_state_t *G_PmoveReplay_GetEntityState( int entNum, int deltaTime )
+{
+	static entity_state_t state;
+
+	memset( &state, 0, sizeof( state ) );
+	state.number = entNum;
+	return &state;
+}
+
+/*
+* G_PmoveReplay_PredictedEvent
+*/
+static void G_PmoveReplay_PredictedEvent( int entNum, int ev, int parm )
+{
+}
+
+/*
+* G_PmoveReplay_TouchTriggers
+*/
+static void G_PmoveReplay_TouchTriggers( pmove_t *pm, vec3_t previous_origin )
+{
+}
+
+/*
+* G_PmoveReplay_LoadFile
+*/
+static void *G_PmoveReplay_LoadFile( const char *filename, const char *magic, size_t recordSize, int *numRecords )
+{
+	int filenum, length;
+	pmove_replayheader_t header;
+	uint8_t *data;
+
+	length = trap_FS_FOpenFile( filename, &filenum, FS_READ );
+	if( length < 0 )
+		return NULL;
+
+	if( length < (int)sizeof( header ) )
+	{
+		trap_FS_FCloseFile( filenum );
+		G_Printf( "%s: truncated\n", filename );
+		return NULL;
+	}
+
+	trap_FS_Read( &header, sizeof( header ), filenum );
+	if( !G_PmoveReplay_CheckHeader( &header, magic, filename ) )
+	{
+		trap_FS_FCloseFile( filenum );
+		return NULL;
+	}
+
+	*numRecords = ( length - sizeof( header ) ) / recordSize;
+	if( header.numRecords && header.numRecords != *numRecords )
+	{
+		trap_FS_FCloseFile( filenum );
+		G_Printf( "%s: truncated\n", filename );
+		return NULL;
+	}
+
+	data = ( uint8_t * )G_Malloc( max( *numRecords, 1 ) * recordSize );
+	trap_FS_Read( data, *numRecords * recordSize, filenum );
+	trap_FS_FCloseFile( filenum );
+
+	return data;
+}
+
+/*
+* G_PmoveReplay_Run
+*
+* Runs all records once, filling results if given
+*/
+static void G_PmoveReplay_Run( const pmove_record_t *records, int numRecords, pmove_result_t *results )
+{
+	int i;
+	pmove_t pm;
+	player_state_t ps;
+	pmove_result_t *result;
+
+	for( i = 0; i < numRecords; i++ )
+	{
+		ps = records[i].ps;
+		gs.gameState = records[i].gameState;
+
+		memset( &pm, 0, sizeof( pm ) );
+		pm.playerState = &ps;
+		pm.cmd = records[i].cmd;
+		pm.snapinitial = records[i].snapinitial != 0;
+
+		Pmove( &pm );
+
+		if( !results )
+			continue;
+
+		result = &results[i];
+		memset( result, 0, sizeof( *result ) );
+		result->ps = ps;
+		VectorCopy( pm.mins, result->mins );
+		VectorCopy( pm.maxs, result->maxs );
+		result->step = pm.step;
+		result->groundentity = pm.groundentity;
+		result->watertype = pm.watertype;
+		result->waterlevel = pm.waterlevel;
+		result->numtouch = pm.numtouch;
+	}
+}
+
+/*
+* G_PmoveReplay_CompareBaseline
+*
+* Writes the baseline if there's none yet
+*/
+static void G_PmoveReplay_CompareBaseline( const char *filename, pmove_result_t *results, int numRecords, bool rebase )
+{
+	int i, filenum, numBaseline, numDiffering, firstDiffering;
+	pmove_result_t *baseline;
+	pmove_replayheader_t header;
+
+	baseline = rebase ? NULL : ( pmove_result_t * )G_PmoveReplay_LoadFile( filename, PMOVE_BASELINE_MAGIC, sizeof( pmove_result_t ), &numBaseline );
+	if( !baseline )
+	{
+		if( trap_FS_FOpenFile( filename, &filenum, FS_WRITE ) == -1 )
+		{
+			G_Printf( "Couldn't open %s for writing\n", filename );
+			return;
+		}
+
+		G_PmoveReplay_InitHeader( &header, PMOVE_BASELINE_MAGIC, numRecords );
+		trap_FS_Write( &header, sizeof( header ), filenum );
+		trap_FS_Write( results, sizeof( pmove_result_t ) * numRecords, filenum );
+		trap_FS_FCloseFile( filenum );
+
+		G_Printf( "Wrote baseline %s\n", filename );
+		return;
+	}
+
+	if( numBaseline != numRecords )
+	{
+		G_Printf( S_COLOR_RED "Baseline has %i moves, the recording %i\n", numBaseline, numRecords );
+		G_Free( baseline );
+		return;
+	}
+
+	numDiffering = 0;
+	firstDiffering = -1;
+	for( i = 0; i < numRecords; i++ )
+	{
+		if( !memcmp( &results[i], &baseline[i], sizeof( pmove_result_t ) ) )
+			continue;
+		if( !numDiffering++ )
+			firstDiffering = i;
+	}
+
+	if( !numDiffering )
+	{
+		G_Printf( S_COLOR_GREEN "All %i moves match the baseline\n", numRecords );
+	}
+	else
+	{
+		pmove_result_t *a = &baseline[firstDiffering], *b = &results[firstDiffering];
+
+		G_Printf( S_COLOR_RED "%i of %i moves differ from the baseline, first at %i:\n", numDiffering, numRecords, firstDiffering );
+		G_Printf( "origin %s -> %s\n", vtos( a->ps.pmove.origin ), vtos( b->ps.pmove.origin ) );
+		G_Printf( "velocity %s -> %s\n", vtos( a->ps.pmove.velocity ), vtos( b->ps.pmove.velocity ) );
+		G_Printf( "pm_flags %i -> %i, groundentity %i -> %i\n", a->ps.pmove.pm_flags, b->ps.pmove.pm_flags, 
+			a->groundentity, b->groundentity );
+	}
+
+	G_Free( baseline );
+}
+
+/*
+* G_PmoveReplay_f
+*
+* pmovereplay <name> [iterations] [rebase]
+*/
+static void G_PmoveReplay_f( void )
+{
+	int i, numRecords, iterations;
+	char filename[MAX_QPATH];
+	bool rebase;
+	pmove_record_t *records;
+	pmove_result_t *results;
+	game_state_t gameState;
+	uint64_t time;
+	unsigned int numTraces, numPointContents;
+
+	// saved module hooks
+	void ( *trace )( trace_t *, vec3_t, vec3_t, vec3_t, vec3_t, int, int, int );
+	int ( *pointContents )( vec3_t, int );
+	entity_state_t *( *getEntityState )( int, int );
+	void ( *predictedEvent )( int, int, int );
+	void ( *touchTriggers )( pmove_t *, vec3_t );
+
+	if( trap_Cmd_Argc() < 2 )
+	{
+		G_Printf( "Usage: %s <name> [iterations] [rebase]\n", trap_Cmd_Argv( 0 ) );
+		return;
+	}
+
+	iterations = trap_Cmd_Argc() > 2 ? max( atoi( trap_Cmd_Argv( 2 ) ), 1 ) : 1;
+	rebase = trap_Cmd_Argc() > 3 && !Q_stricmp( trap_Cmd_Argv( 3 ), "rebase" );
+
+	// the file may still be open for writing
+	G_PmoveReplay_StopRecord();
+
+	Q_snprintfz( filename, sizeof( filename ), PMOVE_RECORD_DIR "/%s.pmr", trap_Cmd_Argv( 1 ) );
+	COM_SanitizeFilePath( filename );
+
+	records = ( pmove_record_t * )G_PmoveReplay_LoadFile( filename, PMOVE_RECORD_MAGIC, sizeof( pmove_record_t ), &numRecords );
+	if( !records )
+	{
+		G_Printf( "Couldn't load %s\n", filename );
+		return;
+	}
+	if( !numRecords )
+	{
+		G_Printf( "%s is empty\n", filename );
+		G_Free( records );
+		return;
+	}
+
+	results = ( pmove_result_t * )G_Malloc( sizeof( pmove_result_t ) * numRecords );
+
+	trace = module_Trace;
+	pointContents = module_PointContents;
+	getEntityState = module_GetEntityState;
+	predictedEvent = module_PredictedEvent;
+	touchTriggers = module_PMoveTouchTriggers;
+	gameState = gs.gameState;
+
+	module_Trace = G_PmoveReplay_Trace;
+	module_PointContents = G_PmoveReplay_PointContents;
+	module_GetEntityState = G_PmoveReplay_GetEntityState;
+	module_PredictedEvent = G_PmoveReplay_PredictedEvent;
+	module_PMoveTouchTriggers = G_PmoveReplay_TouchTriggers;
+
+	// the first pass produces the results, the rest are for timing
+	pmoveNumTraces = pmoveNumPointContents = 0;
+	G_PmoveReplay_Run( records, numRecords, results );
+	numTraces = pmoveNumTraces;
+	numPointContents = pmoveNumPointContents;
+
+	time = trap_Microseconds();
+	for( i = 0; i < iterations; i++ )
+		G_PmoveReplay_Run( records, numRecords, NULL );
+	time = trap_Microseconds() - time;
+
+	module_Trace = trace;
+	module_PointContents = pointContents;
+	module_GetEntityState = getEntityState;
+	module_PredictedEvent = predictedEvent;
+	module_PMoveTouchTriggers = touchTriggers;
+	gs.gameState = gameState;
+
+	G_Printf( "%i moves x %i: %.0f Pmove calls/sec, %.2f traces and %.2f point contents per call\n",
+		numRecords, iterations, (double)numRecords * iterations * 1000000.0 / max( time, 1 ),
+		(double)numTraces / numRecords, (double)numPointContents / numRecords );
+
+	Q_snprintfz( filename, sizeof( filename ), PMOVE_RECORD_DIR "/%s.pmb", trap_Cmd_Argv( 1 ) );
+	COM_SanitizeFilePath( filename );
+	G_PmoveReplay_CompareBaseline( filename, results, numRecords, rebase );
+
+	G_Free( results );
+	G_Free( records );
+}
+
+/*
+* G_PmoveReplay_Init
+*/
+void G_PmoveReplay_Init( void )
+{
+	pmoveRecordFile = 0;
+
+	trap_Cmd_AddCommand( "pmoverecord", G_PmoveRecord_f );
+	trap_Cmd_AddCommand( "pmovereplay", G_PmoveReplay_f );
+}
+
+/*
+* G_PmoveReplay_Shutdown
+*/
+void G_PmoveReplay_Shutdown( void )
+{
+	G_PmoveReplay_StopRecord();
+
+	trap_Cmd_RemoveCommand( "pmoverecord" );
+	trap_Cmd_RemoveCommand( "pmovereplay" );
+}
@@ -20,7 +20,7 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 
 // g_public.h -- game dll information visible to server
 
-#define	GAME_API_VERSION    50
+#define	GAME_API_VERSION    52
 
 //===============================================================
 
@@ -37,6 +37,9 @@ typedef struct stat_query_api_s stat_query_api_t;
 struct stat_query_api_s;
 struct stat_query_s;
 
+struct qthread_s;
+struct qmutex_s;
+
 typedef struct
 {
 	int ping;
@@ -96,6 +99,7 @@ typedef struct
 	int ( *SkinIndex )( const char *name );
 
 	unsigned int ( *Milliseconds )( void );
+	uint64_t ( *Microseconds )( void );
 
 	bool ( *inPVS )( const vec3_t p1, const vec3_t p2 );
 
@@ -117,6 +121,20 @@ typedef struct
 	void *( *Mem_Alloc )( size_t size, const char *filename, int fileline );
 	void ( *Mem_Free )( void *data, const char *filename, int fileline );
 
+	// multithreading
+	struct qthread_s *( *Thread_Create )( void *(*routine) (void*), void *param );
+	void ( *Thread_Join )( struct qthread_s *thread );
+	struct qmutex_s *( *Mutex_Create )( void );
+	void ( *Mutex_Destroy )( struct qmutex_s **mutex );
+	void ( *Mutex_Lock )( struct qmutex_s *mutex );
+	void ( *Mutex_Unlock )( struct qmutex_s *mutex );
+
+	// job scheduler, worker 0 is shared by all threads outside the pool
+	qjobhandle_t ( *Jobs_Add )( qjobfunc_t func, void *arg, const qjobhandle_t *deps, int numDeps );
+	void ( *Jobs_Wait )( qjobhandle_t job );
+	void ( *Jobs_ParallelFor )( unsigned int count, unsigned int granularity, qjobrangefunc_t func, void *arg );
+	int ( *Jobs_NumWorkers )( void );
+
 	// dynvars
 	dynvar_t *( *Dynvar_Create )( const char *name, bool console, dynvar_getter_f getter, dynvar_setter_f setter );
 	void ( *Dynvar_Destroy )( dynvar_t *dynvar );
@@ -174,16 +174,47 @@ spawn_t	spawns[] = {
 	{ NULL, NULL }
 };
 
-static gsitem_t *G_ItemForEntity( edict_t *ent )
+// the parsed entity string of the last map, so that restarts of the
+// same map don't parse the text and look up the spawn functions again
+typedef struct
+{
+	const field_t *field;
+	const char *value;
+	int ivalue;
+	vec3_t vvalue;      // F_FLOAT, F_VECTOR and F_ANGLEHACK
+} g_mapentpair_t;
+
+typedef struct
 {
+	size_t spawnStringOfs;
+	int firstPair, numPairs;
+	bool init;
+
+	// resolved from the classname the first time the entity is spawned
+	bool resolved;
 	gsitem_t *item;
+	spawn_t *spawn;
+} g_mapentrecord_t;
 
-	// check item spawn functions
-	if( ( item = GS_FindItemByClassname( ent->classname ) ) != NULL )
-		return item;
+typedef struct
+{
+	char mapname[MAX_CONFIGSTRING_CHARS];
+	char *mapString;
+	size_t mapStrlen;
 
-	return NULL;
-}
+	char *values;
+	size_t valuesLen;
+
+	g_mapentrecord_t *records;
+	int numRecords, maxRecords;
+
+	g_mapentpair_t *pairs;
+	int numPairs, maxPairs;
+
+	uint64_t coldTime;
+} g_mapentcache_t;
+
+static g_mapentcache_t mapEntCache;
 
 /*
 * G_GametypeFilterMatch
@@ -213,10 +244,8 @@ static bool G_GametypeFilterMatch( const char *filter )
 /*
 * G_CanSpawnEntity
 */
-static bool G_CanSpawnEntity( edict_t *ent )
+static bool G_CanSpawnEntity( edict_t *ent, const gsitem_t *item )
 {
-	gsitem_t *item;
-
 	if( ent == world )
 		return true;
 
@@ -239,7 +268,7 @@ static bool G_CanSpawnEntity( edict_t *ent )
 			return false;
 	}
 
-	if( ( item = G_ItemForEntity( ent ) ) != NULL )
+	if( item )
 	{
 		// not pickable items aren't either spawnable
 		if( !( item->flags & ITFLAG_PICKABLE ) )
@@ -253,36 +282,47 @@ static bool G_CanSpawnEntity( edict_t *ent )
 }
 
 /*
-* G_CallSpawn
+* G_FindSpawn
 * 
-* Finds the spawn function for the entity and calls it
+* Resolves the item or spawn function for a classname, both are
+* NULL if the entity can only be spawned by the scripts
 */
-bool G_CallSpawn( edict_t *ent )
+static void G_FindSpawn( const char *classname, gsitem_t **item, spawn_t **spawn )
 {
 	spawn_t	*s;
-	gsitem_t *item;
 
-	if( !ent->classname )
+	*spawn = NULL;
+
+	// check item spawn functions
+	if( ( *item = GS_FindItemByClassname( classname ) ) != NULL )
+		return;
+
+	// check normal spawn functions
+	for( s = spawns; s->name; s++ )
 	{
-		if( developer->integer )
-			G_Printf( "G_CallSpawn: NULL classname\n" );
-		return false;
+		if( !Q_stricmp( s->name, classname ) )
+		{
+			*spawn = s;
+			return;
+		}
 	}
+}
 
-	if( ( item = G_ItemForEntity( ent ) ) != NULL )
+/*
+* G_CallResolvedSpawn
+*/
+static bool G_CallResolvedSpawn( edict_t *ent, gsitem_t *item, spawn_t *spawn )
+{
+	if( item )
 	{
 		SpawnItem( ent, item );
 		return true;
 	}
 
-	// check normal spawn functions
-	for( s = spawns; s->name; s++ )
+	if( spawn )
 	{
-		if( !Q_stricmp( s->name, ent->classname ) )
-		{
-			s->spawn( ent );
-			return true;
-		}
+		spawn->spawn( ent );
+		return true;
 	}
 
 	// see if there's a spawn definition in the gametype scripts
@@ -297,6 +337,27 @@ bool G_CallSpawn( edict_t *ent )
 	return false;
 }
 
+/*
+* G_CallSpawn
+* 
+* Finds the spawn function for the entity and calls it
+*/
+bool G_CallSpawn( edict_t *ent )
+{
+	gsitem_t *item;
+	spawn_t *spawn;
+
+	if( !ent->classname )
+	{
+		if( developer->integer )
+			G_Printf( "G_CallSpawn: NULL classname\n" );
+		return false;
+	}
+
+	G_FindSpawn( ent->classname, &item, &spawn );
+	return G_CallResolvedSpawn( ent, item, spawn );
+}
+
 /*
 * G_GetEntitySpawnKey
 */
@@ -390,77 +451,118 @@ static char *ED_NewString( const char *string )
 /*
 * ED_ParseField
 * 
-* Takes a key/value pair and sets the binary values
-* in an edict
+* Takes a key/value pair and converts the value for the field
+* it sets, returns false if the key isn't a field
 */
-static void ED_ParseField( char *key, char *value, edict_t *ent )
+static bool ED_ParseField( const char *key, const char *value, g_mapentpair_t *pair )
 {
 	const field_t *f;
-	uint8_t *b;
-	float v;
-	vec3_t vec;
 
 	for( f = fields; f->name; f++ )
 	{
 		if( !Q_stricmp( f->name, key ) )
 		{
 			// found it
-			if( f->flags & FFL_SPAWNTEMP )
-				b = (uint8_t *)&st;
-			else
-				b = (uint8_t *)ent;
+			memset( pair, 0, sizeof( *pair ) );
+			pair->field = f;
+			pair->value = value;
 
 			switch( f->type )
 			{
-			case F_LSTRING:
-				*(char **)( b+f->ofs ) = ED_NewString( value );
-				break;
 			case F_VECTOR:
-				sscanf( value, "%f %f %f", &vec[0], &vec[1], &vec[2] );
-				( (float *)( b+f->ofs ) )[0] = vec[0];
-				( (float *)( b+f->ofs ) )[1] = vec[1];
-				( (float *)( b+f->ofs ) )[2] = vec[2];
+				sscanf( value, "%f %f %f", &pair->vvalue[0], &pair->vvalue[1], &pair->vvalue[2] );
 				break;
 			case F_INT:
-				*(int *)( b+f->ofs ) = atoi( value );
+				pair->ivalue = atoi( value );
 				break;
 			case F_FLOAT:
-				*(float *)( b+f->ofs ) = atof( value );
+				pair->vvalue[0] = atof( value );
 				break;
 			case F_ANGLEHACK:
-				v = atof( value );
-				( (float *)( b+f->ofs ) )[0] = 0;
-				( (float *)( b+f->ofs ) )[1] = v;
-				( (float *)( b+f->ofs ) )[2] = 0;
-				break;
-			case F_IGNORE:
+				pair->vvalue[1] = atof( value );
 				break;
 			default:
-				break; // FIXME: Should this be error?
+				break;
 			}
-			return;
+			return true;
 		}
 	}
 
 	if( developer->integer )
 		G_Printf( "%s is not a field\n", key );
+	return false;
+}
+
+/*
+* ED_SetField
+* 
+* Sets the binary value of a parsed key/value pair in an edict
+*/
+static void ED_SetField( const g_mapentpair_t *pair, edict_t *ent )
+{
+	const field_t *f = pair->field;
+	uint8_t *b;
+
+	if( f->flags & FFL_SPAWNTEMP )
+		b = (uint8_t *)&st;
+	else
+		b = (uint8_t *)ent;
+
+	switch( f->type )
+	{
+	case F_LSTRING:
+		*(char **)( b+f->ofs ) = ED_NewString( pair->value );
+		break;
+	case F_VECTOR:
+	case F_ANGLEHACK:
+		VectorCopy( pair->vvalue, (float *)( b+f->ofs ) );
+		break;
+	case F_INT:
+		*(int *)( b+f->ofs ) = pair->ivalue;
+		break;
+	case F_FLOAT:
+		*(float *)( b+f->ofs ) = pair->vvalue[0];
+		break;
+	case F_IGNORE:
+		break;
+	default:
+		break; // FIXME: Should this be error?
+	}
+}
+
+/*
+* G_MapEntCache_Grow
+*/
+static void *G_MapEntCache_Grow( void *data, int *maxItems, size_t itemSize )
+{
+	int newMaxItems = max( *maxItems * 2, 64 );
+	void *newData = G_Malloc( newMaxItems * itemSize );
+
+	if( data )
+	{
+		memcpy( newData, data, *maxItems * itemSize );
+		G_Free( data );
+	}
+
+	*maxItems = newMaxItems;
+	return newData;
 }
 
 /*
 * ED_ParseEdict
 * 
-* Parses an edict out of the given string, returning the new position
-* ed should be a properly initialized empty edict.
+* Parses the key/value pairs of an edict out of the given string
+* into the map entity cache, returning the new position
 */
-static char *ED_ParseEdict( char *data, edict_t *ent )
+static const char *ED_ParseEdict( const char *data, g_mapentrecord_t *record )
 {
-	bool init;
 	char keyname[256];
-	char *com_token;
+	char *com_token, *value;
+	size_t len;
+	g_mapentcache_t *cache = &mapEntCache;
 
-	init = false;
-	memset( &st, 0, sizeof( st ) );
-	level.spawning_entity = ent;
+	record->init = false;
+	record->firstPair = cache->numPairs;
 
 	// go through all the dictionary pairs
 	while( 1 )
@@ -482,22 +584,127 @@ static char *ED_ParseEdict( char *data, edict_t *ent )
 		if( com_token[0] == '}' )
 			G_Error( "ED_ParseEntity: closing brace without data" );
 
-		init = true;
+		record->init = true;
 
 		// keynames with a leading underscore are used for utility comments,
 		// and are immediately discarded by quake
 		if( keyname[0] == '_' )
 			continue;
 
-		ED_ParseField( keyname, com_token, ent );
+		// every value is followed by at least the closing brace in the
+		// source string, so the copies always fit
+		len = strlen( com_token ) + 1;
+		if( cache->valuesLen + len > cache->mapStrlen + 1 )
+			G_Error( "ED_ParseEntity: entity string overflow" );
+		value = cache->values + cache->valuesLen;
+		memcpy( value, com_token, len );
+
+		if( cache->numPairs == cache->maxPairs )
+			cache->pairs = ( g_mapentpair_t * )G_MapEntCache_Grow( cache->pairs, &cache->maxPairs, sizeof( g_mapentpair_t ) );
+
+		if( ED_ParseField( keyname, value, &cache->pairs[cache->numPairs] ) )
+		{
+			cache->valuesLen += len;
+			cache->numPairs++;
+		}
 	}
 
-	if( !init )
+	record->numPairs = cache->numPairs - record->firstPair;
+
+	return data;
+}
+
+/*
+* ED_SpawnEdict
+* 
+* Sets the fields of an edict from its parsed key/value pairs.
+* ed should be a properly initialized empty edict.
+*/
+static void ED_SpawnEdict( const g_mapentrecord_t *record, edict_t *ent )
+{
+	int i;
+
+	memset( &st, 0, sizeof( st ) );
+	level.spawning_entity = ent;
+
+	for( i = 0; i < record->numPairs; i++ )
+		ED_SetField( &mapEntCache.pairs[record->firstPair + i], ent );
+
+	if( !record->init )
 		ent->classname = NULL;
 	if( ent->classname && ent->helpmessage )
 		ent->mapmessage_index = G_RegisterHelpMessage( ent->helpmessage );
+}
 
-	return data;
+/*
+* G_FreeMapEntityCache
+*/
+void G_FreeMapEntityCache( void )
+{
+	g_mapentcache_t *cache = &mapEntCache;
+
+	if( cache->mapString )
+		G_Free( cache->mapString );
+	if( cache->values )
+		G_Free( cache->values );
+	if( cache->records )
+		G_Free( cache->records );
+	if( cache->pairs )
+		G_Free( cache->pairs );
+
+	memset( cache, 0, sizeof( *cache ) );
+}
+
+/*
+* G_LoadMapEntityCache
+* 
+* Parses the entity string of the level unless the cache already holds it,
+* returns false if it had to be parsed
+*/
+static bool G_LoadMapEntityCache( void )
+{
+	const char *entities;
+	char *token;
+	g_mapentrecord_t *record;
+	g_mapentcache_t *cache = &mapEntCache;
+
+	if( cache->mapString && cache->mapStrlen == level.mapStrlen && !Q_stricmp( cache->mapname, level.mapname )
+		&& !memcmp( cache->mapString, level.mapString, level.mapStrlen ) )
+		return true;
+
+	G_FreeMapEntityCache();
+
+	cache->mapStrlen = level.mapStrlen;
+	cache->values = ( char * )G_Malloc( level.mapStrlen + 1 );
+
+	entities = level.mapString;
+	while( 1 )
+	{
+		// parse the opening brace
+		token = COM_Parse( &entities );
+		if( !entities )
+			break;
+		if( token[0] != '{' )
+			G_Error( "G_SpawnMapEntities: found %s when expecting {", token );
+
+		if( cache->numRecords == cache->maxRecords )
+			cache->records = ( g_mapentrecord_t * )G_MapEntCache_Grow( cache->records, &cache->maxRecords, sizeof( g_mapentrecord_t ) );
+
+		record = &cache->records[cache->numRecords++];
+		memset( record, 0, sizeof( *record ) );
+
+		// keep track of string definition of this entity
+		record->spawnStringOfs = entities - level.mapString;
+
+		entities = ED_ParseEdict( entities, record );
+	}
+
+	// only key the cache once the whole string parsed fine
+	Q_strncpyz( cache->mapname, level.mapname, sizeof( cache->mapname ) );
+	cache->mapString = ( char * )G_Malloc( level.mapStrlen + 1 );
+	memcpy( cache->mapString, level.mapString, level.mapStrlen );
+
+	return false;
 }
 
 /*
@@ -750,14 +957,20 @@ static void G_FreeEntities( void )
 
 /*
 * G_SpawnEntities
+*
+* Only item registration is deferred until after the spawn loop, once per item.
+* Spawn functions still register their own models, sounds and images inline,
+* since they need the indices right away.
 */
 static void G_SpawnEntities( void )
 {
-	int i;
+	int i, j;
 	edict_t *ent;
-	char *token;
 	const gsitem_t *item;
-	char *entities;
+	g_mapentrecord_t *record;
+	bool cached;
+	bool precacheItems[GS_MAX_ITEM_TAGS];
+	uint64_t startTime, parseTime, spawnTime;
 	
 	game.levelSpawnCount++;
 	level.spawnedTimeStamp = game.realtime;
@@ -765,23 +978,24 @@ static void G_SpawnEntities( void )
 
 	G_InitBodyQueue(); // reserve some spots for dead player bodies
 	
-	entities = level.mapString;
 	level.map_parsed_ents[0] = 0;
 	level.map_parsed_len = 0;
 
+	startTime = trap_Microseconds();
+	cached = G_LoadMapEntityCache();
+	parseTime = trap_Microseconds() - startTime;
+
+	// items are registered once each after all entities are spawned
+	memset( precacheItems, 0, sizeof( precacheItems ) );
+
 	i = 0;
 	ent = NULL;
-	while( 1 )
+	for( j = 0; j < mapEntCache.numRecords; j++ )
 	{
+		record = &mapEntCache.records[j];
+
 		level.spawning_entity = NULL;
 		
-		// parse the opening brace
-		token = COM_Parse( &entities );
-		if( !entities )
-			break;
-		if( token[0] != '{' )
-			G_Error( "G_SpawnMapEntities: found %s when expecting {", token );
-		
 		if( !ent )
 		{
 			ent = world;
@@ -790,24 +1004,30 @@ static void G_SpawnEntities( void )
 		else
 			ent = G_Spawn();
 		
-		ent->spawnString = entities; // keep track of string definition of this entity
+		ent->spawnString = level.mapString + record->spawnStringOfs; // keep track of string definition of this entity
 		
-		entities = ED_ParseEdict( entities, ent );
+		ED_SpawnEdict( record, ent );
 		if( !ent->classname )
 		{
 			i++;
 			G_FreeEdict( ent );
 			continue;
 		}
+
+		if( !record->resolved )
+		{
+			G_FindSpawn( ent->classname, &record->item, &record->spawn );
+			record->resolved = true;
+		}
 		
-		if( !G_CanSpawnEntity( ent ) )
+		if( !G_CanSpawnEntity( ent, record->item ) )
 		{
 			i++;
 			G_FreeEdict( ent );
 			continue;
 		}
 
-		if( !G_CallSpawn( ent ) )
+		if( !G_CallResolvedSpawn( ent, record->item, record->spawn ) )
 		{
 			i++;
 			G_FreeEdict( ent );
@@ -824,7 +1044,7 @@ static void G_SpawnEntities( void )
 				{
 					// override entity's classname with whatever item specifies
 					ent->classname = item->classname;
-					PrecacheItem( item );
+					precacheItems[item->tag] = true;
 					continue;
 				}
 			}
@@ -838,6 +1058,12 @@ static void G_SpawnEntities( void )
 	// is the parsing string sane?
 	assert( level.map_parsed_len < level.mapStrlen );
 	level.map_parsed_ents[level.map_parsed_len] = 0;
+
+	for( j = 0; j < GS_MAX_ITEM_TAGS; j++ )
+	{
+		if( precacheItems[j] )
+			PrecacheItem( GS_FindItemByTag( j ) );
+	}
 	
 	G_FindTeams();
 	
@@ -846,6 +1072,19 @@ static void G_SpawnEntities( void )
 	
 	// items need brush model entities spawned before they are linked
 	G_Items_FinishSpawningItems();
+
+	spawnTime = trap_Microseconds() - startTime - parseTime;
+	if( !cached )
+		mapEntCache.coldTime = parseTime + spawnTime;
+
+	if( developer->integer )
+	{
+		G_Printf( "%i entities, %i inhibited: parse %.2f ms, spawn %.2f ms", mapEntCache.numRecords, i, 
+			parseTime / 1000.0, spawnTime / 1000.0 );
+		if( cached )
+			G_Printf( " (cached, cold start took %.2f ms)", mapEntCache.coldTime / 1000.0 );
+		G_Printf( "\n" );
+	}
 }
 
 /*
@@ -84,6 +84,11 @@ static inline unsigned int trap_Milliseconds( void )
 	return GAME_IMPORT.Milliseconds();
 }
 
+static inline uint64_t trap_Microseconds( void )
+{
+	return GAME_IMPORT.Microseconds();
+}
+
 static inline bool trap_inPVS( const vec3_t p1, const vec3_t p2 )
 {
 	return GAME_IMPORT.inPVS( p1, p2 ) == true;
@@ -162,6 +167,57 @@ static inline void trap_MemFree( void *data, const char *filename, int fileline
 	GAME_IMPORT.Mem_Free( data, filename, fileline );
 }
 
+// multithreading
+static inline struct qthread_s *trap_Thread_Create( void *(*routine) (void*), void *param )
+{
+	return GAME_IMPORT.Thread_Create( routine, param );
+}
+
+static inline void trap_Thread_Join( struct qthread_s *thread )
+{
+	GAME_IMPORT.Thread_Join( thread );
+}
+
+static inline struct qmutex_s *trap_Mutex_Create( void )
+{
+	return GAME_IMPORT.Mutex_Create();
+}
+
+static inline void trap_Mutex_Destroy( struct qmutex_s **mutex )
+{
+	GAME_IMPORT.Mutex_Destroy( mutex );
+}
+
+static inline void trap_Mutex_Lock( struct qmutex_s *mutex )
+{
+	GAME_IMPORT.Mutex_Lock( mutex );
+}
+
+static inline void trap_Mutex_Unlock( struct qmutex_s *mutex )
+{
+	GAME_IMPORT.Mutex_Unlock( mutex );
+}
+
+static inline qjobhandle_t trap_Jobs_Add( qjobfunc_t func, void *arg, const qjobhandle_t *deps, int numDeps )
+{
+	return GAME_IMPORT.Jobs_Add( func, arg, deps, numDeps );
+}
+
+static inline void trap_Jobs_Wait( qjobhandle_t job )
+{
+	GAME_IMPORT.Jobs_Wait( job );
+}
+
+static inline void trap_Jobs_ParallelFor( unsigned int count, unsigned int granularity, qjobrangefunc_t func, void *arg )
+{
+	GAME_IMPORT.Jobs_ParallelFor( count, granularity, func, arg );
+}
+
+static inline int trap_Jobs_NumWorkers( void )
+{
+	return GAME_IMPORT.Jobs_NumWorkers();
+}
+
 // dynvars
 static inline dynvar_t *trap_Dynvar_Create( const char *name, bool console, dynvar_getter_f getter, dynvar_setter_f setter )
 {
@@ -1694,6 +1694,7 @@ void ClientThink( edict_t *ent, usercmd_t *ucmd, int timeDelta )
 		pm.snapinitial = true;
 
 	// perform a pmove
+	G_PmoveReplay_Record( &pm );
 	Pmove( &pm );
 
 	// save results of pmove
@@ -145,6 +145,11 @@ typedef	struct angelwrap_api_s
 	// any
 	CScriptAnyInterface *( *asCreateAnyCpp )( asIScriptEngine *engine );
 	void ( *asReleaseAnyCpp )( CScriptAnyInterface *any );
+
+	// bytecode cache
+	unsigned int ( *asHashScriptSection )( unsigned int hash, const char *name, const char *code, size_t length );
+	bool ( *asLoadByteCode )( asIScriptModule *module, const char *filename, unsigned int sourceHash );
+	bool ( *asSaveByteCode )( asIScriptModule *module, const char *filename, unsigned int sourceHash );
 } angelwrap_api_t;
 
 #endif
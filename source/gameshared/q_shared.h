@@ -388,6 +388,16 @@ typedef enum
 // equals to INFINITE on Windows and SDL_MUTEX_MAXWAIT
 #define Q_THREADS_WAIT_INFINITE 0xFFFFFFFF
 
+// handle of a job in the engine job scheduler, 0 refers to no job
+typedef unsigned int qjobhandle_t;
+
+// worker is less than the number of workers. Pool threads have their own index,
+// but every thread outside the pool (main, sound, http...) runs jobs as worker 0,
+// possibly at the same time, so per-worker data must not be used from worker 0
+// without locking
+typedef void ( *qjobfunc_t )( void *arg, int worker );
+typedef void ( *qjobrangefunc_t )( void *arg, unsigned int first, unsigned int count, int worker );
+
 //==============================================================
 
 // connection state of the client in the server
@@ -0,0 +1,227 @@
+/*
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+*/
+
+#ifndef GAME_QSIMD_H
+#define GAME_QSIMD_H
+
+#include "q_arch.h"
+
+/*
+* Thin wrappers around 4-wide SIMD registers. SSE2 is used on x86 builds that
+* guarantee it (always the case for x86-64), NEON on ARM and a plain C version
+* everywhere else or when C_ONLY is defined. qf4_load and qf4_store expect
+* 16-byte aligned addresses, the -u variants don't.
+*
+* qiv_t is a 128-bit integer vector for pixel processing. It is only available
+* with QSIMD_SSE2 or QSIMD_NEON, callers provide their own scalar fallbacks.
+* qiv_loadl and qiv_storel only touch the low 64 bits, the pack functions
+* expect values that fit the narrower type except for qiv_packs32to16 and
+* qiv_packus16to8, which saturate signed input. qiv_mullo32 keeps the low 32
+* bits of the product.
+*/
+
+#if !defined( C_ONLY ) && ( defined( __SSE2__ ) || defined( _M_X64 ) || defined( _M_AMD64 ) || ( defined( _M_IX86_FP ) && _M_IX86_FP >= 2 ) )
+#define QSIMD_SSE2
+#include <emmintrin.h>
+#elif !defined( C_ONLY ) && ( defined( __ARM_NEON ) || defined( __ARM_NEON__ ) )
+#define QSIMD_NEON
+#include <arm_neon.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if defined( QSIMD_SSE2 )
+
+#define QSIMD_NAME "SSE2"
+
+typedef __m128 qf4_t;
+typedef __m128 qm4_t;
+
+static inline qf4_t qf4_load( const float *p ) { return _mm_load_ps( p ); }
+static inline void qf4_store( float *p, qf4_t a ) { _mm_store_ps( p, a ); }
+static inline qf4_t qf4_loadu( const float *p ) { return _mm_loadu_ps( p ); }
+static inline void qf4_storeu( float *p, qf4_t a ) { _mm_storeu_ps( p, a ); }
+static inline qf4_t qf4_splat( float f ) { return _mm_set1_ps( f ); }
+static inline qf4_t qf4_zero( void ) { return _mm_setzero_ps(); }
+static inline qf4_t qf4_add( qf4_t a, qf4_t b ) { return _mm_add_ps( a, b ); }
+static inline qf4_t qf4_sub( qf4_t a, qf4_t b ) { return _mm_sub_ps( a, b ); }
+static inline qf4_t qf4_mul( qf4_t a, qf4_t b ) { return _mm_mul_ps( a, b ); }
+static inline qf4_t qf4_min( qf4_t a, qf4_t b ) { return _mm_min_ps( a, b ); }
+static inline qf4_t qf4_max( qf4_t a, qf4_t b ) { return _mm_max_ps( a, b ); }
+static inline qm4_t qf4_cmplt( qf4_t a, qf4_t b ) { return _mm_cmplt_ps( a, b ); }
+static inline qm4_t qf4_cmpge( qf4_t a, qf4_t b ) { return _mm_cmpge_ps( a, b ); }
+static inline int qm4_bits( qm4_t m ) { return _mm_movemask_ps( m ); }
+
+typedef __m128i qiv_t;
+
+static inline qiv_t qiv_loadu( const void *p ) { return _mm_loadu_si128( ( const __m128i * )p ); }
+static inline qiv_t qiv_loadl( const void *p ) { return _mm_loadl_epi64( ( const __m128i * )p ); }
+static inline void qiv_storel( void *p, qiv_t a ) { _mm_storel_epi64( ( __m128i * )p, a ); }
+static inline void qiv_storeu( void *p, qiv_t a ) { _mm_storeu_si128( ( __m128i * )p, a ); }
+static inline qiv_t qiv_set_u32( uint32_t a, uint32_t b, uint32_t c, uint32_t d ) { return _mm_set_epi32( d, c, b, a ); }
+static inline qiv_t qiv_splat_u32( uint32_t a ) { return _mm_set1_epi32( a ); }
+static inline qiv_t qiv_and( qiv_t a, qiv_t b ) { return _mm_and_si128( a, b ); }
+static inline qiv_t qiv_or( qiv_t a, qiv_t b ) { return _mm_or_si128( a, b ); }
+static inline qiv_t qiv_add16( qiv_t a, qiv_t b ) { return _mm_add_epi16( a, b ); }
+static inline qiv_t qiv_add32( qiv_t a, qiv_t b ) { return _mm_add_epi32( a, b ); }
+static inline qiv_t qiv_sub32( qiv_t a, qiv_t b ) { return _mm_sub_epi32( a, b ); }
+static inline qiv_t qiv_srl16( qiv_t a, int n ) { return _mm_srli_epi16( a, n ); }
+static inline qiv_t qiv_srl32( qiv_t a, int n ) { return _mm_srli_epi32( a, n ); }
+static inline qiv_t qiv_sra32( qiv_t a, int n ) { return _mm_srai_epi32( a, n ); }
+static inline qiv_t qiv_mullo32( qiv_t a, qiv_t b )
+{
+	// no 32-bit low multiply before SSE4.1, multiply even and odd lanes separately
+	__m128i even = _mm_mul_epu32( a, b );
+	__m128i odd = _mm_mul_epu32( _mm_srli_epi64( a, 32 ), _mm_srli_epi64( b, 32 ) );
+	return _mm_unpacklo_epi32( _mm_shuffle_epi32( even, _MM_SHUFFLE( 0, 0, 2, 0 ) ), _mm_shuffle_epi32( odd, _MM_SHUFFLE( 0, 0, 2, 0 ) ) );
+}
+static inline qiv_t qiv_zext8lo( qiv_t a ) { return _mm_unpacklo_epi8( a, _mm_setzero_si128() ); }
+static inline qiv_t qiv_zext8hi( qiv_t a ) { return _mm_unpackhi_epi8( a, _mm_setzero_si128() ); }
+static inline qiv_t qiv_zext16lo( qiv_t a ) { return _mm_unpacklo_epi16( a, _mm_setzero_si128() ); }
+static inline qiv_t qiv_zext16hi( qiv_t a ) { return _mm_unpackhi_epi16( a, _mm_setzero_si128() ); }
+static inline qiv_t qiv_sext16lo( qiv_t a ) { return _mm_srai_epi32( _mm_unpacklo_epi16( a, a ), 16 ); }
+static inline qiv_t qiv_sext16hi( qiv_t a ) { return _mm_srai_epi32( _mm_unpackhi_epi16( a, a ), 16 ); }
+static inline qiv_t qiv_zip32lo( qiv_t a, qiv_t b ) { return _mm_unpacklo_epi32( a, b ); }
+static inline qiv_t qiv_zip32hi( qiv_t a, qiv_t b ) { return _mm_unpackhi_epi32( a, b ); }
+static inline qiv_t qiv_swap32pairs( qiv_t a ) { return _mm_shuffle_epi32( a, _MM_SHUFFLE( 2, 3, 0, 1 ) ); }
+static inline qiv_t qiv_hi64( qiv_t a ) { return _mm_srli_si128( a, 8 ); }
+static inline qiv_t qiv_unpacklo64( qiv_t a, qiv_t b ) { return _mm_unpacklo_epi64( a, b ); }
+static inline qiv_t qiv_pack16to8( qiv_t a, qiv_t b ) { return _mm_packus_epi16( a, b ); }
+static inline qiv_t qiv_pack32to16( qiv_t a, qiv_t b )
+{
+	// no unsigned 32->16 pack in SSE2, sign-extend the low halves and use the signed one
+	a = _mm_srai_epi32( _mm_slli_epi32( a, 16 ), 16 );
+	b = _mm_srai_epi32( _mm_slli_epi32( b, 16 ), 16 );
+	return _mm_packs_epi32( a, b );
+}
+static inline qiv_t qiv_packs32to16( qiv_t a, qiv_t b ) { return _mm_packs_epi32( a, b ); }
+static inline qiv_t qiv_packus16to8( qiv_t a, qiv_t b ) { return _mm_packus_epi16( a, b ); }
+
+#elif defined( QSIMD_NEON )
+
+#define QSIMD_NAME "NEON"
+
+typedef float32x4_t qf4_t;
+typedef uint32x4_t qm4_t;
+
+static inline qf4_t qf4_load( const float *p ) { return vld1q_f32( p ); }
+static inline void qf4_store( float *p, qf4_t a ) { vst1q_f32( p, a ); }
+static inline qf4_t qf4_loadu( const float *p ) { return vld1q_f32( p ); }
+static inline void qf4_storeu( float *p, qf4_t a ) { vst1q_f32( p, a ); }
+static inline qf4_t qf4_splat( float f ) { return vdupq_n_f32( f ); }
+static inline qf4_t qf4_zero( void ) { return vdupq_n_f32( 0.0f ); }
+static inline qf4_t qf4_add( qf4_t a, qf4_t b ) { return vaddq_f32( a, b ); }
+static inline qf4_t qf4_sub( qf4_t a, qf4_t b ) { return vsubq_f32( a, b ); }
+static inline qf4_t qf4_mul( qf4_t a, qf4_t b ) { return vmulq_f32( a, b ); }
+static inline qf4_t qf4_min( qf4_t a, qf4_t b ) { return vminq_f32( a, b ); }
+static inline qf4_t qf4_max( qf4_t a, qf4_t b ) { return vmaxq_f32( a, b ); }
+static inline qm4_t qf4_cmplt( qf4_t a, qf4_t b ) { return vcltq_f32( a, b ); }
+static inline qm4_t qf4_cmpge( qf4_t a, qf4_t b ) { return vcgeq_f32( a, b ); }
+static inline int qm4_bits( qm4_t m )
+{
+	return ( vgetq_lane_u32( m, 0 ) & 1 ) | ( vgetq_lane_u32( m, 1 ) & 2 )
+		| ( vgetq_lane_u32( m, 2 ) & 4 ) | ( vgetq_lane_u32( m, 3 ) & 8 );
+}
+
+typedef uint8x16_t qiv_t;
+
+#define QIV_U16( a ) vreinterpretq_u16_u8( a )
+#define QIV_U32( a ) vreinterpretq_u32_u8( a )
+#define QIV_S16( a ) vreinterpretq_s16_u8( a )
+#define QIV_S32( a ) vreinterpretq_s32_u8( a )
+
+static inline qiv_t qiv_loadu( const void *p ) { return vld1q_u8( ( const uint8_t * )p ); }
+static inline qiv_t qiv_loadl( const void *p ) { return vcombine_u8( vld1_u8( ( const uint8_t * )p ), vdup_n_u8( 0 ) ); }
+static inline void qiv_storel( void *p, qiv_t a ) { vst1_u8( ( uint8_t * )p, vget_low_u8( a ) ); }
+static inline void qiv_storeu( void *p, qiv_t a ) { vst1q_u8( ( uint8_t * )p, a ); }
+static inline qiv_t qiv_set_u32( uint32_t a, uint32_t b, uint32_t c, uint32_t d ) { uint32_t t[4] = { a, b, c, d }; return vreinterpretq_u8_u32( vld1q_u32( t ) ); }
+static inline qiv_t qiv_splat_u32( uint32_t a ) { return vreinterpretq_u8_u32( vdupq_n_u32( a ) ); }
+static inline qiv_t qiv_and( qiv_t a, qiv_t b ) { return vandq_u8( a, b ); }
+static inline qiv_t qiv_or( qiv_t a, qiv_t b ) { return vorrq_u8( a, b ); }
+static inline qiv_t qiv_add16( qiv_t a, qiv_t b ) { return vreinterpretq_u8_u16( vaddq_u16( QIV_U16( a ), QIV_U16( b ) ) ); }
+static inline qiv_t qiv_add32( qiv_t a, qiv_t b ) { return vreinterpretq_u8_u32( vaddq_u32( QIV_U32( a ), QIV_U32( b ) ) ); }
+static inline qiv_t qiv_sub32( qiv_t a, qiv_t b ) { return vreinterpretq_u8_u32( vsubq_u32( QIV_U32( a ), QIV_U32( b ) ) ); }
+static inline qiv_t qiv_srl16( qiv_t a, int n ) { return vreinterpretq_u8_u16( vshlq_u16( QIV_U16( a ), vdupq_n_s16( -n ) ) ); }
+static inline qiv_t qiv_srl32( qiv_t a, int n ) { return vreinterpretq_u8_u32( vshlq_u32( QIV_U32( a ), vdupq_n_s32( -n ) ) ); }
+static inline qiv_t qiv_sra32( qiv_t a, int n ) { return vreinterpretq_u8_s32( vshlq_s32( QIV_S32( a ), vdupq_n_s32( -n ) ) ); }
+static inline qiv_t qiv_mullo32( qiv_t a, qiv_t b ) { return vreinterpretq_u8_u32( vmulq_u32( QIV_U32( a ), QIV_U32( b ) ) ); }
+static inline qiv_t qiv_zext8lo( qiv_t a ) { return vreinterpretq_u8_u16( vmovl_u8( vget_low_u8( a ) ) ); }
+static inline qiv_t qiv_zext8hi( qiv_t a ) { return vreinterpretq_u8_u16( vmovl_u8( vget_high_u8( a ) ) ); }
+static inline qiv_t qiv_zext16lo( qiv_t a ) { return vreinterpretq_u8_u32( vmovl_u16( vget_low_u16( QIV_U16( a ) ) ) ); }
+static inline qiv_t qiv_zext16hi( qiv_t a ) { return vreinterpretq_u8_u32( vmovl_u16( vget_high_u16( QIV_U16( a ) ) ) ); }
+static inline qiv_t qiv_sext16lo( qiv_t a ) { return vreinterpretq_u8_s32( vmovl_s16( vget_low_s16( QIV_S16( a ) ) ) ); }
+static inline qiv_t qiv_sext16hi( qiv_t a ) { return vreinterpretq_u8_s32( vmovl_s16( vget_high_s16( QIV_S16( a ) ) ) ); }
+static inline qiv_t qiv_zip32lo( qiv_t a, qiv_t b ) { return vreinterpretq_u8_u32( vzipq_u32( QIV_U32( a ), QIV_U32( b ) ).val[0] ); }
+static inline qiv_t qiv_zip32hi( qiv_t a, qiv_t b ) { return vreinterpretq_u8_u32( vzipq_u32( QIV_U32( a ), QIV_U32( b ) ).val[1] ); }
+static inline qiv_t qiv_swap32pairs( qiv_t a ) { return vreinterpretq_u8_u32( vrev64q_u32( QIV_U32( a ) ) ); }
+static inline qiv_t qiv_hi64( qiv_t a ) { return vcombine_u8( vget_high_u8( a ), vdup_n_u8( 0 ) ); }
+static inline qiv_t qiv_unpacklo64( qiv_t a, qiv_t b ) { return vcombine_u8( vget_low_u8( a ), vget_low_u8( b ) ); }
+static inline qiv_t qiv_pack16to8( qiv_t a, qiv_t b ) { return vcombine_u8( vqmovn_u16( QIV_U16( a ) ), vqmovn_u16( QIV_U16( b ) ) ); }
+static inline qiv_t qiv_pack32to16( qiv_t a, qiv_t b ) { return vreinterpretq_u8_u16( vcombine_u16( vmovn_u32( QIV_U32( a ) ), vmovn_u32( QIV_U32( b ) ) ) ); }
+static inline qiv_t qiv_packs32to16( qiv_t a, qiv_t b ) { return vreinterpretq_u8_s16( vcombine_s16( vqmovn_s32( QIV_S32( a ) ), vqmovn_s32( QIV_S32( b ) ) ) ); }
+static inline qiv_t qiv_packus16to8( qiv_t a, qiv_t b ) { return vcombine_u8( vqmovun_s16( QIV_S16( a ) ), vqmovun_s16( QIV_S16( b ) ) ); }
+
+#undef QIV_U16
+#undef QIV_U32
+#undef QIV_S16
+#undef QIV_S32
+
+#else
+
+#define QSIMD_NAME "C"
+
+typedef struct { float f[4]; } qf4_t;
+typedef struct { int m[4]; } qm4_t;
+
+static inline qf4_t qf4_load( const float *p ) { qf4_t r; r.f[0] = p[0]; r.f[1] = p[1]; r.f[2] = p[2]; r.f[3] = p[3]; return r; }
+static inline void qf4_store( float *p, qf4_t a ) { p[0] = a.f[0]; p[1] = a.f[1]; p[2] = a.f[2]; p[3] = a.f[3]; }
+static inline qf4_t qf4_loadu( const float *p ) { return qf4_load( p ); }
+static inline void qf4_storeu( float *p, qf4_t a ) { qf4_store( p, a ); }
+static inline qf4_t qf4_splat( float f ) { qf4_t r; r.f[0] = r.f[1] = r.f[2] = r.f[3] = f; return r; }
+static inline qf4_t qf4_zero( void ) { return qf4_splat( 0.0f ); }
+
+#define QF4_OP( name, expr ) \
+	static inline qf4_t name( qf4_t a, qf4_t b ) { qf4_t r; int i; for( i = 0; i < 4; i++ ) { float x = a.f[i], y = b.f[i]; r.f[i] = ( expr ); } return r; }
+#define QM4_OP( name, expr ) \
+	static inline qm4_t name( qf4_t a, qf4_t b ) { qm4_t r; int i; for( i = 0; i < 4; i++ ) { float x = a.f[i], y = b.f[i]; r.m[i] = ( expr ); } return r; }
+
+QF4_OP( qf4_add, x + y )
+QF4_OP( qf4_sub, x - y )
+QF4_OP( qf4_mul, x * y )
+QF4_OP( qf4_min, x < y ? x : y )
+QF4_OP( qf4_max, x > y ? x : y )
+QM4_OP( qf4_cmplt, x < y )
+QM4_OP( qf4_cmpge, x >= y )
+
+#undef QF4_OP
+#undef QM4_OP
+
+static inline int qm4_bits( qm4_t m ) { return ( m.m[0] ? 1 : 0 ) | ( m.m[1] ? 2 : 0 ) | ( m.m[2] ? 4 : 0 ) | ( m.m[3] ? 8 : 0 ); }
+
+#endif
+
+// a*b + c
+static inline qf4_t qf4_madd( qf4_t a, qf4_t b, qf4_t c ) { return qf4_add( qf4_mul( a, b ), c ); }
+
+#ifdef __cplusplus
+};
+#endif
+
+#endif // GAME_QSIMD_H
@@ -38,6 +38,9 @@ struct stat_query_s
 
 	bool	has_json;
 
+	// JSON has been serialized into the request
+	bool	prepared;
+
 	// if 'req' is NULL we have a GET cause that has to be created
 	// just before launch when we have all parameters
 	// url is stored only for GET, cause we can pass it in POST directly to wswcurl
@@ -340,8 +343,18 @@ static void StatQuery_SetCallback( stat_query_t *query, void( *callback_fn )(sta
 	query->customp = customp;
 }
 
+/*
+* StatQuery_Prepare
+*
+* Serializes, compresses and encodes the JSON into the request. Doesn't touch
+* any shared state, so it may be called from a worker thread before Send.
+*/
 static void StatQuery_Prepare( stat_query_t *query )
 {
+	if( query->prepared )
+		return;
+	query->prepared = true;
+
 	if( !query->req && query->url )
 	{
 		// GET request, finish the url and create the object
@@ -638,6 +651,7 @@ void StatQuery_Init( void )
 	sq_export.GetRawResponse = StatQuery_GetRawResponse;
 	sq_export.GetTokenizedResponse = StatQuery_GetTokenizedResponse;
 	sq_export.Poll = StatQuery_Poll;
+	sq_export.Prepare = StatQuery_Prepare;
 
 	// init JSON
 	hooks.malloc_fn = SQ_JSON_Alloc;
@@ -71,6 +71,10 @@ typedef struct stat_query_api_s
 
 	// translates to wswcurl_perform()
 	void ( *Poll )( void );
+
+	// serialize the POST data ahead of Send, this is thread-safe as long as
+	// the query isn't touched by anything else in the meantime
+	void ( *Prepare )( stat_query_t *query );
 } stat_query_api_t;
 
 #endif
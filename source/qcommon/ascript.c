@@ -171,6 +171,7 @@ void Com_ScriptModule_Init( void )
 	import.Print = Com_ScriptModule_Print;
 
 	import.Milliseconds = Sys_Milliseconds;
+	import.Microseconds = Sys_Microseconds;
 
 	import.Cvar_Get = Cvar_Get;
 	import.Cvar_Set = Cvar_Set;
@@ -187,6 +188,12 @@ void Com_ScriptModule_Init( void )
 	import.Cmd_RemoveCommand = Cmd_RemoveCommand;
 	import.Cmd_ExecuteText = Cbuf_ExecuteText;
 
+	import.FS_FOpenFile = FS_FOpenFile;
+	import.FS_Read = FS_Read;
+	import.FS_Write = FS_Write;
+	import.FS_FCloseFile = FS_FCloseFile;
+	import.FS_RemoveFile = FS_RemoveFile;
+
 	import.Mem_Alloc = Com_ScriptModule_MemAlloc;
 	import.Mem_Free = Com_ScriptModule_MemFree;
 	import.Mem_AllocPool = Com_ScriptModule_MemAllocPool;
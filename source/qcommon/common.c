@@ -827,6 +827,8 @@ void Qcommon_InitCommands( void )
 #ifndef PUBLIC_BUILD
 	Cmd_AddCommand( "error", Com_Error_f );
 	Cmd_AddCommand( "lag", Com_Lag_f );
+	Cmd_AddCommand( "bufpipebench", QBufPipe_Bench_f );
+	Cmd_AddCommand( "jobsbench", QJobs_Bench_f );
 #endif
 
 	Cmd_AddCommand( "irc_connect", Irc_Connect_f );
@@ -849,6 +851,8 @@ void Qcommon_ShutdownCommands( void )
 #ifndef PUBLIC_BUILD
 	Cmd_RemoveCommand( "error" );
 	Cmd_RemoveCommand( "lag" );
+	Cmd_RemoveCommand( "bufpipebench" );
+	Cmd_RemoveCommand( "jobsbench" );
 #endif
 
 	Cmd_RemoveCommand( "irc_connect" );
@@ -929,6 +933,8 @@ void Qcommon_Init( int argc, char **argv )
     
 	Com_LoadCompressionLibraries();
 
+	QJobs_Init();
+
 	FS_Init();
 
 	Cbuf_AddText( "exec default.cfg\n" );
@@ -1165,6 +1171,8 @@ void Qcommon_Shutdown( void )
 
 	FS_Shutdown();
 
+	QJobs_Shutdown();
+
 	Com_UnloadCompressionLibraries();
 
 	wswcurl_cleanup();
@@ -32,6 +32,12 @@ int (ZEXPORT *qzinflateInit2_)(z_streamp strm, int  windowBits, const char *vers
 int (ZEXPORT *qzinflate)(z_streamp strm, int flush);
 int (ZEXPORT *qzinflateEnd)(z_streamp strm);
 int (ZEXPORT *qzinflateReset)(z_streamp strm);
+int (ZEXPORT *qzinflateSetDictionary)(z_streamp strm, const Bytef *dictionary, uInt dictLength);
+int (ZEXPORT *qzdeflateInit_)(z_streamp strm, int level, const char *version, int stream_size);
+int (ZEXPORT *qzdeflate)(z_streamp strm, int flush);
+int (ZEXPORT *qzdeflateEnd)(z_streamp strm);
+int (ZEXPORT *qzdeflateReset)(z_streamp strm);
+int (ZEXPORT *qzdeflateSetDictionary)(z_streamp strm, const Bytef *dictionary, uInt dictLength);
 gzFile (ZEXPORT *qgzopen)(const char *, const char *);
 z_off_t (ZEXPORT *qgzseek)(gzFile, z_off_t, int);
 z_off_t (ZEXPORT *qgztell)(gzFile);
@@ -52,6 +58,12 @@ static dllfunc_t zlibfuncs[] =
 	{ "inflate", ( void **)&qzinflate },
 	{ "inflateEnd", ( void **)&qzinflateEnd },
 	{ "inflateReset", ( void **)&qzinflateReset },
+	{ "inflateSetDictionary", ( void **)&qzinflateSetDictionary },
+	{ "deflateInit_", ( void **)&qzdeflateInit_ },
+	{ "deflate", ( void **)&qzdeflate },
+	{ "deflateEnd", ( void **)&qzdeflateEnd },
+	{ "deflateReset", ( void **)&qzdeflateReset },
+	{ "deflateSetDictionary", ( void **)&qzdeflateSetDictionary },
 	{ "gzopen", ( void **)&qgzopen },
 	{ "gzseek", ( void **)&qgzseek },
 	{ "gztell", ( void **)&qgztell },
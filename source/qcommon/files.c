@@ -90,7 +90,6 @@ typedef struct
 #define FS_PACKFILE_COHERENT	    2
 #define FS_PACKFILE_DIRECTORY		4
 
-#define FS_PACKFILE_NUM_THREADS		4     // including the main thread
 
 typedef struct packfile_s
 {
@@ -584,6 +583,21 @@ const char *FS_PakNameForFile( const char *filename )
 	return FS_PakNameForPath( search->pack );
 }
 
+/*
+* FS_PakChecksumForFile
+*
+* Returns the checksum of the pak file the file would be loaded from, 0 for loose files.
+*/
+unsigned FS_PakChecksumForFile( const char *filename )
+{
+	searchpath_t *search = FS_SearchPathForFile( filename, NULL, NULL, 0, NULL, FS_SEARCH_ALL );
+
+	if( !search || !search->pack )
+		return 0;
+
+	return search->pack->checksum;
+}
+
 /*
 * FS_VFSHandleForPakName
 *
@@ -3816,34 +3830,20 @@ static void FS_ReplaceDeferredPaks( void )
 /*
 * FS_LoadDeferredPaks_Job
 */
-typedef struct
+static void FS_LoadDeferredPaks_Job( void *parg, unsigned int first, unsigned int count, int worker )
 {
-	volatile int *cnt;
-	int maxcnt;
-	pack_t **packs;
-	qmutex_t *mutex;
-} deferred_pack_arg_t;
-
-static void *FS_LoadDeferredPaks_Job( void *parg )
-{
-	int i;
+	unsigned int i;
 	pack_t *pack;
-	deferred_pack_arg_t *arg = parg;
-
-	while( true ) {
-		i = Sys_Atomic_Add( arg->cnt, 1, arg->mutex );
-		if( i >= arg->maxcnt )
-			break;
+	pack_t **packs = parg;
 
-		pack = arg->packs[i];
+	for( i = first; i < first + count; i++ ) {
+		pack = packs[i];
 
 		assert( pack != NULL );
 		assert( pack->deferred_load );
 
 		pack->deferred_pack = FS_LoadPackFile( pack->filename, false );
 	}
-
-	return NULL;
 }
 
 /*
@@ -3851,13 +3851,9 @@ static void *FS_LoadDeferredPaks_Job( void *parg )
 */
 static void FS_LoadDeferredPaks( int newpaks )
 {
-	int i;
-	volatile int cnt;
-	qthread_t *threads[FS_PACKFILE_NUM_THREADS - 1] = { NULL };
-	const int num_threads = min( newpaks, FS_PACKFILE_NUM_THREADS ) - 1;
+	int cnt;
 	pack_t **packs;
 	searchpath_t *search;
-	deferred_pack_arg_t *arg;
 
 	if( !newpaks )
 		return;
@@ -3875,30 +3871,11 @@ static void FS_LoadDeferredPaks( int newpaks )
 		}
 	}
 
-	arg = Mem_TempMalloc( sizeof( *arg ) );
-	arg->cnt = Mem_TempMalloc( sizeof( int ) );
-	arg->maxcnt = newpaks;
-	arg->packs = packs;
-	arg->mutex = QMutex_Create();
-
-	if( num_threads > 0 ) {
-		for( i = 0; i < num_threads; i++ )
-			threads[i] = QThread_Create( FS_LoadDeferredPaks_Job, arg );
-	}
-
-	FS_LoadDeferredPaks_Job( arg );
-
-	if( num_threads > 0 ) {
-		for( i = 0; i < num_threads; i++ )
-			QThread_Join( threads[i] );
-	}
+	QJobs_ParallelFor( cnt, 1, FS_LoadDeferredPaks_Job, packs );
 
 	FS_ReplaceDeferredPaks();
 
-	Mem_TempFree( (void *)arg->cnt );
-	Mem_TempFree( arg->packs );
-	QMutex_Destroy( &arg->mutex );
-	Mem_TempFree( arg );
+	Mem_TempFree( packs );
 }
 
 /*
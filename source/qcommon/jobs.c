@@ -0,0 +1,657 @@
+/*
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+*/
+
+// jobs.c -- work-stealing job scheduler shared by the engine and the modules
+
+#include "qcommon.h"
+#include "sys_threads.h"
+
+#define QJOBS_MAX_WORKERS		15		// not counting the threads outside the pool
+#define QJOBS_MAX_JOBS			1024	// power of two, job handles keep the index in the low bits
+#define QJOBS_MAX_DEPENDENCIES	4		// the rest are waited for before the job is added
+#define QJOBS_MAX_RANGES		64
+
+#define QJOBS_HANDLE_INDEX( h )	( ( h ) & ( QJOBS_MAX_JOBS - 1 ) )
+#define QJOBS_HANDLE( index, generation ) ( ( ( generation ) * QJOBS_MAX_JOBS ) | ( index ) )
+
+#ifdef _MSC_VER
+#define QJOBS_THREAD_LOCAL	__declspec( thread )
+#else
+#define QJOBS_THREAD_LOCAL	__thread
+#endif
+
+typedef struct
+{
+	qjobfunc_t func;
+	void *arg;
+
+	unsigned int generation;	// bumped when the job is done, so stale handles read as done
+	bool inuse;
+	int pending;				// unfinished dependencies
+
+	// jobs waiting for this one, linked through their dependency slots
+	int firstDependent, firstDependentSlot;
+	int nextDependent[QJOBS_MAX_DEPENDENCIES], nextDependentSlot[QJOBS_MAX_DEPENDENCIES];
+
+	int nextFree;
+} qjob_t;
+
+// jobs ready to run, the owner takes the newest, thieves the oldest
+typedef struct
+{
+	qmutex_t *mutex;
+	unsigned int head, tail;
+	int jobs[QJOBS_MAX_JOBS];
+} qjobqueue_t;
+
+typedef struct
+{
+	qjobrangefunc_t func;
+	void *arg;
+	unsigned int count, granularity;
+	int numChunks;
+	volatile int nextChunk, chunksDone;
+	int refs;				// the caller and the helper jobs
+} qjobrange_t;
+
+static struct
+{
+	bool initialized;
+	volatile int shutdown;
+	int numWorkers;
+	qthread_t *threads[QJOBS_MAX_WORKERS];
+
+	// guards the jobs, their dependencies and the ranges
+	qmutex_t *mutex;
+	qcondvar_t *doneCond;	// signaled when a job or a range finishes
+	int numWaiters;
+
+	qjob_t jobs[QJOBS_MAX_JOBS];
+	int firstFree;
+
+	qjobrange_t ranges[QJOBS_MAX_RANGES];
+
+	// queue 0 takes the jobs added by threads outside the pool
+	qjobqueue_t queues[QJOBS_MAX_WORKERS + 1];
+	volatile int numQueued;
+
+	qmutex_t *wakeMutex;
+	qcondvar_t *wakeCond;	// signaled when a job is queued and a worker sleeps
+	volatile int numSleeping;
+} qjobs;
+
+static cvar_t *com_workers;
+
+// 0 for threads outside the pool
+static QJOBS_THREAD_LOCAL int qjobs_worker;
+
+/*
+* QJobs_AtomicLoad
+*/
+static int QJobs_AtomicLoad( volatile int *value )
+{
+	int val;
+
+	do {
+		val = *value;
+	} while( !Sys_Atomic_CAS( value, val, val, qjobs.mutex ) );
+
+	return val;
+}
+
+/*
+* QJobs_AtomicFetchAdd
+*
+* Returns the previous value, Sys_Atomic_Add doesn't agree on that between platforms
+*/
+static int QJobs_AtomicFetchAdd( volatile int *value, int add )
+{
+	int val;
+
+	do {
+		val = *value;
+	} while( !Sys_Atomic_CAS( value, val, val + add, qjobs.mutex ) );
+
+	return val;
+}
+
+/*
+* QJobs_WakeWaiters
+*
+* Must be called with the mutex held
+*/
+static void QJobs_WakeWaiters( void )
+{
+	int i;
+
+	for( i = 0; i < qjobs.numWaiters; i++ ) {
+		QCondVar_Wake( qjobs.doneCond );
+	}
+}
+
+/*
+* QJobs_Push
+*/
+static void QJobs_Push( int index )
+{
+	qjobqueue_t *queue = &qjobs.queues[qjobs_worker];
+
+	QMutex_Lock( queue->mutex );
+	assert( queue->tail - queue->head < QJOBS_MAX_JOBS );
+	queue->jobs[queue->tail++ & ( QJOBS_MAX_JOBS - 1 )] = index;
+	QMutex_Unlock( queue->mutex );
+
+	// the sleeping count is raised before the workers check for jobs,
+	// and jobs are counted before it's checked here
+	QJobs_AtomicFetchAdd( &qjobs.numQueued, 1 );
+	if( QJobs_AtomicLoad( &qjobs.numSleeping ) ) {
+		QMutex_Lock( qjobs.wakeMutex );
+		QCondVar_Wake( qjobs.wakeCond );
+		QMutex_Unlock( qjobs.wakeMutex );
+	}
+}
+
+/*
+* QJobs_Pop
+*/
+static int QJobs_Pop( qjobqueue_t *queue, bool newest )
+{
+	int index = -1;
+
+	if( queue->head == queue->tail ) {
+		// unlocked peek, a job that is just being added is found on the next try
+		return -1;
+	}
+
+	QMutex_Lock( queue->mutex );
+	if( queue->head != queue->tail ) {
+		if( newest ) {
+			index = queue->jobs[--queue->tail & ( QJOBS_MAX_JOBS - 1 )];
+		} else {
+			index = queue->jobs[queue->head++ & ( QJOBS_MAX_JOBS - 1 )];
+		}
+	}
+	QMutex_Unlock( queue->mutex );
+
+	if( index >= 0 ) {
+		QJobs_AtomicFetchAdd( &qjobs.numQueued, -1 );
+	}
+	return index;
+}
+
+/*
+* QJobs_Complete
+*/
+static void QJobs_Complete( int index )
+{
+	int dependent, slot, next;
+	qjob_t *job = &qjobs.jobs[index];
+
+	QMutex_Lock( qjobs.mutex );
+
+	for( dependent = job->firstDependent, slot = job->firstDependentSlot; dependent >= 0; dependent = next ) {
+		qjob_t *djob = &qjobs.jobs[dependent];
+
+		next = djob->nextDependent[slot];
+		slot = djob->nextDependentSlot[slot];
+
+		if( !--djob->pending ) {
+			QJobs_Push( dependent );
+		}
+	}
+
+	job->inuse = false;
+	job->generation++;
+	if( !QJOBS_HANDLE( index, job->generation ) ) {
+		job->generation++;	// the generation wrapped, 0 means no job
+	}
+	job->nextFree = qjobs.firstFree;
+	qjobs.firstFree = index;
+
+	QJobs_WakeWaiters();
+
+	QMutex_Unlock( qjobs.mutex );
+}
+
+/*
+* QJobs_RunOne
+*
+* Runs a job from the queue of the worker or steals one from the others
+*/
+static bool QJobs_RunOne( int worker )
+{
+	int i, index;
+	qjob_t *job;
+
+	index = QJobs_Pop( &qjobs.queues[worker], true );
+	for( i = 1; index < 0 && i <= qjobs.numWorkers; i++ ) {
+		index = QJobs_Pop( &qjobs.queues[( worker + i ) % ( qjobs.numWorkers + 1 )], false );
+	}
+	if( index < 0 ) {
+		return false;
+	}
+
+	job = &qjobs.jobs[index];
+	job->func( job->arg, worker );
+
+	QJobs_Complete( index );
+	return true;
+}
+
+/*
+* QJobs_WorkerProc
+*/
+static void *QJobs_WorkerProc( void *param )
+{
+	qjobs_worker = ( int )( intptr_t )param;
+
+	while( !qjobs.shutdown ) {
+		if( QJobs_RunOne( qjobs_worker ) ) {
+			continue;
+		}
+
+		QMutex_Lock( qjobs.wakeMutex );
+		QJobs_AtomicFetchAdd( &qjobs.numSleeping, 1 );
+		if( !QJobs_AtomicLoad( &qjobs.numQueued ) && !qjobs.shutdown ) {
+			QCondVar_Wait( qjobs.wakeCond, qjobs.wakeMutex, Q_THREADS_WAIT_INFINITE );
+		}
+		QJobs_AtomicFetchAdd( &qjobs.numSleeping, -1 );
+		QMutex_Unlock( qjobs.wakeMutex );
+	}
+
+	return NULL;
+}
+
+/*
+* QJobs_Init
+*/
+void QJobs_Init( void )
+{
+	int i;
+
+	memset( &qjobs, 0, sizeof( qjobs ) );
+
+	// changes take effect on restart
+	com_workers = Cvar_Get( "com_workers", "-1", 0 );
+
+	// by default there's a worker for every core but the one of the main thread
+	qjobs.numWorkers = com_workers->integer < 0 ? Sys_Thread_NumProcessors() - 1 : com_workers->integer;
+	qjobs.numWorkers = bound( 0, qjobs.numWorkers, QJOBS_MAX_WORKERS );
+
+	qjobs.mutex = QMutex_Create();
+	qjobs.doneCond = QCondVar_Create();
+	qjobs.wakeMutex = QMutex_Create();
+	qjobs.wakeCond = QCondVar_Create();
+
+	for( i = 0; i < QJOBS_MAX_JOBS; i++ ) {
+		qjobs.jobs[i].generation = 1;
+		qjobs.jobs[i].nextFree = i + 1 < QJOBS_MAX_JOBS ? i + 1 : -1;
+	}
+	qjobs.firstFree = 0;
+
+	for( i = 0; i <= qjobs.numWorkers; i++ ) {
+		qjobs.queues[i].mutex = QMutex_Create();
+	}
+
+	for( i = 0; i < qjobs.numWorkers; i++ ) {
+		// worker 0 is any thread outside the pool
+		qjobs.threads[i] = QThread_Create( QJobs_WorkerProc, ( void * )( intptr_t )( i + 1 ) );
+	}
+
+	qjobs.initialized = true;
+}
+
+/*
+* QJobs_Shutdown
+*/
+void QJobs_Shutdown( void )
+{
+	int i;
+
+	if( !qjobs.initialized ) {
+		return;
+	}
+
+	// nobody may be left waiting for a job
+	while( QJobs_RunOne( 0 ) );
+
+	QMutex_Lock( qjobs.wakeMutex );
+	qjobs.shutdown = 1;
+	for( i = 0; i < qjobs.numWorkers; i++ ) {
+		QCondVar_Wake( qjobs.wakeCond );
+	}
+	QMutex_Unlock( qjobs.wakeMutex );
+
+	for( i = 0; i < qjobs.numWorkers; i++ ) {
+		QThread_Join( qjobs.threads[i] );
+	}
+
+	for( i = 0; i <= qjobs.numWorkers; i++ ) {
+		QMutex_Destroy( &qjobs.queues[i].mutex );
+	}
+
+	QCondVar_Destroy( &qjobs.wakeCond );
+	QMutex_Destroy( &qjobs.wakeMutex );
+	QCondVar_Destroy( &qjobs.doneCond );
+	QMutex_Destroy( &qjobs.mutex );
+
+	qjobs.initialized = false;
+}
+
+/*
+* QJobs_NumWorkers
+*
+* Returns the number of distinct worker indices. The threads outside the
+* pool all run jobs as worker 0, so that index is not exclusive to a thread.
+*/
+int QJobs_NumWorkers( void )
+{
+	return qjobs.numWorkers + 1;
+}
+
+/*
+* QJobs_IsPending
+*
+* Must be called with the mutex held
+*/
+static bool QJobs_IsPending( qjobhandle_t handle )
+{
+	const qjob_t *job = &qjobs.jobs[QJOBS_HANDLE_INDEX( handle )];
+	return handle && job->inuse && QJOBS_HANDLE( QJOBS_HANDLE_INDEX( handle ), job->generation ) == handle;
+}
+
+/*
+* QJobs_Wait
+*
+* Blocks until the job is done. Workers of the pool run other jobs
+* while they wait, so jobs may wait for the jobs they add.
+*/
+void QJobs_Wait( qjobhandle_t handle )
+{
+	if( !handle || !qjobs.initialized ) {
+		return;
+	}
+
+	QMutex_Lock( qjobs.mutex );
+
+	while( QJobs_IsPending( handle ) ) {
+		if( qjobs_worker ) {
+			QMutex_Unlock( qjobs.mutex );
+			if( QJobs_RunOne( qjobs_worker ) ) {
+				QMutex_Lock( qjobs.mutex );
+				continue;
+			}
+			QMutex_Lock( qjobs.mutex );
+
+			// new jobs don't signal the waiters, so check for them now and then
+			qjobs.numWaiters++;
+			QCondVar_Wait( qjobs.doneCond, qjobs.mutex, 1 );
+			qjobs.numWaiters--;
+			continue;
+		}
+
+		qjobs.numWaiters++;
+		QCondVar_Wait( qjobs.doneCond, qjobs.mutex, Q_THREADS_WAIT_INFINITE );
+		qjobs.numWaiters--;
+	}
+
+	QMutex_Unlock( qjobs.mutex );
+}
+
+/*
+* QJobs_Add
+*
+* Queues a job that runs once all jobs in deps are done, returns 0
+* if the job was run right away. Handles of jobs that are already
+* done may be passed as dependencies.
+*/
+qjobhandle_t QJobs_Add( qjobfunc_t func, void *arg, const qjobhandle_t *deps, int numDeps )
+{
+	int i, index;
+	qjob_t *job, *djob;
+	qjobhandle_t handle;
+
+	if( numDeps > QJOBS_MAX_DEPENDENCIES ) {
+		for( i = QJOBS_MAX_DEPENDENCIES; i < numDeps; i++ ) {
+			QJobs_Wait( deps[i] );
+		}
+		numDeps = QJOBS_MAX_DEPENDENCIES;
+	}
+
+	if( !qjobs.initialized || !qjobs.numWorkers ) {
+		goto run;
+	}
+
+	QMutex_Lock( qjobs.mutex );
+
+	index = qjobs.firstFree;
+	if( index < 0 ) {
+		QMutex_Unlock( qjobs.mutex );
+		goto run;
+	}
+
+	job = &qjobs.jobs[index];
+	qjobs.firstFree = job->nextFree;
+
+	job->func = func;
+	job->arg = arg;
+	job->inuse = true;
+	job->pending = 0;
+	job->firstDependent = job->firstDependentSlot = -1;
+	handle = QJOBS_HANDLE( index, job->generation );
+
+	for( i = 0; i < numDeps; i++ ) {
+		if( !QJobs_IsPending( deps[i] ) ) {
+			continue;
+		}
+
+		djob = &qjobs.jobs[QJOBS_HANDLE_INDEX( deps[i] )];
+
+		job->nextDependent[job->pending] = djob->firstDependent;
+		job->nextDependentSlot[job->pending] = djob->firstDependentSlot;
+		djob->firstDependent = index;
+		djob->firstDependentSlot = job->pending;
+		job->pending++;
+	}
+
+	if( !job->pending ) {
+		QJobs_Push( index );
+	}
+
+	QMutex_Unlock( qjobs.mutex );
+	return handle;
+
+run:
+	// without workers or free slots, run it on this thread
+	for( i = 0; i < numDeps; i++ ) {
+		QJobs_Wait( deps[i] );
+	}
+	func( arg, qjobs_worker );
+	return 0;
+}
+
+/*
+* QJobs_RunChunks
+*/
+static void QJobs_RunChunks( qjobrange_t *range, int worker )
+{
+	int chunk;
+	unsigned int first;
+
+	while( ( chunk = QJobs_AtomicFetchAdd( &range->nextChunk, 1 ) ) < range->numChunks ) {
+		first = chunk * range->granularity;
+		range->func( range->arg, first, min( range->granularity, range->count - first ), worker );
+
+		if( QJobs_AtomicFetchAdd( &range->chunksDone, 1 ) + 1 == range->numChunks ) {
+			QMutex_Lock( qjobs.mutex );
+			QJobs_WakeWaiters();
+			QMutex_Unlock( qjobs.mutex );
+		}
+	}
+}
+
+/*
+* QJobs_RangeJob
+*/
+static void QJobs_RangeJob( void *arg, int worker )
+{
+	qjobrange_t *range = arg;
+
+	QJobs_RunChunks( range, worker );
+
+	QMutex_Lock( qjobs.mutex );
+	range->refs--;
+	QMutex_Unlock( qjobs.mutex );
+}
+
+/*
+* QJobs_ParallelFor
+*
+* Splits [0, count) into chunks of granularity items and runs them on the
+* pool and the calling thread, returning when all are done. The caller
+* takes chunks until none are left, so it never waits for jobs that
+* haven't started yet.
+*/
+void QJobs_ParallelFor( unsigned int count, unsigned int granularity, qjobrangefunc_t func, void *arg )
+{
+	int i, numHelpers = 0;
+	qjobrange_t *range = NULL;
+
+	if( !count ) {
+		return;
+	}
+
+	granularity = max( granularity, 1 );
+	if( qjobs.initialized && qjobs.numWorkers && count > granularity ) {
+		QMutex_Lock( qjobs.mutex );
+		for( i = 0; i < QJOBS_MAX_RANGES; i++ ) {
+			if( !qjobs.ranges[i].refs ) {
+				range = &qjobs.ranges[i];
+				break;
+			}
+		}
+
+		if( range ) {
+			range->func = func;
+			range->arg = arg;
+			range->count = count;
+			range->granularity = granularity;
+			range->numChunks = ( count + granularity - 1 ) / granularity;
+			range->nextChunk = range->chunksDone = 0;
+
+			numHelpers = min( range->numChunks - 1, qjobs.numWorkers );
+			range->refs = numHelpers + 1;
+		}
+		QMutex_Unlock( qjobs.mutex );
+	}
+
+	if( !range ) {
+		func( arg, 0, count, qjobs_worker );
+		return;
+	}
+
+	for( i = 0; i < numHelpers; i++ ) {
+		QJobs_Add( QJobs_RangeJob, range, NULL, 0 );
+	}
+
+	QJobs_RunChunks( range, qjobs_worker );
+
+	QMutex_Lock( qjobs.mutex );
+	while( QJobs_AtomicLoad( &range->chunksDone ) < range->numChunks ) {
+		qjobs.numWaiters++;
+		QCondVar_Wait( qjobs.doneCond, qjobs.mutex, Q_THREADS_WAIT_INFINITE );
+		qjobs.numWaiters--;
+	}
+
+	// helper jobs that start late find no chunks and drop their reference
+	range->refs--;
+	QMutex_Unlock( qjobs.mutex );
+}
+
+// ============================================================================
+
+#define QJOBS_BENCH_CHAIN	64
+
+static volatile int qjobsBenchCounter;
+
+/*
+* QJobs_BenchJob
+*/
+static void QJobs_BenchJob( void *arg, int worker )
+{
+	QJobs_AtomicFetchAdd( &qjobsBenchCounter, 1 );
+}
+
+/*
+* QJobs_BenchRangeJob
+*/
+static void QJobs_BenchRangeJob( void *arg, unsigned int first, unsigned int count, int worker )
+{
+	QJobs_AtomicFetchAdd( &qjobsBenchCounter, count );
+}
+
+/*
+* QJobs_Bench_f
+*
+* jobsbench [jobs]
+*/
+void QJobs_Bench_f( void )
+{
+	int i, j, numJobs;
+	uint64_t time;
+	qjobhandle_t handle, *handles;
+
+	numJobs = Cmd_Argc() > 1 ? bound( 1, atoi( Cmd_Argv( 1 ) ), QJOBS_MAX_JOBS ) : 1000;
+	handles = Mem_TempMalloc( numJobs * sizeof( *handles ) );
+
+	Com_Printf( "%i workers\n", QJobs_NumWorkers() );
+
+	// independent jobs
+	qjobsBenchCounter = 0;
+	time = Sys_Microseconds();
+	for( i = 0; i < numJobs; i++ ) {
+		handles[i] = QJobs_Add( QJobs_BenchJob, NULL, NULL, 0 );
+	}
+	for( i = 0; i < numJobs; i++ ) {
+		QJobs_Wait( handles[i] );
+	}
+	time = Sys_Microseconds() - time;
+	Com_Printf( "add and wait: %i jobs, %.2f us per job\n", qjobsBenchCounter, (double)time / numJobs );
+
+	// every job depends on the previous one
+	qjobsBenchCounter = 0;
+	time = Sys_Microseconds();
+	for( i = 0; i < numJobs; i += QJOBS_BENCH_CHAIN ) {
+		handle = 0;
+		for( j = i; j < numJobs && j < i + QJOBS_BENCH_CHAIN; j++ ) {
+			handle = QJobs_Add( QJobs_BenchJob, NULL, &handle, 1 );
+		}
+		QJobs_Wait( handle );
+	}
+	time = Sys_Microseconds() - time;
+	Com_Printf( "dependency chains: %i jobs, %.2f us per job\n", qjobsBenchCounter, (double)time / numJobs );
+
+	// one item per chunk
+	qjobsBenchCounter = 0;
+	time = Sys_Microseconds();
+	QJobs_ParallelFor( numJobs, 1, QJobs_BenchRangeJob, NULL );
+	time = Sys_Microseconds() - time;
+	Com_Printf( "parallel for: %i chunks, %.2f us per chunk\n", qjobsBenchCounter, (double)time / numJobs );
+
+	Mem_TempFree( handles );
+}
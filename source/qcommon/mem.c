@@ -523,6 +523,30 @@ static void Mem_CountPoolStats( mempool_t *pool, int *count, int *size, int *rea
 		( *realsize ) += pool->realsize;
 }
 
+/*
+* Mem_NamedPoolTotalSize
+*
+* Returns the amount of memory allocated from the top-level pool with the
+* given name and all of its children, or 0 if there is no such pool.
+*/
+size_t Mem_NamedPoolTotalSize( const char *name )
+{
+	int size;
+	mempool_t *pool;
+
+	for( pool = poolChain; pool; pool = pool->next )
+	{
+		if( !strcmp( pool->name, name ) )
+		{
+			size = 0;
+			Mem_CountPoolStats( pool, NULL, &size, NULL );
+			return size;
+		}
+	}
+
+	return 0;
+}
+
 static void Mem_PrintStats( void )
 {
 	int count, size, real;
@@ -1793,9 +1793,11 @@ int NET_SetSocketNoDelay( socket_t *socket, int nodelay )
 }
 
 /*
-* NET_Sleep
+* NET_SleepMicroseconds
+*
+* Sleeps until the timeout expires or data arrives on any of the sockets
 */
-void NET_Sleep( int msec, socket_t *sockets[] )
+void NET_SleepMicroseconds( uint64_t usec, socket_t *sockets[] )
 {
 	struct timeval timeout;
 	fd_set fdset;
@@ -1826,11 +1828,19 @@ void NET_Sleep( int msec, socket_t *sockets[] )
 		}
 	}
 
-	timeout.tv_sec = msec / 1000;
-	timeout.tv_usec = ( msec % 1000 ) * 1000;
+	timeout.tv_sec = usec / 1000000;
+	timeout.tv_usec = usec % 1000000;
 	select( FD_SETSIZE, &fdset, NULL, NULL, &timeout );
 }
 
+/*
+* NET_Sleep
+*/
+void NET_Sleep( int msec, socket_t *sockets[] )
+{
+	NET_SleepMicroseconds( (uint64_t)max( msec, 0 ) * 1000, sockets );
+}
+
 /*
 * NET_Monitor
 * Monitors the given sockets with the given timeout in milliseconds
@@ -143,96 +143,256 @@ void Netchan_Setup( netchan_t *chan, const socket_t *socket, const netadr_t *add
 
 static uint8_t msg_process_data[MAX_MSGLEN];
 
+//=============================================================
 //=============================================================
 // Zlib compression
 //=============================================================
 
 #include "compression.h"
 
+/*
+* Preset dictionary for reliable and fragmented messages. Short messages such as
+* configstring updates and scoreboards mostly consist of the same command names,
+* paths and info keys, which zlib can't find repetitions of on its own. The
+* strings that are most likely to appear are placed at the end of the dictionary,
+* where they can be referenced with the shortest distances.
+*
+* Streams compressed with the dictionary carry its checksum in the zlib header,
+* so the receiving side doesn't need to be told which kind of message it got.
+* Changing the contents requires bumping NETCHAN_DICTIONARY_VERSION.
+*/
+static const char netchan_dictionary[] =
+	"models/objects/gibs/illuminati1/illuminati1.md3"
+	"models/objects/projectile/"
+	"models/weapons/gunblade/gunblade.md3"
+	"models/weapons/machinegun/machinegun.md3"
+	"models/weapons/riotgun/riotgun.md3"
+	"models/weapons/glauncher/glauncher.md3"
+	"models/weapons/rlauncher/rlauncher.md3"
+	"models/weapons/plasmagun/plasmagun.md3"
+	"models/weapons/lasergun/lasergun.md3"
+	"models/weapons/electrobolt/electrobolt.md3"
+	"models/weapons/instagun/instagun.md3"
+	"models/powerups/"
+	"models/items/armor/"
+	"models/items/health/"
+	"models/items/ammo/"
+	"models/players/bigvic/default"
+	"models/players/padpork/default"
+	"models/players/viciious/default"
+	"sounds/announcer/countdown/"
+	"sounds/announcer/ctf/"
+	"sounds/announcer/callvote/"
+	"sounds/announcer/"
+	"sounds/weapons/"
+	"sounds/items/"
+	"sounds/world/"
+	"sounds/misc/"
+	"sounds/players/"
+	"gfx/hud/icons/"
+	"gfx/misc/"
+	"gfx/"
+	".md3"
+	".wav"
+	".ogg"
+	".tga"
+	".png"
+	"\\hand\\2\\color\\255 255 255\\skin\\default\\model\\bigvic"
+	"\\name\\"
+	"\\mmflags\\"
+	"\\cl_mm_session\\"
+	"\\f\\"
+	"cmd "
+	"changing"
+	"reconnect"
+	"disconnect"
+	"precache"
+	"obry \""
+	"memo \""
+	"mapmsg \""
+	"qm \""
+	"mm \""
+	"plstats 0 \""
+	"aw \""
+	"cpf \""
+	"cp \""
+	"tvch \""
+	"tch \""
+	"ch \""
+	"pr \""
+	"scb \"&t 1 0 0 &t 2 0 0 &s &p "
+	" 0 0 0 0 0 0 0 \"";
+
+static z_stream netchan_deflateStream;
+static z_stream netchan_inflateStream;
+static bool netchan_deflateInitialized;
+static bool netchan_inflateInitialized;
+
+typedef struct
+{
+	unsigned int messages;
+	uint64_t bytesIn;
+	uint64_t bytesOut;
+	uint64_t usec;
+} netchan_compression_stats_t;
+
+// plain and dictionary compression, and decompression of both
+static netchan_compression_stats_t netchan_compressStats[2];
+static netchan_compression_stats_t netchan_decompressStats;
+
+static cvar_t *net_showcompression;
+
 static int Netchan_ZLibCompressChunk( const uint8_t *source, unsigned long sourceLen, uint8_t *dest, unsigned long destLen,
-									 int level, int wbits )
+									 int level, bool dictionary )
 {
-	int result, zlerror;
+	int zlerror;
+	z_stream *strm = &netchan_deflateStream;
 
-	zlerror = qzcompress2( dest, &destLen, source, sourceLen, level );
+	// the stream is kept around so that the compression state
+	// isn't allocated and set up again for every message
+	if( !netchan_deflateInitialized )
+	{
+		memset( strm, 0, sizeof( *strm ) );
+		zlerror = qzdeflateInit( strm, level );
+		if( zlerror != Z_OK )
+		{
+			Com_DPrintf( "ZLib data error! Error code %i on deflateInit.\n", zlerror );
+			return -1;
+		}
+		netchan_deflateInitialized = true;
+	}
+	else
+	{
+		qzdeflateReset( strm );
+	}
+
+	if( dictionary )
+		qzdeflateSetDictionary( strm, ( const Bytef * )netchan_dictionary, sizeof( netchan_dictionary ) - 1 );
+
+	strm->next_in = ( Bytef * )source;
+	strm->avail_in = sourceLen;
+	strm->next_out = dest;
+	strm->avail_out = destLen;
+
+	zlerror = qzdeflate( strm, Z_FINISH );
 	switch( zlerror )
 	{
+	case Z_STREAM_END:
+		return strm->total_out; // returns the new length
 	case Z_OK:
-		result = destLen; // returns the new length into destLen
-		break;
-	case Z_MEM_ERROR:
-		Com_DPrintf( "ZLib data error! Z_MEM_ERROR on compress.\n" );
-		result = -1;
-		break;
 	case Z_BUF_ERROR:
 		Com_DPrintf( "ZLib data error! Z_BUF_ERROR on compress.\n" );
-		result = -1;
-		break;
+		return -1;
 	case Z_STREAM_ERROR:
 		Com_DPrintf( "ZLib data error! Z_STREAM_ERROR on compress.\n" );
-		result = -1;
-		break;
+		return -1;
 	default:
 		Com_DPrintf( "ZLib data error! Error code %i on compress.\n", zlerror );
-		result = -1;
-		break;
+		return -1;
 	}
-
-	return result;
 }
 
-static int Netchan_ZLibDecompressChunk( const uint8_t *source, unsigned long sourceLen, uint8_t *dest, unsigned long destLen,
-									   int wbits )
+static int Netchan_ZLibDecompressChunk( const uint8_t *source, unsigned long sourceLen, uint8_t *dest, unsigned long destLen )
 {
-	int result, zlerror;
+	int zlerror;
+	z_stream *strm = &netchan_inflateStream;
+
+	if( !netchan_inflateInitialized )
+	{
+		memset( strm, 0, sizeof( *strm ) );
+		zlerror = qzinflateInit2( strm, MAX_WBITS );
+		if( zlerror != Z_OK )
+		{
+			Com_DPrintf( "ZLib data error! Error code %i on inflateInit.\n", zlerror );
+			return -1;
+		}
+		netchan_inflateInitialized = true;
+	}
+	else
+	{
+		qzinflateReset( strm );
+	}
+
+	strm->next_in = ( Bytef * )source;
+	strm->avail_in = sourceLen;
+	strm->next_out = dest;
+	strm->avail_out = destLen;
+
+	zlerror = qzinflate( strm, Z_FINISH );
+	if( zlerror == Z_NEED_DICT )
+	{
+		// fails with Z_DATA_ERROR if the sender used a different dictionary
+		zlerror = qzinflateSetDictionary( strm, ( const Bytef * )netchan_dictionary, sizeof( netchan_dictionary ) - 1 );
+		if( zlerror == Z_OK )
+			zlerror = qzinflate( strm, Z_FINISH );
+	}
 
-	zlerror = qzuncompress( dest, &destLen, source, sourceLen );
 	switch( zlerror )
 	{
-	case Z_OK:
-		result = destLen; // returns the new length into destLen
-		break;
+	case Z_STREAM_END:
+		return strm->total_out; // returns the new length
 	case Z_MEM_ERROR:
 		Com_DPrintf( "ZLib data error! Z_MEM_ERROR on decompress.\n" );
-		result = -1;
-		break;
+		return -1;
+	case Z_OK:
 	case Z_BUF_ERROR:
 		Com_DPrintf( "ZLib data error! Z_BUF_ERROR on decompress.\n" );
-		result = -1;
-		break;
+		return -1;
 	case Z_DATA_ERROR:
 		Com_DPrintf( "ZLib data error! Z_DATA_ERROR on decompress.\n" );
-		result = -1;
-		break;
+		return -1;
 	default:
 		Com_DPrintf( "ZLib data error! Error code %i on decompress.\n", zlerror );
-		result = -1;
-		break;
+		return -1;
 	}
+}
 
-	return result;
+/*
+* Netchan_AddCompressionStats
+*/
+static void Netchan_AddCompressionStats( netchan_compression_stats_t *stats, const char *what,
+	size_t bytesIn, size_t bytesOut, uint64_t usec )
+{
+	stats->messages++;
+	stats->bytesIn += bytesIn;
+	stats->bytesOut += bytesOut;
+	stats->usec += usec;
+
+	if( net_showcompression->integer )
+	{
+		Com_Printf( "%s %4i -> %4i (%5.1f%%) in %u usec\n", what, (int)bytesIn, (int)bytesOut,
+			bytesIn ? 100.0 * bytesOut / bytesIn : 0.0, (unsigned)usec );
+	}
 }
 
 /*
 * Netchan_CompressMessage
 */
-int Netchan_CompressMessage( msg_t *msg )
+int Netchan_CompressMessage( netchan_t *chan, msg_t *msg )
 {
 	int length;
+	bool dictionary;
+	uint64_t start;
 
 	if( msg == NULL || !msg->data )
 		return 0;
 
+	start = Sys_Microseconds();
+	dictionary = chan && chan->dictionaryCompression;
+
 	// zero-fill our buffer
 	length = 0;
 	memset( msg_process_data, 0, sizeof( msg_process_data ) );
 
 	//compress the message
 	length = Netchan_ZLibCompressChunk( msg->data, msg->cursize, 
-		msg_process_data, sizeof( msg_process_data ), Z_BEST_COMPRESSION, -MAX_WBITS );
+		msg_process_data, sizeof( msg_process_data ), Z_BEST_COMPRESSION, dictionary );
 	if( length < 0 )  // failed to compress, return the error
 		return length;
 
+	Netchan_AddCompressionStats( &netchan_compressStats[dictionary ? 1 : 0], dictionary ? "compress (dictionary)" : "compress", 
+		msg->cursize, length, Sys_Microseconds() - start );
+
 	if( (size_t)length >= msg->cursize || length >= MAX_MSGLEN )
 	{
 		return 0; // compressed was bigger. Send uncompressed
@@ -252,6 +412,7 @@ int Netchan_CompressMessage( msg_t *msg )
 int Netchan_DecompressMessage( msg_t *msg )
 {
 	int length;
+	uint64_t start;
 
 	if( msg == NULL || !msg->data )
 		return 0;
@@ -259,7 +420,9 @@ int Netchan_DecompressMessage( msg_t *msg )
 	if( msg->compressed == false )
 		return 0;
 
-	length = Netchan_ZLibDecompressChunk( msg->data + msg->readcount, msg->cursize - msg->readcount, msg_process_data, ( sizeof( msg_process_data ) - msg->readcount ), -MAX_WBITS );
+	start = Sys_Microseconds();
+
+	length = Netchan_ZLibDecompressChunk( msg->data + msg->readcount, msg->cursize - msg->readcount, msg_process_data, ( sizeof( msg_process_data ) - msg->readcount ) );
 	if( length < 0 )
 		return length;
 
@@ -269,6 +432,9 @@ int Netchan_DecompressMessage( msg_t *msg )
 		return -1;
 	}
 
+	Netchan_AddCompressionStats( &netchan_decompressStats, "decompress", msg->cursize - msg->readcount, length, 
+		Sys_Microseconds() - start );
+
 	//write it back into the original container
 	msg->cursize = msg->readcount;
 	MSG_CopyData( msg, msg_process_data, length );
@@ -277,6 +443,39 @@ int Netchan_DecompressMessage( msg_t *msg )
 	return length;
 }
 
+/*
+* Netchan_PrintCompressionStats
+*/
+static void Netchan_PrintCompressionStats( const char *what, const netchan_compression_stats_t *stats )
+{
+	if( !stats->messages )
+	{
+		Com_Printf( "%-22s no messages\n", what );
+		return;
+	}
+
+	Com_Printf( "%-22s %8u msgs %10.0f -> %10.0f bytes (%5.1f%%) %8.3f ms (%.1f usec/msg)\n", what, 
+		stats->messages, (double)stats->bytesIn, (double)stats->bytesOut, 100.0 * stats->bytesOut / stats->bytesIn, 
+		stats->usec / 1000.0, (double)stats->usec / stats->messages );
+}
+
+/*
+* Netchan_CompressionStats_f
+*/
+static void Netchan_CompressionStats_f( void )
+{
+	if( !Q_stricmp( Cmd_Argv( 1 ), "reset" ) )
+	{
+		memset( netchan_compressStats, 0, sizeof( netchan_compressStats ) );
+		memset( &netchan_decompressStats, 0, sizeof( netchan_decompressStats ) );
+		return;
+	}
+
+	Netchan_PrintCompressionStats( "compress", &netchan_compressStats[0] );
+	Netchan_PrintCompressionStats( "compress (dictionary)", &netchan_compressStats[1] );
+	Netchan_PrintCompressionStats( "decompress", &netchan_decompressStats );
+}
+
 /*
 * Netchan_DropAllFragments
 * 
@@ -660,6 +859,9 @@ void Netchan_Init( void )
 	showpackets = Cvar_Get( "showpackets", "0", 0 );
 	showdrop = Cvar_Get( "showdrop", "0", 0 );
 	net_showfragments = Cvar_Get( "net_showfragments", "0", 0 );
+	net_showcompression = Cvar_Get( "net_showcompression", "0", 0 );
+
+	Cmd_AddCommand( "net_compressionstats", Netchan_CompressionStats_f );
 }
 
 /*
@@ -667,4 +869,16 @@ void Netchan_Init( void )
 */
 void Netchan_Shutdown( void )
 {
+	Cmd_RemoveCommand( "net_compressionstats" );
+
+	if( netchan_deflateInitialized )
+	{
+		qzdeflateEnd( &netchan_deflateStream );
+		netchan_deflateInitialized = false;
+	}
+	if( netchan_inflateInitialized )
+	{
+		qzinflateEnd( &netchan_inflateStream );
+		netchan_inflateInitialized = false;
+	}
 }
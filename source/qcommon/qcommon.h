@@ -141,14 +141,43 @@ void SNAP_ParseBaseline( msg_t *msg, entity_state_t *baselines );
 void SNAP_SkipFrame( msg_t *msg, struct snapshot_s *header );
 struct snapshot_s *SNAP_ParseFrame( msg_t *msg, struct snapshot_s *lastFrame, int *suppressCount, struct snapshot_s *backup, entity_state_t *baselines, int showNet );
 
+#define SNAP_MAX_SHARED_PAYLOADS		32
+
+// encoded frame payloads (everything after the game commands) of shared frames,
+// keyed by the frame and the delta base, valid for one server frame
+typedef struct
+{
+	unsigned int sharedId;
+	unsigned int baseSharedId;			// 0 for non-delta frames
+	size_t offset;
+	size_t size;
+} snap_sharedpayload_t;
+
+typedef struct snap_payloadcache_s
+{
+	int numPayloads;
+	snap_sharedpayload_t payloads[SNAP_MAX_SHARED_PAYLOADS];
+	size_t size;
+	size_t maxsize;
+	uint8_t *data;
+	unsigned int hits, misses;			// payloads reused and encoded, shown by the TV server's status
+} snap_payloadcache_t;
+
 void SNAP_WriteFrameSnapToClient( struct ginfo_s *gi, struct client_s *client, msg_t *msg, unsigned int frameNum, unsigned int gameTime,
 								 entity_state_t *baselines, struct client_entities_s *client_entities,
-								 int numcmds, gcommand_t *commands, const char *commandsData );
+								 int numcmds, gcommand_t *commands, const char *commandsData, 
+								 snap_payloadcache_t *payloadCache );
 
 void SNAP_BuildClientFrameSnap( struct cmodel_state_s *cms, struct ginfo_s *gi, unsigned int frameNum, unsigned int timeStamp,
 							   struct fatvis_s *fatvis, struct client_s *client, 
 							   game_state_t *gameState, struct client_entities_s *client_entities,
 							   bool relay, struct mempool_s *mempool );
+void SNAP_ShareClientFrameSnap( struct cmodel_state_s *cms, struct client_s *client, struct client_s *source, 
+							   unsigned int frameNum, unsigned int sharedId, struct mempool_s *mempool );
+
+void SNAP_InitPayloadCache( snap_payloadcache_t *cache, size_t maxsize, struct mempool_s *mempool );
+void SNAP_ClearPayloadCache( snap_payloadcache_t *cache );
+void SNAP_FreePayloadCache( snap_payloadcache_t *cache );
 
 void SNAP_FreeClientFrames( struct client_s *client );
 
@@ -635,6 +664,7 @@ int         NET_Send( const socket_t *socket, const void *data, size_t length, c
 int64_t		NET_SendFile( const socket_t *socket, int file, size_t offset, size_t count, const netadr_t *address );
 
 void	    NET_Sleep( int msec, socket_t *sockets[] );
+void		NET_SleepMicroseconds( uint64_t usec, socket_t *sockets[] );
 int         NET_Monitor( int msec, socket_t *sockets[], 
 				void (*read_cb)(socket_t *socket, void*), 
 				void (*write_cb)(socket_t *socket, void*), 
@@ -690,9 +720,16 @@ typedef struct
 	uint8_t unsentBuffer[MAX_MSGLEN];
 	bool unsentIsCompressed;
 
+	bool dictionaryCompression;	// peer knows our preset compression dictionary
+
 	bool fatal_error;
 } netchan_t;
 
+// version of the preset compression dictionary, advertised in the connect
+// flags so both sides only use it when they have the same one
+#define NETCHAN_DICTIONARY_VERSION	1
+#define NETCHAN_DICTIONARY_SHIFT	8
+
 extern netadr_t	net_from;
 
 
@@ -703,7 +740,7 @@ bool Netchan_Process( netchan_t *chan, msg_t *msg );
 bool Netchan_Transmit( netchan_t *chan, msg_t *msg );
 bool Netchan_PushAllFragments( netchan_t *chan );
 bool Netchan_TransmitNextFragment( netchan_t *chan );
-int Netchan_CompressMessage( msg_t *msg );
+int Netchan_CompressMessage( netchan_t *chan, msg_t *msg );
 int Netchan_DecompressMessage( msg_t *msg );
 void Netchan_OutOfBand( const socket_t *socket, const netadr_t *address, size_t length, const uint8_t *data );
 void Netchan_OutOfBandPrint( const socket_t *socket, const netadr_t *address, const char *format, ... );
@@ -812,6 +849,7 @@ time_t		FS_BaseFileMTime( const char *filename );
 // // only for game files
 const char *FS_FirstExtension( const char *filename, const char *extensions[], int num_extensions );
 const char *FS_PakNameForFile( const char *filename );
+unsigned    FS_PakChecksumForFile( const char *filename );
 bool    FS_IsPureFile( const char *pakname );
 const char *FS_FileManifest( const char *filename );
 const char *FS_BaseNameForFile( const char *filename );
@@ -911,6 +949,7 @@ void _Mem_CheckSentinels( void *data, const char *filename, int fileline );
 void _Mem_CheckSentinelsGlobal( const char *filename, int fileline );
 
 size_t Mem_PoolTotalSize( mempool_t *pool );
+size_t Mem_NamedPoolTotalSize( const char *name );
 
 #define Mem_AllocExt( pool, size, z ) _Mem_AllocExt( pool, size, 0, z, 0, 0, __FILE__, __LINE__ )
 #define Mem_Alloc( pool, size ) _Mem_Alloc( pool, size, 0, 0, __FILE__, __LINE__ )
@@ -991,6 +1030,8 @@ void	*Sys_AcquireWakeLock( void );
 void	Sys_ReleaseWakeLock( void *wl );
 
 int 	Sys_GetCurrentProcessId( void );
+bool	Sys_GetMemoryUsage( size_t *resident, size_t *unique, size_t *physical );
+int	Sys_ForkInstance( void );
 
 /*
 ==============================================================
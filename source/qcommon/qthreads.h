@@ -35,6 +35,10 @@ typedef struct qcondvar_s qcondvar_t;
 struct qbufPipe_s;
 typedef struct qbufPipe_s qbufPipe_t;
 
+// QBufPipe_Create flags
+#define QBUFPIPE_BLOCKWRITE		1	// writers wait for space instead of dropping commands
+#define QBUFPIPE_MULTIWRITER	2	// lock-free, any number of threads may write
+
 qmutex_t *QMutex_Create( void );
 void QMutex_Destroy( qmutex_t **pmutex );
 void QMutex_Lock( qmutex_t *mutex );
@@ -57,8 +61,18 @@ qbufPipe_t *QBufPipe_Create( size_t bufSize, int flags );
 void QBufPipe_Destroy( qbufPipe_t **pqueue );
 void QBufPipe_Finish( qbufPipe_t *queue );
 void QBufPipe_WriteCmd( qbufPipe_t *queue, const void *cmd, unsigned cmd_size );
+void QBufPipe_WriteCmds( qbufPipe_t *queue, const void *cmds, unsigned cmds_size );
 int QBufPipe_ReadCmds( qbufPipe_t *queue, unsigned( **cmdHandlers )(const void *) );
 void QBufPipe_Wait( qbufPipe_t *queue, int (*read)( qbufPipe_t *, unsigned( ** )(const void *), bool ), 
 	unsigned (**cmdHandlers)( const void * ), unsigned timeout_msec );
+void QBufPipe_Bench_f( void );
+
+void QJobs_Init( void );
+void QJobs_Shutdown( void );
+int QJobs_NumWorkers( void );
+qjobhandle_t QJobs_Add( qjobfunc_t func, void *arg, const qjobhandle_t *deps, int numDeps );
+void QJobs_Wait( qjobhandle_t job );
+void QJobs_ParallelFor( unsigned int count, unsigned int granularity, qjobrangefunc_t func, void *arg );
+void QJobs_Bench_f( void );
 
 #endif // Q_THREADS_H
@@ -618,15 +618,91 @@ static void SNAP_RelayMultiPOVCommands( ginfo_t *gi, client_t *client, msg_t *ms
 	}
 }
 
+/*
+* SNAP_InitPayloadCache
+*/
+void SNAP_InitPayloadCache( snap_payloadcache_t *cache, size_t maxsize, mempool_t *mempool )
+{
+	memset( cache, 0, sizeof( *cache ) );
+	cache->maxsize = maxsize;
+	cache->data = ( uint8_t * )Mem_Alloc( mempool, maxsize );
+}
+
+/*
+* SNAP_ClearPayloadCache
+*
+* Must be called before the frames of a new server frame are written
+*/
+void SNAP_ClearPayloadCache( snap_payloadcache_t *cache )
+{
+	cache->numPayloads = 0;
+	cache->size = 0;
+}
+
+/*
+* SNAP_FreePayloadCache
+*/
+void SNAP_FreePayloadCache( snap_payloadcache_t *cache )
+{
+	if( cache->data )
+		Mem_Free( cache->data );
+	memset( cache, 0, sizeof( *cache ) );
+}
+
+/*
+* SNAP_FindSharedPayload
+*/
+static snap_sharedpayload_t *SNAP_FindSharedPayload( snap_payloadcache_t *cache, unsigned int sharedId, unsigned int baseSharedId )
+{
+	int i;
+	snap_sharedpayload_t *payload;
+
+	for( i = 0, payload = cache->payloads; i < cache->numPayloads; i++, payload++ )
+	{
+		if( payload->sharedId == sharedId && payload->baseSharedId == baseSharedId )
+			return payload;
+	}
+
+	return NULL;
+}
+
+/*
+* SNAP_StoreSharedPayload
+*/
+static void SNAP_StoreSharedPayload( snap_payloadcache_t *cache, unsigned int sharedId, unsigned int baseSharedId, 
+	const uint8_t *data, size_t size )
+{
+	snap_sharedpayload_t *payload;
+
+	if( cache->numPayloads == SNAP_MAX_SHARED_PAYLOADS || cache->size + size > cache->maxsize )
+		return;
+
+	payload = &cache->payloads[cache->numPayloads++];
+	payload->sharedId = sharedId;
+	payload->baseSharedId = baseSharedId;
+	payload->offset = cache->size;
+	payload->size = size;
+
+	memcpy( cache->data + cache->size, data, size );
+	cache->size += size;
+}
+
 /*
 * SNAP_WriteFrameSnapToClient
+*
+* If a payload cache is given, the part of the message that only depends on the
+* frame and its delta base is encoded once for all clients sharing both.
 */
 void SNAP_WriteFrameSnapToClient( ginfo_t *gi, client_t *client, msg_t *msg, unsigned int frameNum, unsigned int gameTime,
 								 entity_state_t *baselines, client_entities_t *client_entities,
-								 int numcmds, gcommand_t *commands, const char *commandsData )
+								 int numcmds, gcommand_t *commands, const char *commandsData, 
+								 snap_payloadcache_t *payloadCache )
 {
 	client_snapshot_t *frame, *oldframe;
 	int flags, i, index, pos, length, supcnt;
+	size_t payloadPos;
+	unsigned int baseSharedId;
+	snap_sharedpayload_t *payload;
 
 	// this is the frame we are creating
 	frame = &client->snapShots[frameNum & UPDATE_MASK];
@@ -721,24 +797,48 @@ void SNAP_WriteFrameSnapToClient( ginfo_t *gi, client_t *client, msg_t *msg, uns
 	}
 	MSG_WriteShort( msg, -1 );
 
-	// send over the areabits
-	MSG_WriteByte( msg, frame->areabytes );
-	MSG_WriteData( msg, frame->areabits, frame->areabytes );
+	// the rest only depends on the frame and the frame it is delta compressed from
+	payload = NULL;
+	payloadPos = msg->cursize;
+	baseSharedId = oldframe ? oldframe->sharedId : 0;
+	if( !frame->sharedId || ( oldframe && !oldframe->sharedId ) )
+		payloadCache = NULL;
 
-	SNAP_WriteDeltaGameStateToClient( oldframe, frame, msg );
+	if( payloadCache )
+		payload = SNAP_FindSharedPayload( payloadCache, frame->sharedId, baseSharedId );
 
-	// delta encode the playerstate
-	for( i = 0; i < frame->numplayers; i++ )
+	if( payload )
 	{
-		if( oldframe && oldframe->numplayers > i )
-			SNAP_WritePlayerstateToClient( &oldframe->ps[i], &frame->ps[i], msg );
-		else
-			SNAP_WritePlayerstateToClient( NULL, &frame->ps[i], msg );
+		MSG_WriteData( msg, payloadCache->data + payload->offset, payload->size );
+		payloadCache->hits++;
 	}
-	MSG_WriteByte( msg, 0 );
+	else
+	{
+		// send over the areabits
+		MSG_WriteByte( msg, frame->areabytes );
+		MSG_WriteData( msg, frame->areabits, frame->areabytes );
+
+		SNAP_WriteDeltaGameStateToClient( oldframe, frame, msg );
+
+		// delta encode the playerstate
+		for( i = 0; i < frame->numplayers; i++ )
+		{
+			if( oldframe && oldframe->numplayers > i )
+				SNAP_WritePlayerstateToClient( &oldframe->ps[i], &frame->ps[i], msg );
+			else
+				SNAP_WritePlayerstateToClient( NULL, &frame->ps[i], msg );
+		}
+		MSG_WriteByte( msg, 0 );
+
+		// delta encode the entities
+		SNAP_EmitPacketEntities( gi, oldframe, frame, msg, baselines, client_entities ? client_entities->entities : NULL, client_entities ? client_entities->num_entities : 0 );
 
-	// delta encode the entities
-	SNAP_EmitPacketEntities( gi, oldframe, frame, msg, baselines, client_entities ? client_entities->entities : NULL, client_entities ? client_entities->num_entities : 0 );
+		if( payloadCache )
+		{
+			SNAP_StoreSharedPayload( payloadCache, frame->sharedId, baseSharedId, msg->data + payloadPos, msg->cursize - payloadPos );
+			payloadCache->misses++;
+		}
+	}
 
 	// write length into reserved space
 	length = msg->cursize - pos - 2;
@@ -1103,6 +1203,7 @@ void SNAP_BuildClientFrameSnap( cmodel_state_t *cms, ginfo_t *gi, unsigned int f
 	frame->sentTimeStamp = timeStamp;
 	frame->UcmdExecuted = client->UcmdExecuted;
 	frame->relay = relay;
+	frame->sharedId = 0;
 
 	if( client->mv )
 	{
@@ -1227,6 +1328,65 @@ void SNAP_BuildClientFrameSnap( cmodel_state_t *cms, ginfo_t *gi, unsigned int f
 	client_entities->next_entities = ne;
 }
 
+/*
+* SNAP_ShareClientFrameSnap
+*
+* Gives the client a copy of the frame that has just been built for another client
+* that sees exactly the same, sharing its entities in the circular client_entities
+* array. The source frame must have already been marked with sharedId, which
+* must be unique across frames.
+*/
+void SNAP_ShareClientFrameSnap( cmodel_state_t *cms, client_t *client, client_t *source, 
+							   unsigned int frameNum, unsigned int sharedId, mempool_t *mempool )
+{
+	client_snapshot_t *frame, *src;
+
+	assert( client != source );
+	assert( sharedId != 0 );
+
+	frame = &client->snapShots[frameNum & UPDATE_MASK];
+	src = &source->snapShots[frameNum & UPDATE_MASK];
+	assert( src->sharedId == sharedId );
+
+	if( frame->numareas < src->numareas )
+	{
+		frame->numareas = src->numareas;
+		if( frame->areabits )
+		{
+			Mem_Free( frame->areabits );
+			frame->areabits = NULL;
+		}
+		frame->areabits = (uint8_t*)Mem_Alloc( mempool, frame->numareas * CM_AreaRowSize( cms ) );
+	}
+
+	if( frame->ps_size < src->numplayers )
+	{
+		if( frame->ps )
+		{
+			Mem_Free( frame->ps );
+			frame->ps = NULL;
+		}
+
+		frame->ps = ( player_state_t* )Mem_Alloc( mempool, sizeof( player_state_t )*src->numplayers );
+		frame->ps_size = src->numplayers;
+	}
+
+	frame->sentTimeStamp = src->sentTimeStamp;
+	frame->UcmdExecuted = client->UcmdExecuted;
+	frame->relay = src->relay;
+	frame->multipov = src->multipov;
+	frame->allentities = src->allentities;
+	frame->clientarea = src->clientarea;
+	frame->areabytes = src->areabytes;
+	memcpy( frame->areabits, src->areabits, src->areabytes );
+	frame->numplayers = src->numplayers;
+	memcpy( frame->ps, src->ps, sizeof( player_state_t ) * src->numplayers );
+	frame->num_entities = src->num_entities;
+	frame->first_entity = src->first_entity;
+	frame->gameState = src->gameState;
+	frame->sharedId = sharedId;
+}
+
 /*
 * SNAP_FreeClientFrame
 *
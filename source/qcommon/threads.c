@@ -156,9 +156,15 @@ void QThreads_Shutdown( void )
 
 // ============================================================================
 
+// the multi-writer pipe stores each write as a record with this header,
+// records start at 8 byte boundaries within a power of two sized buffer
+#define QBUFPIPE_MW_HEADER_SIZE		8
+#define QBUFPIPE_MW_RECORD_SIZE( size ) ( ( ( size ) + QBUFPIPE_MW_HEADER_SIZE + 7 ) & ~7 )
+
 typedef struct qbufPipe_s
 {
 	int blockWrite;
+	int multiWriter;
 	volatile int terminated;
 	unsigned write_pos;
 	unsigned read_pos;
@@ -168,6 +174,11 @@ typedef struct qbufPipe_s
 	qcondvar_t *nonempty_condvar;
 	qmutex_t *nonempty_mutex;
 	char *buf;
+
+	// multi-writer state, the positions run freely and wrap around
+	volatile int mw_reserve_pos;	// end of the space claimed by writers
+	volatile int mw_read_pos;		// end of the space released by the reader
+	volatile int mw_sleeping;		// the reader waits for the condition variable
 } qbufPipe_t;
 
 /*
@@ -175,9 +186,22 @@ typedef struct qbufPipe_s
 */
 qbufPipe_t *QBufPipe_Create( size_t bufSize, int flags )
 {
-	qbufPipe_t *pipe = malloc( sizeof( *pipe ) + bufSize );
+	qbufPipe_t *pipe;
+
+	if( flags & QBUFPIPE_MULTIWRITER ) {
+		// the free running positions must wrap at a multiple of the size
+		size_t size = 64;
+		while( size < bufSize ) {
+			size <<= 1;
+		}
+		bufSize = size;
+	}
+
+	pipe = malloc( sizeof( *pipe ) + bufSize );
 	memset( pipe, 0, sizeof( *pipe ) );
-	pipe->blockWrite = flags & 1;
+	memset( pipe + 1, 0, bufSize );
+	pipe->blockWrite = flags & QBUFPIPE_BLOCKWRITE;
+	pipe->multiWriter = flags & QBUFPIPE_MULTIWRITER;
 	pipe->buf = (char *)(pipe + 1);
 	pipe->bufSize = bufSize;
 	pipe->cmdbuf_mutex = QMutex_Create();
@@ -217,6 +241,217 @@ static void QBufPipe_Wake( qbufPipe_t *pipe )
 	QCondVar_Wake( pipe->nonempty_condvar );
 }
 
+/*
+* QBufPipe_AtomicLoad
+*
+* Reads a value written by another thread, with a full barrier
+*/
+static int QBufPipe_AtomicLoad( qbufPipe_t *pipe, volatile int *value )
+{
+	int val;
+
+	do {
+		val = *value;
+	} while( !Sys_Atomic_CAS( value, val, val, pipe->cmdbuf_mutex ) );
+
+	return val;
+}
+
+/*
+* QBufPipe_WakeMW
+*
+* Only takes the mutex if the reader sleeps. The flag is raised before the
+* reader checks for records, and records are committed before the flag is
+* checked here, so one of the two threads always sees the other.
+*/
+static void QBufPipe_WakeMW( qbufPipe_t *pipe )
+{
+	if( QBufPipe_AtomicLoad( pipe, &pipe->mw_sleeping ) ) {
+		QMutex_Lock( pipe->nonempty_mutex );
+		QBufPipe_Wake( pipe );
+		QMutex_Unlock( pipe->nonempty_mutex );
+	}
+}
+
+/*
+* QBufPipe_CommitMW
+*/
+static void QBufPipe_CommitMW( qbufPipe_t *pipe, unsigned pos, int value )
+{
+	volatile int *header = ( volatile int * )( pipe->buf + ( pos & ( pipe->bufSize - 1 ) ) );
+
+	// the reader zeroes the space it releases
+	if( !Sys_Atomic_CAS( header, 0, value, pipe->cmdbuf_mutex ) ) {
+		assert( 0 );
+	}
+}
+
+/*
+* QBufPipe_WriteCmdsMW
+*
+* Claims space for a record with a CAS on the reserve position, copies the
+* commands and then commits the record header. Writers never wait for each
+* other, only for the reader to release space when the pipe is full.
+*/
+static void QBufPipe_WriteCmdsMW( qbufPipe_t *pipe, const void *cmds, unsigned cmds_size )
+{
+	unsigned pos, read_pos, tail, size, total;
+
+	size = QBUFPIPE_MW_RECORD_SIZE( cmds_size );
+	if( size > pipe->bufSize ) {
+		assert( 0 );
+		return;
+	}
+
+	while( 1 ) {
+		if( pipe->terminated ) {
+			return;
+		}
+
+		pos = ( unsigned )pipe->mw_reserve_pos;
+		read_pos = ( unsigned )QBufPipe_AtomicLoad( pipe, &pipe->mw_read_pos );
+
+		// records are never split, skip the tail of the buffer if needed
+		tail = pipe->bufSize - ( pos & ( pipe->bufSize - 1 ) );
+		total = size <= tail ? size : tail + size;
+
+		if( pos - read_pos + total > pipe->bufSize ) {
+			if( pipe->blockWrite ) {
+				QThread_Yield();
+				continue;
+			}
+			return;
+		}
+
+		if( Sys_Atomic_CAS( &pipe->mw_reserve_pos, ( int )pos, ( int )( pos + total ), pipe->cmdbuf_mutex ) ) {
+			break;
+		}
+	}
+
+	if( total > size ) {
+		QBufPipe_CommitMW( pipe, pos, -( int )tail );
+		pos += tail;
+	}
+
+	memcpy( pipe->buf + ( pos & ( pipe->bufSize - 1 ) ) + QBUFPIPE_MW_HEADER_SIZE, cmds, cmds_size );
+	QBufPipe_CommitMW( pipe, pos, ( int )cmds_size );
+
+	QBufPipe_WakeMW( pipe );
+}
+
+/*
+* QBufPipe_HasCmdsMW
+*
+* Returns true if the record at the read position is committed
+*/
+static bool QBufPipe_HasCmdsMW( qbufPipe_t *pipe )
+{
+	unsigned pos = ( unsigned )pipe->mw_read_pos;
+	return QBufPipe_AtomicLoad( pipe, ( volatile int * )( pipe->buf + ( pos & ( pipe->bufSize - 1 ) ) ) ) != 0;
+}
+
+/*
+* QBufPipe_ReadCmdsMW
+*
+* Runs the commands of all committed records in order. Records hold one
+* or more commands, which are walked by the sizes the handlers return.
+*/
+static int QBufPipe_ReadCmdsMW( qbufPipe_t *pipe, unsigned (**cmdHandlers)( const void * ) )
+{
+	int read = 0;
+
+	while( !pipe->terminated ) {
+		int header;
+		unsigned pos, size;
+		char *record, *cmd, *end;
+
+		pos = ( unsigned )pipe->mw_read_pos;
+		record = pipe->buf + ( pos & ( pipe->bufSize - 1 ) );
+
+		header = QBufPipe_AtomicLoad( pipe, ( volatile int * )record );
+		if( !header ) {
+			// empty or the next writer is still copying
+			break;
+		}
+
+		if( header < 0 ) {
+			// skipped tail of the buffer
+			size = ( unsigned )-header;
+		} else {
+			cmd = record + QBUFPIPE_MW_HEADER_SIZE;
+			end = cmd + header;
+
+			while( cmd < end ) {
+				unsigned cmd_size = cmdHandlers[*( (int *)cmd )]( cmd );
+				read++;
+
+				if( !cmd_size ) {
+					pipe->terminated = 1;
+					return -1;
+				}
+
+				if( cmd_size > ( unsigned )( end - cmd ) ) {
+					assert( 0 );
+					pipe->terminated = 1;
+					return -1;
+				}
+
+				cmd += cmd_size;
+			}
+
+			size = QBUFPIPE_MW_RECORD_SIZE( ( unsigned )header );
+		}
+
+		// writers expect released space to be zeroed
+		memset( record, 0, size );
+		Sys_Atomic_Add( &pipe->mw_read_pos, ( int )size, pipe->cmdbuf_mutex );
+	}
+
+	return read;
+}
+
+/*
+* QBufPipe_FinishMW
+*/
+static void QBufPipe_FinishMW( qbufPipe_t *pipe )
+{
+	while( QBufPipe_AtomicLoad( pipe, &pipe->mw_reserve_pos ) != QBufPipe_AtomicLoad( pipe, &pipe->mw_read_pos ) 
+		&& !pipe->terminated ) {
+		QMutex_Lock( pipe->nonempty_mutex );
+		QBufPipe_Wake( pipe );
+		QMutex_Unlock( pipe->nonempty_mutex );
+		QThread_Yield();
+	}
+}
+
+/*
+* QBufPipe_WaitMW
+*/
+static void QBufPipe_WaitMW( qbufPipe_t *pipe, int (*read)( qbufPipe_t *, unsigned( ** )(const void *), bool ), 
+	unsigned (**cmdHandlers)( const void * ), unsigned timeout_msec )
+{
+	while( !pipe->terminated ) {
+		bool result = false;
+
+		if( !QBufPipe_HasCmdsMW( pipe ) ) {
+			QMutex_Lock( pipe->nonempty_mutex );
+
+			Sys_Atomic_CAS( &pipe->mw_sleeping, 0, 1, pipe->cmdbuf_mutex );
+			if( !QBufPipe_HasCmdsMW( pipe ) && !pipe->terminated ) {
+				result = QCondVar_Wait( pipe->nonempty_condvar, pipe->nonempty_mutex, timeout_msec );
+			}
+			Sys_Atomic_CAS( &pipe->mw_sleeping, 1, 0, pipe->cmdbuf_mutex );
+
+			QMutex_Unlock( pipe->nonempty_mutex );
+		}
+
+		if( read( pipe, cmdHandlers, result ) < 0 ) {
+			// done
+			return;
+		}
+	}
+}
+
 /*
 * QBufPipe_Finish
 *
@@ -225,6 +460,11 @@ static void QBufPipe_Wake( qbufPipe_t *pipe )
 */
 void QBufPipe_Finish( qbufPipe_t *pipe )
 {
+	if( pipe->multiWriter ) {
+		QBufPipe_FinishMW( pipe );
+		return;
+	}
+
 	while( Sys_Atomic_CAS( &pipe->cmdbuf_len, 0, 0, pipe->cmdbuf_mutex ) == false && !pipe->terminated ) {
 		QMutex_Lock( pipe->nonempty_mutex );
 		QBufPipe_Wake( pipe );
@@ -272,6 +512,10 @@ void QBufPipe_WriteCmd( qbufPipe_t *pipe, const void *cmd, unsigned cmd_size )
 	if( pipe->terminated ) {
 		return;
 	}
+	if( pipe->multiWriter ) {
+		QBufPipe_WriteCmdsMW( pipe, cmd, cmd_size );
+		return;
+	}
 
 	assert( pipe->bufSize >= pipe->write_pos );
 	if( pipe->bufSize < pipe->write_pos ) {
@@ -334,6 +578,19 @@ void QBufPipe_WriteCmd( qbufPipe_t *pipe, const void *cmd, unsigned cmd_size )
 	}
 }
 
+/*
+* QBufPipe_WriteCmds
+*
+* Adds a batch of commands packed one after another, they're passed
+* to the reader at once and only claim space in the pipe once.
+*/
+void QBufPipe_WriteCmds( qbufPipe_t *pipe, const void *cmds, unsigned cmds_size )
+{
+	// the reader walks the commands by the sizes returned by the handlers,
+	// so the batch is written the same way a single command is
+	QBufPipe_WriteCmd( pipe, cmds, cmds_size );
+}
+
 /*
 * QBufPipe_ReadCmds
 */
@@ -344,6 +601,9 @@ int QBufPipe_ReadCmds( qbufPipe_t *pipe, unsigned (**cmdHandlers)( const void *
 	if( !pipe ) {
 		return -1;
 	}
+	if( pipe->multiWriter ) {
+		return QBufPipe_ReadCmdsMW( pipe, cmdHandlers );
+	}
 
 	while( Sys_Atomic_CAS( &pipe->cmdbuf_len, 0, 0, pipe->cmdbuf_mutex ) == false && !pipe->terminated ) {
 		int cmd;
@@ -398,6 +658,11 @@ int QBufPipe_ReadCmds( qbufPipe_t *pipe, unsigned (**cmdHandlers)( const void *
 void QBufPipe_Wait( qbufPipe_t *pipe, int (*read)( qbufPipe_t *, unsigned( ** )(const void *), bool ), 
 	unsigned (**cmdHandlers)( const void * ), unsigned timeout_msec )
 {
+	if( pipe->multiWriter ) {
+		QBufPipe_WaitMW( pipe, read, cmdHandlers, timeout_msec );
+		return;
+	}
+
 	while( !pipe->terminated ) {
 		int res;
 		bool result = false;
@@ -421,3 +686,226 @@ void QBufPipe_Wait( qbufPipe_t *pipe, int (*read)( qbufPipe_t *, unsigned( ** )(
 		}
 	}
 }
+
+// ============================================================================
+
+#define QBUFPIPE_BENCH_LATENCY_SAMPLES	200
+
+// the single writer pipe can miss a wake up if the write lands right before
+// the reader starts waiting, so the reader can't wait forever
+#define QBUFPIPE_BENCH_WAIT_MSEC		100
+
+typedef struct
+{
+	int id;
+	int writer;
+	unsigned seq;
+	int pad;
+	uint64_t time;
+} qbufPipeBenchCmd_t;
+
+static struct
+{
+	qbufPipe_t *pipe;
+	qmutex_t *writeMutex;		// the single writer pipe needs writers to take turns
+	volatile int start;
+	int numMessages;
+
+	// reader thread only
+	int received;
+	bool measureLatency;
+	uint64_t latencySum, latencyMax;
+} qbufPipeBench;
+
+/*
+* QBufPipe_BenchMsgCmd
+*/
+static unsigned QBufPipe_BenchMsgCmd( const void *pcmd )
+{
+	const qbufPipeBenchCmd_t *cmd = pcmd;
+
+	qbufPipeBench.received++;
+	if( qbufPipeBench.measureLatency ) {
+		uint64_t latency = Sys_Microseconds() - cmd->time;
+		qbufPipeBench.latencySum += latency;
+		qbufPipeBench.latencyMax = max( qbufPipeBench.latencyMax, latency );
+	}
+	return sizeof( *cmd );
+}
+
+/*
+* QBufPipe_BenchStopCmd
+*/
+static unsigned QBufPipe_BenchStopCmd( const void *pcmd )
+{
+	return 0;
+}
+
+static unsigned ( *qbufPipeBenchCmdHandlers[] )( const void * ) = {
+	QBufPipe_BenchMsgCmd,
+	QBufPipe_BenchStopCmd
+};
+
+/*
+* QBufPipe_BenchRead
+*/
+static int QBufPipe_BenchRead( qbufPipe_t *pipe, unsigned( **cmdHandlers )(const void *), bool timeout )
+{
+	return QBufPipe_ReadCmds( pipe, cmdHandlers );
+}
+
+/*
+* QBufPipe_BenchReaderProc
+*/
+static void *QBufPipe_BenchReaderProc( void *param )
+{
+	QBufPipe_Wait( qbufPipeBench.pipe, QBufPipe_BenchRead, qbufPipeBenchCmdHandlers, QBUFPIPE_BENCH_WAIT_MSEC );
+	return NULL;
+}
+
+/*
+* QBufPipe_BenchWrite
+*/
+static void QBufPipe_BenchWrite( qbufPipeBenchCmd_t *cmd )
+{
+	if( qbufPipeBench.writeMutex ) {
+		QMutex_Lock( qbufPipeBench.writeMutex );
+	}
+	QBufPipe_WriteCmd( qbufPipeBench.pipe, cmd, sizeof( *cmd ) );
+	if( qbufPipeBench.writeMutex ) {
+		QMutex_Unlock( qbufPipeBench.writeMutex );
+	}
+}
+
+/*
+* QBufPipe_BenchWriterProc
+*/
+static void *QBufPipe_BenchWriterProc( void *param )
+{
+	int i;
+	qbufPipeBenchCmd_t cmd;
+
+	memset( &cmd, 0, sizeof( cmd ) );
+	cmd.writer = ( int )( intptr_t )param;
+
+	while( !Sys_Atomic_CAS( &qbufPipeBench.start, 1, 1, NULL ) ) {
+		QThread_Yield();
+	}
+
+	for( i = 0; i < qbufPipeBench.numMessages; i++ ) {
+		cmd.seq = i;
+		QBufPipe_BenchWrite( &cmd );
+	}
+
+	return NULL;
+}
+
+/*
+* QBufPipe_BenchStart
+*/
+static qthread_t *QBufPipe_BenchStart( int flags, bool lockWriters )
+{
+	memset( &qbufPipeBench, 0, sizeof( qbufPipeBench ) );
+	qbufPipeBench.pipe = QBufPipe_Create( 0x10000, QBUFPIPE_BLOCKWRITE | flags );
+	qbufPipeBench.writeMutex = lockWriters ? QMutex_Create() : NULL;
+	return QThread_Create( QBufPipe_BenchReaderProc, NULL );
+}
+
+/*
+* QBufPipe_BenchStop
+*/
+static void QBufPipe_BenchStop( qthread_t *reader )
+{
+	qbufPipeBenchCmd_t cmd;
+
+	memset( &cmd, 0, sizeof( cmd ) );
+	cmd.id = 1;
+	QBufPipe_BenchWrite( &cmd );
+
+	QThread_Join( reader );
+
+	if( qbufPipeBench.writeMutex ) {
+		QMutex_Destroy( &qbufPipeBench.writeMutex );
+	}
+	QBufPipe_Destroy( &qbufPipeBench.pipe );
+}
+
+/*
+* QBufPipe_BenchThroughput
+*/
+static void QBufPipe_BenchThroughput( const char *name, int flags, int numWriters, int numMessages )
+{
+	int i;
+	uint64_t time;
+	qthread_t *reader, *writers[16];
+
+	reader = QBufPipe_BenchStart( flags, !( flags & QBUFPIPE_MULTIWRITER ) && numWriters > 1 );
+	qbufPipeBench.numMessages = numMessages;
+
+	for( i = 0; i < numWriters; i++ ) {
+		writers[i] = QThread_Create( QBufPipe_BenchWriterProc, ( void * )( intptr_t )i );
+	}
+
+	time = Sys_Microseconds();
+	Sys_Atomic_CAS( &qbufPipeBench.start, 0, 1, NULL );
+
+	for( i = 0; i < numWriters; i++ ) {
+		QThread_Join( writers[i] );
+	}
+
+	QBufPipe_BenchStop( reader );
+	time = Sys_Microseconds() - time;
+
+	Com_Printf( "%s: %i messages in %.2f ms, %.0f messages/sec%s\n", name, qbufPipeBench.received, time / 1000.0,
+		(double)qbufPipeBench.received * 1000000.0 / max( time, 1 ), 
+		qbufPipeBench.received != numWriters * numMessages ? S_COLOR_RED " (messages lost)" : "" );
+}
+
+/*
+* QBufPipe_BenchLatency
+*
+* Measures how long it takes for a sleeping reader to get a message
+*/
+static void QBufPipe_BenchLatency( const char *name, int flags )
+{
+	int i;
+	qthread_t *reader;
+	qbufPipeBenchCmd_t cmd;
+
+	reader = QBufPipe_BenchStart( flags, false );
+	qbufPipeBench.measureLatency = true;
+
+	memset( &cmd, 0, sizeof( cmd ) );
+	for( i = 0; i < QBUFPIPE_BENCH_LATENCY_SAMPLES; i++ ) {
+		// give the reader time to go to sleep
+		Sys_Sleep( 1 );
+
+		cmd.seq = i;
+		cmd.time = Sys_Microseconds();
+		QBufPipe_BenchWrite( &cmd );
+	}
+
+	QBufPipe_BenchStop( reader );
+
+	Com_Printf( "%s: wake latency %.1f us average, %u us max\n", name,
+		(double)qbufPipeBench.latencySum / max( qbufPipeBench.received, 1 ), (unsigned)qbufPipeBench.latencyMax );
+}
+
+/*
+* QBufPipe_Bench_f
+*
+* bufpipebench [writers] [messages per writer]
+*/
+void QBufPipe_Bench_f( void )
+{
+	int numWriters, numMessages;
+
+	numWriters = Cmd_Argc() > 1 ? bound( 1, atoi( Cmd_Argv( 1 ) ), 16 ) : 4;
+	numMessages = Cmd_Argc() > 2 ? max( atoi( Cmd_Argv( 2 ) ), 1 ) : 50000;
+
+	QBufPipe_BenchThroughput( "single writer", 0, numWriters, numMessages );
+	QBufPipe_BenchThroughput( "multi writer", QBUFPIPE_MULTIWRITER, numWriters, numMessages );
+
+	QBufPipe_BenchLatency( "single writer", 0 );
+	QBufPipe_BenchLatency( "multi writer", QBUFPIPE_MULTIWRITER );
+}
@@ -734,9 +734,10 @@ void R_AliasModelFrameBounds( const model_t *mod, int frame, vec3_t mins, vec3_t
 /*
 * R_AddAliasModelToDrawList
 *
-* Returns true if the entity is added to draw list
+* Returns true if the entity is added to draw list. May be called
+* from frontend workers.
 */
-bool R_AddAliasModelToDrawList( const entity_t *e )
+bool R_AddAliasModelToDrawList( drawList_t *list, const entity_t *e )
 {
 	int i, j;
 	const model_t *mod;
@@ -798,14 +799,14 @@ bool R_AddAliasModelToDrawList( const entity_t *e )
 			for( j = 0; j < mesh->numskins; j++ ) {
 				shader = mesh->skins[j].shader;
 				if( shader ) {
-					R_AddSurfToDrawList( rn.meshlist, e, fog, shader, distance, 0, NULL, aliasmodel->drawSurfs + i );
+					R_AddSurfToDrawList( list, e, fog, shader, distance, 0, NULL, aliasmodel->drawSurfs + i );
 				}
 			}
 			continue;
 		}
 
 		if( shader ) {
-			R_AddSurfToDrawList( rn.meshlist, e, fog, shader, distance, 0, NULL, aliasmodel->drawSurfs + i );
+			R_AddSurfToDrawList( list, e, fog, shader, distance, 0, NULL, aliasmodel->drawSurfs + i );
 		}
 	}
 
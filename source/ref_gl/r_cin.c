@@ -23,6 +23,18 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 
 #define MAX_CINEMATICS	256
 
+#define CIN_QUEUE_SIZE	2							// frames decoded ahead of the display
+#define CIN_NUM_FRAMES	( CIN_QUEUE_SIZE + 1 )		// plus the one being displayed
+
+typedef struct
+{
+	ref_yuv_t		cyuv;
+	int				width, height;
+	unsigned int	time;			// Sys_Milliseconds the frame is due at
+	uint8_t			*pixels;
+	size_t			size;
+} r_cinframe_t;
+
 typedef struct r_cinhandle_s
 {
 	unsigned int	id;
@@ -39,11 +51,30 @@ typedef struct r_cinhandle_s
 	qmutex_t		*lock;
 	ref_yuv_t		*cyuv;
 	image_t			*yuv_images[3];
+
+	// decode-ahead queue, filled by the decoder thread for YUV cinematics
+	bool			async;
+	float			framerate;
+	double			decodeTime;
+	unsigned int	queueHead, queueCount;
+	r_cinframe_t	frames[CIN_NUM_FRAMES];
+
 	struct r_cinhandle_s *prev, *next;
 } r_cinhandle_t;
 
+typedef struct
+{
+	struct qthread_s *thread;
+	qmutex_t		*listLock;		// held by the thread while it walks the active list
+	qmutex_t		*wakeLock;
+	struct qcondvar_s *wakeCond;
+	bool			wake;
+	bool			shutdown;
+} r_cindecoder_t;
+
 static r_cinhandle_t *r_cinematics;
 static r_cinhandle_t r_cinematics_headnode, *r_free_cinematics;
+static r_cindecoder_t r_cindecoder;
 
 /*
 * R_RunCin
@@ -60,6 +91,25 @@ static void R_RunCin( r_cinhandle_t *h )
 
 	ri.Mutex_Lock( h->lock );
 
+	if( h->async ) {
+		// show the most recent frame that is due, the decoder refills the queue
+		while( h->queueCount && h->frames[h->queueHead].time <= now ) {
+			r_cinframe_t *frame = &h->frames[h->queueHead];
+
+			h->cyuv = &frame->cyuv;
+			h->pic = ( uint8_t * )h->cyuv;
+			h->width = frame->width;
+			h->height = frame->height;
+			h->new_frame = true;
+
+			h->queueHead = ( h->queueHead + 1 ) % CIN_NUM_FRAMES;
+			h->queueCount--;
+		}
+
+		ri.Mutex_Unlock( h->lock );
+		return;
+	}
+
 	if( h->reset ) {
 		h->new_frame = false;
 		h->reset = false;
@@ -85,6 +135,191 @@ static void R_RunCin( r_cinhandle_t *h )
 	ri.Mutex_Unlock( h->lock );
 }
 
+/*
+* R_CopyCinematicFrame
+*
+* The decoder reuses its buffers, so queued frames need their own copy of the planes
+*/
+static void R_CopyCinematicFrame( r_cinframe_t *frame, const ref_yuv_t *cyuv )
+{
+	int i;
+	size_t size, planeSize[3];
+	uint8_t *dst;
+
+	for( i = 0, size = 0; i < 3; i++ ) {
+		planeSize[i] = abs( cyuv->yuv[i].stride ) * cyuv->yuv[i].height;
+		size += planeSize[i];
+	}
+
+	if( size > frame->size ) {
+		if( frame->pixels ) {
+			R_Free( frame->pixels );
+		}
+		frame->pixels = R_Malloc( size );
+		frame->size = size;
+	}
+
+	frame->cyuv = *cyuv;
+
+	for( i = 0, dst = frame->pixels; i < 3; i++ ) {
+		const ref_img_plane_t *plane = &cyuv->yuv[i];
+
+		// keep the layout R_UploadRawYUVPic expects for negative strides
+		if( plane->stride < 0 ) {
+			memcpy( dst, plane->data + plane->stride * plane->height, planeSize[i] );
+			frame->cyuv.yuv[i].data = dst + planeSize[i];
+		} else {
+			memcpy( dst, plane->data, planeSize[i] );
+			frame->cyuv.yuv[i].data = dst;
+		}
+
+		dst += planeSize[i];
+	}
+}
+
+/*
+* R_DecodeCinematicAhead
+*
+* Runs the cinematic clock up to CIN_QUEUE_SIZE frames ahead of the real one
+* and queues every new frame. Only the decoder thread touches h->cin of
+* asynchronous cinematics. Popping a frame advances the head and shrinks the
+* queue by one, so the tail slot is stable while the lock is not held.
+*/
+static void R_DecodeCinematicAhead( r_cinhandle_t *h, unsigned int now )
+{
+	int width, height;
+	bool redraw;
+	unsigned int count, tail, time;
+	double frameMsec, limit;
+	ref_yuv_t *cyuv;
+
+	ri.Mutex_Lock( h->lock );
+
+	if( h->reset ) {
+		h->reset = false;
+		h->queueCount = 0;
+		h->decodeTime = now;
+		ri.CIN_Reset( h->cin, now );
+	}
+
+	count = h->queueCount;
+	tail = h->queueHead + count;
+
+	ri.Mutex_Unlock( h->lock );
+
+	frameMsec = 1000.0 / h->framerate;
+	limit = now + frameMsec * CIN_QUEUE_SIZE;
+
+	// don't let a stalled decoder queue frames that are already late
+	if( h->decodeTime + frameMsec < now ) {
+		h->decodeTime = now - frameMsec;
+	}
+
+	while( count < CIN_QUEUE_SIZE && h->decodeTime + frameMsec <= limit ) {
+		h->decodeTime += frameMsec;
+		time = ( unsigned int )ceil( h->decodeTime );
+
+		if( !ri.CIN_NeedNextFrame( h->cin, time ) ) {
+			continue;
+		}
+
+		redraw = false;
+		cyuv = ri.CIN_ReadNextFrameYUV( h->cin, &width, &height, NULL, NULL, &redraw );
+		if( !cyuv ) {
+			// end of a cinematic that doesn't loop, keep showing the last frame
+			break;
+		}
+		if( !redraw ) {
+			continue;
+		}
+
+		R_CopyCinematicFrame( &h->frames[tail % CIN_NUM_FRAMES], cyuv );
+		h->frames[tail % CIN_NUM_FRAMES].width = width;
+		h->frames[tail % CIN_NUM_FRAMES].height = height;
+		h->frames[tail % CIN_NUM_FRAMES].time = time;
+		tail++;
+
+		ri.Mutex_Lock( h->lock );
+		count = ++h->queueCount;
+		ri.Mutex_Unlock( h->lock );
+	}
+}
+
+/*
+* R_CinDecoderThreadProc
+*/
+static void *R_CinDecoderThreadProc( void *param )
+{
+	r_cinhandle_t *handle, *hnode;
+
+	while( 1 ) {
+		ri.Mutex_Lock( r_cindecoder.wakeLock );
+		while( !r_cindecoder.wake && !r_cindecoder.shutdown ) {
+			ri.CondVar_Wait( r_cindecoder.wakeCond, r_cindecoder.wakeLock, Q_THREADS_WAIT_INFINITE );
+		}
+		r_cindecoder.wake = false;
+		if( r_cindecoder.shutdown ) {
+			ri.Mutex_Unlock( r_cindecoder.wakeLock );
+			break;
+		}
+		ri.Mutex_Unlock( r_cindecoder.wakeLock );
+
+		if( rsh.registrationOpen ) {
+			continue;
+		}
+
+		ri.Mutex_Lock( r_cindecoder.listLock );
+
+		hnode = &r_cinematics_headnode;
+		for( handle = hnode->prev; handle != hnode; handle = handle->prev ) {
+			if( handle->async ) {
+				R_DecodeCinematicAhead( handle, ri.Sys_Milliseconds() );
+			}
+		}
+
+		ri.Mutex_Unlock( r_cindecoder.listLock );
+	}
+
+	return NULL;
+}
+
+/*
+* R_WakeCinDecoder
+*/
+static void R_WakeCinDecoder( void )
+{
+	if( !r_cindecoder.thread ) {
+		return;
+	}
+
+	ri.Mutex_Lock( r_cindecoder.wakeLock );
+	r_cindecoder.wake = true;
+	ri.CondVar_Wake( r_cindecoder.wakeCond );
+	ri.Mutex_Unlock( r_cindecoder.wakeLock );
+}
+
+/*
+* R_LockCinematicsList
+*
+* Keeps the decoder thread away while the active list is modified
+*/
+static void R_LockCinematicsList( void )
+{
+	if( r_cindecoder.thread ) {
+		ri.Mutex_Lock( r_cindecoder.listLock );
+	}
+}
+
+/*
+* R_UnlockCinematicsList
+*/
+static void R_UnlockCinematicsList( void )
+{
+	if( r_cindecoder.thread ) {
+		ri.Mutex_Unlock( r_cindecoder.listLock );
+	}
+}
+
 /*
 * R_UploadCinematicFrame
 */
@@ -233,6 +468,14 @@ void R_InitCinematics( void )
 			r_cinematics[i].next = &r_cinematics[i+1];
 		r_cinematics[i].id = i + 1;
 	}
+
+	memset( &r_cindecoder, 0, sizeof( r_cindecoder ) );
+	if( r_cin_async->integer ) {
+		r_cindecoder.listLock = ri.Mutex_Create();
+		r_cindecoder.wakeLock = ri.Mutex_Create();
+		r_cindecoder.wakeCond = ri.CondVar_Create();
+		r_cindecoder.thread = ri.Thread_Create( R_CinDecoderThreadProc, NULL );
+	}
 }
 
 /*
@@ -248,6 +491,8 @@ void R_RunAllCinematics( void )
 		next = handle->prev;
 		R_RunCin( handle );
 	}
+
+	R_WakeCinDecoder();
 }
 
 /*
@@ -314,6 +559,7 @@ unsigned int R_StartCinematic( const char *arg )
 	r_cinhandle_t *handle, *hnode, *next;
 	struct cinematics_s *cin;
 	bool yuv;
+	float framerate;
 
 	name_size = strlen( "video/" ) + strlen( arg ) + 1;
 	name = alloca( name_size );
@@ -337,7 +583,7 @@ unsigned int R_StartCinematic( const char *arg )
 	}
 
 	// open the file, read header, etc
-	cin = ri.CIN_Open( name, ri.Sys_Milliseconds(), &yuv, NULL );
+	cin = ri.CIN_Open( name, ri.Sys_Milliseconds(), &yuv, &framerate );
 
 	// take a free cinematic handle if possible
 	if( !r_free_cinematics || !cin )
@@ -364,12 +610,18 @@ unsigned int R_StartCinematic( const char *arg )
 	handle->pic = NULL;
 	handle->cyuv = NULL;
 	handle->lock = ri.Mutex_Create();
+	handle->async = yuv && framerate > 0 && r_cindecoder.thread != NULL;
+	handle->framerate = framerate;
+	handle->decodeTime = ri.Sys_Milliseconds();
+	handle->queueHead = handle->queueCount = 0;
 
 	// put handle at the start of the list
+	R_LockCinematicsList();
 	handle->prev = &r_cinematics_headnode;
 	handle->next = r_cinematics_headnode.next;
 	handle->next->prev = handle;
 	handle->prev->next = handle;
+	R_UnlockCinematicsList();
 
 	return handle->id;
 }
@@ -429,6 +681,7 @@ void R_FreeUnusedCinematics( void )
 */
 void R_FreeCinematic( unsigned int id )
 {
+	int i;
 	qmutex_t *lock;
 	r_cinhandle_t *handle;
 	
@@ -437,6 +690,8 @@ void R_FreeCinematic( unsigned int id )
 		return;
 	}
 
+	R_LockCinematicsList();
+
 	lock = handle->lock;
 	ri.Mutex_Lock( lock );
 
@@ -444,6 +699,15 @@ void R_FreeCinematic( unsigned int id )
 	handle->cin = NULL;
 	handle->lock = NULL;
 
+	for( i = 0; i < CIN_NUM_FRAMES; i++ ) {
+		if( handle->frames[i].pixels ) {
+			R_Free( handle->frames[i].pixels );
+		}
+	}
+	memset( handle->frames, 0, sizeof( handle->frames ) );
+	handle->async = false;
+	handle->queueHead = handle->queueCount = 0;
+
 	assert( handle->name );
 	R_Free( handle->name );
 	handle->name = NULL;
@@ -462,6 +726,8 @@ void R_FreeCinematic( unsigned int id )
 
 	ri.Mutex_Unlock( lock );
 
+	R_UnlockCinematicsList();
+
 	ri.Mutex_Destroy( &lock );
 }
 
@@ -495,6 +761,20 @@ void R_ShutdownCinematics( void )
 {
 	r_cinhandle_t *handle, *hnode, *next;
 
+	if( r_cindecoder.thread ) {
+		ri.Mutex_Lock( r_cindecoder.wakeLock );
+		r_cindecoder.shutdown = true;
+		ri.CondVar_Wake( r_cindecoder.wakeCond );
+		ri.Mutex_Unlock( r_cindecoder.wakeLock );
+
+		ri.Thread_Join( r_cindecoder.thread );
+		r_cindecoder.thread = NULL;
+
+		ri.CondVar_Destroy( &r_cindecoder.wakeCond );
+		ri.Mutex_Destroy( &r_cindecoder.wakeLock );
+		ri.Mutex_Destroy( &r_cindecoder.listLock );
+	}
+
 	hnode = &r_cinematics_headnode;
 	for( handle = hnode->prev; handle != hnode; handle = next )
 	{
@@ -20,6 +20,7 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 #include "r_local.h"
 #include "r_imagelib.h"
 #include "../qalgo/hash.h"
+#include "../gameshared/q_simd.h"
 
 #define	MAX_GLIMAGES	    8192
 #define IMAGES_HASH_SIZE    64
@@ -572,9 +573,9 @@ static void R_FlipTexture( const uint8_t *in, uint8_t *out, int width, int heigh
 }
 
 /*
-* R_ResampleTexture
+* R_ResampleTexture_C
 */
-static void R_ResampleTexture( int ctx, const uint8_t *in, int inwidth, int inheight, uint8_t *out, 
+static void R_ResampleTexture_C( int ctx, const uint8_t *in, int inwidth, int inheight, uint8_t *out, 
 	int outwidth, int outheight, int samples, int alignment )
 {
 	int i, j, k;
@@ -630,11 +631,11 @@ static void R_ResampleTexture( int ctx, const uint8_t *in, int inwidth, int inhe
 }
 
 /*
-* R_ResampleTexture16
+* R_ResampleTexture16_C
 *
 * Assumes 16-bit unpack alignment
 */
-static void R_ResampleTexture16( int ctx, const unsigned short *in, int inwidth, int inheight,
+static void R_ResampleTexture16_C( int ctx, const unsigned short *in, int inwidth, int inheight,
 	unsigned short *out, int outwidth, int outheight, int rMask, int gMask, int bMask, int aMask )
 {
 	int i, j;
@@ -692,11 +693,11 @@ static void R_ResampleTexture16( int ctx, const unsigned short *in, int inwidth,
 }
 
 /*
-* R_MipMap
+* R_MipMap_C
 * 
 * Operates in place, quartering the size of the texture
 */
-static void R_MipMap( uint8_t *in, int width, int height, int samples, int alignment )
+static void R_MipMap_C( uint8_t *in, int width, int height, int samples, int alignment )
 {
 	int i, j, k;
 	int instride = ALIGN( width * samples, alignment );
@@ -733,11 +734,11 @@ static void R_MipMap( uint8_t *in, int width, int height, int samples, int align
 }
 
 /*
-* R_MipMap16
+* R_MipMap16_C
 *
 * Operates in place, quartering the size of the 16-bit texture, assumes unpack alignment of 4
 */
-static void R_MipMap16( unsigned short *in, int width, int height, int rMask, int gMask, int bMask, int aMask )
+static void R_MipMap16_C( unsigned short *in, int width, int height, int rMask, int gMask, int bMask, int aMask )
 {
 	int i, j;
 	int instride = ALIGN( width, 2 );
@@ -782,6 +783,595 @@ static void R_MipMap16( unsigned short *in, int width, int height, int rMask, in
 	}
 }
 
+#if defined( QSIMD_SSE2 ) || defined( QSIMD_NEON )
+
+/*
+* R_LoadPixel32
+*/
+static inline uint32_t R_LoadPixel32( const uint8_t *p )
+{
+	uint32_t v;
+	memcpy( &v, p, sizeof( v ) );
+	return v;
+}
+
+/*
+* R_AveragePixelPairs
+*
+* a and b hold four RGBA pixels each, returns ( a0 + a1 + b0 + b1 ) >> 2
+* and ( a2 + a3 + b2 + b3 ) >> 2 in the low 64 bits
+*/
+static inline qiv_t R_AveragePixelPairs( qiv_t a, qiv_t b )
+{
+	qiv_t lo = qiv_add16( qiv_zext8lo( a ), qiv_zext8lo( b ) );
+	qiv_t hi = qiv_add16( qiv_zext8hi( a ), qiv_zext8hi( b ) );
+
+	lo = qiv_add16( lo, qiv_hi64( lo ) );
+	hi = qiv_add16( hi, qiv_hi64( hi ) );
+	lo = qiv_srl16( qiv_unpacklo64( lo, hi ), 2 );
+	return qiv_pack16to8( lo, lo );
+}
+
+/*
+* R_AverageComponent16
+*/
+static inline qiv_t R_AverageComponent16( qiv_t p0, qiv_t p1, qiv_t p2, qiv_t p3, qiv_t m )
+{
+	qiv_t sum = qiv_add32( qiv_add32( qiv_and( p0, m ), qiv_and( p1, m ) ), qiv_add32( qiv_and( p2, m ), qiv_and( p3, m ) ) );
+	return qiv_and( qiv_srl32( sum, 2 ), m );
+}
+
+/*
+* R_AveragePixels16
+*
+* Averages four vectors of 16-bit pixels held in 32-bit lanes, one
+* component mask at a time
+*/
+static inline qiv_t R_AveragePixels16( qiv_t p0, qiv_t p1, qiv_t p2, qiv_t p3, const qiv_t *masks )
+{
+	return qiv_or(
+		qiv_or( R_AverageComponent16( p0, p1, p2, p3, masks[0] ), R_AverageComponent16( p0, p1, p2, p3, masks[1] ) ),
+		qiv_or( R_AverageComponent16( p0, p1, p2, p3, masks[2] ), R_AverageComponent16( p0, p1, p2, p3, masks[3] ) ) );
+}
+
+/*
+* R_ResampleTexture_SIMD
+*
+* Produces the same output as R_ResampleTexture_C, two RGBA pixels at a time
+*/
+static void R_ResampleTexture_SIMD( int ctx, const uint8_t *in, int inwidth, int inheight, uint8_t *out, 
+	int outwidth, int outheight, int samples, int alignment )
+{
+	int i, j, k;
+	int inwidthS, outwidthS;
+	unsigned int frac, fracstep;
+	const uint8_t *inrow, *inrow2;
+	unsigned *p1, *p2;
+	qiv_t a, b;
+
+	if( ( samples != 4 ) || ( inwidth == outwidth && inheight == outheight ) )
+	{
+		R_ResampleTexture_C( ctx, in, inwidth, inheight, out, outwidth, outheight, samples, alignment );
+		return;
+	}
+
+	p1 = ( unsigned * )R_PrepareImageBuffer( ctx, TEXTURE_LINE_BUF, outwidth * sizeof( *p1 ) * 2 );
+	p2 = p1 + outwidth;
+
+	fracstep = inwidth * 0x10000 / outwidth;
+
+	frac = fracstep >> 2;
+	for( i = 0; i < outwidth; i++ )
+	{
+		p1[i] = samples * ( frac >> 16 );
+		frac += fracstep;
+	}
+
+	frac = 3 * ( fracstep >> 2 );
+	for( i = 0; i < outwidth; i++ )
+	{
+		p2[i] = samples * ( frac >> 16 );
+		frac += fracstep;
+	}
+
+	inwidthS = ALIGN( inwidth * samples, alignment );
+	outwidthS = ALIGN( outwidth * samples, alignment );
+	for( i = 0; i < outheight; i++, out += outwidthS )
+	{
+		inrow = in + inwidthS * (int)( ( i + 0.25 ) * inheight / outheight );
+		inrow2 = in + inwidthS * (int)( ( i + 0.75 ) * inheight / outheight );
+		for( j = 0; j + 1 < outwidth; j += 2 )
+		{
+			a = qiv_set_u32( R_LoadPixel32( inrow + p1[j] ), R_LoadPixel32( inrow + p2[j] ),
+				R_LoadPixel32( inrow + p1[j + 1] ), R_LoadPixel32( inrow + p2[j + 1] ) );
+			b = qiv_set_u32( R_LoadPixel32( inrow2 + p1[j] ), R_LoadPixel32( inrow2 + p2[j] ),
+				R_LoadPixel32( inrow2 + p1[j + 1] ), R_LoadPixel32( inrow2 + p2[j + 1] ) );
+			qiv_storel( out + j * 4, R_AveragePixelPairs( a, b ) );
+		}
+
+		for( ; j < outwidth; j++ )
+		{
+			for( k = 0; k < 4; k++ )
+				out[j * 4 + k] = ( inrow[p1[j] + k] + inrow[p2[j] + k] + inrow2[p1[j] + k] + inrow2[p2[j] + k] ) >> 2;
+		}
+	}
+}
+
+/*
+* R_ResampleTexture16_SIMD
+*
+* Produces the same output as R_ResampleTexture16_C, four pixels at a time
+*/
+static void R_ResampleTexture16_SIMD( int ctx, const unsigned short *in, int inwidth, int inheight,
+	unsigned short *out, int outwidth, int outheight, int rMask, int gMask, int bMask, int aMask )
+{
+	int i, j;
+	int inwidthA, outwidthA;
+	unsigned int frac, fracstep;
+	const unsigned short *inrow, *inrow2, *pix1, *pix2, *pix3, *pix4;
+	unsigned *p1, *p2;
+	qiv_t masks[4], res;
+
+	if( inwidth == outwidth && inheight == outheight )
+	{
+		R_ResampleTexture16_C( ctx, in, inwidth, inheight, out, outwidth, outheight, rMask, gMask, bMask, aMask );
+		return;
+	}
+
+	p1 = ( unsigned * )R_PrepareImageBuffer( ctx, TEXTURE_LINE_BUF, outwidth * sizeof( *p1 ) * 2 );
+	p2 = p1 + outwidth;
+
+	fracstep = inwidth * 0x10000 / outwidth;
+
+	frac = fracstep >> 2;
+	for( i = 0; i < outwidth; i++ )
+	{
+		p1[i] = frac >> 16;
+		frac += fracstep;
+	}
+
+	frac = 3 * ( fracstep >> 2 );
+	for( i = 0; i < outwidth; i++ )
+	{
+		p2[i] = frac >> 16;
+		frac += fracstep;
+	}
+
+	masks[0] = qiv_splat_u32( rMask );
+	masks[1] = qiv_splat_u32( gMask );
+	masks[2] = qiv_splat_u32( bMask );
+	masks[3] = qiv_splat_u32( aMask );
+
+	inwidthA = ALIGN( inwidth, 2 );
+	outwidthA = ALIGN( outwidth, 2 );
+	for( i = 0; i < outheight; i++, out += outwidthA )
+	{
+		inrow = in + inwidthA * (int)( ( i + 0.25 ) * inheight / outheight );
+		inrow2 = in + inwidthA * (int)( ( i + 0.75 ) * inheight / outheight );
+		for( j = 0; j + 3 < outwidth; j += 4 )
+		{
+			res = R_AveragePixels16(
+				qiv_set_u32( inrow[p1[j]], inrow[p1[j + 1]], inrow[p1[j + 2]], inrow[p1[j + 3]] ),
+				qiv_set_u32( inrow[p2[j]], inrow[p2[j + 1]], inrow[p2[j + 2]], inrow[p2[j + 3]] ),
+				qiv_set_u32( inrow2[p1[j]], inrow2[p1[j + 1]], inrow2[p1[j + 2]], inrow2[p1[j + 3]] ),
+				qiv_set_u32( inrow2[p2[j]], inrow2[p2[j + 1]], inrow2[p2[j + 2]], inrow2[p2[j + 3]] ),
+				masks );
+			qiv_storel( out + j, qiv_pack32to16( res, res ) );
+		}
+
+		for( ; j < outwidth; j++ )
+		{
+			pix1 = inrow + p1[j];
+			pix2 = inrow + p2[j];
+			pix3 = inrow2 + p1[j];
+			pix4 = inrow2 + p2[j];
+
+			out[j] = ( ( ( ( *pix1 & rMask ) + ( *pix2 & rMask ) + ( *pix3 & rMask ) + ( *pix4 & rMask ) ) >> 2 ) & rMask ) |
+					( ( ( ( *pix1 & gMask ) + ( *pix2 & gMask ) + ( *pix3 & gMask ) + ( *pix4 & gMask ) ) >> 2 ) & gMask ) |
+					( ( ( ( *pix1 & bMask ) + ( *pix2 & bMask ) + ( *pix3 & bMask ) + ( *pix4 & bMask ) ) >> 2 ) & bMask ) |
+					( ( ( ( *pix1 & aMask ) + ( *pix2 & aMask ) + ( *pix3 & aMask ) + ( *pix4 & aMask ) ) >> 2 ) & aMask );
+		}
+	}
+}
+
+/*
+* R_MipMap_SIMD
+*
+* Produces the same output as R_MipMap_C, two RGBA pixels at a time
+*/
+static void R_MipMap_SIMD( uint8_t *in, int width, int height, int samples, int alignment )
+{
+	int i, j, k;
+	int instride = ALIGN( width * samples, alignment );
+	int outwidth, outheight, outpadding;
+	uint8_t *out = in;
+	uint8_t *next;
+	int inofs;
+
+	if( samples != 4 )
+	{
+		R_MipMap_C( in, width, height, samples, alignment );
+		return;
+	}
+
+	outwidth = width >> 1;
+	outheight = height >> 1;
+	if( !outwidth )
+		outwidth = 1;
+	if( !outheight )
+		outheight = 1;
+	outpadding = ALIGN( outwidth * samples, alignment ) - outwidth * samples;
+
+	for( i = 0; i < outheight; i++, in += instride * 2, out += outpadding )
+	{
+		next = ( ( ( i << 1 ) + 1 ) < height ) ? ( in + instride ) : in;
+
+		// the output trails the input, so the row can be filtered in place
+		for( j = 0; ( ( j << 1 ) + 3 ) < width; j += 2, out += 8 )
+			qiv_storel( out, R_AveragePixelPairs( qiv_loadu( in + j * 8 ), qiv_loadu( next + j * 8 ) ) );
+
+		for( inofs = j * 8; j < outwidth; j++, inofs += 4 )
+		{
+			if( ( ( j << 1 ) + 1 ) < width )
+			{
+				for( k = 0; k < 4; ++k, ++inofs )
+					*( out++ ) = ( in[inofs] + in[inofs + 4] + next[inofs] + next[inofs + 4] ) >> 2;
+			}
+			else
+			{
+				for( k = 0; k < 4; ++k, ++inofs )
+					*( out++ ) = ( in[inofs] + next[inofs] ) >> 1;
+			}
+		}
+	}
+}
+
+/*
+* R_MipMap16_SIMD
+*
+* Produces the same output as R_MipMap16_C, four pixels at a time
+*/
+static void R_MipMap16_SIMD( unsigned short *in, int width, int height, int rMask, int gMask, int bMask, int aMask )
+{
+	int i, j;
+	int instride = ALIGN( width, 2 );
+	int outwidth, outheight, outpadding;
+	unsigned short *out = in;
+	unsigned short *next;
+	int col, p[4];
+	qiv_t masks[4], lowMask, a, b, res;
+
+	outwidth = width >> 1;
+	outheight = height >> 1;
+	if( !outwidth )
+		outwidth = 1;
+	if( !outheight )
+		outheight = 1;
+	outpadding = outwidth & 1;
+
+	masks[0] = qiv_splat_u32( rMask );
+	masks[1] = qiv_splat_u32( gMask );
+	masks[2] = qiv_splat_u32( bMask );
+	masks[3] = qiv_splat_u32( aMask );
+	lowMask = qiv_splat_u32( 0xFFFF );
+
+	for( i = 0; i < outheight; i++, in += instride * 2, out += outpadding )
+	{
+		next = ( ( ( i << 1 ) + 1 ) < height ) ? ( in + instride ) : in;
+
+		// each 32-bit lane holds an even pixel in the low half and an odd one in the high half
+		for( j = 0; ( ( j << 1 ) + 7 ) < width; j += 4, out += 4 )
+		{
+			a = qiv_loadu( in + ( j << 1 ) );
+			b = qiv_loadu( next + ( j << 1 ) );
+			res = R_AveragePixels16( qiv_and( a, lowMask ), qiv_srl32( a, 16 ),
+				qiv_and( b, lowMask ), qiv_srl32( b, 16 ), masks );
+			qiv_storel( out, qiv_pack32to16( res, res ) );
+		}
+
+		for( ; j < outwidth; j++ )
+		{
+			col = j << 1;
+			p[0] = in[col];
+			p[1] = next[col];
+			if( ( col + 1 ) < width )
+			{
+				p[2] = in[col + 1];
+				p[3] = next[col + 1];
+				*( out++ ) =	( ( ( ( p[0] & rMask ) + ( p[1] & rMask ) + ( p[2] & rMask ) + ( p[3] & rMask ) ) >> 2 ) & rMask ) |
+								( ( ( ( p[0] & gMask ) + ( p[1] & gMask ) + ( p[2] & gMask ) + ( p[3] & gMask ) ) >> 2 ) & gMask ) |
+								( ( ( ( p[0] & bMask ) + ( p[1] & bMask ) + ( p[2] & bMask ) + ( p[3] & bMask ) ) >> 2 ) & bMask ) |
+								( ( ( ( p[0] & aMask ) + ( p[1] & aMask ) + ( p[2] & aMask ) + ( p[3] & aMask ) ) >> 2 ) & aMask );
+			}
+			else
+			{
+				*( out++ ) =	( ( ( ( p[0] & rMask ) + ( p[1] & rMask ) ) >> 1 ) & rMask ) |
+								( ( ( ( p[0] & gMask ) + ( p[1] & gMask ) ) >> 1 ) & gMask ) |
+								( ( ( ( p[0] & bMask ) + ( p[1] & bMask ) ) >> 1 ) & bMask ) |
+								( ( ( ( p[0] & aMask ) + ( p[1] & aMask ) ) >> 1 ) & aMask );
+			}
+		}
+	}
+}
+
+#endif
+
+typedef struct
+{
+	const char *name;
+	void ( *resample )( int ctx, const uint8_t *in, int inwidth, int inheight, uint8_t *out, 
+		int outwidth, int outheight, int samples, int alignment );
+	void ( *resample16 )( int ctx, const unsigned short *in, int inwidth, int inheight,
+		unsigned short *out, int outwidth, int outheight, int rMask, int gMask, int bMask, int aMask );
+	void ( *mipmap )( uint8_t *in, int width, int height, int samples, int alignment );
+	void ( *mipmap16 )( unsigned short *in, int width, int height, int rMask, int gMask, int bMask, int aMask );
+} imageProcessingFuncs_t;
+
+static const imageProcessingFuncs_t r_imageProcessingC =
+{
+	"C",
+	R_ResampleTexture_C,
+	R_ResampleTexture16_C,
+	R_MipMap_C,
+	R_MipMap16_C
+};
+
+#if defined( QSIMD_SSE2 ) || defined( QSIMD_NEON )
+static const imageProcessingFuncs_t r_imageProcessingSIMD =
+{
+	QSIMD_NAME,
+	R_ResampleTexture_SIMD,
+	R_ResampleTexture16_SIMD,
+	R_MipMap_SIMD,
+	R_MipMap16_SIMD
+};
+#else
+#define r_imageProcessingSIMD r_imageProcessingC
+#endif
+
+/*
+* R_ImageProcessingFuncs
+*
+* Picks the resampling and mipmapping kernels, r_image_simd 0 forces the plain C ones
+*/
+static const imageProcessingFuncs_t *R_ImageProcessingFuncs( void )
+{
+	return r_image_simd->integer ? &r_imageProcessingSIMD : &r_imageProcessingC;
+}
+
+/*
+* R_ResampleTexture
+*/
+static void R_ResampleTexture( int ctx, const uint8_t *in, int inwidth, int inheight, uint8_t *out, 
+	int outwidth, int outheight, int samples, int alignment )
+{
+	R_ImageProcessingFuncs()->resample( ctx, in, inwidth, inheight, out, outwidth, outheight, samples, alignment );
+}
+
+/*
+* R_ResampleTexture16
+*/
+static void R_ResampleTexture16( int ctx, const unsigned short *in, int inwidth, int inheight,
+	unsigned short *out, int outwidth, int outheight, int rMask, int gMask, int bMask, int aMask )
+{
+	R_ImageProcessingFuncs()->resample16( ctx, in, inwidth, inheight, out, outwidth, outheight, rMask, gMask, bMask, aMask );
+}
+
+/*
+* R_MipMap
+*/
+static void R_MipMap( uint8_t *in, int width, int height, int samples, int alignment )
+{
+	R_ImageProcessingFuncs()->mipmap( in, width, height, samples, alignment );
+}
+
+/*
+* R_MipMap16
+*/
+static void R_MipMap16( unsigned short *in, int width, int height, int rMask, int gMask, int bMask, int aMask )
+{
+	R_ImageProcessingFuncs()->mipmap16( in, width, height, rMask, gMask, bMask, aMask );
+}
+
+enum
+{
+	IMAGEBENCH_RESAMPLE,
+	IMAGEBENCH_MIPMAP,
+	IMAGEBENCH_RESAMPLE16,
+	IMAGEBENCH_MIPMAP16,
+
+	NUM_IMAGEBENCH_KERNELS
+};
+
+typedef struct
+{
+	uint64_t time[2];			// C, SIMD
+	unsigned int mismatches;
+} imageBenchStat_t;
+
+/*
+* R_ImageBenchMipChain
+*/
+static void R_ImageBenchMipChain( const imageProcessingFuncs_t *funcs, uint8_t *data, int width, int height, int samples, bool is16 )
+{
+	while( width > 1 || height > 1 )
+	{
+		if( is16 )
+			funcs->mipmap16( ( unsigned short * )data, width, height, 31 << 11, 63 << 5, 31, 0 );
+		else
+			funcs->mipmap( data, width, height, samples, 1 );
+		width = max( width >> 1, 1 );
+		height = max( height >> 1, 1 );
+	}
+}
+
+/*
+* R_ImageBenchImage
+*
+* Runs every kernel over a decoded image with both the C and SIMD versions,
+* the 16-bit kernels get an RGB565 copy of the image
+*/
+static void R_ImageBenchImage( const uint8_t *pic, int width, int height, int samples, int iterations, imageBenchStat_t *stats )
+{
+	int i, pass, k, x, y;
+	int outwidth = max( width * 3 / 4, 1 ), outheight = max( height * 3 / 4, 1 );
+	size_t size = width * height * samples, outsize = outwidth * outheight * samples;
+	size_t size16 = ALIGN( width, 2 ) * height * sizeof( unsigned short ), outsize16 = ALIGN( outwidth, 2 ) * outheight * sizeof( unsigned short );
+	uint8_t *out[NUM_IMAGEBENCH_KERNELS][2];
+	unsigned short *pic16;
+	const uint8_t *p;
+	uint64_t start;
+
+	pic16 = R_Malloc( size16 );
+	for( y = 0; y < height; y++ )
+	{
+		for( x = 0, p = pic + y * width * samples; x < width; x++, p += samples )
+		{
+			if( samples >= 3 )
+				pic16[y * ALIGN( width, 2 ) + x] = ( ( p[0] >> 3 ) << 11 ) | ( ( p[1] >> 2 ) << 5 ) | ( p[2] >> 3 );
+			else
+				pic16[y * ALIGN( width, 2 ) + x] = ( ( p[0] >> 3 ) << 11 ) | ( ( p[0] >> 2 ) << 5 ) | ( p[0] >> 3 );
+		}
+	}
+
+	for( pass = 0; pass < 2; pass++ )
+	{
+		const imageProcessingFuncs_t *funcs = pass ? &r_imageProcessingSIMD : &r_imageProcessingC;
+
+		out[IMAGEBENCH_RESAMPLE][pass] = R_Malloc( outsize );
+		out[IMAGEBENCH_MIPMAP][pass] = R_Malloc( size );
+		out[IMAGEBENCH_RESAMPLE16][pass] = R_Malloc( outsize16 );
+		out[IMAGEBENCH_MIPMAP16][pass] = R_Malloc( size16 );
+
+		start = ri.Sys_Microseconds();
+		for( i = 0; i < iterations; i++ )
+			funcs->resample( QGL_CONTEXT_MAIN, pic, width, height, out[IMAGEBENCH_RESAMPLE][pass], outwidth, outheight, samples, 1 );
+		stats[IMAGEBENCH_RESAMPLE].time[pass] += ri.Sys_Microseconds() - start;
+
+		start = ri.Sys_Microseconds();
+		for( i = 0; i < iterations; i++ )
+		{
+			memcpy( out[IMAGEBENCH_MIPMAP][pass], pic, size );
+			R_ImageBenchMipChain( funcs, out[IMAGEBENCH_MIPMAP][pass], width, height, samples, false );
+		}
+		stats[IMAGEBENCH_MIPMAP].time[pass] += ri.Sys_Microseconds() - start;
+
+		start = ri.Sys_Microseconds();
+		for( i = 0; i < iterations; i++ )
+			funcs->resample16( QGL_CONTEXT_MAIN, pic16, width, height, ( unsigned short * )out[IMAGEBENCH_RESAMPLE16][pass],
+				outwidth, outheight, 31 << 11, 63 << 5, 31, 0 );
+		stats[IMAGEBENCH_RESAMPLE16].time[pass] += ri.Sys_Microseconds() - start;
+
+		start = ri.Sys_Microseconds();
+		for( i = 0; i < iterations; i++ )
+		{
+			memcpy( out[IMAGEBENCH_MIPMAP16][pass], pic16, size16 );
+			R_ImageBenchMipChain( funcs, out[IMAGEBENCH_MIPMAP16][pass], width, height, 1, true );
+		}
+		stats[IMAGEBENCH_MIPMAP16].time[pass] += ri.Sys_Microseconds() - start;
+	}
+
+	if( memcmp( out[IMAGEBENCH_RESAMPLE][0], out[IMAGEBENCH_RESAMPLE][1], outsize ) )
+		stats[IMAGEBENCH_RESAMPLE].mismatches++;
+	if( memcmp( out[IMAGEBENCH_MIPMAP][0], out[IMAGEBENCH_MIPMAP][1], size ) )
+		stats[IMAGEBENCH_MIPMAP].mismatches++;
+	if( memcmp( out[IMAGEBENCH_RESAMPLE16][0], out[IMAGEBENCH_RESAMPLE16][1], outsize16 ) )
+		stats[IMAGEBENCH_RESAMPLE16].mismatches++;
+	if( memcmp( out[IMAGEBENCH_MIPMAP16][0], out[IMAGEBENCH_MIPMAP16][1], size16 ) )
+		stats[IMAGEBENCH_MIPMAP16].mismatches++;
+
+	for( k = 0; k < NUM_IMAGEBENCH_KERNELS; k++ )
+	{
+		R_Free( out[k][0] );
+		R_Free( out[k][1] );
+	}
+	R_Free( pic16 );
+}
+
+/*
+* R_ImageBench_f
+*
+* r_imagebench <directory> [iterations]
+*
+* Decodes the TGA/PNG/JPG images in a directory and times resampling them to
+* 3/4 size and building full mip chains with the C and SIMD kernels, checking
+* that both produce identical output. Doesn't touch GL.
+*/
+void R_ImageBench_f( void )
+{
+	static const char *kernelNames[NUM_IMAGEBENCH_KERNELS] = { "resample", "mipmap", "resample16", "mipmap16" };
+	char filenames[8192], pathname[MAX_QPATH];
+	const char *dir, *filename;
+	int iterations;
+	int e, i, k, numfiles, num;
+	int numImages = 0;
+	uint64_t numPixels = 0;
+	imageBenchStat_t stats[NUM_IMAGEBENCH_KERNELS];
+	loaderCbInfo_t cbinfo = { QGL_CONTEXT_MAIN, TEXTURE_LOADING_BUF0 };
+	r_imginfo_t imginfo;
+	uint8_t *pic;
+
+	if( ri.Cmd_Argc() < 2 )
+	{
+		Com_Printf( "Usage: %s <directory> [iterations]\n", ri.Cmd_Argv( 0 ) );
+		return;
+	}
+
+	dir = ri.Cmd_Argv( 1 );
+	iterations = ri.Cmd_Argc() > 2 ? max( atoi( ri.Cmd_Argv( 2 ) ), 1 ) : 4;
+
+	memset( stats, 0, sizeof( stats ) );
+
+	for( e = 0; e < (int)NUM_IMAGE_EXTENSIONS - 1; e++ ) // last is KTX
+	{
+		numfiles = ri.FS_GetFileList( dir, IMAGE_EXTENSIONS[e], NULL, 0, 0, 0 );
+
+		for( i = 0; i < numfiles; i += num )
+		{
+			if( ( num = ri.FS_GetFileList( dir, IMAGE_EXTENSIONS[e], filenames, sizeof( filenames ), i, numfiles ) ) == 0 )
+			{
+				num = 1; // advance by one file
+				continue;
+			}
+
+			for( k = 0, filename = filenames; k < num && *filename; k++, filename += strlen( filename ) + 1 )
+			{
+				Q_snprintfz( pathname, sizeof( pathname ), "%s/%s", dir, filename );
+
+				imginfo = IMG_LoadImage( pathname, _R_AllocImageBufferCb, ( void * )&cbinfo );
+				if( !imginfo.pixels || imginfo.samples < 1 )
+					continue;
+
+				// the loading buffer gets reused by the kernels' scratch space
+				pic = R_Malloc( imginfo.width * imginfo.height * imginfo.samples );
+				memcpy( pic, imginfo.pixels, imginfo.width * imginfo.height * imginfo.samples );
+
+				R_ImageBenchImage( pic, imginfo.width, imginfo.height, imginfo.samples, iterations, stats );
+
+				R_Free( pic );
+
+				numImages++;
+				numPixels += imginfo.width * imginfo.height;
+			}
+		}
+	}
+
+	if( !numImages )
+	{
+		Com_Printf( "No images found in %s\n", dir );
+		return;
+	}
+
+	Com_Printf( "%i images, %.1f Mpixels, %i iterations\n", numImages, numPixels / 1000000.0, iterations );
+	for( k = 0; k < NUM_IMAGEBENCH_KERNELS; k++ )
+	{
+		Com_Printf( "%-10s: C %8.2f ms, %s %8.2f ms, %.2fx, %s%u mismatches\n" S_COLOR_WHITE, kernelNames[k],
+			stats[k].time[0] / 1000.0, r_imageProcessingSIMD.name, stats[k].time[1] / 1000.0,
+			stats[k].time[1] ? (double)stats[k].time[0] / stats[k].time[1] : 0.0,
+			stats[k].mismatches ? S_COLOR_RED : "", stats[k].mismatches );
+	}
+}
+
 /*
 * R_TextureInternalFormat
 */
@@ -1610,6 +2200,358 @@ error: // must not be reached after actually starting uploading the texture
 	return false;
 }
 
+/*
+==================
+PROCESSED IMAGE CACHE
+
+Upload-ready mip chains of images decoded from TGA/PNG/JPG files are kept
+as uncompressed KTX files under cache/textures so that later loads skip
+decoding, resampling and mipmap generation. The key/value data of each
+file stores a hash of where the source file comes from and when it was
+modified, and a hash of the settings that affect processing. Stale files
+are simply overwritten.
+==================
+*/
+
+#define IMAGE_CACHE_DIRECTORY	"cache/textures"
+#define IMAGE_CACHE_VERSION		2
+#define IMAGE_CACHE_KV_KEY		"wswImageCache"
+
+typedef struct
+{
+	int				version;
+	unsigned int	sourceHash;
+	unsigned int	settingsHash;
+	int				width, height;			// source image size
+	int				samples;
+	int				flags;					// flags set by the image loader
+	char			extension[8];			// source file extension
+} imageCacheKey_t;
+
+#define IMAGE_CACHE_KV_LENGTH	( sizeof( IMAGE_CACHE_KV_KEY ) + sizeof( imageCacheKey_t ) )
+#define IMAGE_CACHE_KV_SIZE		( sizeof( int ) + ALIGN( IMAGE_CACHE_KV_LENGTH, 4 ) )
+
+typedef struct
+{
+	unsigned int	hits, misses, writes, failures;
+	uint64_t		hitTime, missTime;		// microseconds spent loading
+	uint64_t		bytesRead, bytesWritten;
+} imageCacheStats_t;
+
+static imageCacheStats_t r_imageCacheStats;
+static qmutex_t *r_imageCacheStatsLock;		// images are loaded by several threads
+
+/*
+* R_ImageCacheSettingsHash
+*/
+static unsigned int R_ImageCacheSettingsHash( int flags, int minmipsize )
+{
+	int settings[7];
+
+	settings[0] = IMAGE_CACHE_VERSION;
+	settings[1] = flags & ~( IT_BGRA|IT_SYNC|IT_NO_DATA_SYNC );
+	settings[2] = minmipsize;
+	settings[3] = ( flags & IT_NOPICMIP ) ? 0 : ( ( flags & IT_SKY ) ? r_skymip->integer : r_picmip->integer );
+	settings[4] = glConfig.maxTextureSize;
+	settings[5] = glConfig.ext.texture_non_power_of_two ? 1 : 0;
+	settings[6] = glConfig.ext.bgra ? 1 : 0;
+
+	return COM_SuperFastHash( ( const uint8_t * )settings, sizeof( settings ), sizeof( settings ) );
+}
+
+/*
+* R_HashImageSource
+*
+* Finds the source file for the image, replacing the extension in pathname,
+* and hashes its name, the checksum of the pak it's in and its modification
+* time. The file itself isn't read, a cache hit only reads the cache file.
+*/
+static bool R_HashImageSource( char *pathname, size_t pathname_size, unsigned int *hash )
+{
+	const char *extension;
+	int64_t stamp[2];
+
+	extension = ri.FS_FirstExtension( pathname, IMAGE_EXTENSIONS, NUM_IMAGE_EXTENSIONS - 1 ); // last is KTX
+	if( !extension )
+		return false;
+
+	COM_ReplaceExtension( pathname, extension, pathname_size );
+
+	stamp[0] = ri.FS_PakChecksumForFile( pathname );
+	stamp[1] = ri.FS_FileMTime( pathname );
+	if( stamp[1] <= 0 )
+		return false;
+
+	*hash = COM_SuperFastHash( ( const uint8_t * )pathname, strlen( pathname ), 0 );
+	*hash = COM_SuperFastHash( ( const uint8_t * )stamp, sizeof( stamp ), *hash );
+	return true;
+}
+
+/*
+* R_ImageCacheDataSize
+*/
+static size_t R_ImageCacheDataSize( int width, int height, int samples, int mips )
+{
+	int i;
+	size_t size = 0;
+
+	for( i = 0; i < mips; i++ )
+	{
+		size += sizeof( int ) + ALIGN( width * samples, 4 ) * height;
+		width = max( width >> 1, 1 );
+		height = max( height >> 1, 1 );
+	}
+
+	return size;
+}
+
+/*
+* R_UploadImageCache
+*
+* Uploads the mip levels following the key/value data of a cache file.
+* image->flags and image->samples must already be set.
+*/
+static void R_UploadImageCache( int ctx, image_t *image, const ktx_header_t *header, const uint8_t *data )
+{
+	int i;
+	int comp, format, type, target;
+	int width = header->pixelWidth, height = header->pixelHeight;
+
+	R_TextureFormat( image->flags, image->samples, &comp, &format, &type );
+	R_TextureTarget( image->flags, &target );
+
+	R_SetupTexParameters( image->flags, width, height, image->minmipsize );
+
+	R_UnpackAlignment( ctx, 4 );
+
+	for( i = 0; i < header->numberOfMipmapLevels; i++ )
+	{
+		data += sizeof( int );
+		qglTexImage2D( target, i, comp, width, height, 0, format, type, data );
+		data += ALIGN( width * image->samples, 4 ) * height;
+
+		width = max( width >> 1, 1 );
+		height = max( height >> 1, 1 );
+	}
+
+	image->upload_width = header->pixelWidth;
+	image->upload_height = header->pixelHeight;
+}
+
+/*
+* R_LoadImageCache
+*/
+static bool R_LoadImageCache( int ctx, image_t *image, const char *cachename,
+	unsigned int sourceHash, unsigned int settingsHash )
+{
+	int length;
+	uint8_t *buffer;
+	const uint8_t *kv;
+	ktx_header_t *header;
+	imageCacheKey_t key;
+
+	length = R_LoadFile( cachename, ( void ** )&buffer );
+	if( !buffer )
+		return false;
+
+	if( length < (int)( sizeof( ktx_header_t ) + IMAGE_CACHE_KV_SIZE ) )
+		goto stale;
+
+	header = ( ktx_header_t * )buffer;
+	if( memcmp( header->identifier, "\xABKTX 11\xBB\r\n\x1A\n", 12 ) || ( header->endianness != 0x04030201 )
+		|| ( header->bytesOfKeyValueData != IMAGE_CACHE_KV_SIZE ) || ( header->type != GL_UNSIGNED_BYTE )
+		|| ( header->numberOfFaces != 1 ) || ( header->numberOfMipmapLevels < 1 ) || ( header->numberOfMipmapLevels > 32 )
+		|| ( header->pixelWidth < 1 ) || ( header->pixelHeight < 1 ) )
+		goto stale;
+
+	kv = buffer + sizeof( ktx_header_t );
+	if( ( *( const int * )kv != IMAGE_CACHE_KV_LENGTH ) || memcmp( kv + sizeof( int ), IMAGE_CACHE_KV_KEY, sizeof( IMAGE_CACHE_KV_KEY ) ) )
+		goto stale;
+
+	memcpy( &key, kv + sizeof( int ) + sizeof( IMAGE_CACHE_KV_KEY ), sizeof( key ) );
+	if( ( key.version != IMAGE_CACHE_VERSION ) || ( key.sourceHash != sourceHash ) || ( key.settingsHash != settingsHash )
+		|| ( key.samples < 1 ) || ( key.samples > 4 ) )
+		goto stale;
+
+	if( sizeof( ktx_header_t ) + IMAGE_CACHE_KV_SIZE + R_ImageCacheDataSize( header->pixelWidth, header->pixelHeight,
+		key.samples, header->numberOfMipmapLevels ) != (size_t)length )
+		goto stale;
+
+	key.extension[sizeof( key.extension ) - 1] = 0;
+
+	image->width = key.width;
+	image->height = key.height;
+	image->samples = key.samples;
+	image->flags |= key.flags & IT_BGRA;
+	Q_strncpyz( image->extension, key.extension, sizeof( image->extension ) );
+
+	R_BindImage( image );
+
+	R_UploadImageCache( ctx, image, header, kv + IMAGE_CACHE_KV_SIZE );
+
+	ri.Mutex_Lock( r_imageCacheStatsLock );
+	r_imageCacheStats.bytesRead += length;
+	ri.Mutex_Unlock( r_imageCacheStatsLock );
+
+	R_FreeFile( buffer );
+	return true;
+
+stale:
+	R_FreeFile( buffer );
+	return false;
+}
+
+/*
+* R_UploadAndCacheImage
+*
+* Processes a 2D image the same way R_Upload32 does, but keeps every mip level
+* in a KTX file buffer, which is then uploaded and written to the cache.
+*/
+static void R_UploadAndCacheImage( int ctx, image_t *image, uint8_t *pic, const char *cachename, imageCacheKey_t *key )
+{
+	int i, mips;
+	int flags = image->flags, samples = image->samples;
+	int width = image->width, height = image->height;
+	int scaledWidth, scaledHeight;
+	int filenum, length, pitch, alignedPitch;
+	size_t size;
+	uint8_t *buffer, *scaled, *data, *kv;
+	const uint8_t *in;
+	ktx_header_t *header;
+	int comp, format, type;
+
+	if( flags & ( IT_FLIPX|IT_FLIPY|IT_FLIPDIAGONAL ) )
+	{
+		uint8_t *temp = R_PrepareImageBuffer( ctx, TEXTURE_FLIPPING_BUF0, width * height * samples );
+		R_FlipTexture( pic, temp, width, height, samples, 
+			(flags & IT_FLIPX) ? true : false, 
+			(flags & IT_FLIPY) ? true : false, 
+			(flags & IT_FLIPDIAGONAL) ? true : false );
+		pic = temp;
+	}
+
+	R_ScaledImageSize( width, height, &scaledWidth, &scaledHeight, flags, 1, image->minmipsize, false );
+	mips = ( flags & IT_NOMIPMAP ) ? 1 : R_MipCount( scaledWidth, scaledHeight, image->minmipsize );
+
+	size = sizeof( ktx_header_t ) + IMAGE_CACHE_KV_SIZE + R_ImageCacheDataSize( scaledWidth, scaledHeight, samples, mips );
+	buffer = R_PrepareImageBuffer( ctx, TEXTURE_LOADING_BUF1, size );
+	memset( buffer, 0, sizeof( ktx_header_t ) + IMAGE_CACHE_KV_SIZE );
+
+	R_TextureFormat( flags, samples, &comp, &format, &type );
+
+	header = ( ktx_header_t * )buffer;
+	memcpy( header->identifier, "\xABKTX 11\xBB\r\n\x1A\n", 12 );
+	header->endianness = 0x04030201;
+	header->type = type;
+	header->typeSize = 1;
+	header->format = format;
+	header->internalFormat = comp;
+	header->baseInternalFormat = format;
+	header->pixelWidth = scaledWidth;
+	header->pixelHeight = scaledHeight;
+	header->numberOfFaces = 1;
+	header->numberOfMipmapLevels = mips;
+	header->bytesOfKeyValueData = IMAGE_CACHE_KV_SIZE;
+
+	key->flags = flags & IT_BGRA;
+	kv = buffer + sizeof( ktx_header_t );
+	*( int * )kv = IMAGE_CACHE_KV_LENGTH;
+	memcpy( kv + sizeof( int ), IMAGE_CACHE_KV_KEY, sizeof( IMAGE_CACHE_KV_KEY ) );
+	memcpy( kv + sizeof( int ) + sizeof( IMAGE_CACHE_KV_KEY ), key, sizeof( *key ) );
+
+	// resample and mipmap with the same unpack alignment R_Upload32 uses,
+	// padding the rows of each level to 4 bytes as KTX requires
+	scaled = R_PrepareImageBuffer( ctx, TEXTURE_RESAMPLING_BUF0, scaledWidth * scaledHeight * samples );
+	R_ResampleTexture( ctx, pic, width, height, scaled, scaledWidth, scaledHeight, samples, 1 );
+
+	data = kv + IMAGE_CACHE_KV_SIZE;
+	width = scaledWidth;
+	height = scaledHeight;
+	for( i = 0; i < mips; i++ )
+	{
+		int y;
+
+		if( i )
+		{
+			R_MipMap( scaled, width, height, samples, 1 );
+			width = max( width >> 1, 1 );
+			height = max( height >> 1, 1 );
+		}
+
+		pitch = width * samples;
+		alignedPitch = ALIGN( pitch, 4 );
+
+		*( int * )data = alignedPitch * height;
+		data += sizeof( int );
+
+		for( y = 0, in = scaled; y < height; y++, in += pitch, data += alignedPitch )
+		{
+			memcpy( data, in, pitch );
+			memset( data + pitch, 0, alignedPitch - pitch );
+		}
+	}
+
+	R_BindImage( image );
+
+	R_UploadImageCache( ctx, image, header, kv + IMAGE_CACHE_KV_SIZE );
+
+	if( ri.FS_FOpenFile( cachename, &filenum, FS_WRITE ) == -1 )
+	{
+		ri.Mutex_Lock( r_imageCacheStatsLock );
+		r_imageCacheStats.failures++;
+		ri.Mutex_Unlock( r_imageCacheStatsLock );
+		return;
+	}
+
+	length = ri.FS_Write( buffer, size, filenum );
+	ri.FS_FCloseFile( filenum );
+
+	if( length != (int)size )
+	{
+		ri.FS_RemoveFile( cachename );
+		ri.Mutex_Lock( r_imageCacheStatsLock );
+		r_imageCacheStats.failures++;
+		ri.Mutex_Unlock( r_imageCacheStatsLock );
+		return;
+	}
+
+	ri.Mutex_Lock( r_imageCacheStatsLock );
+	r_imageCacheStats.writes++;
+	r_imageCacheStats.bytesWritten += size;
+	ri.Mutex_Unlock( r_imageCacheStatsLock );
+}
+
+/*
+* R_ImageCacheStats_f
+*
+* imagecachestats [reset]
+*/
+void R_ImageCacheStats_f( void )
+{
+	imageCacheStats_t stats, *s = &stats;
+
+	ri.Mutex_Lock( r_imageCacheStatsLock );
+	if( !Q_stricmp( ri.Cmd_Argv( 1 ), "reset" ) )
+	{
+		memset( &r_imageCacheStats, 0, sizeof( r_imageCacheStats ) );
+		ri.Mutex_Unlock( r_imageCacheStatsLock );
+		return;
+	}
+	stats = r_imageCacheStats;
+	ri.Mutex_Unlock( r_imageCacheStatsLock );
+
+	Com_Printf( "Image cache is %s\n", r_texturecache->integer ? "enabled" : "disabled" );
+	Com_Printf( "%u hits, %u misses, %u writes, %u failed writes\n", s->hits, s->misses, s->writes, s->failures );
+	Com_Printf( "%.1f MB read, %.1f MB written\n", s->bytesRead / ( 1024.0 * 1024.0 ), s->bytesWritten / ( 1024.0 * 1024.0 ) );
+
+	if( s->hits )
+		Com_Printf( "hit: %.3f ms average, %.1f ms total\n", s->hitTime / 1000.0 / s->hits, s->hitTime / 1000.0 );
+	if( s->misses )
+		Com_Printf( "miss: %.3f ms average, %.1f ms total\n", s->missTime / 1000.0 / s->misses, s->missTime / 1000.0 );
+	if( s->hits && s->misses && s->hitTime )
+		Com_Printf( "cached loads are %.1fx faster\n", ( (double)s->missTime / s->misses ) / ( (double)s->hitTime / s->hits ) );
+}
+
 /*
 * R_LoadImageFromDisk
 */
@@ -1721,8 +2663,39 @@ static bool R_LoadImageFromDisk( int ctx, image_t *image )
 	else
 	{
 		uint8_t *pic = NULL;
+		bool cache = false;
+		char cachename[1024];
+		imageCacheKey_t key;
+		uint64_t startTime = 0;
 
 		Q_strncatz( pathname, ".tga", pathsize );
+
+		if( r_texturecache->integer && !( flags & ( IT_ARRAY|IT_3D ) ) &&
+			( len + sizeof( IMAGE_CACHE_DIRECTORY "/.ktx" ) <= sizeof( cachename ) ) )
+		{
+			startTime = ri.Sys_Microseconds();
+
+			memset( &key, 0, sizeof( key ) );
+			key.version = IMAGE_CACHE_VERSION;
+			key.settingsHash = R_ImageCacheSettingsHash( flags, image->minmipsize );
+			cache = R_HashImageSource( pathname, pathsize, &key.sourceHash );
+		}
+
+		if( cache )
+		{
+			Q_snprintfz( cachename, sizeof( cachename ), IMAGE_CACHE_DIRECTORY "/%s.ktx", image->name );
+			if( R_LoadImageCache( ctx, image, cachename, key.sourceHash, key.settingsHash ) )
+			{
+				ri.Mutex_Lock( r_imageCacheStatsLock );
+				r_imageCacheStats.hits++;
+				r_imageCacheStats.hitTime += ri.Sys_Microseconds() - startTime;
+				ri.Mutex_Unlock( r_imageCacheStatsLock );
+
+				R_DeferDataSync();
+				return true;
+			}
+		}
+
 		samples = R_ReadImageFromDisk( ctx, pathname, pathsize, &pic, &width, &height, &flags, 0 );
 
 		if( pic )
@@ -1731,10 +2704,28 @@ static bool R_LoadImageFromDisk( int ctx, image_t *image )
 			image->height = height;
 			image->samples = samples;
 
-			R_BindImage( image );
+			if( cache )
+			{
+				key.width = width;
+				key.height = height;
+				key.samples = samples;
+				Q_strncpyz( key.extension, &pathname[len], sizeof( key.extension ) );
+
+				image->flags = flags;
+				R_UploadAndCacheImage( ctx, image, pic, cachename, &key );
+
+				ri.Mutex_Lock( r_imageCacheStatsLock );
+				r_imageCacheStats.misses++;
+				r_imageCacheStats.missTime += ri.Sys_Microseconds() - startTime;
+				ri.Mutex_Unlock( r_imageCacheStatsLock );
+			}
+			else
+			{
+				R_BindImage( image );
 
-			R_Upload32( ctx, &pic, 0, 0, 0, width, height, flags, image->minmipsize, &image->upload_width, 
-				&image->upload_height, samples, false, false );
+				R_Upload32( ctx, &pic, 0, 0, 0, width, height, flags, image->minmipsize, &image->upload_width, 
+					&image->upload_height, samples, false, false );
+			}
 
 			Q_strncpyz( image->extension, &pathname[len], sizeof( image->extension ) );
 			loaded = true;
@@ -2700,6 +3691,7 @@ void R_InitImages( void )
 
 	r_imagesPool = R_AllocPool( r_mempool, "Images" );
 	r_imagesLock = ri.Mutex_Create();
+	r_imageCacheStatsLock = ri.Mutex_Create();
 
 	unpackAlignment[QGL_CONTEXT_MAIN] = 4;
 	qglPixelStorei( GL_PACK_ALIGNMENT, 1 );
@@ -2830,6 +3822,7 @@ void R_ShutdownImages( void )
 		r_8to24table = NULL;
 	}
 
+	ri.Mutex_Destroy( &r_imageCacheStatsLock );
 	ri.Mutex_Destroy( &r_imagesLock );
 
 	R_FreePool( &r_imagesPool );
@@ -0,0 +1,211 @@
+/*
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+*/
+
+// r_jobs.c: worker pool for splitting frontend work across cores
+
+#include "r_local.h"
+
+typedef struct
+{
+	int				numWorkers;
+	struct qthread_s *threads[MAX_FRONTEND_WORKERS];
+
+	struct qmutex_s	*mutex;
+	struct qcondvar_s *wakeCond;		// signaled when a new batch is posted
+	struct qcondvar_s *doneCond;		// signaled when the last chunk of a batch is done
+
+	volatile bool	shutdown;
+	unsigned int	generation;
+
+	// current batch
+	r_jobfunc_t		func;
+	void			*arg;
+	unsigned int	count;
+	unsigned int	granularity;
+	unsigned int	nextChunk, numChunks, chunksDone;
+} r_jobs_t;
+
+static r_jobs_t r_jobs;
+
+/*
+* R_RunJobChunks
+*
+* Grabs chunks of the current batch until none are left. Must be called
+* with the mutex held, the mutex is released while the job runs.
+*/
+static void R_RunJobChunks( int worker )
+{
+	unsigned int chunk, first;
+
+	while( r_jobs.nextChunk < r_jobs.numChunks ) {
+		chunk = r_jobs.nextChunk++;
+		first = chunk * r_jobs.granularity;
+
+		ri.Mutex_Unlock( r_jobs.mutex );
+		r_jobs.func( r_jobs.arg, first, min( r_jobs.granularity, r_jobs.count - first ), worker );
+		ri.Mutex_Lock( r_jobs.mutex );
+
+		if( ++r_jobs.chunksDone == r_jobs.numChunks ) {
+			ri.CondVar_Wake( r_jobs.doneCond );
+		}
+	}
+}
+
+/*
+* R_JobWorkerProc
+*/
+static void *R_JobWorkerProc( void *param )
+{
+	int worker = ( int )( intptr_t )param;
+	unsigned int generation = 0;
+
+	ri.Mutex_Lock( r_jobs.mutex );
+
+	while( !r_jobs.shutdown ) {
+		if( r_jobs.generation == generation ) {
+			ri.CondVar_Wait( r_jobs.wakeCond, r_jobs.mutex, Q_THREADS_WAIT_INFINITE );
+			continue;
+		}
+
+		generation = r_jobs.generation;
+		R_RunJobChunks( worker );
+	}
+
+	ri.Mutex_Unlock( r_jobs.mutex );
+	return NULL;
+}
+
+/*
+* R_InitJobs
+*/
+void R_InitJobs( void )
+{
+	int i;
+
+	memset( &r_jobs, 0, sizeof( r_jobs ) );
+
+	r_jobs.numWorkers = bound( 0, r_workers->integer, MAX_FRONTEND_WORKERS );
+	if( !r_jobs.numWorkers ) {
+		return;
+	}
+
+	r_jobs.mutex = ri.Mutex_Create();
+	r_jobs.wakeCond = ri.CondVar_Create();
+	r_jobs.doneCond = ri.CondVar_Create();
+
+	for( i = 0; i < r_jobs.numWorkers; i++ ) {
+		// worker 0 is the thread that posts the batch
+		r_jobs.threads[i] = ri.Thread_Create( R_JobWorkerProc, ( void * )( intptr_t )( i + 1 ) );
+	}
+}
+
+/*
+* R_ShutdownJobs
+*/
+void R_ShutdownJobs( void )
+{
+	int i;
+
+	if( !r_jobs.numWorkers ) {
+		return;
+	}
+
+	ri.Mutex_Lock( r_jobs.mutex );
+	r_jobs.shutdown = true;
+	for( i = 0; i < r_jobs.numWorkers; i++ ) {
+		ri.CondVar_Wake( r_jobs.wakeCond );
+	}
+	ri.Mutex_Unlock( r_jobs.mutex );
+
+	for( i = 0; i < r_jobs.numWorkers; i++ ) {
+		ri.Thread_Join( r_jobs.threads[i] );
+	}
+
+	ri.CondVar_Destroy( &r_jobs.doneCond );
+	ri.CondVar_Destroy( &r_jobs.wakeCond );
+	ri.Mutex_Destroy( &r_jobs.mutex );
+
+	memset( &r_jobs, 0, sizeof( r_jobs ) );
+}
+
+/*
+* R_NumJobWorkers
+*
+* Returns the number of threads that may execute a job at once, including
+* the caller of R_ParallelFor
+*/
+int R_NumJobWorkers( void )
+{
+	return r_jobs.numWorkers + 1;
+}
+
+/*
+* R_ParallelFor
+*
+* Splits [0, count) into chunks of granularity items and runs them on
+* the worker pool and the calling thread, returning when all are done.
+* Jobs receive the index of the executing thread, which is less than
+* R_NumJobWorkers(), and must not touch GL state. If the pool is already
+* busy with a batch posted by another thread, the range runs inline as
+* worker 0, so jobs that keep per-worker state should only be posted by
+* the frontend.
+*/
+void R_ParallelFor( unsigned int count, unsigned int granularity, r_jobfunc_t func, void *arg )
+{
+	int i;
+
+	if( !count ) {
+		return;
+	}
+
+	granularity = max( granularity, 1 );
+	if( !r_jobs.numWorkers || count <= granularity ) {
+		func( arg, 0, count, 0 );
+		return;
+	}
+
+	ri.Mutex_Lock( r_jobs.mutex );
+
+	if( r_jobs.func ) {
+		// another thread owns the pool at the moment
+		ri.Mutex_Unlock( r_jobs.mutex );
+		func( arg, 0, count, 0 );
+		return;
+	}
+
+	r_jobs.func = func;
+	r_jobs.arg = arg;
+	r_jobs.count = count;
+	r_jobs.granularity = granularity;
+	r_jobs.nextChunk = r_jobs.chunksDone = 0;
+	r_jobs.numChunks = ( count + granularity - 1 ) / granularity;
+	r_jobs.generation++;
+
+	for( i = 0; i < r_jobs.numWorkers; i++ ) {
+		ri.CondVar_Wake( r_jobs.wakeCond );
+	}
+
+	R_RunJobChunks( 0 );
+
+	while( r_jobs.chunksDone < r_jobs.numChunks ) {
+		ri.CondVar_Wait( r_jobs.doneCond, r_jobs.mutex, Q_THREADS_WAIT_INFINITE );
+	}
+
+	r_jobs.func = NULL;
+	ri.Mutex_Unlock( r_jobs.mutex );
+}
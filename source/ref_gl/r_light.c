@@ -420,6 +420,69 @@ static void R_BuildLightmap( int w, int h, bool deluxe, const uint8_t *data, uin
 	}
 }
 
+typedef struct
+{
+	int w, h, samples;
+	int rectX, xStride;
+	size_t dataStride;				// distance between the blocks in source data
+	const uint8_t *data;
+	uint8_t *dest;
+	bool deluxeBlocks;				// odd blocks are deluxemaps
+} lightmapPackJob_t;
+
+/*
+* R_BuildPackedLightmapsJob
+*
+* Converts blocks of a packed lightmap texture, each block covers its own rectangle
+*/
+static void R_BuildPackedLightmapsJob( void *arg, unsigned int first, unsigned int count, int worker )
+{
+	const lightmapPackJob_t *job = arg;
+	unsigned int i, x, y;
+
+	for( i = first; i < first + count; i++ )
+	{
+		x = i % job->rectX;
+		y = i / job->rectX;
+		R_BuildLightmap( job->w, job->h, job->deluxeBlocks && ( i & 1 ) ? true : false,
+			job->data ? job->data + i * job->dataStride : NULL,
+			job->dest + ( y * job->h * job->rectX + x ) * job->xStride, job->rectX * job->xStride, job->samples );
+	}
+}
+
+typedef struct
+{
+	int w, h, samples;
+	int layerWidth;
+	size_t blockSize, dataStride;
+	const uint8_t *data;
+	uint8_t *dest;
+	size_t layerSize;
+	bool deluxe;					// put the deluxemap next to the lightmap
+} lightmapLayersJob_t;
+
+/*
+* R_BuildLightmapLayersJob
+*/
+static void R_BuildLightmapLayersJob( void *arg, unsigned int first, unsigned int count, int worker )
+{
+	const lightmapLayersJob_t *job = arg;
+	unsigned int i;
+	const uint8_t *data;
+	uint8_t *dest;
+
+	for( i = first; i < first + count; i++ )
+	{
+		data = job->data ? job->data + i * job->dataStride : NULL;
+		dest = job->dest + i * job->layerSize;
+
+		R_BuildLightmap( job->w, job->h, false, data, dest, job->layerWidth * job->samples, job->samples );
+		if( job->deluxe )
+			R_BuildLightmap( job->w, job->h, true, data ? data + job->blockSize : NULL,
+				dest + job->w * job->samples, job->layerWidth * job->samples, job->samples );
+	}
+}
+
 /*
 * R_UploadLightmap
 */
@@ -451,12 +514,12 @@ static int R_PackLightmaps( int num, int w, int h, int dataSize, int stride, int
 	const char *name, const uint8_t *data, mlightmapRect_t *rects )
 {
 	int i, x, y, root;
-	uint8_t *block;
 	int lightmapNum;
 	int rectX, rectY, rectW, rectH, rectSize;
 	int maxX, maxY, max, xStride;
 	double tw, th, tx, ty;
 	mlightmapRect_t *rect;
+	lightmapPackJob_t job;
 
 	maxX = r_maxLightmapBlockSize / w;
 	maxY = r_maxLightmapBlockSize / h;
@@ -544,15 +607,22 @@ static int R_PackLightmaps( int num, int w, int h, int dataSize, int stride, int
 
 	ri.Com_DPrintf( "%ix%i : %ix%i\n", rectX, rectY, rectW, rectH );
 
-	block = r_lightmapBuffer;
-	for( y = 0, ty = 0.0, num = 0, rect = rects; y < rectY; y++, ty += th, block += rectX * xStride * h )
+	job.w = w;
+	job.h = h;
+	job.samples = samples;
+	job.rectX = rectX;
+	job.xStride = xStride;
+	job.dataStride = dataSize * stride;
+	job.data = data;
+	job.dest = r_lightmapBuffer;
+	job.deluxeBlocks = mapConfig.deluxeMappingEnabled;
+
+	R_ParallelFor( rectX * rectY, 1, R_BuildPackedLightmapsJob, &job );
+
+	for( y = 0, ty = 0.0, num = 0, rect = rects; y < rectY; y++, ty += th )
 	{
-		for( x = 0, tx = 0.0; x < rectX; x++, tx += tw, num++, data += dataSize * stride )
+		for( x = 0, tx = 0.0; x < rectX; x++, tx += tw, num++ )
 		{
-			R_BuildLightmap( w, h, 
-				mapConfig.deluxeMappingEnabled && ( num & 1 ) ? true : false, 
-				data, block + x * xStride, rectX * xStride, samples );
-
 			// this is not a real texture matrix, but who cares?
 			if( rects )
 			{
@@ -640,13 +710,16 @@ void R_BuildLightmaps( model_t *mod, int numLightmaps, int w, int h, const uint8
 	if( mapConfig.lightmapArrays )
 	{
 		int numLayers = min( glConfig.maxTextureLayers, 256 ); // layer index is a uint8_t
-		int layer = 0;
-		int lightmapNum = 0;
-		image_t *image = NULL;
+		int numImageLayers;
+		int layer;
+		int lightmapNum;
+		image_t *image;
 		mlightmapRect_t *rect = rects;
 		int blockSize = w * h * LIGHTMAP_BYTES;
 		float texScale = 1.0f;
 		char tempbuf[16];
+		lightmapLayersJob_t job;
+		uint8_t *layerData;
 
 		if( mapConfig.deluxeMaps )
 			numLightmaps /= 2;
@@ -654,47 +727,55 @@ void R_BuildLightmaps( model_t *mod, int numLightmaps, int w, int h, const uint8
 		if( mapConfig.deluxeMappingEnabled )
 			texScale = 0.5f;
 
-		for( i = 0; i < numLightmaps; i++ )
+		// convert all layers of a texture at once
+		R_Free( r_lightmapBuffer );
+		r_lightmapBufferSize = size * samples * min( numLayers, max( numLightmaps, 1 ) );
+		r_lightmapBuffer = R_MallocExt( r_mempool, r_lightmapBufferSize, 0, 0 );
+
+		job.w = w;
+		job.h = h;
+		job.samples = samples;
+		job.layerWidth = layerWidth;
+		job.blockSize = blockSize;
+		job.dataStride = blockSize * ( mapConfig.deluxeMaps ? 2 : 1 );
+		job.dest = r_lightmapBuffer;
+		job.layerSize = size * samples;
+		job.deluxe = mapConfig.deluxeMappingEnabled;
+
+		for( i = 0; i < numLightmaps; i += numImageLayers )
 		{
-			if( !layer )
+			if( r_numUploadedLightmaps == MAX_LIGHTMAP_IMAGES )
 			{
-				if( r_numUploadedLightmaps == MAX_LIGHTMAP_IMAGES )
-				{
-					// not sure what I'm supposed to do here.. an unrealistic scenario
-					Com_Printf( S_COLOR_YELLOW "Warning: r_numUploadedLightmaps == MAX_LIGHTMAP_IMAGES\n" );
-					break;
-				}
-				lightmapNum = r_numUploadedLightmaps++;
-				image = R_Create3DImage( va_r( tempbuf, sizeof( tempbuf ), "*lm%i", lightmapNum ), layerWidth, h,
-					( ( i + numLayers ) <= numLightmaps ) ? numLayers : numLightmaps % numLayers,
-					IT_SPECIAL, IMAGE_TAG_GENERIC, samples, true );
-				r_lightmapTextures[lightmapNum] = image;
+				// not sure what I'm supposed to do here.. an unrealistic scenario
+				Com_Printf( S_COLOR_YELLOW "Warning: r_numUploadedLightmaps == MAX_LIGHTMAP_IMAGES\n" );
+				break;
 			}
 
-			R_BuildLightmap( w, h, false, data, r_lightmapBuffer, layerWidth * samples, samples );
-			data += blockSize;
+			numImageLayers = min( numLayers, numLightmaps - i );
 
-			rect->texNum = lightmapNum;
-			rect->texLayer = layer;
-			// this is not a real texture matrix, but who cares?
-			rect->texMatrix[0][0] = texScale; rect->texMatrix[0][1] = 0.0f;
-			rect->texMatrix[1][0] = 1.0f; rect->texMatrix[1][1] = 0.0f;
-			++rect;
+			lightmapNum = r_numUploadedLightmaps++;
+			image = R_Create3DImage( va_r( tempbuf, sizeof( tempbuf ), "*lm%i", lightmapNum ), layerWidth, h,
+				numImageLayers, IT_SPECIAL, IMAGE_TAG_GENERIC, samples, true );
+			r_lightmapTextures[lightmapNum] = image;
 
-			if( mapConfig.deluxeMappingEnabled )
-				R_BuildLightmap( w, h, true, data, r_lightmapBuffer + w * samples, layerWidth * samples, samples );
+			job.data = data ? data + i * job.dataStride : NULL;
+			R_ParallelFor( numImageLayers, 1, R_BuildLightmapLayersJob, &job );
 
-			if( mapConfig.deluxeMaps )
+			for( layer = 0; layer < numImageLayers; layer++ )
 			{
-				data += blockSize;
+				rect->texNum = lightmapNum;
+				rect->texLayer = layer;
+				// this is not a real texture matrix, but who cares?
+				rect->texMatrix[0][0] = texScale; rect->texMatrix[0][1] = 0.0f;
+				rect->texMatrix[1][0] = 1.0f; rect->texMatrix[1][1] = 0.0f;
 				++rect;
-			}
 
-			R_ReplaceImageLayer( image, layer, &r_lightmapBuffer );
+				if( mapConfig.deluxeMaps )
+					++rect;
 
-			++layer;
-			if( layer == numLayers )
-				layer = 0;
+				layerData = r_lightmapBuffer + layer * job.layerSize;
+				R_ReplaceImageLayer( image, layer, &layerData );
+			}
 		}
 	}
 	else
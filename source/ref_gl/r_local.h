@@ -405,6 +405,9 @@ extern cvar_t *r_soft_particles_scale;
 extern cvar_t *r_fxaa;
 
 extern cvar_t *r_lodbias;
+extern cvar_t *r_skinning_simd;
+extern cvar_t *r_skinning_parallel;
+extern cvar_t *r_image_simd;
 extern cvar_t *r_lodscale;
 
 extern cvar_t *r_gamma;
@@ -416,6 +419,7 @@ extern cvar_t *r_mode;
 extern cvar_t *r_nobind;
 extern cvar_t *r_picmip;
 extern cvar_t *r_skymip;
+extern cvar_t *r_texturecache;
 extern cvar_t *r_polyblend;
 extern cvar_t *r_lockpvs;
 extern cvar_t *r_screenshot_fmtstr;
@@ -433,6 +437,8 @@ extern cvar_t *r_usenotexture;
 extern cvar_t *r_maxglslbones;
 
 extern cvar_t *r_multithreading;
+extern cvar_t *r_workers;
+extern cvar_t *r_cin_async;
 
 extern cvar_t *gl_cull;
 
@@ -450,7 +456,7 @@ void R_LatLongToNorm4( const uint8_t latlong[2], vec4_t out );
 //
 // r_alias.c
 //
-bool	R_AddAliasModelToDrawList( const entity_t *e );
+bool	R_AddAliasModelToDrawList( drawList_t *list, const entity_t *e );
 void	R_DrawAliasSurf( const entity_t *e, const shader_t *shader, const mfog_t *fog, const portalSurface_t *portalSurface, unsigned int shadowBits, drawSurfaceAlias_t *drawSurf );
 bool	R_AliasModelLerpTag( orientation_t *orient, const maliasmodel_t *aliasmodel, int framenum, int oldframenum,
 				float lerpfrac, const char *name );
@@ -520,6 +526,18 @@ void		RFB_GetObjectSize( int object, int *width, int *height );
 void		RFB_FreeUnusedObjects( void );
 void		RFB_Shutdown( void );
 
+//
+// r_jobs.c
+//
+#define MAX_FRONTEND_WORKERS	7
+
+typedef void ( *r_jobfunc_t )( void *arg, unsigned int first, unsigned int count, int worker );
+
+void		R_InitJobs( void );
+void		R_ShutdownJobs( void );
+int			R_NumJobWorkers( void );
+void		R_ParallelFor( unsigned int count, unsigned int granularity, r_jobfunc_t func, void *arg );
+
 //
 // r_light.c
 //
@@ -652,8 +670,10 @@ void R_AddVBOSlice( unsigned int index, unsigned int numVerts, unsigned int numE
 vboSlice_t *R_GetVBOSlice( unsigned int index );
 
 void R_InitDrawLists( void );
+void R_MergeDrawList( drawList_t *list, drawList_t *fragment );
 
 void R_SortDrawList( drawList_t *list );
+void R_SortBench_f( void );
 void R_DrawSurfaces( drawList_t *list );
 void R_DrawOutlinedSurfaces( drawList_t *list );
 
@@ -683,6 +703,12 @@ void		R_DrawStretchPoly( const poly_t *poly, float x_offset, float y_offset );
 bool	R_SurfPotentiallyFragmented( const msurface_t *surf );
 int			R_GetClippedFragments( const vec3_t origin, float radius, vec3_t axis[3], int maxfverts,
 								  vec4_t *fverts, int maxfragments, fragment_t *fragments );
+unsigned int R_QueueClippedFragments( const vec3_t origin, float radius, vec3_t axis[3] );
+int			R_GetQueuedFragments( unsigned int ticket, int maxfverts, vec4_t *fverts, int maxfragments, fragment_t *fragments );
+void		R_FlushQueuedFragments( void );
+void		R_FinishFlushQueuedFragments( void );
+void		R_InitFragmentClipper( void );
+void		R_ShutdownFragmentClipper( void );
 
 //
 // r_register.c
@@ -700,6 +726,7 @@ rserr_t		R_SetMode( int x, int y, int width, int height, int displayFrequency, b
 // r_scene.c
 //
 extern drawList_t r_worldlist, r_portalmasklist;
+extern drawList_t r_fragmentlists[MAX_FRONTEND_WORKERS+1];
 
 void R_AddDebugBounds( const vec3_t mins, const vec3_t maxs, const byte_vec4_t color );
 void R_ClearScene( void );
@@ -716,6 +743,12 @@ void R_RenderScene( const refdef_t *fd );
 
 void		R_MarkLeaves( void );
 void		R_DrawWorld( void );
+size_t		R_LeafCullSize( unsigned int numLeafs, bool results );
+void		R_InitLeafCull( mleafcull_t *lc, unsigned int numLeafs, bool results, uint8_t *buffer );
+void		R_FlattenLeafs( mleafcull_t *lc, mleaf_t **leafs );
+void		R_CullLeafs( mleafcull_t *lc, unsigned int first, unsigned int count, 
+				const cplane_t *frustum, unsigned int clipFlags, unsigned int dlightBits, unsigned int shadowBits );
+void		R_CullBench_f( void );
 bool	R_SurfPotentiallyVisible( const msurface_t *surf );
 bool	R_SurfPotentiallyShadowed( const msurface_t *surf );
 bool	R_SurfPotentiallyLit( const msurface_t *surf );
@@ -736,7 +769,8 @@ shader_t	*R_FindShaderForSkinFile( const struct skinfile_s *skinfile, const char
 //
 // r_skm.c
 //
-bool	R_AddSkeletalModelToDrawList( const entity_t *e );
+bool	R_AddSkeletalModelToDrawList( drawList_t *list, const entity_t *e );
+void	R_SkinBench_f( void );
 void	R_DrawSkeletalSurf( const entity_t *e, const shader_t *shader, const mfog_t *fog, const portalSurface_t *portalSurface, unsigned int shadowBits, drawSurfaceSkeletal_t *drawSurf );
 float		R_SkeletalModelBBox( const entity_t *e, vec3_t mins, vec3_t maxs );
 void		R_SkeletalModelFrameBounds( const model_t *mod, int frame, vec3_t mins, vec3_t maxs );
@@ -1096,15 +1096,57 @@ static void R_EndGL( void )
 		RB_FlipFrontFace();
 }
 
+#define ENTITIES_PER_JOB		16
+
+static bool r_entityCulled[MAX_REF_ENTITIES];
+
+/*
+* R_AddModelEntitiesJob
+*
+* Culls alias and skeletal models on a frontend worker, adding their
+* surfaces to the worker's draw list fragment
+*/
+static void R_AddModelEntitiesJob( void *arg, unsigned int first, unsigned int count, int worker )
+{
+	unsigned int i;
+	entity_t *e;
+	drawList_t *fragment = &r_fragmentlists[worker];
+
+	for( i = first; i < first + count; i++ )
+	{
+		e = R_NUM2ENT( rsc.numLocalEntities + i );
+		if( e->rtype != RT_MODEL || !e->model ) {
+			continue;
+		}
+
+		if( !r_lerpmodels->integer )
+			e->backlerp = 0;
+
+		switch( e->model->type )
+		{
+		case mod_alias:
+			r_entityCulled[R_ENT2NUM( e )] = ! R_AddAliasModelToDrawList( fragment, e );
+			break;
+		case mod_skeletal:
+			r_entityCulled[R_ENT2NUM( e )] = ! R_AddSkeletalModelToDrawList( fragment, e );
+			break;
+		default:
+			break;
+		}
+	}
+}
+
 /*
 * R_DrawEntities
 */
 static void R_DrawEntities( void )
 {
+	int j;
 	unsigned int i;
 	entity_t *e;
 	bool shadowmap = ( ( rn.renderFlags & RF_SHADOWMAPVIEW ) != 0 );
 	bool culled = true;
+	bool parallel;
 
 	if( rn.renderFlags & RF_ENVVIEW )
 	{
@@ -1120,6 +1162,17 @@ static void R_DrawEntities( void )
 		return;
 	}
 
+	// models are culled and added on the worker pool when there are enough of them,
+	// everything else goes through the loop below
+	parallel = R_NumJobWorkers() > 1 && rsc.numEntities >= rsc.numLocalEntities + ENTITIES_PER_JOB * 2;
+	if( parallel )
+	{
+		R_ParallelFor( rsc.numEntities - rsc.numLocalEntities, ENTITIES_PER_JOB, R_AddModelEntitiesJob, NULL );
+
+		for( j = 0; j < R_NumJobWorkers(); j++ )
+			R_MergeDrawList( rn.meshlist, &r_fragmentlists[j] );
+	}
+
 	for( i = rsc.numLocalEntities; i < rsc.numEntities; i++ )
 	{
 		e = R_NUM2ENT(i);
@@ -1139,10 +1192,10 @@ static void R_DrawEntities( void )
 			switch( e->model->type )
 			{
 			case mod_alias:
-				culled = ! R_AddAliasModelToDrawList( e );
+				culled = parallel ? r_entityCulled[i] : ! R_AddAliasModelToDrawList( rn.meshlist, e );
 				break;
 			case mod_skeletal:
-				culled = ! R_AddSkeletalModelToDrawList( e );
+				culled = parallel ? r_entityCulled[i] : ! R_AddSkeletalModelToDrawList( rn.meshlist, e );
 				break;
 			case mod_brush:
 				e->outlineHeight = rsc.worldent->outlineHeight;
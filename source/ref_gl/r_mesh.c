@@ -26,6 +26,7 @@ drawList_t r_worldlist;
 drawList_t r_shadowlist;
 drawList_t r_portalmasklist;
 drawList_t r_portallist, r_skyportallist;
+drawList_t r_fragmentlists[MAX_FRONTEND_WORKERS+1];
 
 /*
 * R_InitDrawList
@@ -40,11 +41,18 @@ void R_InitDrawList( drawList_t *list )
 */
 void R_InitDrawLists( void )
 {
+	int i;
+
 	R_InitDrawList( &r_worldlist );
 	R_InitDrawList( &r_portalmasklist );
 	R_InitDrawList( &r_portallist );
 	R_InitDrawList( &r_skyportallist );
 	R_InitDrawList( &r_shadowlist );
+
+	for( i = 0; i < MAX_FRONTEND_WORKERS+1; i++ ) {
+		R_InitDrawList( &r_fragmentlists[i] );
+		r_fragmentlists[i].deferCinematics = true;
+	}
 }
 
 /*
@@ -81,13 +89,14 @@ static void R_ReserveDrawSurfaces( drawList_t *list, int minMeshes )
 	oldSize = maxMeshes;
 	newSize = max( minMeshes, oldSize * 2 );
 
-	newDs = R_Malloc( newSize * sizeof( sortedDrawSurf_t ) );
+	newDs = R_Malloc( newSize * 2 * sizeof( sortedDrawSurf_t ) );
 	if( ds ) {
 		memcpy( newDs, ds, oldSize * sizeof( sortedDrawSurf_t ) );
 		R_Free( ds );
 	}
 	
 	list->drawSurfs = newDs;
+	list->drawSurfsTemp = newDs + newSize;
 	list->maxDrawSurfs = newSize;
 }
 
@@ -121,6 +130,50 @@ static void R_UnpackSortKey( unsigned int sortKey, unsigned int *shaderNum, int
 	*fogNum = (signed int)(sortKey & 0x1F) - 1;
 }
 
+/*
+* R_MergeDrawList
+*
+* Appends surfaces added to a worker fragment to the draw list and
+* empties the fragment
+*/
+void R_MergeDrawList( drawList_t *list, drawList_t *fragment )
+{
+	unsigned int i;
+	unsigned int shaderNum, entNum;
+	int fogNum, portalNum;
+	const shader_t *shader;
+
+	if( !fragment->numDrawSurfs ) {
+		return;
+	}
+
+	if( list->numDrawSurfs + fragment->numDrawSurfs > list->maxDrawSurfs ) {
+		int minMeshes = MIN_RENDER_MESHES + list->numDrawSurfs + fragment->numDrawSurfs;
+		if( rsh.worldBrushModel ) {
+			minMeshes += rsh.worldBrushModel->numDrawSurfaces;
+		}
+		R_ReserveDrawSurfaces( list, minMeshes );
+	}
+
+	memcpy( list->drawSurfs + list->numDrawSurfs, fragment->drawSurfs, 
+		fragment->numDrawSurfs * sizeof( sortedDrawSurf_t ) );
+	list->numDrawSurfs += fragment->numDrawSurfs;
+
+	// workers have no GL context so cinematics are uploaded here
+	if( fragment->hasCinematics ) {
+		for( i = 0; i < fragment->numDrawSurfs; i++ ) {
+			R_UnpackSortKey( (unsigned int)fragment->drawSurfs[i].sortKey, &shaderNum, &fogNum, &portalNum, &entNum );
+			shader = R_ShaderById( shaderNum );
+			if( shader && shader->cin ) {
+				R_UploadCinematicShader( shader );
+			}
+		}
+		fragment->hasCinematics = false;
+	}
+
+	fragment->numDrawSurfs = 0;
+}
+
 /*
 * R_PackOpaqueOrder
 *
@@ -172,7 +225,11 @@ void *R_AddSurfToDrawList( drawList_t *list, const entity_t *e, const mfog_t *fo
 	renderFx = e->renderfx;
 
 	if( shader->cin ) {
-		R_UploadCinematicShader( shader );
+		if( list->deferCinematics ) {
+			list->hasCinematics = true;
+		} else {
+			R_UploadCinematicShader( shader );
+		}
 	}
 
 	// reallocate if numDrawSurfs
@@ -214,8 +271,8 @@ void *R_AddSurfToDrawList( drawList_t *list, const entity_t *e, const mfog_t *fo
 	}
 
 	sds = &list->drawSurfs[list->numDrawSurfs++];
-	sds->distKey = R_PackDistKey( shaderSort, (int)dist, order );
-	sds->sortKey = R_PackSortKey( shader->id, fog ? fog - rsh.worldBrushModel->fogs : -1,
+	sds->sortKey = ( (uint64_t)R_PackDistKey( shaderSort, (int)dist, order ) << 32 ) |
+		R_PackSortKey( shader->id, fog ? fog - rsh.worldBrushModel->fogs : -1,
 		portalSurf ? portalSurf - rn.portalSurfaces : -1, R_ENT2NUM(e) );
 	sds->drawSurf = ( drawSurfaceType_t * )drawSurf;
 
@@ -231,43 +288,195 @@ void *R_AddSurfToDrawList( drawList_t *list, const entity_t *e, const mfog_t *fo
 void R_UpdateDrawListSurf( void *psds, unsigned order )
 {
 	sortedDrawSurf_t *sds = psds;
-	sds->distKey |= (order & 0x7FF);
+	sds->sortKey |= (uint64_t)(order & 0x7FF) << 32;
 }
 
 /*
 * R_DrawSurfCompare
 *
-* Comparison callback function for R_SortDrawList
+* Comparison callback function for qsort, only used by the sorting benchmark
 */
 static int R_DrawSurfCompare( const sortedDrawSurf_t *sbs1, const sortedDrawSurf_t *sbs2 )
 {
-	if( sbs1->distKey > sbs2->distKey )
-		return 1;
-	if( sbs2->distKey > sbs1->distKey )
-		return -1;
-
 	if( sbs1->sortKey > sbs2->sortKey )
 		return 1;
 	if( sbs2->sortKey > sbs1->sortKey )
 		return -1;
-
 	return 0;
 }
 
+#define DRAWLIST_INSERTION_SORT_THRESHOLD	32
+
+/*
+* R_InsertionSortDrawSurfs
+*/
+static void R_InsertionSortDrawSurfs( sortedDrawSurf_t *ds, unsigned int numDrawSurfs )
+{
+	unsigned int i, j;
+	sortedDrawSurf_t tmp;
+
+	for( i = 1; i < numDrawSurfs; i++ ) {
+		tmp = ds[i];
+		for( j = i; j > 0 && ds[j-1].sortKey > tmp.sortKey; j-- ) {
+			ds[j] = ds[j-1];
+		}
+		ds[j] = tmp;
+	}
+}
+
+/*
+* R_RadixSortDrawSurfs
+*
+* Stable LSD radix sort on the 64-bit keys, 8 bits per pass. All histograms
+* are built in a single pass over the list, and passes for digits that are
+* the same for every surface (typically most of the high bits) are skipped.
+* Returns the array that holds the result, either ds or temp.
+*/
+static sortedDrawSurf_t *R_RadixSortDrawSurfs( sortedDrawSurf_t *ds, sortedDrawSurf_t *temp, unsigned int numDrawSurfs )
+{
+	unsigned int i, pass, sum, count;
+	unsigned int histograms[8][256];
+	unsigned int *histogram;
+	sortedDrawSurf_t *src = ds, *dst = temp, *swap;
+	uint64_t key;
+
+	memset( histograms, 0, sizeof( histograms ) );
+	for( i = 0; i < numDrawSurfs; i++ ) {
+		key = ds[i].sortKey;
+		for( pass = 0; pass < 8; pass++ ) {
+			histograms[pass][(key >> (pass * 8)) & 0xFF]++;
+		}
+	}
+
+	for( pass = 0; pass < 8; pass++ ) {
+		unsigned int shift = pass * 8;
+
+		histogram = histograms[pass];
+		if( histogram[(src[0].sortKey >> shift) & 0xFF] == numDrawSurfs ) {
+			continue;
+		}
+
+		// turn counts into offsets
+		for( i = 0, sum = 0; i < 256; i++ ) {
+			count = histogram[i];
+			histogram[i] = sum;
+			sum += count;
+		}
+
+		for( i = 0; i < numDrawSurfs; i++ ) {
+			dst[histogram[(src[i].sortKey >> shift) & 0xFF]++] = src[i];
+		}
+
+		swap = src; src = dst; dst = swap;
+	}
+
+	return src;
+}
+
+/*
+* R_SortDrawSurfs
+*/
+static void R_SortDrawSurfs( sortedDrawSurf_t *ds, sortedDrawSurf_t *temp, unsigned int numDrawSurfs )
+{
+	sortedDrawSurf_t *sorted;
+
+	if( numDrawSurfs < 2 ) {
+		return;
+	}
+
+	if( numDrawSurfs <= DRAWLIST_INSERTION_SORT_THRESHOLD ) {
+		R_InsertionSortDrawSurfs( ds, numDrawSurfs );
+		return;
+	}
+
+	sorted = R_RadixSortDrawSurfs( ds, temp, numDrawSurfs );
+	if( sorted != ds ) {
+		memcpy( ds, sorted, numDrawSurfs * sizeof( *ds ) );
+	}
+}
+
+static int r_sortBenchIterations;
+
+/*
+* R_BenchmarkDrawListSort
+*
+* Sorts a captured, unsorted copy of the draw list over and over again
+* with qsort and with the radix sort, and verifies that the keys match.
+*/
+static void R_BenchmarkDrawListSort( const sortedDrawSurf_t *captured, unsigned int numDrawSurfs, int iterations )
+{
+	int i;
+	unsigned int j;
+	uint64_t start, qsortTime, radixTime;
+	sortedDrawSurf_t *ds1, *ds2, *temp;
+
+	ds1 = R_Malloc( numDrawSurfs * 3 * sizeof( *ds1 ) );
+	ds2 = ds1 + numDrawSurfs;
+	temp = ds2 + numDrawSurfs;
+
+	qsortTime = radixTime = 0;
+	for( i = 0; i < iterations; i++ ) {
+		memcpy( ds1, captured, numDrawSurfs * sizeof( *ds1 ) );
+		start = ri.Sys_Microseconds();
+		qsort( ds1, numDrawSurfs, sizeof( sortedDrawSurf_t ), 
+			(int (*)(const void *, const void *))R_DrawSurfCompare );
+		qsortTime += ri.Sys_Microseconds() - start;
+
+		memcpy( ds2, captured, numDrawSurfs * sizeof( *ds2 ) );
+		start = ri.Sys_Microseconds();
+		R_SortDrawSurfs( ds2, temp, numDrawSurfs );
+		radixTime += ri.Sys_Microseconds() - start;
+	}
+
+	for( j = 0; j < numDrawSurfs; j++ ) {
+		if( ds1[j].sortKey != ds2[j].sortKey ) {
+			break;
+		}
+	}
+
+	Com_Printf( "Sorted %u draw surfaces %i times\n", numDrawSurfs, iterations );
+	Com_Printf( "qsort: %.3f usec/sort, radix: %.3f usec/sort, %s\n", 
+		(double)qsortTime / iterations, (double)radixTime / iterations,
+		j < numDrawSurfs ? S_COLOR_RED "order mismatch" : "same order" );
+
+	R_Free( ds1 );
+}
+
 /*
 * R_SortDrawList
 *
-* Regular quicksort. Note that for all kinds of transparent meshes
-* you probably want to set distance or draw order to prevent flickering
-* due to quicksort's unstable nature.
+* Note that for all kinds of transparent meshes you probably want to set
+* distance or draw order, surfaces with equal keys keep the order they
+* were added in.
 */
 void R_SortDrawList( drawList_t *list )
 {
 	if( r_draworder->integer ) {
 		return;
 	}
-	qsort( list->drawSurfs, list->numDrawSurfs, sizeof( sortedDrawSurf_t ), 
-		(int (*)(const void *, const void *))R_DrawSurfCompare );
+
+	// capture the main view list for R_SortBench_f
+	if( r_sortBenchIterations && !( rn.renderFlags & RF_NONVIEWERREF ) && list->numDrawSurfs > 1 ) {
+		R_BenchmarkDrawListSort( list->drawSurfs, list->numDrawSurfs, r_sortBenchIterations );
+		r_sortBenchIterations = 0;
+	}
+
+	R_SortDrawSurfs( list->drawSurfs, list->drawSurfsTemp, list->numDrawSurfs );
+}
+
+/*
+* R_SortBench_f
+*
+* Benchmarks sorting of the next main view draw list
+*/
+void R_SortBench_f( void )
+{
+	int iterations = 1000;
+
+	if( ri.Cmd_Argc() > 1 ) {
+		iterations = max( atoi( ri.Cmd_Argv( 1 ) ), 1 );
+	}
+	r_sortBenchIterations = iterations;
 }
 
 /*
@@ -438,7 +647,7 @@ static void _R_DrawSurfaces( drawList_t *list )
 
 	for( i = 0; i < list->numDrawSurfs; i++ ) {
 		sds = list->drawSurfs + i;
-		sortKey = sds->sortKey;
+		sortKey = (unsigned int)sds->sortKey;
 		drawSurfType = *(int *)sds->drawSurf;
 
 		assert( drawSurfType > ST_NONE && drawSurfType < ST_MAX_TYPES );
@@ -52,8 +52,7 @@ typedef struct
 
 typedef struct
 {
-	unsigned int		distKey;
-	unsigned int		sortKey;
+	uint64_t			sortKey;		// distance key in the upper 32 bits, batching key in the lower
 	drawSurfaceType_t	*drawSurf;
 } sortedDrawSurf_t;
 
@@ -61,6 +60,10 @@ typedef struct
 {
 	unsigned int		numDrawSurfs, maxDrawSurfs;
 	sortedDrawSurf_t	*drawSurfs;
+	sortedDrawSurf_t	*drawSurfsTemp;	// scratch space for radix sorting
+
+	bool				deferCinematics;	// filled by frontend workers, which can't upload
+	bool				hasCinematics;
 
 	unsigned int		maxVboSlices;
 	vboSlice_t			*vboSlices;
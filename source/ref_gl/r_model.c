@@ -183,6 +183,13 @@ static void Mod_CreateVisLeafs( model_t *mod )
 	}
 
 	loadbmodel->visleafs[numVisLeafs] = NULL;
+
+	R_InitLeafCull( &loadbmodel->visleafcull, numVisLeafs, false, 
+		Mod_Malloc( mod, R_LeafCullSize( numVisLeafs, false ) ) );
+	R_FlattenLeafs( &loadbmodel->visleafcull, loadbmodel->visleafs );
+
+	R_InitLeafCull( &loadbmodel->pvsleafcull, numVisLeafs, true, 
+		Mod_Malloc( mod, R_LeafCullSize( numVisLeafs, true ) ) );
 }
 
 /*
@@ -903,6 +910,12 @@ void R_FreeUnusedModels( void )
 {
 	int i;
 	model_t *mod;
+	bool freeWorld;
+
+	freeWorld = rsh.worldModel && rsh.worldModel->registrationSequence != rsh.registrationSequence;
+	if( freeWorld ) {
+		R_FlushQueuedFragments();
+	}
 
 	for( i = 0, mod = mod_known; i < mod_numknown; i++, mod++ ) {
 		if( !mod->name ) {
@@ -921,6 +934,10 @@ void R_FreeUnusedModels( void )
 		rsh.worldModel = NULL;
 		rsh.worldBrushModel = NULL;
 	}
+
+	if( freeWorld ) {
+		R_FinishFlushQueuedFragments();
+	}
 }
 
 /*
@@ -1267,6 +1284,9 @@ static void R_FinishMapConfig( const model_t *mod )
 */
 void R_RegisterWorldModel( const char *model, const dvis_t *pvsData )
 {
+	// queued decals belong to the old world
+	R_FlushQueuedFragments();
+
 	r_prevworldmodel = rsh.worldModel;
 	rsh.worldModel = NULL;
 	rsh.worldBrushModel = NULL;
@@ -1280,6 +1300,7 @@ void R_RegisterWorldModel( const char *model, const dvis_t *pvsData )
 	mod_isworldmodel = false;
 
 	if( !rsh.worldModel ) {
+		R_FinishFlushQueuedFragments();
 		return;
 	}
 
@@ -1289,6 +1310,8 @@ void R_RegisterWorldModel( const char *model, const dvis_t *pvsData )
 	R_TouchModel( rsh.worldModel );
 	rsh.worldBrushModel = ( mbrushmodel_t * )rsh.worldModel->extradata;
 	rsh.worldBrushModel->pvs = ( dvis_t * )pvsData;
+
+	R_FinishFlushQueuedFragments();
 }
 
 /*
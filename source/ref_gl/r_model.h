@@ -89,7 +89,8 @@ typedef struct msurface_s
 		float		color[3];
 	};
 
-	int				fragmentframe;		// for multi-check avoidance
+	int				fragmentframe[2];	// for multi-check avoidance, one per fragment clipper
+	int				traceframe;			// for multi-check avoidance in R_TraceLine
 
 	struct superLightStyle_s *superLightStyle;
 
@@ -148,6 +149,24 @@ typedef struct
 	float			texMatrix[2][2];
 } mlightmapRect_t;
 
+#define LEAF_CULLED		0x80			// in mleafcull_t::clipFlags
+
+// flattened leaf bounds for the SIMD culling pass in R_DrawWorld
+typedef struct
+{
+	unsigned int	numLeafs;
+	unsigned int	stride;				// numLeafs rounded up to a multiple of 4
+	mleaf_t			**leafs;
+	float			*bounds;			// SoA: mins x, y, z, then maxs x, y, z, stride floats each
+
+	// per-leaf culling results, NULL for the model-wide list
+	uint8_t			*clipFlags;
+	unsigned int	*dlightBits;
+	unsigned int	*shadowBits;
+
+	unsigned int	pvsframe;			// rf.pvsframecount the list was gathered for
+} mleafcull_t;
+
 typedef struct mbrushmodel_s
 {
 	const bspFormatDesc_t *format;
@@ -167,6 +186,8 @@ typedef struct mbrushmodel_s
 	unsigned int	numleafs;			// number of visible leafs, not counting 0
 	mleaf_t			*leafs;
 	mleaf_t			**visleafs;
+	mleafcull_t		visleafcull;		// all visleafs
+	mleafcull_t		pvsleafcull;		// visleafs in the current PVS, rebuilt by R_DrawWorld
 
 	unsigned int	numnodes;
 	mnode_t			*nodes;
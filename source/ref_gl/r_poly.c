@@ -116,23 +116,71 @@ void R_DrawStretchPoly( const poly_t *poly, float x_offset, float y_offset )
 
 //==================================================================================
 
-static int numFragmentVerts;
-static int maxFragmentVerts;
-static vec4_t *fragmentVerts;
+#define	MAX_FRAGMENT_VERTS  64
 
-static int numClippedFragments;
-static int maxClippedFragments;
-static fragment_t *clippedFragments;
+#define MAX_QUEUED_FRAGMENT_CLIPS	256
+#define MAX_QUEUED_FRAGMENT_VERTS	64
+#define MAX_QUEUED_FRAGMENTS		64
 
-static cplane_t fragmentPlanes[6];
-static vec3_t fragmentOrigin;
-static vec3_t fragmentNormal;
-static float fragmentRadius;
-static float fragmentDiameterSquared;
+// the synchronous and the asynchronous clipper each have their own
+// slot in msurface_t::fragmentframe
+enum
+{
+	FRAGMENT_CONTEXT_SYNC,
+	FRAGMENT_CONTEXT_ASYNC
+};
 
-static int r_fragmentframecount;
+typedef struct
+{
+	int context;
+	int framecount;
 
-#define	MAX_FRAGMENT_VERTS  64
+	int numVerts;
+	int maxVerts;
+	vec4_t *verts;
+
+	int numFragments;
+	int maxFragments;
+	fragment_t *fragments;
+
+	cplane_t planes[6];
+	vec3_t origin;
+	vec3_t normal;
+	float radius;
+	float diameterSquared;
+} r_fragmentclip_t;
+
+typedef struct
+{
+	unsigned int ticket;		// 0 for free slots
+	bool done;
+
+	vec3_t origin;
+	float radius;
+	vec3_t axis[3];
+
+	int numFragments;
+	vec4_t verts[MAX_QUEUED_FRAGMENT_VERTS];
+	fragment_t fragments[MAX_QUEUED_FRAGMENTS];
+} r_fragmentrequest_t;
+
+typedef struct
+{
+	struct qthread_s *thread;
+	struct qmutex_s *queueLock;		// protects the request slots and the tickets
+	struct qmutex_s *clipLock;		// held while the world is being clipped against
+	struct qcondvar_s *wakeCond;
+	volatile bool shutdown;
+
+	unsigned int nextTicket;
+	unsigned int clipTicket;		// next ticket to be clipped
+	r_fragmentrequest_t *requests;
+
+	r_fragmentclip_t clip;
+} r_fragmentclipper_t;
+
+static r_fragmentclip_t r_fragmentclip;
+static r_fragmentclipper_t r_fragmentclipper;
 
 /*
 * R_WindingClipFragment
@@ -142,7 +190,7 @@ static int r_fragmentframecount;
 * a convex fragment (polygon, trifan) which the result of clipping
 * the input winding by six fragment planes.
 */
-static bool R_WindingClipFragment( vec3_t *wVerts, int numVerts, msurface_t *surf, vec3_t snorm )
+static bool R_WindingClipFragment( r_fragmentclip_t *fc, vec3_t *wVerts, int numVerts, msurface_t *surf, vec3_t snorm )
 {
 	int i, j;
 	int stage, newc, numv;
@@ -157,7 +205,7 @@ static bool R_WindingClipFragment( vec3_t *wVerts, int numVerts, msurface_t *sur
 	numv = numVerts;
 	verts = wVerts;
 
-	for( stage = 0, plane = fragmentPlanes; stage < 6; stage++, plane++ )
+	for( stage = 0, plane = fc->planes; stage < 6; stage++, plane++ )
 	{
 		for( i = 0, v = verts[0], front = false; i < numv; i++, v += 3 )
 		{
@@ -230,22 +278,22 @@ static bool R_WindingClipFragment( vec3_t *wVerts, int numVerts, msurface_t *sur
 	}
 
 	// fully clipped
-	if( numFragmentVerts + numv > maxFragmentVerts )
+	if( fc->numVerts + numv > fc->maxVerts )
 		return false;
 
-	fr = &clippedFragments[numClippedFragments++];
+	fr = &fc->fragments[fc->numFragments++];
 	fr->numverts = numv;
-	fr->firstvert = numFragmentVerts;
+	fr->firstvert = fc->numVerts;
 	fr->fognum = surf->fog ? surf->fog - rsh.worldBrushModel->fogs + 1 : -1;
 	VectorCopy( snorm, fr->normal );
-	for( i = 0, v = verts[0], nextv = fragmentVerts[numFragmentVerts]; i < numv; i++, v += 3, nextv += 4 )
+	for( i = 0, v = verts[0], nextv = fc->verts[fc->numVerts]; i < numv; i++, v += 3, nextv += 4 )
 	{
 		VectorCopy( v, nextv );
 		nextv[3] = 1;
 	}
 
-	numFragmentVerts += numv;
-	if( numFragmentVerts == maxFragmentVerts && numClippedFragments == maxClippedFragments )
+	fc->numVerts += numv;
+	if( fc->numVerts == fc->maxVerts && fc->numFragments == fc->maxFragments )
 		return true;
 
 	// if all of the following is true:
@@ -262,7 +310,7 @@ static bool R_WindingClipFragment( vec3_t *wVerts, int numVerts, msurface_t *sur
 			nextv = ( i == 3 ) ? verts[0] : v + 3;
 			VectorSubtract( v, nextv, t );
 
-			d = fragmentDiameterSquared - DotProduct( t, t );
+			d = fc->diameterSquared - DotProduct( t, t );
 			if( d > 0.01 || d < -0.01 )
 				return false;
 		}
@@ -280,7 +328,7 @@ static bool R_WindingClipFragment( vec3_t *wVerts, int numVerts, msurface_t *sur
 * q2 polys) or tristrips for ultra-fast clipping, providing there's
 * enough stack space (depending on MAX_FRAGMENT_VERTS value).
 */
-static bool R_PlanarSurfClipFragment( msurface_t *surf, vec3_t normal )
+static bool R_PlanarSurfClipFragment( r_fragmentclip_t *fc, msurface_t *surf, vec3_t normal )
 {
 	int i;
 	mesh_t *mesh;
@@ -325,7 +373,7 @@ static bool R_PlanarSurfClipFragment( msurface_t *surf, vec3_t normal )
 				continue; // greater than 60 degrees
 		}
 
-		if( R_WindingClipFragment( poly, 3, surf, snorm ) )
+		if( R_WindingClipFragment( fc, poly, 3, surf, snorm ) )
 			return true;
 	}
 
@@ -335,7 +383,7 @@ static bool R_PlanarSurfClipFragment( msurface_t *surf, vec3_t normal )
 /*
 * R_PatchSurfClipFragment
 */
-static bool R_PatchSurfClipFragment( msurface_t *surf, vec3_t normal )
+static bool R_PatchSurfClipFragment( r_fragmentclip_t *fc, msurface_t *surf, vec3_t normal )
 {
 	int i, j;
 	mesh_t *mesh;
@@ -379,7 +427,7 @@ tri2:
 		if( DotProduct( normal, snorm ) < 0.5 )
 			continue; // greater than 60 degrees
 
-		if( R_WindingClipFragment( poly, 3, surf, snorm ) )
+		if( R_WindingClipFragment( fc, poly, 3, surf, snorm ) )
 			return true;
 
 		if( !j )
@@ -404,7 +452,7 @@ bool R_SurfPotentiallyFragmented( const msurface_t *surf )
 /*
 * R_RecursiveFragmentNode
 */
-static void R_RecursiveFragmentNode( void )
+static void R_RecursiveFragmentNode( r_fragmentclip_t *fc )
 {
 	int stackdepth = 0;
 	float dist;
@@ -424,21 +472,21 @@ static void R_RecursiveFragmentNode( void )
 
 			do
 			{
-				if( numFragmentVerts == maxFragmentVerts || numClippedFragments == maxClippedFragments )
+				if( fc->numVerts == fc->maxVerts || fc->numFragments == fc->maxFragments )
 					return; // already reached the limit
 
 				surf = *mark++;
-				if( surf->fragmentframe == r_fragmentframecount )
+				if( surf->fragmentframe[fc->context] == fc->framecount )
 					continue;
-				surf->fragmentframe = r_fragmentframecount;
+				surf->fragmentframe[fc->context] = fc->framecount;
 
-				if( !BoundsAndSphereIntersect( surf->mins, surf->maxs, fragmentOrigin, fragmentRadius ) )
+				if( !BoundsAndSphereIntersect( surf->mins, surf->maxs, fc->origin, fc->radius ) )
 					continue;
 
 				if( surf->facetype == FACETYPE_PATCH )
-					inside = R_PatchSurfClipFragment( surf, fragmentNormal );
+					inside = R_PatchSurfClipFragment( fc, surf, fc->normal );
 				else
-					inside = R_PlanarSurfClipFragment( surf, fragmentNormal );
+					inside = R_PlanarSurfClipFragment( fc, surf, fc->normal );
 
 				// if there some fragments that are inside a surface, that doesn't mean that
 				// there are no fragments that are OUTSIDE, so the check below is disabled
@@ -447,7 +495,7 @@ static void R_RecursiveFragmentNode( void )
 				(void)inside; // hush compiler warning
 			} while( *mark );
 
-			if( numFragmentVerts == maxFragmentVerts || numClippedFragments == maxClippedFragments )
+			if( fc->numVerts == fc->maxVerts || fc->numFragments == fc->maxFragments )
 				return; // already reached the limit
 
 nextNodeOnStack:
@@ -457,23 +505,23 @@ nextNodeOnStack:
 			continue;
 		}
 
-		dist = PlaneDiff( fragmentOrigin, node->plane );
-		if( dist > fragmentRadius )
+		dist = PlaneDiff( fc->origin, node->plane );
+		if( dist > fc->radius )
 		{
 			node = node->children[0];
 			continue;
 		}
 
-		if( ( dist >= -fragmentRadius ) && ( stackdepth < sizeof( localstack )/sizeof( mnode_t * ) ) )
+		if( ( dist >= -fc->radius ) && ( stackdepth < sizeof( localstack )/sizeof( mnode_t * ) ) )
 			localstack[stackdepth++] = node->children[0];
 		node = node->children[1];
 	}
 }
 
 /*
-* R_GetClippedFragments
+* R_ClipFragments
 */
-int R_GetClippedFragments( const vec3_t origin, float radius, vec3_t axis[3], 
+static int R_ClipFragments( r_fragmentclip_t *fc, const vec3_t origin, float radius, vec3_t axis[3], 
 	int maxfverts, vec4_t *fverts, int maxfragments, fragment_t *fragments )
 {
 	int i;
@@ -485,21 +533,24 @@ int R_GetClippedFragments( const vec3_t origin, float radius, vec3_t axis[3],
 	assert( maxfragments > 0 );
 	assert( fragments );
 
-	r_fragmentframecount++;
+	if( !rsh.worldBrushModel )
+		return 0;
+
+	fc->framecount++;
 
 	// initialize fragments
-	numFragmentVerts = 0;
-	maxFragmentVerts = maxfverts;
-	fragmentVerts = fverts;
+	fc->numVerts = 0;
+	fc->maxVerts = maxfverts;
+	fc->verts = fverts;
 
-	numClippedFragments = 0;
-	maxClippedFragments = maxfragments;
-	clippedFragments = fragments;
+	fc->numFragments = 0;
+	fc->maxFragments = maxfragments;
+	fc->fragments = fragments;
 
-	VectorCopy( origin, fragmentOrigin );
-	VectorCopy( axis[0], fragmentNormal );
-	fragmentRadius = radius;
-	fragmentDiameterSquared = radius*radius*4;
+	VectorCopy( origin, fc->origin );
+	VectorCopy( axis[0], fc->normal );
+	fc->radius = radius;
+	fc->diameterSquared = radius*radius*4;
 
 	// calculate clipping planes
 	for( i = 0; i < 3; i++ )
@@ -507,16 +558,269 @@ int R_GetClippedFragments( const vec3_t origin, float radius, vec3_t axis[3],
 		float radius0 = (i ? radius : 40);
 		d = DotProduct( origin, axis[i] );
 
-		VectorCopy( axis[i], fragmentPlanes[i*2].normal );
-		fragmentPlanes[i*2].dist = d - radius0;
-		fragmentPlanes[i*2].type = PlaneTypeForNormal( fragmentPlanes[i*2].normal );
+		VectorCopy( axis[i], fc->planes[i*2].normal );
+		fc->planes[i*2].dist = d - radius0;
+		fc->planes[i*2].type = PlaneTypeForNormal( fc->planes[i*2].normal );
+
+		VectorNegate( axis[i], fc->planes[i*2+1].normal );
+		fc->planes[i*2+1].dist = -d - radius0;
+		fc->planes[i*2+1].type = PlaneTypeForNormal( fc->planes[i*2+1].normal );
+	}
+
+	R_RecursiveFragmentNode( fc );
+
+	return fc->numFragments;
+}
+
+/*
+* R_GetClippedFragments
+*/
+int R_GetClippedFragments( const vec3_t origin, float radius, vec3_t axis[3], 
+	int maxfverts, vec4_t *fverts, int maxfragments, fragment_t *fragments )
+{
+	r_fragmentclip.context = FRAGMENT_CONTEXT_SYNC;
+
+	return R_ClipFragments( &r_fragmentclip, origin, radius, axis, maxfverts, fverts, maxfragments, fragments );
+}
+
+/*
+* R_FragmentClipperThreadProc
+*
+* Clips queued requests in the order they were queued. The clip lock is held
+* while the world is being walked so it can't be swapped from under us.
+*/
+static void *R_FragmentClipperThreadProc( void *param )
+{
+	bool valid;
+	unsigned int ticket;
+	r_fragmentrequest_t *req;
+	r_fragmentclipper_t *fcl = &r_fragmentclipper;
+
+	ri.Mutex_Lock( fcl->queueLock );
+
+	while( !fcl->shutdown ) {
+		if( fcl->clipTicket == fcl->nextTicket ) {
+			ri.CondVar_Wait( fcl->wakeCond, fcl->queueLock, Q_THREADS_WAIT_INFINITE );
+			continue;
+		}
+
+		ticket = fcl->clipTicket++;
+		req = &fcl->requests[ticket % MAX_QUEUED_FRAGMENT_CLIPS];
+		if( req->ticket != ticket || req->done ) {
+			// flushed
+			continue;
+		}
+
+		ri.Mutex_Unlock( fcl->queueLock );
+
+		// the lock order is clip lock first, so check for a flush that
+		// may have happened in between once more
+		ri.Mutex_Lock( fcl->clipLock );
+		ri.Mutex_Lock( fcl->queueLock );
+		valid = req->ticket == ticket && !req->done;
+		ri.Mutex_Unlock( fcl->queueLock );
+
+		// the request slot can't be reused until it's marked as done
+		if( valid ) {
+			req->numFragments = R_ClipFragments( &fcl->clip, req->origin, req->radius, req->axis, 
+				MAX_QUEUED_FRAGMENT_VERTS, req->verts, MAX_QUEUED_FRAGMENTS, req->fragments );
+		}
+		ri.Mutex_Unlock( fcl->clipLock );
+
+		ri.Mutex_Lock( fcl->queueLock );
+		if( valid ) {
+			req->done = true;
+		}
+	}
+
+	ri.Mutex_Unlock( fcl->queueLock );
+	return NULL;
+}
+
+/*
+* R_QueueClippedFragments
+*
+* Queues the fragment clip for the worker thread and returns the ticket
+* to pass to R_GetQueuedFragments, or 0 if the queue is full.
+*/
+unsigned int R_QueueClippedFragments( const vec3_t origin, float radius, vec3_t axis[3] )
+{
+	unsigned int ticket;
+	r_fragmentrequest_t *req;
+	r_fragmentclipper_t *fcl = &r_fragmentclipper;
+
+	if( !fcl->thread ) {
+		return 0;
+	}
+
+	ri.Mutex_Lock( fcl->queueLock );
+
+	ticket = fcl->nextTicket;
+	if( !ticket ) {
+		// wrapped around, 0 is reserved for free slots
+		ticket = fcl->nextTicket = fcl->clipTicket = 1;
+	}
+
+	req = &fcl->requests[ticket % MAX_QUEUED_FRAGMENT_CLIPS];
+	if( req->ticket && !req->done ) {
+		// the worker is a whole queue behind, results that nobody
+		// has picked up are simply overwritten otherwise
+		ri.Mutex_Unlock( fcl->queueLock );
+		return 0;
+	}
+
+	req->ticket = ticket;
+	req->done = false;
+	VectorCopy( origin, req->origin );
+	req->radius = radius;
+	VectorCopy( axis[0], req->axis[0] );
+	VectorCopy( axis[1], req->axis[1] );
+	VectorCopy( axis[2], req->axis[2] );
+	req->numFragments = 0;
+
+	fcl->nextTicket++;
+	ri.CondVar_Wake( fcl->wakeCond );
+
+	ri.Mutex_Unlock( fcl->queueLock );
+
+	return ticket;
+}
+
+/*
+* R_GetQueuedFragments
+*
+* Returns -1 if the request hasn't been clipped yet, otherwise copies
+* the fragments out and releases the ticket. Flushed and overwritten
+* requests yield no fragments.
+*/
+int R_GetQueuedFragments( unsigned int ticket, int maxfverts, vec4_t *fverts, int maxfragments, fragment_t *fragments )
+{
+	int i, numFragments, numVerts;
+	r_fragmentrequest_t *req;
+	r_fragmentclipper_t *fcl = &r_fragmentclipper;
+
+	if( !fcl->thread || !ticket ) {
+		return 0;
+	}
+
+	ri.Mutex_Lock( fcl->queueLock );
+
+	req = &fcl->requests[ticket % MAX_QUEUED_FRAGMENT_CLIPS];
+	if( req->ticket != ticket ) {
+		ri.Mutex_Unlock( fcl->queueLock );
+		return 0;
+	}
+
+	if( !req->done ) {
+		ri.Mutex_Unlock( fcl->queueLock );
+		return -1;
+	}
+
+	numVerts = 0;
+	numFragments = 0;
+	for( i = 0; i < req->numFragments && numFragments < maxfragments; i++ ) {
+		const fragment_t *fr = &req->fragments[i];
+
+		if( numVerts + fr->numverts > maxfverts ) {
+			break;
+		}
+
+		memcpy( fverts + numVerts, req->verts + fr->firstvert, sizeof( vec4_t ) * fr->numverts );
+		fragments[numFragments] = *fr;
+		fragments[numFragments].firstvert = numVerts;
+		numVerts += fr->numverts;
+		numFragments++;
+	}
+
+	req->ticket = 0;
+
+	ri.Mutex_Unlock( fcl->queueLock );
+
+	return numFragments;
+}
+
+/*
+* R_FlushQueuedFragments
+*
+* Drops all queued requests and keeps the worker thread out of the world model
+* until R_FinishFlushQueuedFragments is called. Used while the world model changes.
+*/
+void R_FlushQueuedFragments( void )
+{
+	int i;
+	r_fragmentclipper_t *fcl = &r_fragmentclipper;
+
+	if( !fcl->thread ) {
+		return;
+	}
+
+	ri.Mutex_Lock( fcl->clipLock );
+
+	ri.Mutex_Lock( fcl->queueLock );
+	for( i = 0; i < MAX_QUEUED_FRAGMENT_CLIPS; i++ ) {
+		fcl->requests[i].ticket = 0;
+		fcl->requests[i].done = false;
+	}
+	fcl->clipTicket = fcl->nextTicket;
+	ri.Mutex_Unlock( fcl->queueLock );
+}
 
-		VectorNegate( axis[i], fragmentPlanes[i*2+1].normal );
-		fragmentPlanes[i*2+1].dist = -d - radius0;
-		fragmentPlanes[i*2+1].type = PlaneTypeForNormal( fragmentPlanes[i*2+1].normal );
+/*
+* R_FinishFlushQueuedFragments
+*/
+void R_FinishFlushQueuedFragments( void )
+{
+	if( !r_fragmentclipper.thread ) {
+		return;
 	}
 
-	R_RecursiveFragmentNode ();
+	ri.Mutex_Unlock( r_fragmentclipper.clipLock );
+}
+
+/*
+* R_InitFragmentClipper
+*/
+void R_InitFragmentClipper( void )
+{
+	r_fragmentclipper_t *fcl = &r_fragmentclipper;
+
+	memset( &r_fragmentclip, 0, sizeof( r_fragmentclip ) );
+	memset( fcl, 0, sizeof( *fcl ) );
+
+	fcl->requests = R_Malloc( sizeof( r_fragmentrequest_t ) * MAX_QUEUED_FRAGMENT_CLIPS );
+	fcl->nextTicket = fcl->clipTicket = 1;
+	fcl->clip.context = FRAGMENT_CONTEXT_ASYNC;
+
+	fcl->queueLock = ri.Mutex_Create();
+	fcl->clipLock = ri.Mutex_Create();
+	fcl->wakeCond = ri.CondVar_Create();
+	fcl->thread = ri.Thread_Create( R_FragmentClipperThreadProc, NULL );
+}
+
+/*
+* R_ShutdownFragmentClipper
+*/
+void R_ShutdownFragmentClipper( void )
+{
+	r_fragmentclipper_t *fcl = &r_fragmentclipper;
+
+	if( fcl->thread ) {
+		ri.Mutex_Lock( fcl->queueLock );
+		fcl->shutdown = true;
+		ri.CondVar_Wake( fcl->wakeCond );
+		ri.Mutex_Unlock( fcl->queueLock );
+
+		ri.Thread_Join( fcl->thread );
+		fcl->thread = NULL;
+
+		ri.CondVar_Destroy( &fcl->wakeCond );
+		ri.Mutex_Destroy( &fcl->clipLock );
+		ri.Mutex_Destroy( &fcl->queueLock );
+	}
+
+	if( fcl->requests ) {
+		R_Free( fcl->requests );
+	}
 
-	return numClippedFragments;
+	memset( fcl, 0, sizeof( *fcl ) );
 }
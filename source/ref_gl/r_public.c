@@ -110,6 +110,8 @@ QF_DLL_EXPORT ref_export_t *GetRefAPI( ref_import_t *import )
 	globals.SkeletalGetNumBones = R_SkeletalGetNumBones;
 	
 	globals.GetClippedFragments = R_GetClippedFragments;
+	globals.QueueClippedFragments = R_QueueClippedFragments;
+	globals.GetQueuedFragments = R_GetQueuedFragments;
 	
 	globals.ModelBounds = R_ModelBounds;
 	globals.ModelFrameBounds = R_ModelFrameBounds;
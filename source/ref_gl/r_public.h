@@ -22,7 +22,7 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 
 #include "../cgame/ref.h"
 
-#define REF_API_VERSION 22
+#define REF_API_VERSION 26
 
 struct mempool_s;
 struct cinematics_s;
@@ -85,6 +85,7 @@ typedef struct
 	bool ( *FS_MoveFile )( const char *src, const char *dst );
 	bool ( *FS_IsUrl )( const char *url );
 	time_t ( *FS_FileMTime )( const char *filename );
+	unsigned ( *FS_PakChecksumForFile )( const char *filename );
 	bool ( *FS_RemoveDirectory )( const char *dirname );
 	const char * ( *FS_GameDirectory )( void );
 	const char * ( *FS_WriteDirectory )( void );
@@ -116,6 +117,10 @@ typedef struct
 	void ( *Mutex_Destroy )( struct qmutex_s **mutex );
 	void ( *Mutex_Lock )( struct qmutex_s *mutex );
 	void ( *Mutex_Unlock )( struct qmutex_s *mutex );
+	struct qcondvar_s *( *CondVar_Create )( void );
+	void ( *CondVar_Destroy )( struct qcondvar_s **cond );
+	bool ( *CondVar_Wait )( struct qcondvar_s *cond, struct qmutex_s *mutex, unsigned int timeout_msec );
+	void ( *CondVar_Wake )( struct qcondvar_s *cond );
 
 	qbufPipe_t *( *BufPipe_Create )( size_t bufSize, int flags );
 	void ( *BufPipe_Destroy )( qbufPipe_t **pqueue );
@@ -124,6 +129,12 @@ typedef struct
 	int ( *BufPipe_ReadCmds )( qbufPipe_t *queue, unsigned (**cmdHandlers)( const void * ) );
 	void ( *BufPipe_Wait )( qbufPipe_t *queue, int (*read)( qbufPipe_t *, unsigned( ** )(const void *), bool ), 
 		unsigned (**cmdHandlers)( const void * ), unsigned timeout_msec );
+
+	// job scheduler, worker 0 is shared by all threads outside the pool
+	qjobhandle_t ( *Jobs_Add )( qjobfunc_t func, void *arg, const qjobhandle_t *deps, int numDeps );
+	void ( *Jobs_Wait )( qjobhandle_t job );
+	void ( *Jobs_ParallelFor )( unsigned int count, unsigned int granularity, qjobrangefunc_t func, void *arg );
+	int ( *Jobs_NumWorkers )( void );
 } ref_import_t;
 
 typedef struct
@@ -205,6 +216,12 @@ typedef struct
 	int			( *GetClippedFragments )( const vec3_t origin, float radius, vec3_t axis[3], int maxfverts, vec4_t *fverts, 
 									  int maxfragments, fragment_t *fragments );
 
+	// asynchronous version of GetClippedFragments, the results are fetched with GetQueuedFragments
+	// a frame or more later, which returns -1 while the request is still pending
+	unsigned int ( *QueueClippedFragments )( const vec3_t origin, float radius, vec3_t axis[3] );
+	int			( *GetQueuedFragments )( unsigned int ticket, int maxfverts, vec4_t *fverts, 
+									  int maxfragments, fragment_t *fragments );
+
 	struct shader_s * ( *GetShaderForOrigin )( const vec3_t origin );
 	struct cinematics_s * ( *GetShaderCinematic )( struct shader_s *shader );
 
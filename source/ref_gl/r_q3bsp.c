@@ -68,6 +68,41 @@ BRUSHMODEL LOADING
 static uint8_t *mod_base;
 static mbrushmodel_t *loadbmodel;
 
+enum
+{
+	MOD_STAGE_ENTITIES,
+	MOD_STAGE_LIGHTMAPS,
+	MOD_STAGE_SHADERS,
+	MOD_STAGE_GEOMETRY,
+	MOD_STAGE_SURFACES,
+	MOD_STAGE_TREE,
+	MOD_STAGE_MESHES,
+	MOD_STAGE_FINISH,
+
+	MOD_NUM_STAGES
+};
+
+static const char *mod_stageNames[MOD_NUM_STAGES] =
+{
+	"entities", "lightmaps", "shaders", "geometry", "surfaces", "tree", "meshes", "finish"
+};
+
+static uint64_t mod_stageTimes[MOD_NUM_STAGES];
+static uint64_t mod_stageStart;
+
+/*
+* Mod_EndStage
+*
+* Adds the time since the previous call to the given loading stage
+*/
+static void Mod_EndStage( int stage )
+{
+	uint64_t now = ri.Sys_Microseconds();
+
+	mod_stageTimes[stage] += now - mod_stageStart;
+	mod_stageStart = now;
+}
+
 /*
 * Mod_CheckDeluxemaps
 */
@@ -1486,6 +1521,65 @@ static void Mod_LoadLightgrid_RBSP( const lump_t *l )
 	memcpy( out, in, count*sizeof( *out ) );
 }
 
+typedef struct
+{
+	void ( *load )( const lump_t *l );
+	const lump_t *lump;
+} modLumpJob_t;
+
+/*
+* Mod_CheckLumpSize
+*
+* The lump loaders run on worker threads can't raise errors, so their lumps are
+* validated beforehand
+*/
+static void Mod_CheckLumpSize( const char *loader, const lump_t *l, size_t size )
+{
+	if( l->filelen % size )
+		ri.Com_Error( ERR_DROP, "%s: funny lump size in %s", loader, loadmodel->name );
+}
+
+/*
+* Mod_LoadLumpsJob
+*/
+static void Mod_LoadLumpsJob( void *arg, unsigned int first, unsigned int count, int worker )
+{
+	const modLumpJob_t *jobs = arg;
+	unsigned int i;
+
+	for( i = first; i < first + count; i++ )
+		jobs[i].load( jobs[i].lump );
+}
+
+/*
+* Mod_LoadGeometryLumps
+*
+* Planes, vertexes, elems and the lightgrid don't depend on each other or
+* on anything but the lighting setup, so they are converted concurrently
+*/
+static void Mod_LoadGeometryLumps( const dheader_t *header )
+{
+	modLumpJob_t jobs[4];
+	bool raven = ( mod_bspFormat->flags & BSP_RAVEN ) ? true : false;
+
+	Mod_CheckLumpSize( "Mod_LoadPlanes", &header->lumps[LUMP_PLANES], sizeof( dplane_t ) );
+	Mod_CheckLumpSize( "Mod_LoadVertexes", &header->lumps[LUMP_VERTEXES], raven ? sizeof( rdvertex_t ) : sizeof( dvertex_t ) );
+	Mod_CheckLumpSize( "Mod_LoadElems", &header->lumps[LUMP_ELEMENTS], sizeof( int ) );
+	Mod_CheckLumpSize( "Mod_LoadLightgrid", &header->lumps[LUMP_LIGHTGRID], raven ? sizeof( rdgridlight_t ) : sizeof( dgridlight_t ) );
+
+	// the largest lump goes first
+	jobs[0].load = raven ? Mod_LoadVertexes_RBSP : Mod_LoadVertexes;
+	jobs[0].lump = &header->lumps[LUMP_VERTEXES];
+	jobs[1].load = Mod_LoadPlanes;
+	jobs[1].lump = &header->lumps[LUMP_PLANES];
+	jobs[2].load = Mod_LoadElems;
+	jobs[2].lump = &header->lumps[LUMP_ELEMENTS];
+	jobs[3].load = raven ? Mod_LoadLightgrid_RBSP : Mod_LoadLightgrid;
+	jobs[3].lump = &header->lumps[LUMP_LIGHTGRID];
+
+	R_ParallelFor( 4, 1, Mod_LoadLumpsJob, jobs );
+}
+
 /*
 * Mod_LoadLightArray
 */
@@ -1702,6 +1796,28 @@ static void Mod_ApplySuperStylesToFace( const rdface_t *in, msurface_t *out )
 	out->superLightStyle = R_AddSuperLightStyle( loadmodel, lightmaps, lightmapStyles, vertexStyles, lmRects );
 }
 
+#define MESHES_PER_JOB	32
+
+/*
+* Mod_CreateMeshesJob
+*
+* Tessellates patches and builds surface meshes and tangent vectors
+*/
+static void Mod_CreateMeshesJob( void *arg, unsigned int first, unsigned int count, int worker )
+{
+	unsigned int i;
+	msurface_t *surf;
+
+	for( i = first; i < first + count; i++ ) {
+		surf = loadbmodel->surfaces + i;
+		surf->mesh = Mod_CreateMeshForSurface( loadmodel_dsurfaces + i, surf, loadmodel_patchgrouprefs[i] );
+		if( surf->mesh ) {
+			surf->numVerts = surf->mesh->numVerts;
+			surf->numElems = surf->mesh->numElems;
+		}
+	}
+}
+
 /*
 * Mod_Finish
 */
@@ -1766,15 +1882,16 @@ static void Mod_Finish( const lump_t *faces, const lump_t *light, vec3_t gridSiz
 
 	R_SortSuperLightStyles( loadmodel );
 
+	Mod_EndStage( MOD_STAGE_FINISH );
+
+	// each surface only writes to its own mesh, so the output doesn't depend on the order
+	R_ParallelFor( loadbmodel->numsurfaces, MESHES_PER_JOB, Mod_CreateMeshesJob, NULL );
+
+	Mod_EndStage( MOD_STAGE_MESHES );
+
 	in = loadmodel_dsurfaces;
 	surf = loadbmodel->surfaces;
 	for( i = 0; i < loadbmodel->numsurfaces; i++, in++, surf++ ) {
-		surf->mesh = Mod_CreateMeshForSurface( in, surf, loadmodel_patchgrouprefs[i] );
-		if( surf->mesh ) {
-			surf->numVerts = surf->mesh->numVerts;
-			surf->numElems = surf->mesh->numElems;
-		}
-
 		Mod_ApplySuperStylesToFace( in, surf );
 
 		// force outlines hack for old maps
@@ -1824,6 +1941,22 @@ static void Mod_Finish( const lump_t *faces, const lump_t *light, vec3_t gridSiz
 	loadmodel_numpatchgroups = loadmodel_maxpatchgroups = 0;
 }
 
+/*
+* Mod_PrintLoadStages
+*/
+static void Mod_PrintLoadStages( void )
+{
+	int i;
+	uint64_t total = 0;
+
+	for( i = 0; i < MOD_NUM_STAGES; i++ )
+		total += mod_stageTimes[i];
+
+	ri.Com_DPrintf( "Loaded %s in %.1f ms (%i worker threads)\n", loadmodel->name, total / 1000.0, R_NumJobWorkers() );
+	for( i = 0; i < MOD_NUM_STAGES; i++ )
+		ri.Com_DPrintf( "  %-10s %8.1f ms\n", mod_stageNames[i], mod_stageTimes[i] / 1000.0 );
+}
+
 /*
 * Mod_LoadQ3BrushModel
 */
@@ -1849,31 +1982,39 @@ void Mod_LoadQ3BrushModel( model_t *mod, model_t *parent, void *buffer, bspForma
 	for( i = 0; i < sizeof( dheader_t )/4; i++ )
 		( (int *)header )[i] = LittleLong( ( (int *)header )[i] );
 
+	memset( mod_stageTimes, 0, sizeof( mod_stageTimes ) );
+	mod_stageStart = ri.Sys_Microseconds();
+
 	// load into heap
 	Mod_LoadSubmodels( &header->lumps[LUMP_MODELS] );
 	Mod_LoadEntities( &header->lumps[LUMP_ENTITIES], gridSize, ambient, outline );
+	Mod_EndStage( MOD_STAGE_ENTITIES );
+
 	Mod_LoadLighting( &header->lumps[LUMP_LIGHTING], &header->lumps[LUMP_FACES] );
+	Mod_EndStage( MOD_STAGE_LIGHTMAPS );
+
 	Mod_LoadShaderrefs( &header->lumps[LUMP_SHADERREFS] );
 	Mod_PreloadFaces( &header->lumps[LUMP_FACES] );
-	Mod_LoadPlanes( &header->lumps[LUMP_PLANES] );
+	Mod_EndStage( MOD_STAGE_SHADERS );
+
+	Mod_LoadGeometryLumps( header );
+	Mod_EndStage( MOD_STAGE_GEOMETRY );
+
 	Mod_LoadFogs( &header->lumps[LUMP_FOGS], &header->lumps[LUMP_BRUSHES], &header->lumps[LUMP_BRUSHSIDES] );
 	Mod_LoadFaces( &header->lumps[LUMP_FACES] );
-	if( mod_bspFormat->flags & BSP_RAVEN )
-		Mod_LoadVertexes_RBSP( &header->lumps[LUMP_VERTEXES] );
-	else
-		Mod_LoadVertexes( &header->lumps[LUMP_VERTEXES] );
-	Mod_LoadElems( &header->lumps[LUMP_ELEMENTS] );
-	if( mod_bspFormat->flags & BSP_RAVEN )
-		Mod_LoadLightgrid_RBSP( &header->lumps[LUMP_LIGHTGRID] );
-	else
-		Mod_LoadLightgrid( &header->lumps[LUMP_LIGHTGRID] );
 	Mod_LoadPatchGroups( &header->lumps[LUMP_FACES] );
+	Mod_EndStage( MOD_STAGE_SURFACES );
+
 	Mod_LoadLeafs( &header->lumps[LUMP_LEAFS], &header->lumps[LUMP_LEAFFACES] );
 	Mod_LoadNodes( &header->lumps[LUMP_NODES] );
 	if( mod_bspFormat->flags & BSP_RAVEN )
 		Mod_LoadLightArray_RBSP( &header->lumps[LUMP_LIGHTARRAY] );
 	else
 		Mod_LoadLightArray();
+	Mod_EndStage( MOD_STAGE_TREE );
 
 	Mod_Finish( &header->lumps[LUMP_FACES], &header->lumps[LUMP_LIGHTING], gridSize, ambient, outline );
+	Mod_EndStage( MOD_STAGE_FINISH );
+
+	Mod_PrintLoadStages();
 }
@@ -91,6 +91,9 @@ cvar_t *r_soft_particles_scale;
 cvar_t *r_fxaa;
 
 cvar_t *r_lodbias;
+cvar_t *r_skinning_simd;
+cvar_t *r_skinning_parallel;
+cvar_t *r_image_simd;
 cvar_t *r_lodscale;
 
 cvar_t *r_stencilbits;
@@ -101,6 +104,7 @@ cvar_t *r_texturefilter;
 cvar_t *r_texturecompression;
 cvar_t *r_picmip;
 cvar_t *r_skymip;
+cvar_t *r_texturecache;
 cvar_t *r_nobind;
 cvar_t *r_polyblend;
 cvar_t *r_lockpvs;
@@ -122,6 +126,8 @@ cvar_t *gl_drawbuffer;
 cvar_t *gl_driver;
 cvar_t *gl_cull;
 cvar_t *r_multithreading;
+cvar_t *r_workers;
+cvar_t *r_cin_async;
 
 static bool	r_verbose;
 static bool	r_postinit;
@@ -1031,6 +1037,7 @@ static void R_Register( const char *screenshotsPrefix )
 	r_nobind = ri.Cvar_Get( "r_nobind", "0", 0 );
 	r_picmip = ri.Cvar_Get( "r_picmip", "0", CVAR_ARCHIVE|CVAR_LATCH_VIDEO );
 	r_skymip = ri.Cvar_Get( "r_skymip", "0", CVAR_ARCHIVE|CVAR_LATCH_VIDEO );
+	r_texturecache = ri.Cvar_Get( "r_texturecache", "1", CVAR_ARCHIVE );
 	r_polyblend = ri.Cvar_Get( "r_polyblend", "1", 0 );
 
 	r_mapoverbrightbits = ri.Cvar_Get( "r_mapoverbrightbits", "2", CVAR_ARCHIVE|CVAR_LATCH_VIDEO );
@@ -1089,6 +1096,9 @@ static void R_Register( const char *screenshotsPrefix )
 	r_fxaa = ri.Cvar_Get( "r_fxaa", "1", CVAR_ARCHIVE );
 
 	r_lodbias = ri.Cvar_Get( "r_lodbias", "0", CVAR_ARCHIVE );
+	r_skinning_simd = ri.Cvar_Get( "r_skinning_simd", "1", CVAR_ARCHIVE );
+	r_skinning_parallel = ri.Cvar_Get( "r_skinning_parallel", "2048", CVAR_ARCHIVE );
+	r_image_simd = ri.Cvar_Get( "r_image_simd", "1", CVAR_ARCHIVE );
 	r_lodscale = ri.Cvar_Get( "r_lodscale", "5.0", CVAR_ARCHIVE );
 
 	r_gamma = ri.Cvar_Get( "r_gamma", "1.0", CVAR_ARCHIVE );
@@ -1124,6 +1134,8 @@ static void R_Register( const char *screenshotsPrefix )
 	r_maxglslbones = ri.Cvar_Get( "r_maxglslbones", STR_TOSTR( MAX_GLSL_UNIFORM_BONES ), CVAR_LATCH_VIDEO );
 
 	r_multithreading = ri.Cvar_Get( "r_multithreading", "1", CVAR_ARCHIVE|CVAR_LATCH_VIDEO );
+	r_workers = ri.Cvar_Get( "r_workers", "2", CVAR_ARCHIVE|CVAR_LATCH_VIDEO );
+	r_cin_async = ri.Cvar_Get( "r_cin_async", "0", CVAR_ARCHIVE|CVAR_LATCH_VIDEO );
 
 	gl_cull = ri.Cvar_Get( "gl_cull", "1", 0 );
 	gl_drawbuffer = ri.Cvar_Get( "gl_drawbuffer", "GL_BACK", 0 );
@@ -1135,6 +1147,7 @@ static void R_Register( const char *screenshotsPrefix )
 		gl_driver = NULL;
 
 	ri.Cmd_AddCommand( "imagelist", R_ImageList_f );
+	ri.Cmd_AddCommand( "imagecachestats", R_ImageCacheStats_f );
 	ri.Cmd_AddCommand( "shaderlist", R_ShaderList_f );
 	ri.Cmd_AddCommand( "shaderdump", R_ShaderDump_f );
 	ri.Cmd_AddCommand( "screenshot", R_ScreenShot_f );
@@ -1143,6 +1156,10 @@ static void R_Register( const char *screenshotsPrefix )
 	ri.Cmd_AddCommand( "gfxinfo", R_GfxInfo_f );
 	ri.Cmd_AddCommand( "glslprogramlist", RP_ProgramList_f );
 	ri.Cmd_AddCommand( "cinlist", R_CinList_f );
+	ri.Cmd_AddCommand( "r_sortbench", R_SortBench_f );
+	ri.Cmd_AddCommand( "r_cullbench", R_CullBench_f );
+	ri.Cmd_AddCommand( "r_skinbench", R_SkinBench_f );
+	ri.Cmd_AddCommand( "r_imagebench", R_ImageBench_f );
 }
 
 /*
@@ -1339,6 +1356,8 @@ static rserr_t R_PostInit( void )
 
 	R_InitDrawLists();
 
+	R_InitJobs();
+
 	if( !R_RegisterGLExtensions() ) {
 		QGL_Shutdown();
 		return rserr_unknown;
@@ -1371,6 +1390,8 @@ static rserr_t R_PostInit( void )
 
 	R_InitModels();
 
+	R_InitFragmentClipper();
+
 	R_ClearScene();
 
 	R_InitVolatileAssets();
@@ -1506,16 +1527,25 @@ void R_Shutdown( bool verbose )
 	ri.Cmd_RemoveCommand( "screenshot" );
 	ri.Cmd_RemoveCommand( "envshot" );
 	ri.Cmd_RemoveCommand( "imagelist" );
+	ri.Cmd_RemoveCommand( "imagecachestats" );
 	ri.Cmd_RemoveCommand( "gfxinfo" );
 	ri.Cmd_RemoveCommand( "shaderdump" );
 	ri.Cmd_RemoveCommand( "shaderlist" );
 	ri.Cmd_RemoveCommand( "glslprogramlist" );
 	ri.Cmd_RemoveCommand( "cinlist" );
+	ri.Cmd_RemoveCommand( "r_sortbench" );
+	ri.Cmd_RemoveCommand( "r_cullbench" );
+	ri.Cmd_RemoveCommand( "r_skinbench" );
+	ri.Cmd_RemoveCommand( "r_imagebench" );
+
+	R_ShutdownJobs();
 
 	// free shaders, models, etc.
 
 	R_DestroyVolatileAssets();
 
+	R_ShutdownFragmentClipper();
+
 	R_ShutdownModels();
 
 	R_ShutdownSkinFiles();
@@ -33,20 +33,65 @@ typedef struct
 	void ( *func )( shader_t *shader, shaderpass_t *pass, const char **ptr );
 } shaderkey_t;
 
+#define SHADERCACHE_FILE_NAME		"cache/shaders.cache"
+#define SHADERCACHE_FILE_MAGIC		"QFSC"
+#define SHADERCACHE_FILE_VERSION	1
+
+typedef struct
+{
+	char *filename;
+	char *buffer;			// compressed script text, NULL for empty files
+	size_t size;
+	unsigned checksum;		// of the pak the script comes from, 0 for loose files
+	int64_t mtime;
+	void *entries;
+} shadercachefile_t;
+
 typedef struct shadercache_s
 {
 	char *name;
-	char *buffer;
-	char *filename;
+	shadercachefile_t *file;
 	size_t offset;
 	struct shadercache_s *hash_next;
 } shadercache_t;
 
+// on-disk index of all shader scripts, stores the compressed text of every
+// script followed by the name and offset of every shader definition
+typedef struct
+{
+	char magic[4];
+	int version;
+	int numFiles;
+	int numEntries;
+	unsigned parseTime;		// microseconds it took to build the index from scratch
+} shadercachefileheader_t;
+
+typedef struct
+{
+	int64_t mtime;
+	unsigned checksum;
+	int nameLength;
+	int size;
+	int unused;
+} shadercachefilerecord_t;
+
+typedef struct
+{
+	int file;
+	int offset;
+	int nameLength;
+} shadercacheentryrecord_t;
+
 static shader_t r_shaders[MAX_SHADERS];
 
 static shader_t r_shaders_hash_headnode[SHADERS_HASH_SIZE], *r_free_shaders;
 static shadercache_t *shadercache_hash[SHADERCACHE_HASH_SIZE];
 
+static shadercachefile_t *r_shaderCacheFiles;
+static int r_numShaderCacheFiles;
+static shadercache_t *r_shaderCacheEntries;
+static uint8_t *r_shaderCacheData;
+
 static deformv_t r_currentDeforms[MAX_SHADER_DEFORMVS];
 static shaderpass_t r_currentPasses[MAX_SHADER_PASSES];
 static float r_currentRGBgenArgs[MAX_SHADER_PASSES][3], r_currentAlphagenArgs[MAX_SHADER_PASSES][2];
@@ -71,7 +116,6 @@ static char *r_shortShaderName;
 static size_t r_shortShaderNameSize;
 
 static bool Shader_Parsetok( shader_t *shader, shaderpass_t *pass, const shaderkey_t *keys, const char *token, const char **ptr );
-static void Shader_MakeCache( const char *filename );
 static unsigned int Shader_GetCache( const char *name, shadercache_t **cache );
 #define R_FreePassCinematics(pass) if( (pass)->cin ) { R_FreeCinematic( (pass)->cin ); (pass)->cin = 0; }
 
@@ -909,14 +953,14 @@ static void Shader_Template( shader_t *shader, shaderpass_t *pass, const char **
 	// aha, found it
 
 	// find total length
-	buf = cache->buffer + cache->offset;
+	buf = cache->file->buffer + cache->offset;
 	ptr2 = buf;
 	Shader_SkipBlock( (const char **)&ptr2 );
 	length = ptr2 - buf;
 
 	// replace the following char with a EOF
-	backup = cache->buffer[ptr2 - cache->buffer];
-	cache->buffer[ptr2 - cache->buffer] = '\0';
+	backup = cache->file->buffer[ptr2 - cache->file->buffer];
+	cache->file->buffer[ptr2 - cache->file->buffer] = '\0';
 
 	// now count occurences of each argument in a template
 	ptr_backup = *ptr;
@@ -998,7 +1042,7 @@ static void Shader_Template( shader_t *shader, shaderpass_t *pass, const char **
 	COM_ParseExt( ptr, true );
 
 	// restore backup char
-	cache->buffer[ptr2 - cache->buffer] = backup;
+	cache->file->buffer[ptr2 - cache->file->buffer] = backup;
 }
 
 static void Shader_Skip( shader_t *shader, shaderpass_t *pass, const char **ptr )
@@ -1795,21 +1839,21 @@ void R_PrintShaderCache( const char *name )
 		return;
 	}
 
-	start = cache->buffer + cache->offset;
+	start = cache->file->buffer + cache->offset;
 
 	// temporarily hack in the zero-char
 	ptr = start;
 	Shader_SkipBlock( &ptr );
-	backup = cache->buffer[ptr - cache->buffer];
-	cache->buffer[ptr - cache->buffer] = '\0';
+	backup = cache->file->buffer[ptr - cache->file->buffer];
+	cache->file->buffer[ptr - cache->file->buffer] = '\0';
 
-	Com_Printf( "Found in %s:\n\n", cache->filename );
+	Com_Printf( "Found in %s:\n\n", cache->file->filename );
 	Com_Printf( S_COLOR_YELLOW "%s%s\n", name, start );
 
-	cache->buffer[ptr - cache->buffer] = backup;
+	cache->file->buffer[ptr - cache->file->buffer] = backup;
 }
 
-static void Shader_MakeCache( const char *filename )
+static void Shader_MakeCache( shadercachefile_t *file )
 {
 	int size;
 	unsigned int key;
@@ -1821,10 +1865,10 @@ static void Shader_MakeCache( const char *filename )
 	uint8_t *cacheMemBuf;
 	size_t cacheMemSize;
 
-	pathNameSize = strlen( "scripts/" ) + strlen( filename ) + 1;
+	pathNameSize = strlen( "scripts/" ) + strlen( file->filename ) + 1;
 	pathName = R_Malloc( pathNameSize );
 	assert( pathName );
-	Q_snprintfz( pathName, pathNameSize, "scripts/%s", filename );
+	Q_snprintfz( pathName, pathNameSize, "scripts/%s", file->filename );
 
 	Com_Printf( "...loading '%s'\n", pathName );
 
@@ -1841,6 +1885,9 @@ static void Shader_MakeCache( const char *filename )
 	R_FreeFile( temp );
 	temp = NULL;
 
+	file->buffer = buf;
+	file->size = size + 1;
+
 	// calculate buffer size to allocate our cache objects all at once (we may leak
 	// insignificantly here because of duplicate entries)
 	for( ptr = buf, cacheMemSize = 0; ptr; )
@@ -1854,13 +1901,11 @@ static void Shader_MakeCache( const char *filename )
 	}
 
 	if( !cacheMemSize )
-	{
-		R_Free( buf );
 		goto done;
-	}
 
 	cacheMemBuf = R_Malloc( cacheMemSize );
 	memset( cacheMemBuf, 0, cacheMemSize );
+	file->entries = cacheMemBuf;
 	for( ptr = buf; ptr; )
 	{
 		token = COM_ParseExt( &ptr, true );
@@ -1875,15 +1920,11 @@ static void Shader_MakeCache( const char *filename )
 		cache = ( shadercache_t * )cacheMemBuf; cacheMemBuf += sizeof( shadercache_t ) + strlen( token ) + 1;
 		cache->hash_next = shadercache_hash[key];
 		cache->name = ( char * )( (uint8_t *)cache + sizeof( shadercache_t ) );
-		cache->filename = NULL;
 		strcpy( cache->name, token );
 		shadercache_hash[key] = cache;
 
 set_path_and_offset:
-		if( cache->filename )
-			R_Free( cache->filename );
-		cache->filename = R_CopyString( filename );
-		cache->buffer = buf;
+		cache->file = file;
 		cache->offset = ptr - buf;
 
 		Shader_SkipBlock( &ptr );
@@ -1922,23 +1963,211 @@ static unsigned int Shader_GetCache( const char *name, shadercache_t **cache )
 }
 
 /*
-* R_PrecacheShaders
+* Shader_ReadCacheData
 */
-static void R_InitShadersCache( void )
+static bool Shader_ReadCacheData( const uint8_t **ptr, const uint8_t *end, void *out, size_t size )
+{
+	if( (size_t)( end - *ptr ) < size )
+		return false;
+	memcpy( out, *ptr, size );
+	*ptr += size;
+	return true;
+}
+
+/*
+* Shader_ReadCacheString
+*
+* Strings are stored with their terminating zero so they can be used in place.
+*/
+static char *Shader_ReadCacheString( const uint8_t **ptr, const uint8_t *end, int length )
+{
+	char *str = ( char * )*ptr;
+
+	if( length <= 0 || end - *ptr < length || str[length - 1] != '\0' )
+		return NULL;
+	*ptr += length;
+	return str;
+}
+
+/*
+* Shader_LoadCacheFile
+*
+* Restores the shader script index saved by Shader_WriteCacheFile. The index is only
+* used if it was built from exactly the same list of script files, coming from the
+* same paks or having the same modification times for loose files.
+*/
+static bool Shader_LoadCacheFile( unsigned *parseTime )
+{
+	int i, length, handle;
+	uint8_t *data;
+	const uint8_t *ptr, *end, *entriesStart;
+	char *name;
+	unsigned int key;
+	shadercache_t *cache;
+	shadercachefile_t *file;
+	shadercachefileheader_t header;
+	shadercachefilerecord_t record;
+	shadercacheentryrecord_t entry;
+
+	length = ri.FS_FOpenFile( SHADERCACHE_FILE_NAME, &handle, FS_READ|FS_CACHE );
+	if( length < 0 )
+		return false;
+	if( length < (int)sizeof( header ) ) {
+		ri.FS_FCloseFile( handle );
+		return false;
+	}
+
+	data = R_Malloc( length );
+	ri.FS_Read( data, length, handle );
+	ri.FS_FCloseFile( handle );
+
+	ptr = data;
+	end = data + length;
+
+	Shader_ReadCacheData( &ptr, end, &header, sizeof( header ) );
+	if( memcmp( header.magic, SHADERCACHE_FILE_MAGIC, sizeof( header.magic ) )
+		|| header.version != SHADERCACHE_FILE_VERSION
+		|| header.numFiles != r_numShaderCacheFiles
+		|| header.numEntries <= 0 )
+		goto fail;
+
+	for( i = 0, file = r_shaderCacheFiles; i < r_numShaderCacheFiles; i++, file++ ) {
+		if( !Shader_ReadCacheData( &ptr, end, &record, sizeof( record ) ) )
+			goto fail;
+		if( record.checksum != file->checksum || record.mtime != file->mtime || record.size < 0 )
+			goto fail;
+
+		name = Shader_ReadCacheString( &ptr, end, record.nameLength );
+		if( !name || strcmp( name, file->filename ) )
+			goto fail;
+
+		if( record.size ) {
+			file->buffer = Shader_ReadCacheString( &ptr, end, record.size );
+			if( !file->buffer )
+				goto fail;
+			file->size = record.size;
+		}
+	}
+
+	// validate the entries before touching the hash table
+	entriesStart = ptr;
+	for( i = 0; i < header.numEntries; i++ ) {
+		if( !Shader_ReadCacheData( &ptr, end, &entry, sizeof( entry ) ) )
+			goto fail;
+		if( entry.file < 0 || entry.file >= r_numShaderCacheFiles || !r_shaderCacheFiles[entry.file].buffer
+			|| entry.offset < 0 || (size_t)entry.offset >= r_shaderCacheFiles[entry.file].size )
+			goto fail;
+		if( !Shader_ReadCacheString( &ptr, end, entry.nameLength ) )
+			goto fail;
+	}
+
+	r_shaderCacheData = data;
+	r_shaderCacheEntries = R_Malloc( header.numEntries * sizeof( shadercache_t ) );
+
+	ptr = entriesStart;
+	for( i = 0; i < header.numEntries; i++ ) {
+		Shader_ReadCacheData( &ptr, end, &entry, sizeof( entry ) );
+		name = Shader_ReadCacheString( &ptr, end, entry.nameLength );
+
+		key = Shader_GetCache( name, &cache );
+		if( !cache ) {
+			cache = &r_shaderCacheEntries[i];
+			cache->name = name;
+			cache->hash_next = shadercache_hash[key];
+			shadercache_hash[key] = cache;
+		}
+		cache->file = &r_shaderCacheFiles[entry.file];
+		cache->offset = entry.offset;
+	}
+
+	*parseTime = header.parseTime;
+	return true;
+
+fail:
+	for( i = 0; i < r_numShaderCacheFiles; i++ ) {
+		r_shaderCacheFiles[i].buffer = NULL;
+		r_shaderCacheFiles[i].size = 0;
+	}
+	R_Free( data );
+	return false;
+}
+
+/*
+* Shader_WriteCacheFile
+*/
+static void Shader_WriteCacheFile( unsigned parseTime )
 {
-	int d;
+	int i, handle;
+	shadercache_t *cache;
+	shadercachefile_t *file;
+	shadercachefileheader_t header;
+	shadercachefilerecord_t record;
+	shadercacheentryrecord_t entry;
+
+	memset( &header, 0, sizeof( header ) );
+	memcpy( header.magic, SHADERCACHE_FILE_MAGIC, sizeof( header.magic ) );
+	header.version = SHADERCACHE_FILE_VERSION;
+	header.numFiles = r_numShaderCacheFiles;
+	header.parseTime = parseTime;
+	for( i = 0; i < SHADERCACHE_HASH_SIZE; i++ ) {
+		for( cache = shadercache_hash[i]; cache; cache = cache->hash_next )
+			header.numEntries++;
+	}
+
+	if( !header.numEntries )
+		return;
+
+	if( ri.FS_FOpenFile( SHADERCACHE_FILE_NAME, &handle, FS_WRITE|FS_CACHE ) == -1 ) {
+		Com_Printf( S_COLOR_YELLOW "Could not open %s for writing.\n", SHADERCACHE_FILE_NAME );
+		return;
+	}
+
+	ri.FS_Write( &header, sizeof( header ), handle );
+
+	for( i = 0, file = r_shaderCacheFiles; i < r_numShaderCacheFiles; i++, file++ ) {
+		memset( &record, 0, sizeof( record ) );
+		record.mtime = file->mtime;
+		record.checksum = file->checksum;
+		record.nameLength = strlen( file->filename ) + 1;
+		record.size = file->buffer ? file->size : 0;
+
+		ri.FS_Write( &record, sizeof( record ), handle );
+		ri.FS_Write( file->filename, record.nameLength, handle );
+		if( record.size )
+			ri.FS_Write( file->buffer, record.size, handle );
+	}
+
+	for( i = 0; i < SHADERCACHE_HASH_SIZE; i++ ) {
+		for( cache = shadercache_hash[i]; cache; cache = cache->hash_next ) {
+			entry.file = cache->file - r_shaderCacheFiles;
+			entry.offset = cache->offset;
+			entry.nameLength = strlen( cache->name ) + 1;
+
+			ri.FS_Write( &entry, sizeof( entry ), handle );
+			ri.FS_Write( cache->name, entry.nameLength, handle );
+		}
+	}
+
+	ri.FS_FCloseFile( handle );
+}
+
+/*
+* Shader_ListScriptFiles
+*
+* Fills r_shaderCacheFiles with the names of all shader scripts, along with the
+* checksums of the paks they come from, which is what the on-disk index is keyed on.
+*/
+static void Shader_ListScriptFiles( void )
+{
+	int d, numdirs;
 	int i, j, k, numfiles;
 	int numfiles_total;
 	const char *fileptr;
 	char shaderPaths[1024];
+	char pathName[1024];
+	shadercachefile_t *file;
 	const char *dirs[3] = { "<scripts", ">scripts", "scripts" };
 
-	r_shaderTemplateBuf = NULL;
-
-	memset( shadercache_hash, 0, sizeof( shadercache_t * )*SHADERCACHE_HASH_SIZE );
-	
-	Com_Printf( "Initializing Shaders:\n" );
-
 	numfiles_total = 0;
 	for( d = 0; d < 3; d++ ) {
 		if( d == 2 ) {
@@ -1948,11 +2177,21 @@ static void R_InitShadersCache( void )
 				break;
 		}
 
+		numfiles_total += ri.FS_GetFileList( dirs[d], ".shader", NULL, 0, 0, 0 );
+	}
+	numdirs = d;
+
+	if( !numfiles_total ) {
+		ri.Com_Error( ERR_DROP, "Could not find any shaders!" );
+	}
+
+	r_shaderCacheFiles = R_Malloc( numfiles_total * sizeof( shadercachefile_t ) );
+	r_numShaderCacheFiles = 0;
+
+	for( d = 0; d < numdirs; d++ ) {
 		// enumerate shaders
 		numfiles = ri.FS_GetFileList( dirs[d], ".shader", NULL, 0, 0, 0 );
-		numfiles_total += numfiles;
 
-		// now load them all
 		for( i = 0; i < numfiles; i += k ) {
 			if( ( k = ri.FS_GetFileList( dirs[d], ".shader", shaderPaths, sizeof( shaderPaths ), i, numfiles )) == 0 ) {
 				k = 1; // advance by one file
@@ -1960,8 +2199,13 @@ static void R_InitShadersCache( void )
 			}
 
 			fileptr = shaderPaths;
-			for( j = 0; j < k; j++ ) {
-				Shader_MakeCache( fileptr );
+			for( j = 0; j < k && r_numShaderCacheFiles < numfiles_total; j++ ) {
+				Q_snprintfz( pathName, sizeof( pathName ), "scripts/%s", fileptr );
+
+				file = &r_shaderCacheFiles[r_numShaderCacheFiles++];
+				file->filename = R_CopyString( fileptr );
+				file->checksum = ri.FS_PakChecksumForFile( pathName );
+				file->mtime = ri.FS_FileMTime( pathName );
 
 				fileptr += strlen( fileptr ) + 1;
 				if( !*fileptr ) {
@@ -1970,14 +2214,75 @@ static void R_InitShadersCache( void )
 			}
 		}
 	}
+}
 
-	if( !numfiles_total ) {
-		ri.Com_Error( ERR_DROP, "Could not find any shaders!" );
+/*
+* R_PrecacheShaders
+*/
+static void R_InitShadersCache( void )
+{
+	int i;
+	uint64_t start;
+	unsigned parseTime;
+
+	r_shaderTemplateBuf = NULL;
+
+	memset( shadercache_hash, 0, sizeof( shadercache_t * )*SHADERCACHE_HASH_SIZE );
+	
+	Com_Printf( "Initializing Shaders:\n" );
+
+	start = ri.Sys_Microseconds();
+
+	Shader_ListScriptFiles();
+
+	if( Shader_LoadCacheFile( &parseTime ) ) {
+		Com_Printf( "...loaded %i scripts from %s in %.1f ms, parsing took %.1f ms\n", r_numShaderCacheFiles,
+			SHADERCACHE_FILE_NAME, ( ri.Sys_Microseconds() - start ) / 1000.0, parseTime / 1000.0 );
+	} else {
+		for( i = 0; i < r_numShaderCacheFiles; i++ ) {
+			Shader_MakeCache( &r_shaderCacheFiles[i] );
+		}
+
+		parseTime = ri.Sys_Microseconds() - start;
+		Com_Printf( "...parsed %i scripts in %.1f ms\n", r_numShaderCacheFiles, parseTime / 1000.0 );
+
+		Shader_WriteCacheFile( parseTime );
 	}
 
 	Com_Printf( "--------------------------------------\n" );
 }
 
+/*
+* R_FreeShadersCache
+*/
+static void R_FreeShadersCache( void )
+{
+	int i;
+	shadercachefile_t *file;
+
+	for( i = 0, file = r_shaderCacheFiles; i < r_numShaderCacheFiles; i++, file++ ) {
+		if( !r_shaderCacheData && file->buffer )
+			R_Free( file->buffer );
+		if( file->entries )
+			R_Free( file->entries );
+		R_Free( file->filename );
+	}
+
+	if( r_shaderCacheFiles )
+		R_Free( r_shaderCacheFiles );
+	if( r_shaderCacheEntries )
+		R_Free( r_shaderCacheEntries );
+	if( r_shaderCacheData )
+		R_Free( r_shaderCacheData );
+
+	r_shaderCacheFiles = NULL;
+	r_numShaderCacheFiles = 0;
+	r_shaderCacheEntries = NULL;
+	r_shaderCacheData = NULL;
+
+	memset( shadercache_hash, 0, sizeof( shadercache_hash ) );
+}
+
 /*
 * R_InitShaders
 */
@@ -2155,7 +2460,7 @@ void R_ShutdownShaders( void )
 	r_shortShaderName = NULL;
 	r_shortShaderNameSize = 0;
 
-	memset( shadercache_hash, 0, sizeof( shadercache_hash ) );
+	R_FreeShadersCache();
 }
 
 static void Shader_Readpass( shader_t *shader, const char **ptr )
@@ -2646,7 +2951,7 @@ static void R_LoadShaderReal( shader_t *s, const char *shortname,
 		const char *ptr, *token;
 
 		// shader is in the shader scripts
-		text = cache->buffer + cache->offset;
+		text = cache->file->buffer + cache->offset;
 		ri.Com_DPrintf( "Loading shader %s from cache...\n", shortname );
 
 		ptr = text;
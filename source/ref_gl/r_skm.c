@@ -22,6 +22,7 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 
 #include "r_local.h"
 #include "iqm.h"
+#include "../gameshared/q_simd.h"
 
 // typedefs
 typedef struct iqmheader iqmheader_t;
@@ -1146,6 +1147,122 @@ static void R_SkeletalTransformNormalsAndSVecs( int numverts, const unsigned int
 	}
 }
 
+#if defined( QSIMD_SSE2 ) || defined( QSIMD_NEON )
+
+/*
+* R_SkeletalBlendPoses_SIMD
+*/
+static void R_SkeletalBlendPoses_SIMD( unsigned int numblends, mskblend_t *blends, unsigned int numbones, mat4_t *relbonepose )
+{
+	unsigned int i, j, k;
+	float *pose;
+	const float *b;
+	mskblend_t *blend;
+	qf4_t f, r0, r1, r2, r3;
+
+	for( i = 0, j = numbones, blend = blends; i < numblends; i++, j++, blend++ ) {
+		pose = relbonepose[j];
+
+		// the translation column ends up in the unused 4th lanes of each row too
+		b = relbonepose[blend->indices[0]];
+		f = qf4_splat( blend->weights[0] * (1.0 / 255.0) );
+
+		r0 = qf4_mul( f, qf4_loadu( b +  0 ) );
+		r1 = qf4_mul( f, qf4_loadu( b +  4 ) );
+		r2 = qf4_mul( f, qf4_loadu( b +  8 ) );
+		r3 = qf4_mul( f, qf4_loadu( b + 12 ) );
+
+		for( k = 1; k < SKM_MAX_WEIGHTS && blend->weights[k]; k++ ) {
+			b = relbonepose[blend->indices[k]];
+			f = qf4_splat( blend->weights[k] * (1.0 / 255.0) );
+
+			r0 = qf4_madd( f, qf4_loadu( b +  0 ), r0 );
+			r1 = qf4_madd( f, qf4_loadu( b +  4 ), r1 );
+			r2 = qf4_madd( f, qf4_loadu( b +  8 ), r2 );
+			r3 = qf4_madd( f, qf4_loadu( b + 12 ), r3 );
+		}
+
+		qf4_storeu( pose +  0, r0 );
+		qf4_storeu( pose +  4, r1 );
+		qf4_storeu( pose +  8, r2 );
+		qf4_storeu( pose + 12, r3 );
+	}
+}
+
+/*
+* R_SkeletalTransformVerts_SIMD
+*/
+static void R_SkeletalTransformVerts_SIMD( int numverts, const unsigned int *blends, mat4_t *relbonepose, const vec_t *v, vec_t *ov )
+{
+	const float *pose;
+	qf4_t r;
+
+	for( ; numverts; numverts--, v += 4, ov += 4, blends++ ) {
+		pose = relbonepose[*blends];
+
+		r = qf4_mul( qf4_splat( v[0] ), qf4_loadu( pose ) );
+		r = qf4_madd( qf4_splat( v[1] ), qf4_loadu( pose + 4 ), r );
+		r = qf4_madd( qf4_splat( v[2] ), qf4_loadu( pose + 8 ), r );
+		r = qf4_add( r, qf4_loadu( pose + 12 ) );
+
+		qf4_storeu( ov, r );
+		ov[3] = 1;
+	}
+}
+
+/*
+* R_SkeletalTransformNormals_SIMD
+*/
+static void R_SkeletalTransformNormals_SIMD( int numverts, const unsigned int *blends, mat4_t *relbonepose, const vec_t *v, vec_t *ov )
+{
+	const float *pose;
+	qf4_t r;
+
+	for( ; numverts; numverts--, v += 4, ov += 4, blends++ ) {
+		pose = relbonepose[*blends];
+
+		r = qf4_mul( qf4_splat( v[0] ), qf4_loadu( pose ) );
+		r = qf4_madd( qf4_splat( v[1] ), qf4_loadu( pose + 4 ), r );
+		r = qf4_madd( qf4_splat( v[2] ), qf4_loadu( pose + 8 ), r );
+
+		qf4_storeu( ov, r );
+		ov[3] = 0;
+	}
+}
+
+/*
+* R_SkeletalTransformNormalsAndSVecs_SIMD
+*/
+static void R_SkeletalTransformNormalsAndSVecs_SIMD( int numverts, const unsigned int *blends, mat4_t *relbonepose, const vec_t *v, vec_t *ov, const vec_t *sv, vec_t *osv )
+{
+	const float *pose;
+	qf4_t c0, c1, c2, r, s;
+	float sw;
+
+	for( ; numverts; numverts--, v += 4, ov += 4, sv += 4, osv += 4, blends++ ) {
+		pose = relbonepose[*blends];
+		c0 = qf4_loadu( pose );
+		c1 = qf4_loadu( pose + 4 );
+		c2 = qf4_loadu( pose + 8 );
+
+		r = qf4_mul( qf4_splat( v[0] ), c0 );
+		r = qf4_madd( qf4_splat( v[1] ), c1, r );
+		r = qf4_madd( qf4_splat( v[2] ), c2, r );
+
+		s = qf4_mul( qf4_splat( sv[0] ), c0 );
+		s = qf4_madd( qf4_splat( sv[1] ), c1, s );
+		s = qf4_madd( qf4_splat( sv[2] ), c2, s );
+
+		sw = sv[3];
+		qf4_storeu( ov, r );
+		qf4_storeu( osv, s );
+		ov[3] = 0;
+		osv[3] = sw;
+	}
+}
+
+#endif
+
 // set the FP precision back to whatever value it was
 #if defined ( _WIN32 ) && ( _MSC_VER >= 1400 ) && defined( NDEBUG )
 # pragma float_control(pop)
@@ -1153,6 +1270,263 @@ static void R_SkeletalTransformNormalsAndSVecs( int numverts, const unsigned int
 # pragma fp_contract(off)	// this line is needed on Itanium processors
 #endif
 
+typedef struct
+{
+	const char *name;
+	void ( *blendPoses )( unsigned int numblends, mskblend_t *blends, unsigned int numbones, mat4_t *relbonepose );
+	void ( *transformVerts )( int numverts, const unsigned int *blends, mat4_t *relbonepose, const vec_t *v, vec_t *ov );
+	void ( *transformNormals )( int numverts, const unsigned int *blends, mat4_t *relbonepose, const vec_t *v, vec_t *ov );
+	void ( *transformNormalsAndSVecs )( int numverts, const unsigned int *blends, mat4_t *relbonepose, 
+		const vec_t *v, vec_t *ov, const vec_t *sv, vec_t *osv );
+} skmSkinningFuncs_t;
+
+static const skmSkinningFuncs_t r_skmSkinningC =
+{
+	"C",
+	R_SkeletalBlendPoses,
+	R_SkeletalTransformVerts,
+	R_SkeletalTransformNormals,
+	R_SkeletalTransformNormalsAndSVecs
+};
+
+#if defined( QSIMD_SSE2 ) || defined( QSIMD_NEON )
+static const skmSkinningFuncs_t r_skmSkinningSIMD =
+{
+	QSIMD_NAME,
+	R_SkeletalBlendPoses_SIMD,
+	R_SkeletalTransformVerts_SIMD,
+	R_SkeletalTransformNormals_SIMD,
+	R_SkeletalTransformNormalsAndSVecs_SIMD
+};
+#else
+#define r_skmSkinningSIMD r_skmSkinningC
+#endif
+
+#define SKINNING_VERTS_PER_JOB	512
+
+typedef struct
+{
+	const skmSkinningFuncs_t *funcs;
+	const unsigned int *blends;
+	mat4_t *relbonepose;
+	const vec_t *xyz, *normals, *sVectors;
+	vec_t *outXyz, *outNormals, *outSVectors;	// normals and sVectors may be NULL
+} skmSkinningJob_t;
+
+/*
+* R_SkeletalSkinningFuncs
+*
+* Picks the skinning kernels, r_skinning_simd 0 forces the plain C ones
+*/
+static const skmSkinningFuncs_t *R_SkeletalSkinningFuncs( void )
+{
+	return r_skinning_simd->integer ? &r_skmSkinningSIMD : &r_skmSkinningC;
+}
+
+/*
+* R_SkeletalSkinVertsJob
+*/
+static void R_SkeletalSkinVertsJob( void *arg, unsigned int first, unsigned int count, int worker )
+{
+	const skmSkinningJob_t *job = arg;
+	const size_t ofs = first * 4;
+
+	job->funcs->transformVerts( count, job->blends + first, job->relbonepose, job->xyz + ofs, job->outXyz + ofs );
+
+	if( job->outSVectors ) {
+		job->funcs->transformNormalsAndSVecs( count, job->blends + first, job->relbonepose, 
+			job->normals + ofs, job->outNormals + ofs, job->sVectors + ofs, job->outSVectors + ofs );
+	} else if( job->outNormals ) {
+		job->funcs->transformNormals( count, job->blends + first, job->relbonepose, 
+			job->normals + ofs, job->outNormals + ofs );
+	}
+}
+
+/*
+* R_SkeletalSkinVerts
+*
+* Meshes with at least r_skinning_parallel vertices are split across frontend workers
+*/
+static void R_SkeletalSkinVerts( unsigned int numverts, skmSkinningJob_t *job )
+{
+	if( r_skinning_parallel->integer > 0 && numverts >= (unsigned)r_skinning_parallel->integer ) {
+		R_ParallelFor( numverts, SKINNING_VERTS_PER_JOB, R_SkeletalSkinVertsJob, job );
+		return;
+	}
+	R_SkeletalSkinVertsJob( job, 0, numverts, 0 );
+}
+
+/*
+* R_SkeletalBoneMatrices
+*
+* Builds bone and blend matrices for a single unlerped frame, used by R_SkinBench_f
+*/
+static void R_SkeletalBoneMatrices( const mskmodel_t *skmodel, const bonepose_t *bp, 
+	const skmSkinningFuncs_t *funcs, mat4_t *relbonepose )
+{
+	unsigned int i;
+	const mskbone_t *bone;
+	bonepose_t *tempbonepose;
+	dualquat_t dq;
+
+	tempbonepose = R_Malloc( sizeof( *tempbonepose ) * skmodel->numbones );
+
+	for( i = 0, bone = skmodel->bones; i < skmodel->numbones; i++, bone++ ) {
+		if( bone->parent >= 0 ) {
+			DualQuat_Multiply( tempbonepose[bone->parent].dualquat, bp[i].dualquat, tempbonepose[i].dualquat );
+		}
+		else {
+			DualQuat_Copy( bp[i].dualquat, tempbonepose[i].dualquat );
+		}
+
+		DualQuat_Multiply( tempbonepose[i].dualquat, skmodel->invbaseposes[i].dualquat, dq );
+		DualQuat_Normalize( dq );
+		Matrix4_FromDualQuaternion( dq, relbonepose[i] );
+	}
+
+	funcs->blendPoses( skmodel->numblends, skmodel->blends, skmodel->numbones, relbonepose );
+
+	R_Free( tempbonepose );
+}
+
+/*
+* R_SkinBenchCompare
+*
+* Returns the largest absolute difference between two arrays of vec4's,
+* *exact is cleared if they are not bitwise identical
+*/
+static float R_SkinBenchCompare( const vec_t *a, const vec_t *b, unsigned int numverts, bool *exact )
+{
+	unsigned int i;
+	float diff, maxDiff = 0;
+
+	if( memcmp( a, b, numverts * sizeof( vec4_t ) ) ) {
+		*exact = false;
+	}
+	for( i = 0; i < numverts * 4; i++ ) {
+		diff = fabs( a[i] - b[i] );
+		if( diff > maxDiff ) {
+			maxDiff = diff;
+		}
+	}
+	return maxDiff;
+}
+
+/*
+* R_SkinBench_f
+*
+* r_skinbench [model] [iterations]
+*
+* Skins every mesh of a skeletal model at a few fixed frames with the C and
+* SIMD kernels and on the worker pool, and checks the results against each other
+*/
+void R_SkinBench_f( void )
+{
+	int it, iterations = 100;
+	unsigned int i, f, pass, numframes;
+	unsigned int numverts, numposes, ofs;
+	const char *name = "models/players/bigvic/tris.iqm";
+	model_t *mod;
+	const mskmodel_t *skmodel;
+	const mskmesh_t *mesh;
+	mat4_t *relbonepose[2];
+	vec_t *out[3];
+	uint64_t start, times[3];
+	float maxDiff[2];
+	bool exact[2];
+	skmSkinningJob_t job;
+
+	if( ri.Cmd_Argc() > 1 ) {
+		name = ri.Cmd_Argv( 1 );
+	}
+	if( ri.Cmd_Argc() > 2 ) {
+		iterations = max( atoi( ri.Cmd_Argv( 2 ) ), 1 );
+	}
+
+	mod = R_RegisterModel( name );
+	if( !mod || mod->type != mod_skeletal || !mod->extradata ) {
+		Com_Printf( "%s is not a skeletal model\n", name );
+		return;
+	}
+
+	skmodel = ( const mskmodel_t * )mod->extradata;
+	if( !skmodel->numframes || !skmodel->nummeshes ) {
+		Com_Printf( "%s has no frames\n", name );
+		return;
+	}
+
+	numverts = 0;
+	for( i = 0, mesh = skmodel->meshes; i < skmodel->nummeshes; i++, mesh++ ) {
+		numverts += mesh->numverts;
+	}
+
+	numposes = skmodel->numbones + skmodel->numblends;
+	relbonepose[0] = R_Malloc( sizeof( mat4_t ) * numposes * 2 );
+	relbonepose[1] = relbonepose[0] + numposes;
+
+	// xyz, normals and sVectors of all meshes for each of the three passes
+	out[0] = R_Malloc( sizeof( vec4_t ) * numverts * 3 * 3 );
+	out[1] = out[0] + numverts * 4 * 3;
+	out[2] = out[1] + numverts * 4 * 3;
+
+	numframes = min( skmodel->numframes, 4 );
+	maxDiff[0] = maxDiff[1] = 0;
+	exact[0] = exact[1] = true;
+	times[0] = times[1] = times[2] = 0;
+
+	for( f = 0; f < numframes; f++ ) {
+		const bonepose_t *bp = skmodel->frames[f * skmodel->numframes / numframes].boneposes;
+
+		for( pass = 0; pass < 3; pass++ ) {
+			const skmSkinningFuncs_t *funcs = pass ? &r_skmSkinningSIMD : &r_skmSkinningC;
+			mat4_t *poses = relbonepose[pass ? 1 : 0];
+
+			start = ri.Sys_Microseconds();
+
+			for( it = 0; it < iterations; it++ ) {
+				R_SkeletalBoneMatrices( skmodel, bp, funcs, poses );
+
+				for( i = 0, ofs = 0, mesh = skmodel->meshes; i < skmodel->nummeshes; ofs += mesh->numverts * 4, i++, mesh++ ) {
+					job.funcs = funcs;
+					job.blends = mesh->vertexBlends;
+					job.relbonepose = poses;
+					job.xyz = mesh->xyzArray[0];
+					job.normals = mesh->normalsArray[0];
+					job.sVectors = mesh->sVectorsArray[0];
+					job.outXyz = out[pass] + ofs;
+					job.outNormals = out[pass] + numverts * 4 + ofs;
+					job.outSVectors = out[pass] + numverts * 8 + ofs;
+
+					// only the last pass may use the worker pool
+					if( pass == 2 ) {
+						R_ParallelFor( mesh->numverts, SKINNING_VERTS_PER_JOB, R_SkeletalSkinVertsJob, &job );
+					} else {
+						R_SkeletalSkinVertsJob( &job, 0, mesh->numverts, 0 );
+					}
+				}
+			}
+
+			times[pass] += ri.Sys_Microseconds() - start;
+		}
+
+		for( pass = 1; pass < 3; pass++ ) {
+			float d = R_SkinBenchCompare( out[0], out[pass], numverts * 3, &exact[pass-1] );
+			maxDiff[pass-1] = max( maxDiff[pass-1], d );
+		}
+	}
+
+	R_Free( out[0] );
+	R_Free( relbonepose[0] );
+
+	Com_Printf( "Skinned %s: %i meshes, %i bones, %i blends, %i frames, %i iterations\n", name, 
+		skmodel->nummeshes, skmodel->numbones, skmodel->numblends, numframes, iterations );
+	Com_Printf( "C: %.3f usec/frame\n", (double)times[0] / ( numframes * iterations ) );
+	Com_Printf( "%s: %.3f usec/frame, %s (max error %g)\n", r_skmSkinningSIMD.name, 
+		(double)times[1] / ( numframes * iterations ), exact[0] ? "identical" : "differs", maxDiff[0] );
+	Com_Printf( "%s on %i threads: %.3f usec/frame, %s (max error %g)\n", r_skmSkinningSIMD.name, R_NumJobWorkers(), 
+		(double)times[2] / ( numframes * iterations ), exact[1] ? "identical" : "differs", maxDiff[1] );
+}
+
 //=======================================================================
 
 /*
@@ -1319,7 +1693,7 @@ void R_DrawSkeletalSurf( const entity_t *e, const shader_t *shader, const mfog_t
 			}
 
 			// generate matrices for all blend combinations
-			R_SkeletalBlendPoses( skmodel->numblends, skmodel->blends, skmodel->numbones, bonePoseRelativeMat );
+			R_SkeletalSkinningFuncs()->blendPoses( skmodel->numblends, skmodel->blends, skmodel->numbones, bonePoseRelativeMat );
 		}
 	}
 
@@ -1333,6 +1707,7 @@ void R_DrawSkeletalSurf( const entity_t *e, const shader_t *shader, const mfog_t
 	else
 	{
 		mesh_t dynamicMesh;
+		skmSkinningJob_t skinningJob;
 
 		memset( &dynamicMesh, 0, sizeof( dynamicMesh ) );
 
@@ -1344,17 +1719,16 @@ void R_DrawSkeletalSurf( const entity_t *e, const shader_t *shader, const mfog_t
 			( vattribs & ( VATTRIB_NORMAL_BIT|VATTRIB_SVECTOR_BIT ) ) ? true : false,
 			( vattribs & VATTRIB_SVECTOR_BIT ) ? true : false );
 
-		R_SkeletalTransformVerts( skmesh->numverts, skmesh->vertexBlends, bonePoseRelativeMat,
-			( vec_t * )skmesh->xyzArray[0], ( vec_t * )( dynamicMesh.xyzArray ) );
-
-		if( vattribs & VATTRIB_SVECTOR_BIT ) {
-			R_SkeletalTransformNormalsAndSVecs( skmesh->numverts, skmesh->vertexBlends, bonePoseRelativeMat,
-				( vec_t * )skmesh->normalsArray[0], ( vec_t * )( dynamicMesh.normalsArray ),
-				( vec_t * )skmesh->sVectorsArray[0], ( vec_t * )( dynamicMesh.sVectorsArray ) );
-		} else if( vattribs & VATTRIB_NORMAL_BIT ) {
-			R_SkeletalTransformNormals( skmesh->numverts, skmesh->vertexBlends, bonePoseRelativeMat,
-				( vec_t * )skmesh->normalsArray[0], ( vec_t * )( dynamicMesh.normalsArray ) );
-		}
+		skinningJob.funcs = R_SkeletalSkinningFuncs();
+		skinningJob.blends = skmesh->vertexBlends;
+		skinningJob.relbonepose = bonePoseRelativeMat;
+		skinningJob.xyz = skmesh->xyzArray[0];
+		skinningJob.normals = skmesh->normalsArray[0];
+		skinningJob.sVectors = skmesh->sVectorsArray[0];
+		skinningJob.outXyz = dynamicMesh.xyzArray[0];
+		skinningJob.outNormals = ( vattribs & ( VATTRIB_NORMAL_BIT|VATTRIB_SVECTOR_BIT ) ) ? dynamicMesh.normalsArray[0] : NULL;
+		skinningJob.outSVectors = ( vattribs & VATTRIB_SVECTOR_BIT ) ? dynamicMesh.sVectorsArray[0] : NULL;
+		R_SkeletalSkinVerts( skmesh->numverts, &skinningJob );
 
 		dynamicMesh.stArray = skmesh->stArray;
 
@@ -1409,7 +1783,7 @@ void R_SkeletalModelFrameBounds( const model_t *mod, int frame, vec3_t mins, vec
 /*
 * R_AddSkeletalModelToDrawList
 */
-bool R_AddSkeletalModelToDrawList( const entity_t *e )
+bool R_AddSkeletalModelToDrawList( drawList_t *list, const entity_t *e )
 {
 	int i;
 	const mfog_t *fog;
@@ -1471,7 +1845,7 @@ bool R_AddSkeletalModelToDrawList( const entity_t *e )
 		}
 
 		if( shader ) {
-			R_AddSurfToDrawList( rn.meshlist, e, fog, shader, distance, 0, NULL, skmodel->drawSurfs + i );
+			R_AddSurfToDrawList( list, e, fog, shader, distance, 0, NULL, skmodel->drawSurfs + i );
 		}
 	}
 
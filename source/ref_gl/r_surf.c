@@ -21,6 +21,7 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 // r_surf.c: surface-related refresh code
 
 #include "r_local.h"
+#include "../gameshared/q_simd.h"
 
 static vec3_t modelOrg;							// relative to view point
 
@@ -564,118 +565,487 @@ static void R_MarkLeafSurfaces( msurface_t **mark, unsigned int clipFlags,
 }
 
 /*
-* R_RecursiveWorldNode
+* R_LeafCullSize
+*
+* Returns the size of the buffer R_InitLeafCull expects for numLeafs leafs
 */
-static void R_RecursiveWorldNode( mnode_t *node, unsigned int clipFlags, 
-	unsigned int dlightBits, unsigned int shadowBits )
+size_t R_LeafCullSize( unsigned int numLeafs, bool results )
+{
+	size_t stride = ALIGN( numLeafs, 4 );
+	size_t size;
+
+	size = stride * ( 6 * sizeof( float ) + sizeof( mleaf_t * ) );
+	if( results ) {
+		size += stride * ( 2 * sizeof( unsigned int ) + sizeof( uint8_t ) );
+	}
+	return size;
+}
+
+/*
+* R_InitLeafCull
+*
+* Carves the flattened arrays out of a 16-byte aligned buffer of R_LeafCullSize bytes
+*/
+void R_InitLeafCull( mleafcull_t *lc, unsigned int numLeafs, bool results, uint8_t *buffer )
+{
+	unsigned int stride = ALIGN( numLeafs, 4 );
+
+	memset( lc, 0, sizeof( *lc ) );
+	lc->stride = stride;
+	lc->pvsframe = ~0u;
+
+	lc->bounds = ( float * )buffer; buffer += stride * 6 * sizeof( float );
+	lc->leafs = ( mleaf_t ** )buffer; buffer += stride * sizeof( mleaf_t * );
+	if( results ) {
+		lc->dlightBits = ( unsigned int * )buffer; buffer += stride * sizeof( unsigned int );
+		lc->shadowBits = ( unsigned int * )buffer; buffer += stride * sizeof( unsigned int );
+		lc->clipFlags = buffer;
+	}
+}
+
+/*
+* R_AddLeafCull
+*/
+static void R_AddLeafCull( mleafcull_t *dest, const mleafcull_t *src, unsigned int index )
+{
+	unsigned int i, n = dest->numLeafs++;
+
+	dest->leafs[n] = src->leafs[index];
+	for( i = 0; i < 6; i++ ) {
+		dest->bounds[i * dest->stride + n] = src->bounds[i * src->stride + index];
+	}
+}
+
+/*
+* R_FlattenLeafs
+*
+* Builds the model-wide list of leaf bounds at load time
+*/
+void R_FlattenLeafs( mleafcull_t *lc, mleaf_t **leafs )
+{
+	unsigned int i, n;
+	mleaf_t *leaf;
+
+	for( n = 0; leafs[n]; n++ ) {
+		leaf = leafs[n];
+		lc->leafs[n] = leaf;
+		for( i = 0; i < 3; i++ ) {
+			lc->bounds[i * lc->stride + n] = leaf->mins[i];
+			lc->bounds[( i + 3 ) * lc->stride + n] = leaf->maxs[i];
+		}
+	}
+	lc->numLeafs = n;
+}
+
+/*
+* R_GatherPVSLeafs
+*
+* Copies bounds of all leafs marked by R_MarkLeaves into the compact list
+*/
+static void R_GatherPVSLeafs( mleafcull_t *lc, const mleafcull_t *visleafs, unsigned int pvsframe )
 {
 	unsigned int i;
-	unsigned int dlightBits1;
-	unsigned int shadowBits1;
-	unsigned int bit;
-	const cplane_t *clipplane;
-	mleaf_t	*pleaf;
 
-	while( 1 )
-	{
-		if( node->pvsframe != rf.pvsframecount )
-			return;
+	lc->numLeafs = 0;
+	for( i = 0; i < visleafs->numLeafs; i++ ) {
+		if( visleafs->leafs[i]->pvsframe == pvsframe ) {
+			R_AddLeafCull( lc, visleafs, i );
+		}
+	}
+	lc->pvsframe = pvsframe;
+}
 
-		if( clipFlags )
-		{
-			for( i = sizeof( rn.frustum )/sizeof( rn.frustum[0] ), bit = 1, clipplane = rn.frustum; i > 0; i--, bit<<=1, clipplane++ )
-			{
-				if( clipFlags & bit )
-				{
-					int clipped = BoxOnPlaneSide( node->mins, node->maxs, clipplane );
-					if( clipped == 2 )
-						return;
-					else if( clipped == 1 )
-						clipFlags &= ~bit; // node is entirely on screen
+/*
+* R_CullLeafs
+*
+* Tests leafs in the [first, first + count) range of the list against
+* frustum planes in clipFlags and the light spheres in dlightBits and
+* shadowBits, four leafs at a time. The first leaf must be 4-aligned.
+* Culled leafs are flagged with LEAF_CULLED, otherwise the clip flags
+* only keep the planes the leaf crosses.
+*/
+void R_CullLeafs( mleafcull_t *lc, unsigned int first, unsigned int count, 
+	const cplane_t *frustum, unsigned int clipFlags, unsigned int dlightBits, unsigned int shadowBits )
+{
+	unsigned int i, j, k, bit, last;
+	const unsigned int stride = lc->stride;
+	const float *bounds = lc->bounds;
+	const cplane_t *plane;
+	qf4_t mins[3], maxs[3];
+	qf4_t nearDist, farDist, d, d2, dist;
+	int culled, touched, inside;
+	unsigned int leafClipFlags[4], leafDlightBits[4], leafShadowBits[4];
+
+	assert( !( first & 3 ) );
+
+	last = first + count;
+	for( i = first; i < last; i += 4 ) {
+		for( j = 0; j < 3; j++ ) {
+			mins[j] = qf4_load( bounds + j * stride + i );
+			maxs[j] = qf4_load( bounds + ( j + 3 ) * stride + i );
+		}
+
+		// lanes past the end of the list hold garbage
+		culled = i + 4 > lc->numLeafs ? ( 0xF << ( lc->numLeafs - i ) ) & 0xF : 0;
+
+		for( k = 0; k < 4; k++ ) {
+			leafClipFlags[k] = clipFlags;
+			leafDlightBits[k] = leafShadowBits[k] = 0;
+		}
+
+		for( j = 0, bit = 1, plane = frustum; j < 6; j++, bit <<= 1, plane++ ) {
+			if( !( clipFlags & bit ) ) {
+				continue;
+			}
+
+			// the corner furthest along the normal decides whether the leaf is culled,
+			// the nearest one whether it is entirely in front of the plane
+			farDist = qf4_mul( qf4_splat( plane->normal[0] ), plane->normal[0] >= 0 ? maxs[0] : mins[0] );
+			farDist = qf4_madd( qf4_splat( plane->normal[1] ), plane->normal[1] >= 0 ? maxs[1] : mins[1], farDist );
+			farDist = qf4_madd( qf4_splat( plane->normal[2] ), plane->normal[2] >= 0 ? maxs[2] : mins[2], farDist );
+			nearDist = qf4_mul( qf4_splat( plane->normal[0] ), plane->normal[0] >= 0 ? mins[0] : maxs[0] );
+			nearDist = qf4_madd( qf4_splat( plane->normal[1] ), plane->normal[1] >= 0 ? mins[1] : maxs[1], nearDist );
+			nearDist = qf4_madd( qf4_splat( plane->normal[2] ), plane->normal[2] >= 0 ? mins[2] : maxs[2], nearDist );
+
+			dist = qf4_splat( plane->dist );
+			culled |= qm4_bits( qf4_cmplt( farDist, dist ) );
+			if( culled == 0xF ) {
+				break;
+			}
+
+			inside = qm4_bits( qf4_cmpge( nearDist, dist ) );
+			for( k = 0; k < 4; k++ ) {
+				if( inside & ( 1<<k ) ) {
+					leafClipFlags[k] &= ~bit;
 				}
 			}
 		}
 
-		if( !node->plane )
-			break;
+		if( culled != 0xF ) {
+			// squared distance from the sphere center to the box
+			for( j = 0, bit = 1; dlightBits >= bit && j < rsc.numDlights; j++, bit <<= 1 ) {
+				const dlight_t *dl = rsc.dlights + j;
 
-		dlightBits1 = 0;
-		if( dlightBits )
-		{
-			float dist;
-			unsigned int checkBits = dlightBits;
+				if( !( dlightBits & bit ) ) {
+					continue;
+				}
 
-			for( i = 0, bit = 1; i < rsc.numDlights; i++, bit <<= 1 )
-			{
-				dlight_t *dl = rsc.dlights + i;
-				if( dlightBits & bit )
-				{
-					dist = PlaneDiff( dl->origin, node->plane );
-					if( dist < -dl->intensity )
-						dlightBits &= ~bit;
-					if( dist < dl->intensity )
-						dlightBits1 |= bit;
-
-					checkBits &= ~bit;
-					if( !checkBits )
-						break;
+				d2 = qf4_zero();
+				for( k = 0; k < 3; k++ ) {
+					qf4_t c = qf4_splat( dl->origin[k] );
+					d = qf4_max( qf4_max( qf4_sub( mins[k], c ), qf4_sub( c, maxs[k] ) ), qf4_zero() );
+					d2 = qf4_madd( d, d, d2 );
+				}
+
+				touched = qm4_bits( qf4_cmplt( d2, qf4_splat( dl->intensity * dl->intensity ) ) );
+				for( k = 0; k < 4; k++ ) {
+					if( touched & ( 1<<k ) ) {
+						leafDlightBits[k] |= bit;
+					}
+				}
+			}
+
+			for( j = 0; shadowBits && j < rsc.numShadowGroups; j++ ) {
+				const shadowGroup_t *group = rsc.shadowGroups + j;
+
+				bit = group->bit;
+				if( !( shadowBits & bit ) ) {
+					continue;
+				}
+
+				d2 = qf4_zero();
+				for( k = 0; k < 3; k++ ) {
+					qf4_t c = qf4_splat( group->visOrigin[k] );
+					d = qf4_max( qf4_max( qf4_sub( mins[k], c ), qf4_sub( c, maxs[k] ) ), qf4_zero() );
+					d2 = qf4_madd( d, d, d2 );
+				}
+
+				touched = qm4_bits( qf4_cmplt( d2, qf4_splat( group->visRadius * group->visRadius ) ) );
+				for( k = 0; k < 4; k++ ) {
+					if( touched & ( 1<<k ) ) {
+						leafShadowBits[k] |= bit;
+					}
 				}
 			}
 		}
 
-		shadowBits1 = 0;
-		if( shadowBits )
+		for( k = 0; k < 4; k++ ) {
+			lc->clipFlags[i + k] = ( culled & ( 1<<k ) ) ? LEAF_CULLED : leafClipFlags[k];
+			lc->dlightBits[i + k] = leafDlightBits[k];
+			lc->shadowBits[i + k] = leafShadowBits[k];
+		}
+	}
+}
+
+#define LEAFS_PER_JOB	256		// must be a multiple of 4
+
+typedef struct
+{
+	mleafcull_t		*lc;
+	const cplane_t	*frustum;
+	unsigned int	clipFlags;
+	unsigned int	dlightBits;
+	unsigned int	shadowBits;
+} leafCullJob_t;
+
+/*
+* R_CullLeafsJob
+*/
+static void R_CullLeafsJob( void *arg, unsigned int first, unsigned int count, int worker )
+{
+	leafCullJob_t *job = arg;
+	R_CullLeafs( job->lc, first, count, job->frustum, job->clipFlags, job->dlightBits, job->shadowBits );
+}
+
+/*
+* R_MarkVisibleLeafs
+*
+* Adds surfaces of the leafs that survived R_CullLeafs to the draw list
+*/
+static void R_MarkVisibleLeafs( const mleafcull_t *lc )
+{
+	unsigned int i, j;
+	unsigned int clipFlags;
+	mleaf_t *pleaf;
+	const byte_vec4_t color = { 255, 0, 0, 255 };
+	bool leafvis = r_leafvis->integer && !( rn.renderFlags & RF_NONVIEWERREF );
+
+	for( i = 0; i < lc->numLeafs; i++ ) {
+		clipFlags = lc->clipFlags[i];
+		if( clipFlags == LEAF_CULLED ) {
+			continue;
+		}
+
+		pleaf = lc->leafs[i];
+		pleaf->visframe = rf.frameCount;
+
+		// add leaf bounds to view bounds
+		for( j = 0; j < 3; j++ )
 		{
-			float dist;
-			unsigned int checkBits = shadowBits;
+			rn.visMins[j] = min( rn.visMins[j], pleaf->mins[j] );
+			rn.visMaxs[j] = max( rn.visMaxs[j], pleaf->maxs[j] );
+		}
 
-			for( i = 0; i < rsc.numShadowGroups; i++ )
-			{
-				shadowGroup_t *group = rsc.shadowGroups + i;
-				bit = group->bit;
-				if( checkBits & bit )
-				{
-					dist = PlaneDiff( group->visOrigin, node->plane );
-					if( dist < -group->visRadius )
-						shadowBits &= ~bit;
-					if( dist < group->visRadius )
-						shadowBits1 |= bit;
-
-					checkBits &= ~bit;
-					if( !checkBits )
-						break;
+		rn.dlightBits |= lc->dlightBits[i];
+		rn.shadowBits |= lc->shadowBits[i];
+
+		R_MarkLeafSurfaces( pleaf->firstVisSurface, clipFlags, lc->dlightBits[i], lc->shadowBits[i] );
+		rf.stats.c_world_leafs++;
+
+		if( leafvis ) {
+			R_AddDebugBounds( pleaf->mins, pleaf->maxs, color );
+		}
+	}
+}
+
+//==================================================================================
+
+#define MAX_CULLBENCH_VIEWS	1024
+
+typedef struct
+{
+	refdef_t		refdef;
+	float			farClip;
+	unsigned int	clipFlags;
+} cullBenchView_t;
+
+static struct
+{
+	int				worldModelSequence;
+	int				numViews;
+	cullBenchView_t	*views;
+
+	volatile int	recordViews;		// set by R_CullBench_f, consumed in R_DrawWorld
+	volatile int	iterations;
+} r_cullbench;
+
+/*
+* R_CullBenchReferenceLeafs
+*
+* Straightforward per-leaf version of R_CullLeafs for the frustum planes only
+*/
+static void R_CullBenchReferenceLeafs( const mleafcull_t *lc, const cplane_t *frustum, 
+	unsigned int clipFlags, uint8_t *leafClipFlags )
+{
+	unsigned int i, j, bit;
+	unsigned int flags;
+	vec3_t mins, maxs;
+
+	for( i = 0; i < lc->numLeafs; i++ ) {
+		for( j = 0; j < 3; j++ ) {
+			mins[j] = lc->bounds[j * lc->stride + i];
+			maxs[j] = lc->bounds[( j + 3 ) * lc->stride + i];
+		}
+
+		flags = clipFlags;
+		for( j = 0, bit = 1; j < 6; j++, bit <<= 1 ) {
+			if( flags & bit ) {
+				int clipped = BoxOnPlaneSide( mins, maxs, frustum + j );
+				if( clipped == 2 ) {
+					flags = LEAF_CULLED;
+					break;
+				}
+				if( clipped == 1 ) {
+					flags &= ~bit;
 				}
 			}
 		}
+		leafClipFlags[i] = flags;
+	}
+}
+
+/*
+* R_BenchmarkWorldCull
+*
+* Culls the world from all recorded view positions with R_CullLeafs and
+* with the reference implementation, without drawing anything
+*/
+static void R_BenchmarkWorldCull( int iterations )
+{
+	int i, it;
+	unsigned int j;
+	int cluster, mismatches;
+	uint64_t start, cullTime, refTime;
+	double numPVSLeafs, numVisLeafs;
+	const mleafcull_t *visleafs = &rsh.worldBrushModel->visleafcull;
+	mleafcull_t lc;
+	uint8_t *buffer, *refClipFlags;
+	uint8_t *pvs;
+	cplane_t frustum[6];
+
+	buffer = R_Malloc( R_LeafCullSize( visleafs->numLeafs, true ) + visleafs->numLeafs );
+	R_InitLeafCull( &lc, visleafs->numLeafs, true, buffer );
+	refClipFlags = buffer + R_LeafCullSize( visleafs->numLeafs, true );
+
+	mismatches = 0;
+	cullTime = refTime = 0;
+	numPVSLeafs = numVisLeafs = 0;
 
-		R_RecursiveWorldNode( node->children[0], clipFlags, dlightBits, shadowBits );
+	for( i = 0; i < r_cullbench.numViews; i++ ) {
+		const cullBenchView_t *view = r_cullbench.views + i;
+
+		R_SetupFrustum( &view->refdef, view->farClip, frustum );
+
+		// areabits are not recorded so the PVS may be slightly larger than in game
+		cluster = Mod_PointInLeaf( ( float * )view->refdef.vieworg, rsh.worldModel )->cluster;
+		pvs = cluster >= 0 && rsh.worldBrushModel->pvs ? Mod_ClusterPVS( cluster, rsh.worldModel ) : NULL;
+
+		lc.numLeafs = 0;
+		for( j = 0; j < visleafs->numLeafs; j++ ) {
+			cluster = visleafs->leafs[j]->cluster;
+			if( !pvs || ( pvs[cluster>>3] & ( 1<<( cluster&7 ) ) ) ) {
+				R_AddLeafCull( &lc, visleafs, j );
+			}
+		}
+		numPVSLeafs += lc.numLeafs;
 
-		node = node->children[1];
-		dlightBits = dlightBits1;
-		shadowBits = shadowBits1;
+		start = ri.Sys_Microseconds();
+		for( it = 0; it < iterations; it++ ) {
+			R_CullLeafs( &lc, 0, lc.numLeafs, frustum, view->clipFlags, 0, 0 );
+		}
+		cullTime += ri.Sys_Microseconds() - start;
+
+		start = ri.Sys_Microseconds();
+		for( it = 0; it < iterations; it++ ) {
+			R_CullBenchReferenceLeafs( &lc, frustum, view->clipFlags, refClipFlags );
+		}
+		refTime += ri.Sys_Microseconds() - start;
+
+		for( j = 0; j < lc.numLeafs; j++ ) {
+			if( lc.clipFlags[j] != LEAF_CULLED ) {
+				numVisLeafs++;
+			}
+			if( lc.clipFlags[j] != refClipFlags[j] ) {
+				mismatches++;
+			}
+		}
 	}
 
-	// if a leaf node, draw stuff
-	pleaf = ( mleaf_t * )node;
-	pleaf->visframe = rf.frameCount;
+	R_Free( buffer );
 
-	// add leaf bounds to view bounds
-	for( i = 0; i < 3; i++ )
-	{
-		rn.visMins[i] = min( rn.visMins[i], pleaf->mins[i] );
-		rn.visMaxs[i] = max( rn.visMaxs[i], pleaf->maxs[i] );
+	Com_Printf( "Culled %i views %i times, %.1f leafs in PVS and %.1f visible per view\n", 
+		r_cullbench.numViews, iterations, numPVSLeafs / r_cullbench.numViews, numVisLeafs / r_cullbench.numViews );
+	Com_Printf( "%s: %.3f usec/view, reference: %.3f usec/view, %s%i mismatches\n", QSIMD_NAME,
+		(double)cullTime / ( r_cullbench.numViews * iterations ), (double)refTime / ( r_cullbench.numViews * iterations ),
+		mismatches ? S_COLOR_RED : "", mismatches );
+}
+
+/*
+* R_CullBenchFrame
+*
+* Records the main view and runs pending benchmarks from the frontend
+*/
+static void R_CullBenchFrame( void )
+{
+	int iterations;
+	cullBenchView_t *view;
+
+	if( rn.renderFlags & RF_NONVIEWERREF ) {
+		return;
 	}
 
-	rn.dlightBits |= dlightBits;
-	rn.shadowBits |= shadowBits;
+	if( r_cullbench.worldModelSequence != rsh.worldModelSequence ) {
+		r_cullbench.worldModelSequence = rsh.worldModelSequence;
+		r_cullbench.numViews = 0;
+	}
 
-	R_MarkLeafSurfaces( pleaf->firstVisSurface, clipFlags, dlightBits, shadowBits );
-	rf.stats.c_world_leafs++;
+	if( r_cullbench.recordViews ) {
+		if( !r_cullbench.views ) {
+			r_cullbench.views = R_Malloc( MAX_CULLBENCH_VIEWS * sizeof( *r_cullbench.views ) );
+		}
+		if( r_cullbench.recordViews < 0 ) {
+			// restart
+			r_cullbench.numViews = 0;
+			r_cullbench.recordViews = -r_cullbench.recordViews;
+		}
 
-	if( r_leafvis->integer && !( rn.renderFlags & RF_NONVIEWERREF ) )
-	{
-		const byte_vec4_t color = { 255, 0, 0, 255 };
-		R_AddDebugBounds( pleaf->mins, pleaf->maxs, color );
+		view = &r_cullbench.views[r_cullbench.numViews++];
+		view->refdef = rn.refdef;
+		view->refdef.areabits = NULL;
+		view->farClip = rn.farClip;
+		view->clipFlags = rn.clipFlags;
+
+		if( --r_cullbench.recordViews == 0 || r_cullbench.numViews == MAX_CULLBENCH_VIEWS ) {
+			Com_Printf( "Recorded %i views\n", r_cullbench.numViews );
+			r_cullbench.recordViews = 0;
+		}
+	}
+
+	iterations = r_cullbench.iterations;
+	if( iterations ) {
+		r_cullbench.iterations = 0;
+		if( !r_cullbench.numViews ) {
+			Com_Printf( "No views recorded on this map\n" );
+		} else {
+			R_BenchmarkWorldCull( iterations );
+		}
+	}
+}
+
+/*
+* R_CullBench_f
+*
+* r_cullbench record [frames] - record main view positions
+* r_cullbench run [iterations] - cull the world from recorded views
+*/
+void R_CullBench_f( void )
+{
+	const char *cmd = ri.Cmd_Argv( 1 );
+	int count;
+
+	if( ri.Cmd_Argc() < 2 ) {
+		Com_Printf( "Usage: %s <record [frames]|run [iterations]>\n", ri.Cmd_Argv( 0 ) );
+		return;
+	}
+
+	count = ri.Cmd_Argc() > 2 ? atoi( ri.Cmd_Argv( 2 ) ) : 0;
+
+	if( !Q_stricmp( cmd, "record" ) ) {
+		r_cullbench.recordViews = -bound( 1, count ? count : 300, MAX_CULLBENCH_VIEWS );
+	} else if( !Q_stricmp( cmd, "run" ) ) {
+		r_cullbench.iterations = max( count ? count : 100, 1 );
+	} else {
+		Com_Printf( "Usage: %s <record [frames]|run [iterations]>\n", ri.Cmd_Argv( 0 ) );
 	}
 }
 
@@ -691,6 +1061,8 @@ void R_DrawWorld( void )
 	unsigned int dlightBits;
 	unsigned int shadowBits;
 	bool worldOutlines;
+	mleafcull_t *lc;
+	leafCullJob_t job;
 
 	if( !r_drawworld->integer )
 		return;
@@ -742,10 +1114,25 @@ void R_DrawWorld( void )
 	rn.dlightBits = dlightBits;
 	rn.shadowBits = shadowBits;
 
+	R_CullBenchFrame();
+
 	if( r_speeds->integer )
 		msec = ri.Sys_Milliseconds();
 
-	R_RecursiveWorldNode( rsh.worldBrushModel->nodes, clipFlags, dlightBits, shadowBits );
+	lc = &rsh.worldBrushModel->pvsleafcull;
+	if( lc->pvsframe != rf.pvsframecount ) {
+		R_GatherPVSLeafs( lc, &rsh.worldBrushModel->visleafcull, rf.pvsframecount );
+	}
+
+	// leafs are numbered in BSP order so each job gets a few neighbouring subtrees
+	job.lc = lc;
+	job.frustum = rn.frustum;
+	job.clipFlags = clipFlags;
+	job.dlightBits = dlightBits;
+	job.shadowBits = shadowBits;
+	R_ParallelFor( lc->numLeafs, LEAFS_PER_JOB, R_CullLeafsJob, &job );
+
+	R_MarkVisibleLeafs( lc );
 
 	if( r_speeds->integer )
 		rf.stats.t_world_node += ri.Sys_Milliseconds() - msec;
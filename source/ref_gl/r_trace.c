@@ -144,9 +144,9 @@ static int R_TraceAgainstLeaf( mleaf_t *leaf )
 		do
 		{
 			surf = *mark++;
-			if( surf->fragmentframe == r_traceframecount )
+			if( surf->traceframe == r_traceframecount )
 				continue;	// do not test the same surface more than once
-			surf->fragmentframe = r_traceframecount;
+			surf->traceframe = r_traceframecount;
 
 			if( surf->flags & trace_umask )
 				continue;
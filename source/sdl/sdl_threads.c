@@ -112,6 +112,14 @@ void Sys_Thread_Yield( void )
 	Sys_Sleep(0);
 }
 
+/*
+* Sys_Thread_NumProcessors
+*/
+int Sys_Thread_NumProcessors( void )
+{
+	return max( SDL_GetCPUCount(), 1 );
+}
+
 /*
 * Sys_Atomic_Add
 */
@@ -30,6 +30,8 @@
 
 #define USERINFO_UPDATE_COOLDOWN_MSEC	2000
 
+#define SV_MAX_INSTANCES				64 // upper bound for sv_instances
+
 typedef enum
 {
 	ss_dead,        // no map loaded
@@ -103,6 +105,7 @@ typedef struct
 	unsigned int sentTimeStamp;         // time at what this frame snap was sent to the clients
 	unsigned int UcmdExecuted;
 	game_state_t gameState;
+	unsigned int sharedId;				// nonzero if several clients got a copy of the same frame
 } client_snapshot_t;
 
 typedef struct
@@ -255,12 +258,28 @@ typedef struct fatvis_s
 	uint8_t phs[MAX_MAP_LEAFS/8];
 } fatvis_t;
 
+#define SV_TICK_JITTER_BUCKETS	10
+
+// lateness of world frames and snapshots relative to when the scheduler meant to run them
+typedef struct
+{
+	unsigned int count;
+	unsigned int early;
+	unsigned int buckets[SV_TICK_JITTER_BUCKETS];
+	uint64_t totalUsec;
+	uint64_t maxUsec;
+} sv_tickjitter_t;
+
 typedef struct
 {
 	bool initialized;               // sv_init has completed
 	unsigned int realtime;                  // real world time - always increasing, no clamping, etc
 	unsigned int gametime;                  // game world time - always increasing, no clamping, etc
 
+	uint64_t clockUsec;					// Sys_Microseconds at the millisecond the current frame stands for
+	uint64_t tickDeadline;				// when the next world frame or snapshot is due, 0 if unknown
+	sv_tickjitter_t tickJitter;
+
 	socket_t socket_udp;
 	socket_t socket_udp6;
 	socket_t socket_loopback;
@@ -304,6 +323,8 @@ typedef struct
 	bool autostarted;
 	unsigned int lastMasterResolve;
 	unsigned int autoUpdateMinute;	// the minute number we should run the autoupdate check, in the range 0 to 59
+	int instance;					// index of this process among sv_instances, 0 for the first one
+	bool instancesSpawned;
 } server_constant_t;
 
 //=============================================================================
@@ -371,6 +392,7 @@ extern cvar_t *sv_MOTDFile;
 extern cvar_t *sv_MOTDString;
 extern cvar_t *sv_lastAutoUpdate;
 extern cvar_t *sv_defaultmap;
+extern cvar_t *sv_instances;
 
 extern cvar_t *sv_demodir;
 
@@ -404,6 +426,7 @@ void SVC_MasterInfoResponse( const socket_t *socket, const netadr_t *address );
 int SVC_FakeConnect( char *fakeUserinfo, char *fakeSocketType, const char *fakeIP );
 
 void SV_UpdateActivity( void );
+void SV_TickJitter_f( void );
 
 //
 // sv_oob.c
@@ -403,6 +403,53 @@ static void SV_CvarCheck_f( void )
 	SV_SendServerCommand( client, "cvarinfo \"%s\"", Cmd_Argv( 2 ) );
 }
 
+/*
+* SV_InstanceMem_f
+*
+* Reports the memory used by this server instance and estimates how many
+* instances fit in physical memory. Pages shared with the binary, libraries
+* and the other instances started by sv_instances are only counted once.
+*/
+static void SV_InstanceMem_f( void )
+{
+	static const char *sharedPools[] = { "Collision Map", "Filesystem", "Zip VFS", NULL };
+	static const char *instancePools[] = { "Server", "Game Progs", "Angel Script Module", NULL };
+	size_t resident, unique, shared, physical;
+	size_t size;
+	int i;
+
+	Com_Printf( "instance %i of %i, pid %i\n", svc.instance, max( sv_instances->integer, 1 ), Sys_GetCurrentProcessId() );
+
+	Com_Printf( "shared with other instances:\n" );
+	for( i = 0; sharedPools[i]; i++ )
+	{
+		size = Mem_NamedPoolTotalSize( sharedPools[i] );
+		Com_Printf( "%8uk %s\n", (unsigned)( ( size + 1023 ) / 1024 ), sharedPools[i] );
+	}
+
+	Com_Printf( "per instance:\n" );
+	for( i = 0; instancePools[i]; i++ )
+	{
+		size = Mem_NamedPoolTotalSize( instancePools[i] );
+		Com_Printf( "%8uk %s\n", (unsigned)( ( size + 1023 ) / 1024 ), instancePools[i] );
+	}
+
+	if( !Sys_GetMemoryUsage( &resident, &unique, &physical ) || !unique )
+	{
+		Com_Printf( "Process memory usage is not available on this system\n" );
+		return;
+	}
+
+	shared = resident - unique;
+	Com_Printf( "resident %uk, unique %uk, shared %uk, physical %uM\n",
+		(unsigned)( resident / 1024 ), (unsigned)( unique / 1024 ),
+		(unsigned)( shared / 1024 ), (unsigned)( physical / ( 1024 * 1024 ) ) );
+
+	// the shared pages are paid for once, every instance adds its unique ones
+	if( shared < physical )
+		Com_Printf( "~%u instances fit in physical memory\n", (unsigned)( ( physical - shared ) / unique ) );
+}
+
 //===========================================================
 
 /*
@@ -435,6 +482,9 @@ void SV_InitOperatorCommands( void )
 
 	Cmd_AddCommand( "cvarcheck", SV_CvarCheck_f );
 
+	Cmd_AddCommand( "tickjitter", SV_TickJitter_f );
+	Cmd_AddCommand( "instancemem", SV_InstanceMem_f );
+
 	Cmd_SetCompletionFunc( "map", SV_MapComplete_f );
 	Cmd_SetCompletionFunc( "devmap", SV_MapComplete_f );
 	Cmd_SetCompletionFunc( "gamemap", SV_MapComplete_f );
@@ -469,4 +519,7 @@ void SV_ShutdownOperatorCommands( void )
 	}
 
 	Cmd_RemoveCommand( "cvarcheck" );
+
+	Cmd_RemoveCommand( "tickjitter" );
+	Cmd_RemoveCommand( "instancemem" );
 }
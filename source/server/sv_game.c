@@ -483,6 +483,7 @@ void SV_InitGameProgs( void )
 	import.CM_LeafArea = PF_CM_LeafArea;
 
 	import.Milliseconds = Sys_Milliseconds;
+	import.Microseconds = Sys_Microseconds;
 
 	import.ModelIndex = SV_ModelIndex;
 	import.SoundIndex = SV_SoundIndex;
@@ -514,6 +515,18 @@ void SV_InitGameProgs( void )
 	import.Mem_Alloc = PF_MemAlloc;
 	import.Mem_Free = PF_MemFree;
 
+	import.Thread_Create = QThread_Create;
+	import.Thread_Join = QThread_Join;
+	import.Mutex_Create = QMutex_Create;
+	import.Mutex_Destroy = QMutex_Destroy;
+	import.Mutex_Lock = QMutex_Lock;
+	import.Mutex_Unlock = QMutex_Unlock;
+
+	import.Jobs_Add = QJobs_Add;
+	import.Jobs_Wait = QJobs_Wait;
+	import.Jobs_ParallelFor = QJobs_ParallelFor;
+	import.Jobs_NumWorkers = QJobs_NumWorkers;
+
 	import.Dynvar_Create = Dynvar_Create;
 	import.Dynvar_Destroy = Dynvar_Destroy;
 	import.Dynvar_Lookup = Dynvar_Lookup;
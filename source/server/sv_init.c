@@ -259,6 +259,8 @@ static void SV_SpawnServer( const char *server, bool devmap )
 	SV_ResetClientFrameCounters();
 	svs.realtime = 0;
 	svs.gametime = 0;
+	svs.clockUsec = 0;
+	svs.tickDeadline = 0;
 	SV_UpdateActivity();
 
 	Q_strncpyz( sv.mapname, server, sizeof( sv.mapname ) );
@@ -309,6 +311,82 @@ static void SV_SpawnServer( const char *server, bool devmap )
 	Com_Printf( "-------------------------------------\n" );
 }
 
+/*
+* SV_SpawnInstances
+* 
+* With sv_instances above 1, a dedicated server forks into that many processes
+* before the first map is started. The pack file index, the collision map of
+* that map and everything else loaded up to this point is shared between the
+* instances until one of them writes to it. Every instance then runs its own
+* game on sv_port plus its index, and its own web server on sv_http_port plus
+* its index. Changing the map in an instance loads a private copy of the new
+* collision map.
+*/
+static void SV_SpawnInstances( const char *level )
+{
+	int i, pid, numInstances;
+	unsigned checksum;
+	char name[MAX_CONFIGSTRING_CHARS];
+
+	if( svc.instancesSpawned )
+		return;
+	svc.instancesSpawned = true;
+
+	numInstances = bound( 1, sv_instances->integer, SV_MAX_INSTANCES );
+	if( !dedicated->integer || numInstances < 2 )
+		return;
+
+	Cvar_GetLatchedVars( CVAR_LATCH );
+
+	// loaded once so that all instances point at the same pages
+	svs.cms = CM_New( NULL );
+	CM_AddReference( svs.cms );
+	Q_snprintfz( name, sizeof( name ), "maps/%s.bsp", level );
+	CM_LoadMap( svs.cms, name, false, &checksum );
+
+	// worker threads and the web server thread don't survive fork
+	SV_Web_Shutdown();
+	QJobs_Shutdown();
+
+	for( i = 1; i < numInstances; i++ )
+	{
+		pid = Sys_ForkInstance();
+		if( pid < 0 )
+		{
+			Com_Printf( "Couldn't start server instance %i\n", i );
+			break;
+		}
+		if( !pid )
+		{
+			svc.instance = i;
+			break;
+		}
+	}
+
+	QJobs_Init();
+
+	if( svc.instance )
+	{
+		Cvar_ForceSet( "sv_port", va( "%i", sv_port->integer + svc.instance ) );
+		Cvar_ForceSet( "sv_port6", va( "%i", sv_port6->integer + svc.instance ) );
+#ifdef HTTP_SUPPORT
+		Cvar_ForceSet( "sv_http_port", va( "%i", sv_http_port->integer + svc.instance ) );
+#endif
+
+		// the log file descriptor is shared with the first instance
+		Q_strncpyz( name, Cvar_String( "logconsole" ), sizeof( name ) );
+		if( name[0] )
+		{
+			COM_StripExtension( name );
+			Cvar_ForceSet( "logconsole", va( "%s_%i.log", name, svc.instance ) );
+		}
+	}
+
+	SV_Web_Init();
+
+	Com_Printf( "Server instance %i, pid %i, port %i\n", svc.instance, Sys_GetCurrentProcessId(), sv_port->integer );
+}
+
 /*
 * SV_InitGame
 * A brand new game has been started
@@ -458,10 +536,12 @@ void SV_InitGame( void )
 		svs.clients[i].edict = ent;
 	}
 
-	// load the map
-	assert( !svs.cms );
-	svs.cms = CM_New( NULL );
-	CM_AddReference( svs.cms );
+	// load the map, SV_SpawnInstances may have done so already
+	if( !svs.cms )
+	{
+		svs.cms = CM_New( NULL );
+		CM_AddReference( svs.cms );
+	}
 
 	// keep CPU awake
 	assert( !svs.wakelock );
@@ -601,7 +681,10 @@ void SV_Map( const char *level, bool devmap )
 		level++;
 
 	if( sv.state == ss_dead )
+	{
+		SV_SpawnInstances( level );
 		SV_InitGame(); // the game is just starting
+	}
 
 	// remove all bots before changing map
 	for( i = 0, cl = svs.clients; i < sv_maxclients->integer; i++, cl++ )
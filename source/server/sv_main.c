@@ -73,6 +73,7 @@ cvar_t *sv_highchars;
 cvar_t *sv_hostname;
 cvar_t *sv_public;         // should heartbeats be sent
 cvar_t *sv_defaultmap;
+cvar_t *sv_instances;
 
 cvar_t *sv_iplimit;
 
@@ -470,6 +471,74 @@ static void SV_CheckLatchedUserinfoChanges( void )
 //#define WORLDFRAMETIME 25 // 40fps
 //#define WORLDFRAMETIME 20 // 50fps
 #define WORLDFRAMETIME 16 // 62.5fps
+// upper bounds of the tick jitter histogram buckets in microseconds
+static const unsigned int sv_tickJitterBounds[SV_TICK_JITTER_BUCKETS - 1] =
+{
+	50, 100, 250, 500, 1000, 2000, 5000, 10000, 20000
+};
+
+/*
+* SV_RecordTickJitter
+*/
+static void SV_RecordTickJitter( int64_t lateUsec )
+{
+	int i;
+	sv_tickjitter_t *jitter = &svs.tickJitter;
+
+	jitter->count++;
+	if( lateUsec < 0 )
+	{
+		jitter->early++;
+		lateUsec = 0;
+	}
+
+	jitter->totalUsec += lateUsec;
+	jitter->maxUsec = max( jitter->maxUsec, (uint64_t)lateUsec );
+
+	for( i = 0; i < SV_TICK_JITTER_BUCKETS - 1; i++ )
+	{
+		if( lateUsec < sv_tickJitterBounds[i] )
+			break;
+	}
+	jitter->buckets[i]++;
+}
+
+/*
+* SV_TickJitter_f
+*
+* Prints how late world frames and snapshots ran compared to the time the
+* dedicated server scheduled them for
+*/
+void SV_TickJitter_f( void )
+{
+	int i;
+	unsigned int lower;
+	sv_tickjitter_t *jitter = &svs.tickJitter;
+
+	if( Cmd_Argc() > 1 && !Q_stricmp( Cmd_Argv( 1 ), "reset" ) )
+	{
+		memset( jitter, 0, sizeof( *jitter ) );
+		return;
+	}
+
+	if( !jitter->count )
+	{
+		Com_Printf( "No scheduled ticks recorded\n" );
+		return;
+	}
+
+	Com_Printf( "%u ticks, %u early, average %.1f us late, max %u us\n", jitter->count, jitter->early,
+		(double)jitter->totalUsec / jitter->count, (unsigned)jitter->maxUsec );
+
+	for( i = 0, lower = 0; i < SV_TICK_JITTER_BUCKETS - 1; lower = sv_tickJitterBounds[i++] )
+	{
+		Com_Printf( "%6u - %6u us: %8u (%5.1f%%)\n", lower, sv_tickJitterBounds[i], jitter->buckets[i],
+			100.0 * jitter->buckets[i] / jitter->count );
+	}
+	Com_Printf( "%6u+         us: %8u (%5.1f%%)\n", lower, jitter->buckets[i],
+		100.0 * jitter->buckets[i] / jitter->count );
+}
+
 /*
 * SV_RunGameFrame
 */
@@ -498,14 +567,20 @@ static bool SV_RunGameFrame( int msec )
 		refreshGameModule = true;
 	}
 
-	// if there aren't pending packets to be sent, we can sleep
-	if( dedicated->integer && !sentFragments && !refreshSnapshot )
+	// if there aren't pending packets to be sent, sleep until the next world frame
+	// or snapshot is due, or until a packet arrives on any of the server sockets
+	if( dedicated->integer && !sentFragments && !refreshGameModule )
 	{
-		int sleeptime = min( WORLDFRAMETIME - ( accTime + 1 ), sv.nextSnapTime - ( svs.gametime + 1 ) );
+		int sleeptime = min( WORLDFRAMETIME - (int)accTime, (int)( sv.nextSnapTime - svs.gametime ) );
 
 		if( sleeptime > 0 )
 		{
-			socket_t *sockets [] = { &svs.socket_udp, &svs.socket_udp6 };
+			uint64_t now;
+			socket_t *sockets [] = { &svs.socket_udp, &svs.socket_udp6,
+#ifdef TCP_ALLOW_CONNECT
+				&svs.socket_tcp, &svs.socket_tcp6,
+#endif
+			};
 			socket_t *opened_sockets [sizeof( sockets ) / sizeof( sockets[0] ) + 1 ];
 			size_t sock_ind, open_ind;
 
@@ -522,7 +597,13 @@ static bool SV_RunGameFrame( int msec )
 			}
 			opened_sockets[open_ind] = NULL;
 
-			NET_Sleep( sleeptime, opened_sockets );
+			// the main loop hands out whole milliseconds, so the frame runs as soon as
+			// the clock reaches the millisecond it is due at
+			svs.tickDeadline = svs.clockUsec + (uint64_t)sleeptime * 1000;
+
+			now = Sys_Microseconds();
+			if( svs.tickDeadline > now )
+				NET_SleepMicroseconds( svs.tickDeadline - now, opened_sockets );
 		}
 	}
 
@@ -546,6 +627,12 @@ static bool SV_RunGameFrame( int msec )
 			accTime = 0;
 		}
 
+		if( svs.tickDeadline )
+		{
+			SV_RecordTickJitter( (int64_t)( Sys_Microseconds() - svs.tickDeadline ) );
+			svs.tickDeadline = 0;
+		}
+
 		if( host_speeds->integer )
 			time_before_game = Sys_Milliseconds();
 
@@ -762,6 +849,13 @@ void SV_Frame( int realmsec, int gamemsec )
 	svs.realtime += realmsec;
 	svs.gametime += gamemsec;
 
+	// keep a microsecond clock in step with the whole milliseconds we are fed,
+	// resyncing if it ever gets ahead of the real one
+	if( svs.clockUsec )
+		svs.clockUsec += (uint64_t)realmsec * 1000;
+	if( !svs.clockUsec || svs.clockUsec > Sys_Microseconds() )
+		svs.clockUsec = Sys_Microseconds() / 1000 * 1000;
+
 	// advance to next map if the server is running for too long (numbers taken from q3 src)
 	if( svs.realtime > wrappingPoint || svs.gametime > wrappingPoint || sv.framenum >= wrappingPoint )
 	{
@@ -990,6 +1084,7 @@ void SV_Init( void )
 	sv_pure_forcemodulepk3 =    Cvar_Get( "sv_pure_forcemodulepk3", "", CVAR_LATCH );
 
 	sv_defaultmap =		    Cvar_Get( "sv_defaultmap", "wfdm1", CVAR_ARCHIVE );
+	sv_instances =		    Cvar_Get( "sv_instances", "1", CVAR_NOSET );
 	sv_reconnectlimit =	    Cvar_Get( "sv_reconnectlimit", "3", CVAR_ARCHIVE );
 	sv_maxclients =		    Cvar_Get( "sv_maxclients", "16", CVAR_ARCHIVE | CVAR_SERVERINFO | CVAR_LATCH );
 	sv_maxmvclients =	    Cvar_Get( "sv_maxmvclients", "4", CVAR_ARCHIVE | CVAR_SERVERINFO );
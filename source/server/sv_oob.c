@@ -649,6 +649,7 @@ static void SVC_DirectConnect( const socket_t *socket, const netadr_t *address )
 	char *session_id_str;
 	unsigned int ticket_id;
 	bool tv_client;
+	bool dictionary;
 	unsigned int time;
 
 	Com_DPrintf( "SVC_DirectConnect (%s)\n", Cmd_Args() );
@@ -673,6 +674,7 @@ static void SVC_DirectConnect( const socket_t *socket, const netadr_t *address )
 	game_port = atoi( Cmd_Argv( 2 ) );
 	challenge = atoi( Cmd_Argv( 3 ) );
 	tv_client = ( atoi( Cmd_Argv( 5 ) ) & 1 ? true : false );
+	dictionary = ( ( atoi( Cmd_Argv( 5 ) ) >> NETCHAN_DICTIONARY_SHIFT ) == NETCHAN_DICTIONARY_VERSION );
 
 	if( !Info_Validate( Cmd_Argv( 4 ) ) )
 	{
@@ -861,8 +863,12 @@ static void SVC_DirectConnect( const socket_t *socket, const netadr_t *address )
 		return;
 	}
 
+	// only use the preset compression dictionary if the client has the same one
+	newcl->netchan.dictionaryCompression = dictionary;
+
 	// send the connect packet to the client
-	Netchan_OutOfBandPrint( socket, address, "client_connect\n%s", newcl->session );
+	Netchan_OutOfBandPrint( socket, address, "client_connect\n%s\n%i", newcl->session, 
+		dictionary ? NETCHAN_DICTIONARY_VERSION : 0 );
 
 	// free the incoming entry
 #ifdef TCP_ALLOW_CONNECT
@@ -299,7 +299,7 @@ bool SV_Netchan_Transmit( netchan_t *netchan, msg_t *msg )
 
 	if( sv_compresspackets->integer )
 	{
-		zerror = Netchan_CompressMessage( msg );
+		zerror = Netchan_CompressMessage( netchan, msg );
 		if( zerror < 0 )
 		{          // it's compression error, just send uncompressed
 			Com_DPrintf( "SV_Netchan_Transmit (ignoring compression): Compression error %i\n", zerror );
@@ -370,7 +370,7 @@ void SV_ResetClientFrameCounters( void )
 void SV_WriteFrameSnapToClient( client_t *client, msg_t *msg )
 {
 	SNAP_WriteFrameSnapToClient( &sv.gi, client, msg, sv.framenum, svs.gametime, sv.baselines,
-		&svs.client_entities, 0, NULL, NULL );
+		&svs.client_entities, 0, NULL, NULL, NULL );
 }
 
 /*
@@ -107,13 +107,13 @@ static void S_SoundList_f( void )
 		sc = sfx->cache;
 		if( sc )
 		{
-			size = sc->length*sc->width*sc->channels;
+			size = S_SoundCacheSize( sc );
 			total += size;
 			if( sc->loopstart < sc->length )
 				Com_Printf( "L" );
 			else
 				Com_Printf( " " );
-			Com_Printf( "(%2db) %6i : %s\n", sc->width*8, size, sfx->name );
+			Com_Printf( "(%2db%s) %6i : %s\n", sc->width*8, sc->compressed ? " adpcm" : "", size, sfx->name );
 		}
 		else
 		{
@@ -148,6 +148,8 @@ static bool S_Init( void *hwnd, int maxEntities, bool verbose )
 
 	S_InitScaletable();
 
+	S_InitSoundCache();
+
 	// highfrequency attenuation filter
 	s_lpf_cw = S_LowpassCW( HQ_HF_FREQUENCY, dma.speed );
 
@@ -175,6 +177,8 @@ static void S_Shutdown( bool verbose )
 	
 	S_FreeRawSounds();
 
+	S_ShutdownSoundCache();
+
 	SNDDMA_Shutdown( verbose );
 
 	SNDOGG_Shutdown( verbose );
@@ -1215,6 +1219,59 @@ static void S_Update_()
 	SNDDMA_Submit();
 }
 
+/*
+* S_CompareChannelVolume
+*
+* Loudest channels first, ties are broken by channel index to keep the
+* selection stable between updates
+*/
+static int S_CompareChannelVolume( const void *a, const void *b )
+{
+	const channel_t *ch1 = *( const channel_t ** )a;
+	const channel_t *ch2 = *( const channel_t ** )b;
+	int vol1 = ch1->leftvol + ch1->rightvol;
+	int vol2 = ch2->leftvol + ch2->rightvol;
+
+	if( vol1 != vol2 )
+		return vol2 - vol1;
+	return ch1 - ch2;
+}
+
+/*
+* S_VirtualizeChannels
+*
+* Channels that are too quiet to be heard or that fall off the end of the
+* s_maxvoices budget keep their playback position but are not mixed until
+* they get loud enough again. Returns the number of mixed channels.
+*/
+int S_VirtualizeChannels( void )
+{
+	int i, numActive;
+	channel_t *ch;
+	channel_t *active[MAX_CHANNELS];
+
+	numActive = 0;
+	for( i = 0, ch = channels; i < MAX_CHANNELS; i++, ch++ )
+	{
+		if( !ch->sfx )
+			continue;
+
+		ch->virtualized = max( ch->leftvol, ch->rightvol ) < s_virtualvolume->integer;
+		if( !ch->virtualized )
+			active[numActive++] = ch;
+	}
+
+	if( s_maxvoices->integer > 0 && numActive > s_maxvoices->integer )
+	{
+		qsort( active, numActive, sizeof( *active ), S_CompareChannelVolume );
+		for( i = s_maxvoices->integer; i < numActive; i++ )
+			active[i]->virtualized = true;
+		numActive = s_maxvoices->integer;
+	}
+
+	return numActive;
+}
+
 /*
 * S_Spatialize
 */
@@ -1247,6 +1304,8 @@ static void S_Spatialize( void )
 
 	S_AddLoopSounds();
 
+	S_VirtualizeChannels();
+
 	S_SpatializeRawSounds();
 }
 
@@ -1273,7 +1332,7 @@ static void S_Update( void )
 		for( i = 0; i < MAX_CHANNELS; i++, ch++ )
 			if( ch->sfx && ( ch->leftvol || ch->rightvol ) )
 			{
-				Com_Printf( "%3i %3i %s\n", ch->leftvol, ch->rightvol, ch->sfx->name );
+				Com_Printf( "%3i %3i %s%s\n", ch->leftvol, ch->rightvol, ch->sfx->name, ch->virtualized ? " (virtual)" : "" );
 				total++;
 			}
 
@@ -1658,6 +1717,15 @@ static unsigned S_HandleStuffCmd( const sndStuffCmd_t *cmd )
 	if( !Q_stricmp( cmd->text, "soundlist" ) ) {
 		S_SoundList_f();
 	}
+	else if( !Q_stricmp( cmd->text, "soundcachestats" ) ) {
+		S_SoundCacheStats( false );
+	}
+	else if( !Q_stricmp( cmd->text, "soundcachestats reset" ) ) {
+		S_SoundCacheStats( true );
+	}
+	else if( !Q_strnicmp( cmd->text, "mixbench", 8 ) ) {
+		S_MixBench( atoi( cmd->text + 8 ) );
+	}
 	return sizeof( *cmd );
 }
 
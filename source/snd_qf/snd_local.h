@@ -46,6 +46,8 @@ typedef struct
 	unsigned int speed;              // not needed, because converted on load?
 	unsigned short channels;
 	unsigned short width;
+	bool compressed;          // data holds ADPCM blocks, decoded on demand by S_GetSoundSamples
+	unsigned int id;          // identifies the decoded blocks of compressed sounds
 	uint8_t data[1];          // variable sized
 } sfxcache_t;
 
@@ -123,6 +125,7 @@ typedef struct
 	unsigned int ldelay;	// invidual ear delay offset for both channels
 	unsigned int rdelay;
 	rawsound_t *rawsamples;	// got no static sfx, read samples directly
+	bool virtualized;		// inaudible or over the voice limit, tracked but not mixed
 } channel_t;
 
 typedef struct
@@ -248,6 +251,10 @@ extern cvar_t *s_swapstereo;
 extern cvar_t *s_pseudoAcoustics;
 extern cvar_t *s_separationDelay;
 extern cvar_t *s_globalfocus;
+extern cvar_t *s_mix_simd;
+extern cvar_t *s_maxvoices;
+extern cvar_t *s_virtualvolume;
+extern cvar_t *s_compressedsounds;
 
 extern struct mempool_s *soundpool;
 
@@ -266,10 +273,18 @@ unsigned int ResampleSfx( unsigned int numsamples, unsigned int speed, unsigned
 void S_InitScaletable( void );
 
 sfxcache_t *S_LoadSound( sfx_t *s );
+size_t S_SoundCacheSize( const sfxcache_t *sc );
+const uint8_t *S_GetSoundSamples( sfxcache_t *sc, unsigned int pos, unsigned int history, unsigned int count );
+void S_InitSoundCache( void );
+void S_ShutdownSoundCache( void );
+void S_SoundCacheStats( bool reset );
 
 void S_IssuePlaysound( playsound_t *ps );
 
 int S_PaintChannels( unsigned int endtime, int dumpfile, float gain );
+void S_MixBench( int iterations );
+
+int S_VirtualizeChannels( void );
 
 //====================================================================
 
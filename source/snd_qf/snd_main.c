@@ -47,6 +47,10 @@ cvar_t *s_swapstereo;
 cvar_t *s_pseudoAcoustics;
 cvar_t *s_separationDelay;
 cvar_t *s_globalfocus;
+cvar_t *s_mix_simd;
+cvar_t *s_maxvoices;
+cvar_t *s_virtualvolume;
+cvar_t *s_compressedsounds;
 
 sfx_t known_sfx[MAX_SFX];
 int num_sfx;
@@ -114,6 +118,30 @@ static void SF_SoundInfo_f( void )
 	Com_Printf( "0x%x dma buffer\n", dma.buffer );
 }
 
+/*
+* SF_MixBench_f
+*
+* The benchmark runs on the mixer thread, which owns the channels
+*/
+static void SF_MixBench_f( void )
+{
+	char text[80];
+
+	Q_snprintfz( text, sizeof( text ), "mixbench %i", trap_Cmd_Argc() > 1 ? atoi( trap_Cmd_Argv( 1 ) ) : 0 );
+	S_IssueStuffCmd( s_cmdPipe, text );
+}
+
+/*
+* SF_SoundCacheStats_f
+*/
+static void SF_SoundCacheStats_f( void )
+{
+	if( trap_Cmd_Argc() > 1 && !Q_stricmp( trap_Cmd_Argv( 1 ), "reset" ) )
+		S_IssueStuffCmd( s_cmdPipe, "soundcachestats reset" );
+	else
+		S_IssueStuffCmd( s_cmdPipe, "soundcachestats" );
+}
+
 /*
 * SF_StopAllSounds_f
 */
@@ -282,6 +310,10 @@ bool SF_Init( void *hwnd, int maxEntities, bool verbose )
 	s_pseudoAcoustics = trap_Cvar_Get( "s_pseudoAcoustics", "0", CVAR_ARCHIVE );
 	s_separationDelay = trap_Cvar_Get( "s_separationDelay", "1.0", CVAR_ARCHIVE );
 	s_globalfocus = trap_Cvar_Get( "s_globalfocus", "0", CVAR_ARCHIVE );
+	s_mix_simd = trap_Cvar_Get( "s_mix_simd", "1", CVAR_ARCHIVE );
+	s_maxvoices = trap_Cvar_Get( "s_maxvoices", STR_TOSTR( MAX_CHANNELS ), CVAR_ARCHIVE );
+	s_virtualvolume = trap_Cvar_Get( "s_virtualvolume", "0", CVAR_ARCHIVE );
+	s_compressedsounds = trap_Cvar_Get( "s_compressedsounds", "0", CVAR_ARCHIVE|CVAR_LATCH_SOUND );
 
 #ifdef ENABLE_PLAY
 	trap_Cmd_AddCommand( "play", SF_Play_f );
@@ -294,6 +326,8 @@ bool SF_Init( void *hwnd, int maxEntities, bool verbose )
 	trap_Cmd_AddCommand( "pausemusic", SF_PauseBackgroundTrack );
 	trap_Cmd_AddCommand( "soundlist", SF_SoundList_f );
 	trap_Cmd_AddCommand( "soundinfo", SF_SoundInfo_f );
+	trap_Cmd_AddCommand( "s_mixbench", SF_MixBench_f );
+	trap_Cmd_AddCommand( "soundcachestats", SF_SoundCacheStats_f );
 
 	num_sfx = 0;
 	
@@ -363,6 +397,8 @@ void SF_Shutdown( bool verbose )
 	trap_Cmd_RemoveCommand( "pausemusic" );
 	trap_Cmd_RemoveCommand( "soundlist" );
 	trap_Cmd_RemoveCommand( "soundinfo" );
+	trap_Cmd_RemoveCommand( "s_mixbench" );
+	trap_Cmd_RemoveCommand( "soundcachestats" );
 
 	S_MemFreePool( &soundpool );
 
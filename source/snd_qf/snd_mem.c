@@ -257,19 +257,414 @@ sfxcache_t *S_LoadSound_Wav( sfx_t *s )
 	sc->width = info.width;
 	sc->speed = dma.speed;
 	sc->loopstart = info.loopstart < 0 ? sc->length : info.loopstart * ((double)sc->length / (double)info.samples);
-	s->cache = sc;
 
 	S_Free( data );
 
 	return sc;
 }
 
+/*
+===============================================================================
+
+COMPRESSED SOUNDS
+
+16-bit sounds can be kept in memory as 4-bit IMA ADPCM, which takes a quarter
+of the space of PCM. The sound is split into blocks of SND_BLOCK_SAMPLES
+sample pairs that each start with the decoder state of every channel, so any
+block can be decoded independently. Decoded blocks are kept in a small LRU
+cache that is only accessed by the mixer thread.
+
+===============================================================================
+*/
+
+#define SND_BLOCK_SAMPLES		1024
+#define SND_BLOCK_HEADER		4		// predictor and step index of each channel
+#define SND_BLOCK_SIZE( channels )	( ( SND_BLOCK_HEADER + SND_BLOCK_SAMPLES / 2 ) * ( channels ) )
+#define SND_DECODED_BLOCKS		128
+#define SND_DECODED_HASH_SIZE	256
+
+static const int adpcm_stepTable[89] =
+{
+	7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31, 34, 37, 41, 45,
+	50, 55, 60, 66, 73, 80, 88, 97, 107, 118, 130, 143, 157, 173, 190, 209, 230,
+	253, 279, 307, 337, 371, 408, 449, 494, 544, 598, 658, 724, 796, 876, 963,
+	1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066, 2272, 2499, 2749, 3024, 3327,
+	3660, 4026, 4428, 4871, 5358, 5894, 6484, 7132, 7845, 8630, 9493, 10442, 11487,
+	12635, 13899, 15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767
+};
+
+static const int adpcm_indexTable[16] =
+{
+	-1, -1, -1, -1, 2, 4, 6, 8,
+	-1, -1, -1, -1, 2, 4, 6, 8
+};
+
+typedef struct
+{
+	int predictor;
+	int index;
+} adpcmState_t;
+
+typedef struct decodedBlock_s
+{
+	unsigned int id;			// sfxcache_t id, 0 if unused
+	unsigned int block;
+	unsigned int lastUsed;
+	struct decodedBlock_s *hashNext;
+	short samples[SND_BLOCK_SAMPLES * 2];
+} decodedBlock_t;
+
+typedef struct
+{
+	unsigned int hits;
+	unsigned int misses;
+	uint64_t decodeTime;		// in microseconds
+} soundCacheStats_t;
+
+static decodedBlock_t *s_decodedBlocks;
+static decodedBlock_t *s_decodedHash[SND_DECODED_HASH_SIZE];
+static unsigned int s_decodedFrame;
+static unsigned int s_sfxGenerations[MAX_SFX];	// bumped when a slot gets a new compressed sound
+static soundCacheStats_t s_soundCacheStats;
+
+// contiguous samples handed to the mixer when a read spans several blocks
+static uint8_t *s_sampleScratch;
+static size_t s_sampleScratchSize;
+
+/*
+* S_ADPCM_Step
+*
+* Advances the decoder state by one nibble, shared by the encoder and the
+* decoder so that both always agree on the predictor
+*/
+static inline int S_ADPCM_Step( adpcmState_t *state, int nibble )
+{
+	int step = adpcm_stepTable[state->index];
+	int delta = step >> 3;
+
+	if( nibble & 4 )
+		delta += step;
+	if( nibble & 2 )
+		delta += step >> 1;
+	if( nibble & 1 )
+		delta += step >> 2;
+
+	state->predictor += ( nibble & 8 ) ? -delta : delta;
+	state->predictor = bound( -32768, state->predictor, 32767 );
+	state->index = bound( 0, state->index + adpcm_indexTable[nibble], 88 );
+	return state->predictor;
+}
+
+/*
+* S_ADPCM_EncodeSample
+*/
+static int S_ADPCM_EncodeSample( adpcmState_t *state, int sample )
+{
+	int step = adpcm_stepTable[state->index];
+	int diff = sample - state->predictor;
+	int nibble = 0;
+
+	if( diff < 0 )
+	{
+		nibble = 8;
+		diff = -diff;
+	}
+	if( diff >= step )
+	{
+		nibble |= 4;
+		diff -= step;
+	}
+	if( diff >= ( step >> 1 ) )
+	{
+		nibble |= 2;
+		diff -= step >> 1;
+	}
+	if( diff >= ( step >> 2 ) )
+		nibble |= 1;
+
+	S_ADPCM_Step( state, nibble );
+	return nibble;
+}
+
+/*
+* S_EncodeBlock
+*/
+static void S_EncodeBlock( const short *in, unsigned int numSamples, int channels, uint8_t *out, adpcmState_t *states )
+{
+	int c;
+	unsigned int i;
+	uint8_t *header, *nibbles;
+	int nibble;
+
+	for( c = 0; c < channels; c++ )
+	{
+		header = out + c * SND_BLOCK_HEADER;
+		nibbles = out + channels * SND_BLOCK_HEADER + c * ( SND_BLOCK_SAMPLES / 2 );
+
+		// restart from the exact first sample so the block can be decoded alone
+		states[c].predictor = in[c];
+		header[0] = states[c].predictor & 255;
+		header[1] = ( states[c].predictor >> 8 ) & 255;
+		header[2] = states[c].index;
+		header[3] = 0;
+
+		for( i = 0; i < SND_BLOCK_SAMPLES; i++ )
+		{
+			nibble = S_ADPCM_EncodeSample( &states[c], i < numSamples ? in[i * channels + c] : 0 );
+			if( i & 1 )
+				nibbles[i >> 1] |= nibble << 4;
+			else
+				nibbles[i >> 1] = nibble;
+		}
+	}
+}
+
+/*
+* S_DecodeBlock
+*/
+static void S_DecodeBlock( const uint8_t *in, int channels, short *out )
+{
+	int c;
+	unsigned int i;
+	const uint8_t *header, *nibbles;
+	adpcmState_t state;
+
+	for( c = 0; c < channels; c++ )
+	{
+		header = in + c * SND_BLOCK_HEADER;
+		nibbles = in + channels * SND_BLOCK_HEADER + c * ( SND_BLOCK_SAMPLES / 2 );
+
+		state.predictor = (short)( header[0] | ( header[1] << 8 ) );
+		state.index = min( header[2], 88 );
+
+		for( i = 0; i < SND_BLOCK_SAMPLES; i += 2 )
+		{
+			out[i * channels + c] = S_ADPCM_Step( &state, nibbles[i >> 1] & 15 );
+			out[( i + 1 ) * channels + c] = S_ADPCM_Step( &state, nibbles[i >> 1] >> 4 );
+		}
+	}
+}
+
+/*
+* S_CompressSound
+*
+* Replaces a 16-bit PCM sound with its ADPCM version. Sounds that fit in a
+* single block aren't worth it and are kept as is.
+*
+* Sounds are loaded by both the main and the sound thread, so the id is made
+* of the sfx index and a per-slot generation instead of a shared counter.
+* Only a thread loading this very sfx touches its generation.
+*/
+static sfxcache_t *S_CompressSound( sfx_t *s, sfxcache_t *sc )
+{
+	unsigned int i, numBlocks, blockSize, index;
+	adpcmState_t states[2];
+	sfxcache_t *csc;
+
+	if( sc->width != 2 || sc->length <= SND_BLOCK_SAMPLES )
+		return sc;
+
+	numBlocks = ( sc->length + SND_BLOCK_SAMPLES - 1 ) / SND_BLOCK_SAMPLES;
+	blockSize = SND_BLOCK_SIZE( sc->channels );
+
+	csc = S_Malloc( sizeof( *csc ) + numBlocks * blockSize );
+	*csc = *sc;
+	csc->compressed = true;
+	index = s - known_sfx;
+	csc->id = ++s_sfxGenerations[index] * MAX_SFX + index + 1;
+
+	memset( states, 0, sizeof( states ) );
+	for( i = 0; i < numBlocks; i++ )
+	{
+		S_EncodeBlock( (const short *)sc->data + i * SND_BLOCK_SAMPLES * sc->channels, 
+			min( sc->length - i * SND_BLOCK_SAMPLES, SND_BLOCK_SAMPLES ), sc->channels, csc->data + i * blockSize, states );
+	}
+
+	S_Free( sc );
+	return csc;
+}
+
+/*
+* S_SoundCacheSize
+*/
+size_t S_SoundCacheSize( const sfxcache_t *sc )
+{
+	if( sc->compressed )
+		return ( ( sc->length + SND_BLOCK_SAMPLES - 1 ) / SND_BLOCK_SAMPLES ) * SND_BLOCK_SIZE( sc->channels );
+	return sc->length * sc->width * sc->channels;
+}
+
+/*
+* S_GetDecodedBlock
+*/
+static const short *S_GetDecodedBlock( sfxcache_t *sc, unsigned int block )
+{
+	unsigned int i, hash;
+	uint64_t start;
+	decodedBlock_t *db, **prev;
+
+	hash = ( sc->id * 31 + block ) & ( SND_DECODED_HASH_SIZE - 1 );
+	for( db = s_decodedHash[hash]; db; db = db->hashNext )
+	{
+		if( db->id == sc->id && db->block == block )
+		{
+			db->lastUsed = s_decodedFrame;
+			s_soundCacheStats.hits++;
+			return db->samples;
+		}
+	}
+
+	// evict the least recently used block
+	db = s_decodedBlocks;
+	for( i = 1; i < SND_DECODED_BLOCKS; i++ )
+	{
+		if( s_decodedBlocks[i].lastUsed < db->lastUsed )
+			db = &s_decodedBlocks[i];
+	}
+
+	if( db->id )
+	{
+		prev = &s_decodedHash[( db->id * 31 + db->block ) & ( SND_DECODED_HASH_SIZE - 1 )];
+		while( *prev != db )
+			prev = &( *prev )->hashNext;
+		*prev = db->hashNext;
+	}
+
+	start = trap_Microseconds();
+	S_DecodeBlock( sc->data + block * SND_BLOCK_SIZE( sc->channels ), sc->channels, db->samples );
+	s_soundCacheStats.decodeTime += trap_Microseconds() - start;
+	s_soundCacheStats.misses++;
+
+	db->id = sc->id;
+	db->block = block;
+	db->lastUsed = s_decodedFrame;
+	db->hashNext = s_decodedHash[hash];
+	s_decodedHash[hash] = db;
+	return db->samples;
+}
+
+/*
+* S_GetSoundSamples
+*
+* Returns a pointer to the sample pair at pos with history pairs before it
+* and count pairs after it readable. PCM sounds are returned in place,
+* compressed ones are gathered from their decoded blocks into a scratch
+* buffer that is valid until the next call.
+*/
+const uint8_t *S_GetSoundSamples( sfxcache_t *sc, unsigned int pos, unsigned int history, unsigned int count )
+{
+	unsigned int first, end, run, block, offset;
+	size_t frameSize, size;
+	short *out;
+
+	frameSize = sc->width * sc->channels;
+	if( !sc->compressed )
+		return sc->data + pos * frameSize;
+
+	size = ( history + count ) * frameSize;
+	if( size > s_sampleScratchSize )
+	{
+		if( s_sampleScratch )
+			S_Free( s_sampleScratch );
+		s_sampleScratchSize = size;
+		s_sampleScratch = S_Malloc( s_sampleScratchSize );
+	}
+
+	s_decodedFrame++;
+
+	out = (short *)s_sampleScratch;
+	for( first = pos - history, end = pos + count; first < end; first += run )
+	{
+		block = first / SND_BLOCK_SAMPLES;
+		offset = first % SND_BLOCK_SAMPLES;
+		run = min( end - first, SND_BLOCK_SAMPLES - offset );
+
+		memcpy( out, S_GetDecodedBlock( sc, block ) + offset * sc->channels, run * frameSize );
+		out += run * sc->channels;
+	}
+
+	return s_sampleScratch + history * frameSize;
+}
+
+/*
+* S_InitSoundCache
+*/
+void S_InitSoundCache( void )
+{
+	s_decodedBlocks = S_Malloc( sizeof( *s_decodedBlocks ) * SND_DECODED_BLOCKS );
+	memset( s_decodedHash, 0, sizeof( s_decodedHash ) );
+	s_decodedFrame = 0;
+	memset( &s_soundCacheStats, 0, sizeof( s_soundCacheStats ) );
+}
+
+/*
+* S_ShutdownSoundCache
+*/
+void S_ShutdownSoundCache( void )
+{
+	if( s_decodedBlocks )
+	{
+		S_Free( s_decodedBlocks );
+		s_decodedBlocks = NULL;
+	}
+	memset( s_decodedHash, 0, sizeof( s_decodedHash ) );
+
+	if( s_sampleScratch )
+	{
+		S_Free( s_sampleScratch );
+		s_sampleScratch = NULL;
+	}
+	s_sampleScratchSize = 0;
+}
+
+/*
+* S_SoundCacheStats
+*/
+void S_SoundCacheStats( bool reset )
+{
+	int i;
+	unsigned int numCompressed, lookups;
+	size_t pcmSize, compressedSize;
+	sfxcache_t *sc;
+
+	if( reset )
+	{
+		memset( &s_soundCacheStats, 0, sizeof( s_soundCacheStats ) );
+		return;
+	}
+
+	numCompressed = 0;
+	pcmSize = compressedSize = 0;
+	for( i = 0; i < num_sfx; i++ )
+	{
+		sc = known_sfx[i].cache;
+		if( !known_sfx[i].name[0] || !sc || !sc->compressed )
+			continue;
+
+		numCompressed++;
+		pcmSize += sc->length * sc->width * sc->channels;
+		compressedSize += S_SoundCacheSize( sc );
+	}
+
+	lookups = s_soundCacheStats.hits + s_soundCacheStats.misses;
+
+	Com_Printf( "%u compressed sounds, %u KB instead of %u KB, %u KB saved\n", numCompressed, 
+		(unsigned)( compressedSize / 1024 ), (unsigned)( pcmSize / 1024 ), (unsigned)( ( pcmSize - compressedSize ) / 1024 ) );
+	Com_Printf( "%i decoded blocks of %i samples, %u KB\n", SND_DECODED_BLOCKS, SND_BLOCK_SAMPLES, 
+		(unsigned)( sizeof( decodedBlock_t ) * SND_DECODED_BLOCKS / 1024 ) );
+	Com_Printf( "%u lookups, %u decodes (%.1f%% hits), %.2f us per decode, %.1f ms total\n", lookups, s_soundCacheStats.misses,
+		lookups ? 100.0 * s_soundCacheStats.hits / lookups : 0.0,
+		s_soundCacheStats.misses ? (double)s_soundCacheStats.decodeTime / s_soundCacheStats.misses : 0.0,
+		s_soundCacheStats.decodeTime / 1000.0 );
+}
+
 /*
 * S_LoadSound
 */
 sfxcache_t *S_LoadSound( sfx_t *s )
 {
 	const char *extension;
+	sfxcache_t *sc;
 
 	if( !s->name[0] )
 		return NULL;
@@ -280,20 +675,26 @@ sfxcache_t *S_LoadSound( sfx_t *s )
 	if( s->cache )
 		return s->cache;
 
+	sc = NULL;
 	extension = COM_FileExtension( s->name );
 	if( extension )
 	{
 		if( !Q_stricmp( extension, ".wav" ) )
 		{
-			return S_LoadSound_Wav( s );
+			sc = S_LoadSound_Wav( s );
 		}
-		if( !Q_stricmp( extension, ".ogg" ) )
+		else if( !Q_stricmp( extension, ".ogg" ) )
 		{
-			return SNDOGG_Load( s );
+			sc = SNDOGG_Load( s );
 		}
 	}
 
-	return NULL;
+	// the mixer may pick up s->cache at any time, so only the final buffer is published
+	if( sc && s_compressedsounds->integer )
+		sc = S_CompressSound( s, sc );
+	s->cache = sc;
+
+	return sc;
 }
 
 
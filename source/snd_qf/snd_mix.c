@@ -20,6 +20,7 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 // snd_mix.c -- portable code to mix sounds for snd_dma.c
 
 #include "snd_local.h"
+#include "../gameshared/q_simd.h"
 
 #define	PAINTBUFFER_SIZE    2048
 static portable_samplepair_t paintbuffer[PAINTBUFFER_SIZE];
@@ -293,6 +294,228 @@ LClampDone2:
 }
 #endif
 
+/*
+===============================================================================
+
+MIXING KERNELS
+
+===============================================================================
+*/
+
+/*
+* S_PaintMono16_C
+*/
+static void S_PaintMono16_C( portable_samplepair_t *samp, const short *sfx, unsigned int count, int leftvol, int rightvol )
+{
+	unsigned int i;
+	int j;
+
+	for( i = 0; i < count; i++, samp++ )
+	{
+		j = *sfx++;
+		samp->left += ( j * leftvol ) >> 8;
+		samp->right += ( j * rightvol ) >> 8;
+	}
+}
+
+/*
+* S_PaintStereo16_C
+*/
+static void S_PaintStereo16_C( portable_samplepair_t *samp, const short *sfx, unsigned int count, int leftvol, int rightvol )
+{
+	unsigned int i;
+
+	for( i = 0; i < count; i++, samp++ )
+	{
+		samp->left += ( *sfx++ * leftvol ) >> 8;
+		samp->right += ( *sfx++ * rightvol ) >> 8;
+	}
+}
+
+/*
+* S_PaintRaw_C
+*/
+static void S_PaintRaw_C( portable_samplepair_t *samp, const portable_samplepair_t *in, unsigned int count, int leftvol, int rightvol )
+{
+	unsigned int i;
+
+	for( i = 0; i < count; i++, samp++, in++ )
+	{
+		samp->left += in->left * leftvol;
+		samp->right += in->right * rightvol;
+	}
+}
+
+#if defined( QSIMD_SSE2 ) || defined( QSIMD_NEON )
+
+/*
+* S_AddScaledPairs
+*
+* Adds ( in * vol ) >> shift to two sample pairs of the paint buffer
+*/
+static inline void S_AddScaledPairs( portable_samplepair_t *samp, qiv_t in, qiv_t vol, int shift )
+{
+	qiv_t v = qiv_mullo32( in, vol );
+
+	if( shift )
+		v = qiv_sra32( v, shift );
+	qiv_storeu( samp, qiv_add32( qiv_loadu( samp ), v ) );
+}
+
+/*
+* S_PaintMono16_SIMD
+*/
+static void S_PaintMono16_SIMD( portable_samplepair_t *samp, const short *sfx, unsigned int count, int leftvol, int rightvol )
+{
+	unsigned int i;
+	qiv_t vol = qiv_set_u32( leftvol, rightvol, leftvol, rightvol );
+
+	for( i = 0; i + 8 <= count; i += 8, samp += 8, sfx += 8 )
+	{
+		qiv_t in = qiv_loadu( sfx );
+		qiv_t lo = qiv_sext16lo( in ), hi = qiv_sext16hi( in );
+
+		S_AddScaledPairs( samp + 0, qiv_zip32lo( lo, lo ), vol, 8 );
+		S_AddScaledPairs( samp + 2, qiv_zip32hi( lo, lo ), vol, 8 );
+		S_AddScaledPairs( samp + 4, qiv_zip32lo( hi, hi ), vol, 8 );
+		S_AddScaledPairs( samp + 6, qiv_zip32hi( hi, hi ), vol, 8 );
+	}
+
+	S_PaintMono16_C( samp, sfx, count - i, leftvol, rightvol );
+}
+
+/*
+* S_PaintStereo16_SIMD
+*/
+static void S_PaintStereo16_SIMD( portable_samplepair_t *samp, const short *sfx, unsigned int count, int leftvol, int rightvol )
+{
+	unsigned int i;
+	qiv_t vol = qiv_set_u32( leftvol, rightvol, leftvol, rightvol );
+
+	for( i = 0; i + 4 <= count; i += 4, samp += 4, sfx += 8 )
+	{
+		qiv_t in = qiv_loadu( sfx );
+
+		S_AddScaledPairs( samp + 0, qiv_sext16lo( in ), vol, 8 );
+		S_AddScaledPairs( samp + 2, qiv_sext16hi( in ), vol, 8 );
+	}
+
+	S_PaintStereo16_C( samp, sfx, count - i, leftvol, rightvol );
+}
+
+/*
+* S_PaintRaw_SIMD
+*/
+static void S_PaintRaw_SIMD( portable_samplepair_t *samp, const portable_samplepair_t *in, unsigned int count, int leftvol, int rightvol )
+{
+	unsigned int i;
+	qiv_t vol = qiv_set_u32( leftvol, rightvol, leftvol, rightvol );
+
+	for( i = 0; i + 2 <= count; i += 2, samp += 2, in += 2 )
+		S_AddScaledPairs( samp, qiv_loadu( in ), vol, 0 );
+
+	S_PaintRaw_C( samp, in, count - i, leftvol, rightvol );
+}
+
+/*
+* S_WriteLinearBlastStereo16_SIMD
+*
+* The saturating pack does the clamping of the C version
+*/
+static void S_WriteLinearBlastStereo16_SIMD( void )
+{
+	int i;
+	int val;
+
+	for( i = 0; i + 8 <= snd_linear_count; i += 8 )
+	{
+		qiv_t lo = qiv_sra32( qiv_loadu( snd_p + i ), 8 );
+		qiv_t hi = qiv_sra32( qiv_loadu( snd_p + i + 4 ), 8 );
+		qiv_storeu( snd_out + i, qiv_packs32to16( lo, hi ) );
+	}
+
+	for( ; i < snd_linear_count; i++ )
+	{
+		val = snd_p[i]>>8;
+		snd_out[i] = bound( -32768, val, 0x7fff );
+	}
+}
+
+/*
+* S_WriteSwappedLinearBlastStereo16_SIMD
+*/
+static void S_WriteSwappedLinearBlastStereo16_SIMD( void )
+{
+	int i;
+	int val;
+
+	for( i = 0; i + 8 <= snd_linear_count; i += 8 )
+	{
+		qiv_t lo = qiv_sra32( qiv_swap32pairs( qiv_loadu( snd_p + i ) ), 8 );
+		qiv_t hi = qiv_sra32( qiv_swap32pairs( qiv_loadu( snd_p + i + 4 ) ), 8 );
+		qiv_storeu( snd_out + i, qiv_packs32to16( lo, hi ) );
+	}
+
+	for( ; i < snd_linear_count; i += 2 )
+	{
+		val = snd_p[i+1]>>8;
+		snd_out[i] = bound( -32768, val, 0x7fff );
+
+		val = snd_p[i]>>8;
+		snd_out[i+1] = bound( -32768, val, 0x7fff );
+	}
+}
+
+#endif
+
+typedef struct
+{
+	const char *name;
+	void ( *paintMono16 )( portable_samplepair_t *samp, const short *sfx, unsigned int count, int leftvol, int rightvol );
+	void ( *paintStereo16 )( portable_samplepair_t *samp, const short *sfx, unsigned int count, int leftvol, int rightvol );
+	void ( *paintRaw )( portable_samplepair_t *samp, const portable_samplepair_t *in, unsigned int count, int leftvol, int rightvol );
+	void ( *writeLinearBlast )( void );
+	void ( *writeSwappedLinearBlast )( void );
+} mixFuncs_t;
+
+static const mixFuncs_t s_mixFuncsC =
+{
+	"C",
+	S_PaintMono16_C,
+	S_PaintStereo16_C,
+	S_PaintRaw_C,
+	S_WriteLinearBlastStereo16,
+	S_WriteSwappedLinearBlastStereo16
+};
+
+#if defined( QSIMD_SSE2 ) || defined( QSIMD_NEON )
+static const mixFuncs_t s_mixFuncsSIMD =
+{
+	QSIMD_NAME,
+	S_PaintMono16_SIMD,
+	S_PaintStereo16_SIMD,
+	S_PaintRaw_SIMD,
+	S_WriteLinearBlastStereo16_SIMD,
+	S_WriteSwappedLinearBlastStereo16_SIMD
+};
+#else
+#define s_mixFuncsSIMD s_mixFuncsC
+#endif
+
+static const mixFuncs_t *s_benchMixFuncs;	// forced by S_MixBench
+
+/*
+* S_MixFuncs
+*
+* Picks the mixing kernels, s_mix_simd 0 forces the plain C ones
+*/
+static const mixFuncs_t *S_MixFuncs( void )
+{
+	if( s_benchMixFuncs )
+		return s_benchMixFuncs;
+	return s_mix_simd->integer ? &s_mixFuncsSIMD : &s_mixFuncsC;
+}
+
 static void S_TransferStereo16( unsigned int *pbuf, int endtime )
 {
 	int lpos;
@@ -316,9 +539,9 @@ static void S_TransferStereo16( unsigned int *pbuf, int endtime )
 
 		// write a linear blast of samples
 		if( s_swapstereo->integer )
-			S_WriteSwappedLinearBlastStereo16();
+			S_MixFuncs()->writeSwappedLinearBlast();
 		else
-			S_WriteLinearBlastStereo16();
+			S_MixFuncs()->writeLinearBlast();
 
 		snd_p += snd_linear_count;
 		lpaintedtime += ( snd_linear_count>>1 );
@@ -457,10 +680,10 @@ CHANNEL MIXING
 ===============================================================================
 */
 
-static void S_PaintChannelFrom8( channel_t *ch, sfxcache_t *sc, unsigned int endtime, int offset );
-static void S_PaintChannelFrom16( channel_t *ch, sfxcache_t *sc, unsigned int endtime, int offset );
-static void S_PaintChannelFrom8HQ( channel_t *ch, sfxcache_t *sc, unsigned int endtime, int offset );
-static void S_PaintChannelFrom16HQ( channel_t *ch, sfxcache_t *sc, unsigned int endtime, int offset );
+static void S_PaintChannelFrom8( channel_t *ch, sfxcache_t *sc, const uint8_t *data, unsigned int count, int offset );
+static void S_PaintChannelFrom16( channel_t *ch, sfxcache_t *sc, const uint8_t *data, unsigned int count, int offset );
+static void S_PaintChannelFrom8HQ( channel_t *ch, sfxcache_t *sc, const uint8_t *data, unsigned int count, int offset );
+static void S_PaintChannelFrom16HQ( channel_t *ch, sfxcache_t *sc, const uint8_t *data, unsigned int count, int offset );
 
 int S_PaintChannels( unsigned int endtime, int dumpfile, float gain )
 {
@@ -471,8 +694,11 @@ int S_PaintChannels( unsigned int endtime, int dumpfile, float gain )
 	sfxcache_t *sc;
 	unsigned int ltime, count;
 	playsound_t *ps;
+	const mixFuncs_t *funcs;
+	const uint8_t *data;
 
 	total = 0;
+	funcs = S_MixFuncs();
 	snd_vol = s_volume->value*gain*256;
 	music_vol = s_musicvolume->value*gain*256;
 
@@ -508,7 +734,7 @@ int S_PaintChannels( unsigned int endtime, int dumpfile, float gain )
 		for( i = 0; i < MAX_RAW_SOUNDS; i++ ) {
 			// copy from the streaming sound source
 			int s;
-			unsigned j, stop;
+			unsigned j, stop, run;
 			rawsound_t *rawsound = raw_sounds[i];
 
 			if( !rawsound ) {
@@ -519,12 +745,14 @@ int S_PaintChannels( unsigned int endtime, int dumpfile, float gain )
 				continue;
 			}
 
+			// paint contiguous runs of the ring buffer
 			stop = ( end < rawsound->rawend ) ? end : rawsound->rawend;
-			for( j = paintedtime; j < stop; j++ )
+			for( j = paintedtime; j < stop; j += run )
 			{
 				s = j&( MAX_RAW_SAMPLES-1 );
-				paintbuffer[j-paintedtime].left += rawsound->rawsamples[s].left * rawsound->left_volume;
-				paintbuffer[j-paintedtime].right += rawsound->rawsamples[s].right * rawsound->right_volume;
+				run = min( stop - j, MAX_RAW_SAMPLES - s );
+				funcs->paintRaw( &paintbuffer[j-paintedtime], &rawsound->rawsamples[s], run,
+					rawsound->left_volume, rawsound->right_volume );
 			}
 		}
 
@@ -555,19 +783,29 @@ int S_PaintChannels( unsigned int endtime, int dumpfile, float gain )
 
 				if( count > 0 && ch->sfx )
 				{
-					if( s_pseudoAcoustics->value )
+					if( ch->virtualized )
 					{
+						// tracked but not heard, just advance the playback position
+						ch->pos += count;
+					}
+					else if( s_pseudoAcoustics->value )
+					{
+						// the delayed ear reads behind the current position
+						data = S_GetSoundSamples( sc, ch->pos, min( ch->pos, max( ch->ldelay, ch->rdelay ) ), count );
+
 						if( sc->width == 1 )
-							S_PaintChannelFrom8HQ( ch, sc, count, ltime - paintedtime );
+							S_PaintChannelFrom8HQ( ch, sc, data, count, ltime - paintedtime );
 						else
-							S_PaintChannelFrom16HQ( ch, sc, count, ltime - paintedtime );
+							S_PaintChannelFrom16HQ( ch, sc, data, count, ltime - paintedtime );
 					}
 					else
 					{
+						data = S_GetSoundSamples( sc, ch->pos, 0, count );
+
 						if( sc->width == 1 )
-							S_PaintChannelFrom8( ch, sc, count, ltime - paintedtime );
+							S_PaintChannelFrom8( ch, sc, data, count, ltime - paintedtime );
 						else
-							S_PaintChannelFrom16( ch, sc, count, ltime - paintedtime );
+							S_PaintChannelFrom16( ch, sc, data, count, ltime - paintedtime );
 					}
 					ltime += count;
 				}
@@ -593,13 +831,14 @@ int S_PaintChannels( unsigned int endtime, int dumpfile, float gain )
 			}
 		}
 
+		// transfer out according to DMA format
+		total += end - paintedtime;
+		S_TransferPaintBuffer( end );
+
 		// dump to file
 		if( dumpfile )
 			S_DumpPaintBuffer( end, dumpfile );
 
-		// transfer out according to DMA format
-		total += end - paintedtime;
-		S_TransferPaintBuffer( end );
 		paintedtime = end;
 	}
 
@@ -620,7 +859,7 @@ void S_InitScaletable( void )
 	}
 }
 
-static void S_PaintChannelFrom8( channel_t *ch, sfxcache_t *sc, unsigned int count, int offset )
+static void S_PaintChannelFrom8( channel_t *ch, sfxcache_t *sc, const uint8_t *data, unsigned int count, int offset )
 {
 	unsigned int i;
 	int j;
@@ -646,7 +885,7 @@ static void S_PaintChannelFrom8( channel_t *ch, sfxcache_t *sc, unsigned int cou
 
 	if( sc->channels == 2 )
 	{
-		sfx = (unsigned char *)sc->data + ch->pos * 2;
+		sfx = (unsigned char *)data;
 
 		for( i = 0; i < count; i++, samp++ )
 		{
@@ -656,7 +895,7 @@ static void S_PaintChannelFrom8( channel_t *ch, sfxcache_t *sc, unsigned int cou
 	}
 	else
 	{
-		sfx = (unsigned char *)sc->data + ch->pos;
+		sfx = (unsigned char *)data;
 
 		for( i = 0; i < count; i++, samp++ )
 		{
@@ -669,12 +908,9 @@ static void S_PaintChannelFrom8( channel_t *ch, sfxcache_t *sc, unsigned int cou
 	ch->pos += count;
 }
 
-static void S_PaintChannelFrom16( channel_t *ch, sfxcache_t *sc, unsigned int count, int offset )
+static void S_PaintChannelFrom16( channel_t *ch, sfxcache_t *sc, const uint8_t *data, unsigned int count, int offset )
 {
-	unsigned int i;
-	int j;
 	int leftvol, rightvol;
-	signed short *sfx;
 	portable_samplepair_t *samp;
 
 	if( !snd_vol )
@@ -689,31 +925,14 @@ static void S_PaintChannelFrom16( channel_t *ch, sfxcache_t *sc, unsigned int co
 	samp = &paintbuffer[offset];
 
 	if( sc->channels == 2 )
-	{
-		sfx = (signed short *)sc->data + ch->pos * 2;
-
-		for( i = 0; i < count; i++, samp++ )
-		{
-			samp->left += ( *sfx++ * leftvol ) >> 8;
-			samp->right += ( *sfx++ * rightvol ) >> 8;
-		}
-	}
+		S_MixFuncs()->paintStereo16( samp, (const short *)data, count, leftvol, rightvol );
 	else
-	{
-		sfx = (signed short *)sc->data + ch->pos;
-
-		for( i = 0; i < count; i++, samp++ )
-		{
-			j = *sfx++;
-			samp->left += ( j * leftvol ) >> 8;
-			samp->right += ( j * rightvol ) >> 8;
-		}
-	}
+		S_MixFuncs()->paintMono16( samp, (const short *)data, count, leftvol, rightvol );
 
 	ch->pos += count;
 }
 
-static void S_PaintChannelFrom8HQ( channel_t *ch, sfxcache_t *sc, unsigned int count, int offset )
+static void S_PaintChannelFrom8HQ( channel_t *ch, sfxcache_t *sc, const uint8_t *data, unsigned int count, int offset )
 {
 	unsigned int i;
 	int j, k;
@@ -739,7 +958,7 @@ static void S_PaintChannelFrom8HQ( channel_t *ch, sfxcache_t *sc, unsigned int c
 
 	if( sc->channels == 2 )
 	{
-		sfx = (unsigned char *)sc->data + ch->pos * 2;
+		sfx = (unsigned char *)data;
 
 		for( i = 0; i < count; i++, samp++ )
 		{
@@ -749,7 +968,7 @@ static void S_PaintChannelFrom8HQ( channel_t *ch, sfxcache_t *sc, unsigned int c
 	}
 	else
 	{
-		sfx = (unsigned char *)sc->data + ch->pos;
+		sfx = (unsigned char *)data;
 
 		// initialize our counter here
 		i = 0;
@@ -794,7 +1013,7 @@ static void S_PaintChannelFrom8HQ( channel_t *ch, sfxcache_t *sc, unsigned int c
 	ch->pos += count;
 }
 
-static void S_PaintChannelFrom16HQ( channel_t *ch, sfxcache_t *sc, unsigned int count, int offset )
+static void S_PaintChannelFrom16HQ( channel_t *ch, sfxcache_t *sc, const uint8_t *data, unsigned int count, int offset )
 {
 	unsigned int i;
 	int j, k;
@@ -815,17 +1034,12 @@ static void S_PaintChannelFrom16HQ( channel_t *ch, sfxcache_t *sc, unsigned int
 
 	if( sc->channels == 2 )
 	{
-		sfx = (signed short *)sc->data + ch->pos * 2;
-
-		for( i = 0; i < count; i++, samp++ )
-		{
-			samp->left += ( *sfx++ * leftvol ) >> 8;
-			samp->right += ( *sfx++ * rightvol ) >> 8;
-		}
+		// no delays or filtering for stereo sounds
+		S_MixFuncs()->paintStereo16( samp, (const short *)data, count, leftvol, rightvol );
 	}
 	else
 	{
-		sfx = (signed short *)sc->data + ch->pos;
+		sfx = (signed short *)data;
 
 		// initialize our counter here
 		i = 0;
@@ -865,3 +1079,279 @@ static void S_PaintChannelFrom16HQ( channel_t *ch, sfxcache_t *sc, unsigned int
 
 	ch->pos += count;
 }
+
+/*
+===============================================================================
+
+MIXING BENCHMARK
+
+===============================================================================
+*/
+
+#define MIXBENCH_SOUNDS		4
+#define MIXBENCH_SECONDS	10
+#define MIXBENCH_CHUNK		1024	// sample pairs painted per call, roughly one mixahead step
+#define MIXBENCH_DMA_SAMPLES	( MIXBENCH_CHUNK * 8 )
+
+/*
+* S_MixBenchCreateSound
+*/
+static sfxcache_t *S_MixBenchCreateSound( unsigned int length, int channels, int width, bool loop, int *seed )
+{
+	unsigned int i, numSamples = length * channels;
+	sfxcache_t *sc;
+	float v;
+
+	sc = S_Malloc( sizeof( *sc ) + numSamples * width );
+	sc->length = length;
+	sc->loopstart = loop ? 0 : length;
+	sc->speed = dma.speed;
+	sc->channels = channels;
+	sc->width = width;
+
+	for( i = 0; i < numSamples; i++ )
+	{
+		// a tone with some noise on top to exercise the full sample range
+		v = sin( i * ( 0.01 + 0.003 * length / dma.speed ) ) * 0.8 + Q_crandom( seed ) * 0.2;
+		if( width == 2 )
+			( (short *)sc->data )[i] = (short)( v * 32767 );
+		else
+			sc->data[i] = (uint8_t)(signed char)( v * 127 );
+	}
+
+	return sc;
+}
+
+/*
+* S_MixBenchSetupScene
+*
+* Fills all channels with a mix of looping, one-shot and autolooping sounds
+* at volumes from silent to a quarter of the full one, like a large fight
+* heard from its edge
+*/
+static int S_MixBenchSetupScene( sfx_t *sfx, bool virtualize )
+{
+	int i;
+	channel_t *ch;
+	sfxcache_t *sc;
+
+	memset( channels, 0, sizeof( channels ) );
+
+	for( i = 0, ch = channels; i < MAX_CHANNELS; i++, ch++ )
+	{
+		ch->sfx = &sfx[i % MIXBENCH_SOUNDS];
+		sc = ch->sfx->cache;
+
+		ch->entnum = i;
+		ch->master_vol = 255;
+		ch->leftvol = ( ( i * 37 ) & 255 ) >> 2;
+		ch->rightvol = ( ( i * 101 ) & 255 ) >> 2;
+		ch->autosound = ( i & 7 ) == 0;
+		ch->pos = ( i * 997 ) % sc->length;
+		ch->end = paintedtime + sc->length - ch->pos;
+
+		// pseudo acoustics settings, only used with s_pseudoAcoustics 1
+		ch->lpf_lcoeff = ( i * 523 ) % 40000;
+		ch->lpf_rcoeff = ( i * 317 ) % 40000;
+		if( i & 1 )
+			ch->ldelay = i % 20;
+		else
+			ch->rdelay = i % 20;
+	}
+
+	if( virtualize )
+		return S_VirtualizeChannels();
+	return MAX_CHANNELS;
+}
+
+/*
+* S_MixBenchRender
+*/
+static uint64_t S_MixBenchRender( const mixFuncs_t *funcs, sfx_t *sfx, rawsound_t *raw, 
+	unsigned int length, bool virtualize, int dumpfile, int *numMixed )
+{
+	uint64_t start;
+
+	s_benchMixFuncs = funcs;
+	paintedtime = 0;
+	raw->rawend = length;
+	*numMixed = S_MixBenchSetupScene( sfx, virtualize );
+
+	start = trap_Microseconds();
+	while( paintedtime < length )
+		S_PaintChannels( min( paintedtime + MIXBENCH_CHUNK, length ), dumpfile, 1.0f );
+
+	s_benchMixFuncs = NULL;
+	return trap_Microseconds() - start;
+}
+
+/*
+* S_MixBenchCompareDumps
+*
+* Returns the number of samples that differ between two dumps, or -1 if
+* they couldn't be read back
+*/
+static int S_MixBenchCompareDumps( const char *name1, const char *name2 )
+{
+	int i, len1, len2, file1, file2;
+	int mismatches;
+	short *data1, *data2;
+
+	len1 = trap_FS_FOpenFile( name1, &file1, FS_READ );
+	len2 = trap_FS_FOpenFile( name2, &file2, FS_READ );
+	if( len1 < 0 || len2 < 0 || len1 != len2 )
+	{
+		if( len1 >= 0 )
+			trap_FS_FCloseFile( file1 );
+		if( len2 >= 0 )
+			trap_FS_FCloseFile( file2 );
+		return -1;
+	}
+
+	data1 = S_Malloc( len1 );
+	data2 = S_Malloc( len2 );
+	trap_FS_Read( data1, len1, file1 );
+	trap_FS_Read( data2, len2, file2 );
+	trap_FS_FCloseFile( file1 );
+	trap_FS_FCloseFile( file2 );
+
+	mismatches = 0;
+	for( i = 0; i < len1 / (int)sizeof( short ); i++ )
+	{
+		if( data1[i] != data2[i] )
+			mismatches++;
+	}
+
+	S_Free( data1 );
+	S_Free( data2 );
+	return mismatches;
+}
+
+/*
+* S_MixBench
+*
+* Renders a scripted scene with every channel busy using the C and SIMD
+* kernels, with and without voice virtualization, and checks that both
+* kernel sets dump identical output. Runs on the mixer thread, the live
+* mixer state is saved and restored around it.
+*/
+void S_MixBench( int iterations )
+{
+	int i, pass, seed;
+	int numMixed, numVirtMixed, mismatches;
+	unsigned int length;
+	uint64_t time[2], virtTime;
+	sfx_t sfx[MIXBENCH_SOUNDS];
+	rawsound_t *raw;
+	const mixFuncs_t *funcs[2] = { &s_mixFuncsC, &s_mixFuncsSIMD };
+	const char *dumpNames[2] = { "mixbench/c.raw", "mixbench/simd.raw" };
+	channel_t *savedChannels;
+	rawsound_t *savedRawSounds[MAX_RAW_SOUNDS];
+	playsound_t savedPendingPlays;
+	unsigned int savedPaintedtime;
+	dma_t savedDma;
+	int dumpfile;
+
+	if( !dma.buffer )
+	{
+		Com_Printf( "Sound is not initialized\n" );
+		return;
+	}
+	if( !s_volume->value )
+	{
+		Com_Printf( "s_volume is 0, nothing would be mixed\n" );
+		return;
+	}
+
+	if( iterations <= 0 )
+		iterations = 5;
+
+	// save the live state
+	savedChannels = S_Malloc( sizeof( channels ) );
+	memcpy( savedChannels, channels, sizeof( channels ) );
+	memcpy( savedRawSounds, raw_sounds, sizeof( raw_sounds ) );
+	savedPendingPlays = s_pendingplays;
+	savedPaintedtime = paintedtime;
+	savedDma = dma;
+
+	s_pendingplays.next = s_pendingplays.prev = &s_pendingplays;
+
+	dma.channels = 2;
+	dma.samplebits = 16;
+	dma.samples = MIXBENCH_DMA_SAMPLES;
+	dma.submission_chunk = 1;
+	dma.buffer = S_Malloc( MIXBENCH_DMA_SAMPLES * sizeof( short ) );
+
+	// the scene: 16-bit mono, stereo and one-shot sounds and an 8-bit mono loop
+	seed = 1;
+	memset( sfx, 0, sizeof( sfx ) );
+	for( i = 0; i < MIXBENCH_SOUNDS; i++ )
+		Q_snprintfz( sfx[i].name, sizeof( sfx[i].name ), "*mixbench%i", i );
+	sfx[0].cache = S_MixBenchCreateSound( dma.speed * 3 / 2, 1, 2, true, &seed );
+	sfx[1].cache = S_MixBenchCreateSound( dma.speed, 2, 2, true, &seed );
+	sfx[2].cache = S_MixBenchCreateSound( dma.speed * 4, 1, 2, false, &seed );
+	sfx[3].cache = S_MixBenchCreateSound( dma.speed / 3, 1, 1, true, &seed );
+
+	// and a stereo stream, wrapping around the raw samples buffer
+	memset( raw_sounds, 0, sizeof( raw_sounds ) );
+	raw = S_Malloc( sizeof( *raw ) + sizeof( portable_samplepair_t ) * MAX_RAW_SAMPLES );
+	raw->entnum = -1;
+	raw->left_volume = 40;
+	raw->right_volume = 60;
+	for( i = 0; i < MAX_RAW_SAMPLES; i++ )
+	{
+		raw->rawsamples[i].left = ( Q_rand( &seed ) & 0xffff ) - 0x8000;
+		raw->rawsamples[i].right = ( Q_rand( &seed ) & 0xffff ) - 0x8000;
+	}
+	raw_sounds[0] = raw;
+
+	length = dma.speed * MIXBENCH_SECONDS;
+
+	// output equivalence, through the AVI dump path
+	mismatches = -1;
+	for( pass = 0; pass < 2; pass++ )
+	{
+		if( trap_FS_FOpenFile( dumpNames[pass], &dumpfile, FS_WRITE ) == -1 )
+		{
+			Com_Printf( "Couldn't open %s for writing\n", dumpNames[pass] );
+			break;
+		}
+		S_MixBenchRender( funcs[pass], sfx, raw, length, false, dumpfile, &numMixed );
+		trap_FS_FCloseFile( dumpfile );
+	}
+	if( pass == 2 )
+		mismatches = S_MixBenchCompareDumps( dumpNames[0], dumpNames[1] );
+
+	// timing
+	time[0] = time[1] = virtTime = 0;
+	numMixed = numVirtMixed = 0;
+	for( i = 0; i < iterations; i++ )
+	{
+		for( pass = 0; pass < 2; pass++ )
+			time[pass] += S_MixBenchRender( funcs[pass], sfx, raw, length, false, 0, &numMixed );
+		virtTime += S_MixBenchRender( &s_mixFuncsSIMD, sfx, raw, length, true, 0, &numVirtMixed );
+	}
+
+	Com_Printf( "Mixed %i channels, %i seconds at %i Hz, %i iterations\n", MAX_CHANNELS, MIXBENCH_SECONDS, dma.speed, iterations );
+	Com_Printf( "C: %.1f ms, %s: %.1f ms (%.2fx)\n", time[0] / 1000.0 / iterations, 
+		s_mixFuncsSIMD.name, time[1] / 1000.0 / iterations, time[1] ? (double)time[0] / time[1] : 0.0 );
+	Com_Printf( "%s with virtualization: %.1f ms, %i of %i channels mixed (s_maxvoices %i, s_virtualvolume %i)\n", 
+		s_mixFuncsSIMD.name, virtTime / 1000.0 / iterations, numVirtMixed, numMixed, s_maxvoices->integer, s_virtualvolume->integer );
+	if( mismatches < 0 )
+		Com_Printf( S_COLOR_YELLOW "Couldn't compare the output dumps\n" );
+	else
+		Com_Printf( "%s%i mismatching samples\n", mismatches ? S_COLOR_RED : "", mismatches );
+
+	// restore the live state
+	for( i = 0; i < MIXBENCH_SOUNDS; i++ )
+		S_Free( sfx[i].cache );
+	S_Free( raw );
+	S_Free( dma.buffer );
+
+	dma = savedDma;
+	paintedtime = savedPaintedtime;
+	s_pendingplays = savedPendingPlays;
+	memcpy( raw_sounds, savedRawSounds, sizeof( raw_sounds ) );
+	memcpy( channels, savedChannels, sizeof( channels ) );
+	S_Free( savedChannels );
+}
@@ -208,7 +208,7 @@ sfxcache_t *SNDOGG_Load( sfx_t *s )
 	len = (int) ( (double) samples * (double) dma.speed / (double) vi->rate );
 	len = len * 2 * vi->channels;
 
-	sc = s->cache = S_Malloc( len + sizeof( sfxcache_t ) );
+	sc = S_Malloc( len + sizeof( sfxcache_t ) );
 	sc->length = samples;
 	sc->loopstart = sc->length;
 	sc->speed = vi->rate;
@@ -247,7 +247,6 @@ sfxcache_t *SNDOGG_Load( sfx_t *s )
 		if( (void *)buffer != sc->data )
 			S_Free( buffer );
 		S_Free( sc );
-		s->cache = NULL;
 		return NULL;
 	}
 
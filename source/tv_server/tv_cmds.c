@@ -24,6 +24,7 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 
 #include "tv_upstream.h"
 #include "tv_upstream_demos.h"
+#include "tv_loadtest.h"
 
 static char *TV_ConnstateToString( connstate_t state )
 {
@@ -70,6 +71,13 @@ static void TV_Upstream_Status_f( void )
 		Com_Printf( "Server name: %s\n", upstream->servername );
 		Com_Printf( "Connection: %s\n", TV_ConnstateToString( upstream->state ) );
 		Com_Printf( "Relay: %s\n", TV_ConnstateToString( upstream->relay.state ) );
+		if( upstream->relay.payloadCache.hits + upstream->relay.payloadCache.misses )
+		{
+			const snap_payloadcache_t *cache = &upstream->relay.payloadCache;
+
+			Com_Printf( "Shared frames: %u encoded, %u reused (%.1f%%)\n", cache->misses, cache->hits, 
+				100.0 * cache->hits / ( cache->hits + cache->misses ) );
+		}
 	}
 	else
 	{
@@ -502,6 +510,8 @@ static cmd_function_t cmdlist[] =
 
 	{ "music", TV_Music_f },
 
+	{ "loadtest", TV_LoadTest_f },
+
 	{ NULL, NULL }
 };
 
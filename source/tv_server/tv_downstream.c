@@ -308,7 +308,7 @@ static bool TV_Downstream_Netchan_Transmit( netchan_t *netchan, msg_t *msg )
 
 	if( tv_compresspackets->integer )
 	{
-		zerror = Netchan_CompressMessage( msg );
+		zerror = Netchan_CompressMessage( netchan, msg );
 		if( zerror < 0 )
 		{
 			// it's compression error, just send uncompressed
@@ -475,6 +475,8 @@ bool TV_Downstream_SendMessageToClient( client_t *client, msg_t *msg )
 	assert( client );
 
 	client->lastPacketSentTime = tvs.realtime;
+	if( client->simulated )
+		return true;
 	return TV_Downstream_Netchan_Transmit( &client->netchan, msg );
 }
 
@@ -540,6 +542,7 @@ void TV_Downstream_DropClient( client_t *drop, int type, const char *format, ...
 	drop->edict = NULL;
 	drop->relay = NULL;
 	drop->tv = false;
+	drop->simulated = false;
 	drop->state = CS_ZOMBIE;    // become free in a few seconds
 	drop->name[0] = 0;
 }
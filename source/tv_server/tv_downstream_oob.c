@@ -354,6 +354,7 @@ static void TV_Downstream_DirectConnect( const socket_t *socket, const netadr_t
 	client_t *cl, *newcl;
 	int i, version, game_port, challenge;
 	bool tv_client;
+	bool dictionary;
 
 	version = atoi( Cmd_Argv( 1 ) );
 	if( version != APP_PROTOCOL_VERSION )
@@ -374,6 +375,7 @@ static void TV_Downstream_DirectConnect( const socket_t *socket, const netadr_t
 	game_port = atoi( Cmd_Argv( 2 ) );
 	challenge = atoi( Cmd_Argv( 3 ) );
 	tv_client = ( atoi( Cmd_Argv( 5 ) ) & 1 ? true : false );
+	dictionary = ( ( atoi( Cmd_Argv( 5 ) ) >> NETCHAN_DICTIONARY_SHIFT ) == NETCHAN_DICTIONARY_VERSION );
 
 	if( !Info_Validate( Cmd_Argv( 4 ) ) )
 	{
@@ -508,8 +510,11 @@ static void TV_Downstream_DirectConnect( const socket_t *socket, const netadr_t
 		return;
 	}
 
-	// send the connect packet to the client
-	Netchan_OutOfBandPrint( socket, address, "client_connect" );
+	// only use the preset compression dictionary if the client has the same one
+	newcl->netchan.dictionaryCompression = dictionary;
+
+	// send the connect packet to the client, with an empty session line
+	Netchan_OutOfBandPrint( socket, address, "client_connect\n\n%i", dictionary ? NETCHAN_DICTIONARY_VERSION : 0 );
 
 	// free the incoming entry
 #ifdef TCP_ALLOW_TVCONNECT
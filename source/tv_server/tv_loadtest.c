@@ -0,0 +1,280 @@
+/*
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+*/
+
+// tv_loadtest.c: simulated spectators watching demo relays
+
+#include "tv_local.h"
+
+#include "tv_loadtest.h"
+
+#include "tv_upstream.h"
+#include "tv_upstream_demos.h"
+#include "tv_relay.h"
+#include "tv_relay_client.h"
+#include "tv_downstream.h"
+
+#define MAX_LOADTEST_RELAYS		64
+
+typedef struct
+{
+	bool active;
+	int numrelays;
+	upstream_t *upstreams[MAX_LOADTEST_RELAYS];
+	int spectators;						// per relay
+	int attached[MAX_LOADTEST_RELAYS];
+
+	unsigned int frames;
+	uint64_t relayTime;
+	uint64_t maxRelayTime;
+} tv_loadtest_t;
+
+static tv_loadtest_t tv_loadtest;
+
+/*
+* TV_LoadTest_FindUpstream
+*
+* The upstream is gone once its demo runs out of data
+*/
+static bool TV_LoadTest_FindUpstream( const upstream_t *upstream )
+{
+	int i;
+
+	for( i = 0; i < tvs.numupstreams; i++ )
+	{
+		if( tvs.upstreams[i] && tvs.upstreams[i] == upstream )
+			return true;
+	}
+
+	return false;
+}
+
+/*
+* TV_LoadTest_AttachSpectator
+*/
+static bool TV_LoadTest_AttachSpectator( relay_t *relay, int num )
+{
+	int i;
+	client_t *client;
+	netadr_t address;
+
+	for( i = 0, client = tvs.clients; i < tv_maxclients->integer; i++, client++ )
+	{
+		if( client->state == CS_FREE )
+			break;
+	}
+	if( i == tv_maxclients->integer )
+		return false;
+
+	memset( &client->flood, 0, sizeof( client->flood ) );
+	client->simulated = true;
+	client->reliable = true;		// no acks coming back
+	client->individual_socket = false;
+	client->socket.open = false;
+	client->tv = true;
+	client->mv = true;
+	tvs.nummvclients++;
+
+	TV_Downstream_ClientResetCommandBuffers( client, true );
+	client->lastPacketReceivedTime = tvs.realtime;
+	client->lastconnect = tvs.realtime;
+
+	NET_InitAddress( &address, NA_LOOPBACK );
+	Netchan_Setup( &client->netchan, &tvs.socket_udp, &address, 0 );
+
+	Q_snprintfz( client->userinfo, sizeof( client->userinfo ), "\\name\\loadtest%i_%i", relay->upstream->number, num );
+
+	client->state = CS_CONNECTED;
+	TV_Relay_ClientConnect( relay, client );
+	if( client->state != CS_CONNECTED )
+		return false;	// dropped
+
+	client->state = CS_SPAWNED;
+	TV_Relay_ClientBegin( relay, client );
+
+	return true;
+}
+
+/*
+* TV_LoadTest_Stop
+*/
+static void TV_LoadTest_Stop( void )
+{
+	int i;
+	client_t *client;
+
+	if( !tv_loadtest.active )
+		return;
+
+	for( i = 0, client = tvs.clients; i < tv_maxclients->integer; i++, client++ )
+	{
+		if( client->simulated && client->state != CS_FREE && client->state != CS_ZOMBIE )
+		{
+			TV_Downstream_DropClient( client, DROP_TYPE_GENERAL, "Load test finished" );
+			client->state = CS_FREE;
+		}
+	}
+
+	for( i = 0; i < tv_loadtest.numrelays; i++ )
+	{
+		if( TV_LoadTest_FindUpstream( tv_loadtest.upstreams[i] ) )
+			TV_Upstream_Shutdown( tv_loadtest.upstreams[i], "Load test finished" );
+	}
+
+	tv_loadtest.active = false;
+}
+
+/*
+* TV_LoadTest_Report
+*/
+static void TV_LoadTest_Report( void )
+{
+	int i, spectators, relays;
+
+	spectators = relays = 0;
+	for( i = 0; i < tv_loadtest.numrelays; i++ )
+	{
+		if( !TV_LoadTest_FindUpstream( tv_loadtest.upstreams[i] ) )
+			continue;
+		relays++;
+		spectators += tv_loadtest.attached[i];
+	}
+
+	Com_Printf( "%i relays, %i simulated spectators, %s\n", relays, spectators, 
+		tv_relaythreads->integer ? "threaded" : "unthreaded" );
+	if( !tv_loadtest.frames )
+		return;
+
+	Com_Printf( "%u frames, relay time avg %.3f ms, max %.3f ms\n", tv_loadtest.frames,
+		tv_loadtest.relayTime / ( 1000.0 * tv_loadtest.frames ), tv_loadtest.maxRelayTime / 1000.0 );
+}
+
+/*
+* TV_LoadTest_f
+*
+* loadtest <demo> <relays> <spectators per relay>
+* loadtest stop
+*/
+void TV_LoadTest_f( void )
+{
+	int i, numrelays, spectators;
+	char name[MAX_QPATH];
+	upstream_t *upstream;
+
+	if( Cmd_Argc() == 1 )
+	{
+		if( !tv_loadtest.active )
+		{
+			Com_Printf( "Usage: %s <demo> <relays> <spectators per relay>\n", Cmd_Argv( 0 ) );
+			Com_Printf( "       %s stop\n", Cmd_Argv( 0 ) );
+			return;
+		}
+
+		TV_LoadTest_Report();
+		return;
+	}
+
+	if( !Q_stricmp( Cmd_Argv( 1 ), "stop" ) )
+	{
+		if( tv_loadtest.active )
+			TV_LoadTest_Report();
+		TV_LoadTest_Stop();
+		return;
+	}
+
+	if( Cmd_Argc() < 4 )
+	{
+		Com_Printf( "Usage: %s <demo> <relays> <spectators per relay>\n", Cmd_Argv( 0 ) );
+		return;
+	}
+
+	numrelays = bound( 1, atoi( Cmd_Argv( 2 ) ), MAX_LOADTEST_RELAYS );
+	spectators = max( atoi( Cmd_Argv( 3 ) ), 1 );
+	if( numrelays * spectators > tv_maxclients->integer )
+		Com_Printf( S_COLOR_YELLOW "Only %i spectators fit in tv_maxclients\n", tv_maxclients->integer );
+
+	TV_LoadTest_Stop();
+
+	memset( &tv_loadtest, 0, sizeof( tv_loadtest ) );
+	tv_loadtest.active = true;
+	tv_loadtest.spectators = spectators;
+
+	for( i = 0; i < numrelays; i++ )
+	{
+		Q_snprintfz( name, sizeof( name ), "loadtest%i", i );
+
+		upstream = TV_Upstream_New( Cmd_Argv( 1 ), name, RELAY_MIN_DELAY );
+		TV_Upstream_StartDemo( upstream, Cmd_Argv( 1 ), false );
+		tv_loadtest.upstreams[tv_loadtest.numrelays++] = upstream;
+	}
+}
+
+/*
+* TV_LoadTest_Frame
+*
+* Spectators join as soon as their relay is up, the timing only starts once
+* all of them are in
+*/
+void TV_LoadTest_Frame( uint64_t relayTime )
+{
+	int i;
+	bool ready;
+	client_t *client;
+	relay_t *relay;
+
+	if( !tv_loadtest.active )
+		return;
+
+	ready = true;
+	for( i = 0; i < tv_loadtest.numrelays; i++ )
+	{
+		if( !TV_LoadTest_FindUpstream( tv_loadtest.upstreams[i] ) )
+			continue;
+
+		relay = &tv_loadtest.upstreams[i]->relay;
+		if( relay->state < CA_ACTIVE || !relay->module_export )
+		{
+			ready = false;
+			continue;
+		}
+
+		while( tv_loadtest.attached[i] < tv_loadtest.spectators )
+		{
+			if( !TV_LoadTest_AttachSpectator( relay, tv_loadtest.attached[i] ) )
+			{
+				// out of client slots, run with what we have
+				tv_loadtest.spectators = tv_loadtest.attached[i];
+				break;
+			}
+			tv_loadtest.attached[i]++;
+		}
+	}
+
+	// nothing ever arrives from the simulated spectators
+	for( i = 0, client = tvs.clients; i < tv_maxclients->integer; i++, client++ )
+	{
+		if( client->simulated )
+			client->lastPacketReceivedTime = tvs.realtime;
+	}
+
+	if( !ready )
+		return;
+
+	tv_loadtest.frames++;
+	tv_loadtest.relayTime += relayTime;
+	tv_loadtest.maxRelayTime = max( tv_loadtest.maxRelayTime, relayTime );
+}
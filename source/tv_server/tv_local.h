@@ -103,6 +103,7 @@ typedef struct
 	unsigned int sentTimeStamp;         // time at what this frame snap was sent to the clients
 	unsigned int UcmdExecuted;
 	game_state_t gameState;
+	unsigned int sharedId;				// nonzero if several clients got a copy of the same frame
 } client_snapshot_t;
 
 typedef enum { RD_NONE, RD_PACKET } redirect_t;
@@ -144,6 +145,7 @@ typedef struct client_s
 	bool reliable;                  // no need for acks, upstream is reliable
 	bool mv;                        // send multiview data to the client
 	bool individual_socket;         // client has it's own socket that has to be checked separately
+	bool simulated;                 // load test spectator, nothing is sent over the network
 
 	socket_t socket;
 
@@ -254,6 +256,7 @@ extern cvar_t *tv_reconnectlimit;
 extern cvar_t *tv_public;
 extern cvar_t *tv_autorecord;
 extern cvar_t *tv_lobbymusic;
+extern cvar_t *tv_relaythreads;
 
 extern cvar_t *tv_masterservers;
 extern cvar_t *tv_masterservers_steam;
@@ -26,6 +26,8 @@
 #include "tv_cmds.h"
 #include "tv_downstream.h"
 #include "tv_lobby.h"
+#include "tv_relay_client.h"
+#include "tv_loadtest.h"
 
 tv_t tvs;
 
@@ -46,6 +48,7 @@ cvar_t *tv_tcp;
 cvar_t *tv_public;
 cvar_t *tv_autorecord;
 cvar_t *tv_lobbymusic;
+cvar_t *tv_relaythreads;
 
 cvar_t *tv_timeout;
 cvar_t *tv_zombietime;
@@ -107,6 +110,7 @@ void TV_Init( void )
 	tv_rcon_password = Cvar_Get( "tv_rcon_password", "", 0 );
 	tv_autorecord = Cvar_Get( "tv_autorecord", "", CVAR_ARCHIVE );
 	tv_lobbymusic = Cvar_Get( "tv_lobbymusic", "", CVAR_ARCHIVE );
+	tv_relaythreads = Cvar_Get( "tv_relaythreads", "1", CVAR_ARCHIVE );
 
 	tv_masterservers = Cvar_Get( "tv_masterservers", DEFAULT_MASTER_SERVERS_IPS, CVAR_LATCH );
 	tv_masterservers_steam = Cvar_Get( "tv_masterservers_steam", DEFAULT_MASTER_SERVERS_STEAM_IPS, CVAR_LATCH );
@@ -217,11 +221,14 @@ void TV_Init( void )
 void TV_Frame( int realmsec, int gamemsec )
 {
 	int i;
+	uint64_t relayTime;
 
 	tvs.realtime += realmsec;
 
 	TV_Lobby_Run();
 
+	relayTime = Sys_Microseconds();
+
 	for( i = 0; i < tvs.numupstreams; i++ )
 	{
 		if( !tvs.upstreams[i] )
@@ -234,6 +241,23 @@ void TV_Frame( int realmsec, int gamemsec )
 	}
 	userinfo_modified = false;
 
+	// relays may touch each other's spectators while running, so the snaps are
+	// only encoded, each on its relay's thread, after all of them are done
+	for( i = 0; i < tvs.numupstreams; i++ )
+	{
+		if( tvs.upstreams[i] )
+			TV_Relay_StartClientMessages( &tvs.upstreams[i]->relay );
+	}
+	for( i = 0; i < tvs.numupstreams; i++ )
+	{
+		if( tvs.upstreams[i] )
+			TV_Relay_FinishClientMessages( &tvs.upstreams[i]->relay );
+	}
+
+	relayTime = Sys_Microseconds() - relayTime;
+
+	TV_LoadTest_Frame( relayTime );
+
 	TV_Downstream_ReadPackets();
 	TV_Downstream_SendClientMessages();
 	TV_Downstream_CheckTimeouts();
@@ -197,6 +197,9 @@ void TV_Relay_Shutdown( relay_t *relay, const char *format, ... )
 
 	Com_Printf( "%s" S_COLOR_WHITE ": Relay shutdown: %s\n", relay->upstream->name, msg );
 
+	// the last snap may not have been sent yet
+	TV_Relay_FinishClientMessages( relay );
+
 	// send a message to each connected client
 	for( i = 0, client = tvs.clients; i < tv_maxclients->integer; i++, client++ )
 	{
@@ -236,6 +239,10 @@ void TV_Relay_Shutdown( relay_t *relay, const char *format, ... )
 		memset( &relay->client_entities, 0, sizeof( relay->client_entities ) );
 	}
 
+	SNAP_FreePayloadCache( &relay->payloadCache );
+
+	TV_Relay_ShutdownThread( relay );
+
 	CM_ReleaseReference( relay->cms );
 	relay->cms = NULL;
 
@@ -406,9 +413,8 @@ void TV_Relay_Run( relay_t *relay, int msec )
 		relay->module_export->NewFrameSnapshot( relay->module, relay->curFrame );
 		relay->module_export->SnapFrame( relay->module );
 
-		TV_Relay_SendClientMessages( relay );
-
-		relay->module_export->ClearSnap( relay->module );
+		// sent by TV_Frame once all relays have run
+		relay->snapPending = true;
 	}
 
 	if( relay->upstream->state == CA_DISCONNECTED && relay->packetqueue_pos == relay->upstream->packetqueue_head )
@@ -443,6 +449,10 @@ void TV_Relay_Init( relay_t *relay, upstream_t *upstream, int delay )
 	relay->client_entities.num_entities = tv_maxclients->integer * UPDATE_BACKUP * MAX_SNAP_ENTITIES;
 	relay->client_entities.entities = Mem_Alloc( upstream->mempool, sizeof( entity_state_t ) * relay->client_entities.num_entities );
 
+	SNAP_InitPayloadCache( &relay->payloadCache, MAX_MSGLEN * 4, upstream->mempool );
+
+	TV_Relay_InitThread( relay );
+
 	relay->cms = CM_New( upstream->mempool );
 	CM_AddReference( relay->cms );
 
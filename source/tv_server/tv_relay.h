@@ -63,6 +63,23 @@ typedef struct client_entities_s
 	entity_state_t *entities;			// [num_entities]
 } client_entities_t;
 
+typedef struct
+{
+	int clientnum;
+	size_t offset;
+	size_t size;
+} relay_outmsg_t;
+
+// messages encoded for the spectators, waiting to be sent from the main thread
+typedef struct
+{
+	int nummsgs;
+	relay_outmsg_t *msgs;				// [tv_maxclients->integer]
+	size_t size;
+	size_t maxsize;
+	uint8_t *data;
+} relay_outbox_t;
+
 struct relay_s
 {
 	connstate_t state;
@@ -105,6 +122,22 @@ struct relay_s
 
 	client_entities_t client_entities;
 
+	// multiview frames are identical for all spectators, so they are built and encoded once
+	unsigned int sharedFrameId;
+	snap_payloadcache_t payloadCache;
+
+	// the spectator messages of a snap are encoded on the relay thread while
+	// the main thread waits, then handed back through the outbox for sending
+	bool snapPending;
+	bool snapStarted;
+	relay_outbox_t outbox;
+	struct qthread_s *thread;
+	struct qmutex_s *threadMutex;
+	struct qcondvar_s *threadWakeCond;
+	struct qcondvar_s *threadDoneCond;
+	volatile bool threadWork;
+	volatile bool threadShutdown;
+
 	// serverdata
 	int playernum;
 	int servercount;
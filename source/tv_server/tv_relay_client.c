@@ -23,29 +23,49 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 #include "tv_relay_client.h"
 
 #include "tv_relay.h"
+#include "tv_upstream.h"
 #include "tv_downstream.h"
 
+/*
+* TV_Relay_ParseSkyOrigin
+*
+* Returns false if there's no sky portal with entities in it
+*/
+static bool TV_Relay_ParseSkyOrigin( relay_t *relay, vec3_t origin )
+{
+	int noents = 0;
+	float f1 = 0, f2 = 0;
+
+	if( relay->configstrings[CS_SKYBOX][0] == '\0' )
+		return false;
+
+	if( sscanf( relay->configstrings[CS_SKYBOX], "%f %f %f %f %f %i", &origin[0], &origin[1], &origin[2], &f1, &f2, &noents ) < 3 )
+		return false;
+
+	return !noents;
+}
+
+/*
+* TV_Relay_ClientCanShareFrame
+*
+* Multiview frames of a relay that doesn't occupy a player slot on the upstream
+* server don't depend on the spectator at all
+*/
+static bool TV_Relay_ClientCanShareFrame( relay_t *relay, client_t *client )
+{
+	return client->mv && relay->playernum < 0;
+}
+
 /*
 * TV_Relay_BuildClientFrameSnap
+*
+* The sky portal origin must have been set in relay->fatvis for the current frame
 */
 void TV_Relay_BuildClientFrameSnap( relay_t *relay, client_t *client )
 {
 	edict_t *clent;
 	entity_state_t backup_state = { 0 };
 	entity_shared_t backup_shared = { 0 };
-	vec_t *skyorg = NULL, origin[3];
-
-	if( relay->configstrings[CS_SKYBOX][0] != '\0' )
-	{
-		int noents = 0;
-		float f1 = 0, f2 = 0;
-
-		if( sscanf( relay->configstrings[CS_SKYBOX], "%f %f %f %f %f %i", &origin[0], &origin[1], &origin[2], &f1, &f2, &noents ) >= 3 )
-		{
-			if( !noents )
-				skyorg = origin;
-		}
-	}
 
 	// pretend client occupies our slot on real server
 	clent = client->edict;
@@ -76,7 +96,6 @@ void TV_Relay_BuildClientFrameSnap( relay_t *relay, client_t *client )
 		}
 	}
 
-	relay->fatvis.skyorg = skyorg;		// HACK HACK HACK
 	SNAP_BuildClientFrameSnap( relay->cms, &relay->gi, relay->framenum, relay->realtime, &relay->fatvis,
 		client, relay->module_export->GetGameState( relay->module ),
 		&relay->client_entities,
@@ -91,13 +110,18 @@ void TV_Relay_BuildClientFrameSnap( relay_t *relay, client_t *client )
 }
 
 /*
-* TV_Relay_SendClientDatagram
+* TV_Relay_EncodeClientDatagram
+*
+* Builds the frame for the client and appends the message to the outbox.
+* If sharedSource is set, the client gets a copy of the frame built for it.
 */
-static bool TV_Relay_SendClientDatagram( relay_t *relay, client_t *client )
+static void TV_Relay_EncodeClientDatagram( relay_t *relay, client_t *client, client_t *sharedSource )
 {
 	uint8_t msg_buf[MAX_MSGLEN];
 	msg_t msg;
 	snapshot_t *frame;
+	relay_outbox_t *outbox = &relay->outbox;
+	relay_outmsg_t *outmsg;
 
 	assert( relay );
 	assert( client );
@@ -109,13 +133,254 @@ static bool TV_Relay_SendClientDatagram( relay_t *relay, client_t *client )
 
 	// send over all the relevant entity_state_t
 	// and the player_state_t
-	TV_Relay_BuildClientFrameSnap( relay, client );
+	if( sharedSource && sharedSource != client )
+	{
+		SNAP_ShareClientFrameSnap( relay->cms, client, sharedSource, relay->framenum, relay->sharedFrameId, tv_mempool );
+	}
+	else
+	{
+		TV_Relay_BuildClientFrameSnap( relay, client );
+		if( sharedSource )
+			client->snapShots[relay->framenum & UPDATE_MASK].sharedId = relay->sharedFrameId;
+	}
 
 	frame = relay->curFrame;
 	SNAP_WriteFrameSnapToClient( &relay->gi, client, &msg, relay->framenum, relay->serverTime, relay->baselines,
-		&relay->client_entities, frame->numgamecommands, frame->gamecommands, frame->gamecommandsData );
+		&relay->client_entities, frame->numgamecommands, frame->gamecommands, frame->gamecommandsData, 
+		&relay->payloadCache );
 
-	return TV_Downstream_SendMessageToClient( client, &msg );
+	if( outbox->size + msg.cursize > outbox->maxsize )
+	{
+		outbox->maxsize = max( outbox->maxsize * 2, outbox->size + msg.cursize );
+		outbox->data = Mem_Realloc( outbox->data, outbox->maxsize );
+	}
+
+	assert( outbox->nummsgs < tv_maxclients->integer );
+	outmsg = &outbox->msgs[outbox->nummsgs++];
+	outmsg->clientnum = client - tvs.clients;
+	outmsg->offset = outbox->size;
+	outmsg->size = msg.cursize;
+
+	memcpy( outbox->data + outbox->size, msg.data, msg.cursize );
+	outbox->size += msg.cursize;
+}
+
+/*
+* TV_Relay_EncodeClientMessages
+*
+* Doesn't touch anything but the relay and its own spectators, so it may run
+* on the relay thread while no other relay is handled on the main thread.
+*/
+static void TV_Relay_EncodeClientMessages( relay_t *relay )
+{
+	int i;
+	client_t *client, *sharedSource;
+	vec3_t skyorg;
+
+	assert( relay );
+
+	// this only changes with the configstrings, parse it once for all clients
+	relay->fatvis.skyorg = TV_Relay_ParseSkyOrigin( relay, skyorg ) ? skyorg : NULL;		// HACK HACK HACK
+
+	SNAP_ClearPayloadCache( &relay->payloadCache );
+	sharedSource = NULL;
+
+	relay->outbox.nummsgs = 0;
+	relay->outbox.size = 0;
+
+	for( i = 0, client = tvs.clients; i < tv_maxclients->integer; i++, client++ )
+	{
+		if( client->state != CS_SPAWNED )
+			continue;
+		if( client->relay != relay )
+			continue;
+
+		if( TV_Relay_ClientCanShareFrame( relay, client ) )
+		{
+			// the first one builds the frame, the rest copy it
+			if( !sharedSource )
+			{
+				sharedSource = client;
+				if( !++relay->sharedFrameId )
+					relay->sharedFrameId++;
+			}
+			TV_Relay_EncodeClientDatagram( relay, client, sharedSource );
+		}
+		else
+		{
+			TV_Relay_EncodeClientDatagram( relay, client, NULL );
+		}
+	}
+
+	relay->fatvis.skyorg = NULL;
+}
+
+/*
+* TV_Relay_TransmitClientMessages
+*
+* Sends the encoded messages over the network, must be called from the main thread
+*/
+static void TV_Relay_TransmitClientMessages( relay_t *relay )
+{
+	int i;
+	uint8_t msg_buf[MAX_MSGLEN];
+	msg_t msg;
+	client_t *client;
+	relay_outmsg_t *outmsg;
+
+	for( i = 0, outmsg = relay->outbox.msgs; i < relay->outbox.nummsgs; i++, outmsg++ )
+	{
+		client = &tvs.clients[outmsg->clientnum];
+		if( client->state != CS_SPAWNED || client->relay != relay )
+			continue;
+
+		if( client->simulated )
+		{
+			// pretend the frame has arrived
+			client->lastframe = relay->framenum;
+		}
+
+		// compression is done in place, so the message needs a buffer of its own
+		MSG_Init( &msg, msg_buf, sizeof( msg_buf ) );
+		MSG_WriteData( &msg, relay->outbox.data + outmsg->offset, outmsg->size );
+
+		if( !TV_Downstream_SendMessageToClient( client, &msg ) )
+		{
+			Com_Printf( "%s" S_COLOR_WHITE ": Error sending message: %s\n", client->name, NET_ErrorString() );
+			if( client->reliable )
+			{
+				TV_Downstream_DropClient( client, DROP_TYPE_GENERAL, "Error sending message: %s\n",
+					NET_ErrorString() );
+			}
+		}
+	}
+
+	relay->outbox.nummsgs = 0;
+	relay->outbox.size = 0;
+}
+
+/*
+* TV_Relay_ThreadProc
+*/
+static void *TV_Relay_ThreadProc( void *param )
+{
+	relay_t *relay = ( relay_t * )param;
+
+	QMutex_Lock( relay->threadMutex );
+
+	while( !relay->threadShutdown )
+	{
+		if( !relay->threadWork )
+		{
+			QCondVar_Wait( relay->threadWakeCond, relay->threadMutex, Q_THREADS_WAIT_INFINITE );
+			continue;
+		}
+
+		// the relay belongs to this thread until threadWork is cleared
+		QMutex_Unlock( relay->threadMutex );
+		TV_Relay_EncodeClientMessages( relay );
+		QMutex_Lock( relay->threadMutex );
+
+		relay->threadWork = false;
+		QCondVar_Wake( relay->threadDoneCond );
+	}
+
+	QMutex_Unlock( relay->threadMutex );
+	return NULL;
+}
+
+/*
+* TV_Relay_InitThread
+*/
+void TV_Relay_InitThread( relay_t *relay )
+{
+	relay->outbox.msgs = Mem_Alloc( relay->upstream->mempool, sizeof( relay_outmsg_t ) * tv_maxclients->integer );
+	relay->outbox.maxsize = MAX_MSGLEN;
+	relay->outbox.data = Mem_Alloc( relay->upstream->mempool, relay->outbox.maxsize );
+
+	if( !tv_relaythreads->integer )
+		return;
+
+	relay->threadMutex = QMutex_Create();
+	relay->threadWakeCond = QCondVar_Create();
+	relay->threadDoneCond = QCondVar_Create();
+	relay->thread = QThread_Create( TV_Relay_ThreadProc, relay );
+}
+
+/*
+* TV_Relay_ShutdownThread
+*/
+void TV_Relay_ShutdownThread( relay_t *relay )
+{
+	if( relay->thread )
+	{
+		QMutex_Lock( relay->threadMutex );
+		relay->threadShutdown = true;
+		QCondVar_Wake( relay->threadWakeCond );
+		QMutex_Unlock( relay->threadMutex );
+
+		QThread_Join( relay->thread );
+		relay->thread = NULL;
+
+		QCondVar_Destroy( &relay->threadDoneCond );
+		QCondVar_Destroy( &relay->threadWakeCond );
+		QMutex_Destroy( &relay->threadMutex );
+	}
+
+	if( relay->outbox.msgs )
+		Mem_Free( relay->outbox.msgs );
+	if( relay->outbox.data )
+		Mem_Free( relay->outbox.data );
+	memset( &relay->outbox, 0, sizeof( relay->outbox ) );
+}
+
+/*
+* TV_Relay_StartClientMessages
+*
+* Hands the pending snapshot over to the relay thread. Until it's finished, nothing
+* on the main thread may touch the relay or its spectators.
+*/
+void TV_Relay_StartClientMessages( relay_t *relay )
+{
+	if( !relay->snapPending || !relay->thread )
+		return;
+
+	relay->snapStarted = true;
+
+	QMutex_Lock( relay->threadMutex );
+	relay->threadWork = true;
+	QCondVar_Wake( relay->threadWakeCond );
+	QMutex_Unlock( relay->threadMutex );
+}
+
+/*
+* TV_Relay_FinishClientMessages
+*
+* Waits for the relay thread, or encodes the snapshot right here if it hasn't
+* been handed over, sends it and lets the module clear the snap.
+*/
+void TV_Relay_FinishClientMessages( relay_t *relay )
+{
+	if( !relay->snapPending )
+		return;
+
+	if( relay->snapStarted )
+	{
+		QMutex_Lock( relay->threadMutex );
+		while( relay->threadWork )
+			QCondVar_Wait( relay->threadDoneCond, relay->threadMutex, Q_THREADS_WAIT_INFINITE );
+		QMutex_Unlock( relay->threadMutex );
+	}
+	else
+	{
+		TV_Relay_EncodeClientMessages( relay );
+	}
+
+	relay->snapPending = relay->snapStarted = false;
+
+	TV_Relay_TransmitClientMessages( relay );
+
+	relay->module_export->ClearSnap( relay->module );
 }
 
 /*
@@ -166,29 +431,10 @@ void TV_Relay_ReconnectClients( relay_t *relay )
 */
 void TV_Relay_SendClientMessages( relay_t *relay )
 {
-	int i;
-	client_t *client;
-
 	assert( relay );
 
-	// send a message to each connected client
-	for( i = 0, client = tvs.clients; i < tv_maxclients->integer; i++, client++ )
-	{
-		if( client->state != CS_SPAWNED )
-			continue;
-		if( client->relay != relay )
-			continue;
-
-		if( !TV_Relay_SendClientDatagram( relay, client ) )
-		{
-			Com_Printf( "%s" S_COLOR_WHITE ": Error sending message: %s\n", client->name, NET_ErrorString() );
-			if( client->reliable )
-			{
-				TV_Downstream_DropClient( client, DROP_TYPE_GENERAL, "Error sending message: %s\n",
-					NET_ErrorString() );
-			}
-		}
-	}
+	TV_Relay_EncodeClientMessages( relay );
+	TV_Relay_TransmitClientMessages( relay );
 }
 
 /*
@@ -24,6 +24,10 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 #include "tv_local.h"
 
 void TV_Relay_SendClientMessages( relay_t *relay );
+void TV_Relay_StartClientMessages( relay_t *relay );
+void TV_Relay_FinishClientMessages( relay_t *relay );
+void TV_Relay_InitThread( relay_t *relay );
+void TV_Relay_ShutdownThread( relay_t *relay );
 void TV_Relay_ReconnectClients( relay_t *relay );
 void TV_Relay_ClientUserinfoChanged( relay_t *relay, client_t *client );
 void TV_Relay_ClientBegin( relay_t *relay, client_t *client );
@@ -165,7 +165,7 @@ static void TV_Upstream_Netchan_Transmit( upstream_t *upstream, msg_t *msg )
 
 	// do not enable client compression until I fix the compression+fragmentation rare case bug
 	/*if( cl_compresspackets->integer ) {
-	zerror = Netchan_CompressMessage( msg );
+	zerror = Netchan_CompressMessage( &upstream->netchan, msg );
 	if( zerror < 0 ) {  // it's compression error, just send uncompressed
 	Com_DPrintf( "TV_Upstream_Netchan_Transmit (ignoring compression): Compression error %i\n", zerror );
 	}
@@ -589,7 +589,8 @@ void TV_Upstream_SendConnectPacket( upstream_t *upstream )
 	upstream->userinfo_modified = false;
 
 	Netchan_OutOfBandPrint( upstream->socket, &upstream->serveraddress, "connect %i %i %i \"%s\" %i\n",
-		APP_PROTOCOL_VERSION, Netchan_GamePort(), upstream->challenge, TV_Upstream_Userinfo( upstream ), 1 );
+		APP_PROTOCOL_VERSION, Netchan_GamePort(), upstream->challenge, TV_Upstream_Userinfo( upstream ), 
+		1 | ( NETCHAN_DICTIONARY_VERSION << NETCHAN_DICTIONARY_SHIFT ) );
 }
 
 /*
@@ -56,6 +56,10 @@ static void TV_Upstream_ClientConnectPacket( upstream_t *upstream, msg_t *msg )
 		return;
 
 	Netchan_Setup( &upstream->netchan, upstream->socket, &upstream->serveraddress, Netchan_GamePort() );
+
+	MSG_ReadStringLine( msg ); // session
+	upstream->netchan.dictionaryCompression = ( atoi( MSG_ReadStringLine( msg ) ) == NETCHAN_DICTIONARY_VERSION );
+
 	upstream->state = CA_HANDSHAKE;
 	TV_Upstream_AddReliableCommand( upstream, "new" );
 
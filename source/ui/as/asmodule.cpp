@@ -6,9 +6,14 @@
 #include "as/asui_local.h"
 
 #include <list>
+#include <map>
+#include <vector>
 
 #define UI_AS_MODULE "UI_AS_MODULE"
 
+#define UI_AS_BYTECODE_CACHE_DIRECTORY "cache"
+#define UI_AS_BYTECODE_EXTENSION ".asb"
+
 namespace ASUI {
 
 typedef WSWUI::UI_Main UI_Main;
@@ -129,12 +134,40 @@ public:
 
 class ASModule : public ASInterface
 {
+	// script sections are held back until finishBuilding so that the whole
+	// module can be checked against the bytecode cache first
+	typedef std::pair<std::string, std::string> ScriptSection;
+	typedef std::vector<ScriptSection> ScriptSectionList;
+	typedef std::map<asIScriptModule *, ScriptSectionList> PendingScriptsMap;
+
 	UI_Main *ui_main;
 
 	asIScriptEngine *engine;
 	struct angelwrap_api_s *as_api;
 	asIObjectType *stringObjectType;
 
+	PendingScriptsMap pendingScripts;
+
+	// builds the bytecode cache filename from the module (document) name
+	std::string getByteCodeCacheName( asIScriptModule *module ) const
+	{
+		std::string name( module->GetName() );
+
+		std::string::size_type query = name.find_first_of( "?#" );
+		if( query != std::string::npos ) {
+			name.erase( query );
+		}
+		while( !name.empty() && ( name[0] == '/' || name[0] == '\\' ) ) {
+			name.erase( 0, 1 );
+		}
+
+		char filename[MAX_QPATH];
+		Q_snprintfz( filename, sizeof( filename ), "%s/%s", UI_AS_BYTECODE_CACHE_DIRECTORY, name.c_str() );
+		COM_SanitizeFilePath( filename );
+		COM_ReplaceExtension( filename, UI_AS_BYTECODE_EXTENSION, sizeof( filename ) );
+		return filename;
+	}
+
 // private class, its ok to have everything as public :)
 public:
 	ASModule()
@@ -180,6 +213,8 @@ public:
 	{
 		//module = 0;
 
+		pendingScripts.clear();
+
 		if( as_api && engine != NULL )
 			as_api->asReleaseEngine( engine );
 
@@ -245,20 +280,53 @@ public:
 		if( !module ) {
 			return false;
 		}
-		return module->Build() >= 0;
+
+		unsigned int startTime = trap::Milliseconds();
+
+		ScriptSectionList sections;
+		PendingScriptsMap::iterator it = pendingScripts.find( module );
+		if( it != pendingScripts.end() ) {
+			sections.swap( it->second );
+			pendingScripts.erase( it );
+		}
+
+		unsigned int sourceHash = 0;
+		for( ScriptSectionList::const_iterator sit = sections.begin(); sit != sections.end(); ++sit ) {
+			sourceHash = as_api->asHashScriptSection( sourceHash, sit->first.c_str(), sit->second.c_str(), sit->second.size() );
+		}
+
+		std::string cacheName( getByteCodeCacheName( module ) );
+		if( as_api->asLoadByteCode( module, cacheName.c_str(), sourceHash ) ) {
+			Com_Printf( "ASModule: loaded '%s' from bytecode cache in %u ms\n", module->GetName(), trap::Milliseconds() - startTime );
+			return true;
+		}
+
+		for( ScriptSectionList::const_iterator sit = sections.begin(); sit != sections.end(); ++sit ) {
+			if( module->AddScriptSection( sit->first.c_str(), sit->second.c_str(), sit->second.size() ) < 0 ) {
+				return false;
+			}
+		}
+
+		if( module->Build() < 0 ) {
+			return false;
+		}
+
+		Com_Printf( "ASModule: built '%s' from source in %u ms\n", module->GetName(), trap::Milliseconds() - startTime );
+
+		as_api->asSaveByteCode( module, cacheName.c_str(), sourceHash );
+		return true;
 	}
 
 	virtual bool addScript( asIScriptModule *module, const char *name, const char *code )
 	{
-		// TODO: precache SaveByteCode/LoadByteCode
-		// (this can be done on a global .rml level too)
 		// TODO: figure out if name can be NULL, or otherwise create
 		// temp name from NULL argument to differentiate <script> tags
 		// without source
 		if( !module )
 			return false;
 
-		return module->AddScriptSection( name, code ) >= 0;
+		pendingScripts[module].push_back( ScriptSection( name, code ) );
+		return true;
 	}
 
 	virtual bool addFunction( asIScriptModule *module, const char *name, const char *code, asIScriptFunction **outFunction )
@@ -267,8 +335,6 @@ public:
 		return module ? (module->CompileFunction( name, code, 0, asCOMP_ADD_TO_MODULE, outFunction ) >= 0) : false;
 	}
 
-	// TODO: disk/mem-cache fully compiled set (use Binary*Stream)
-
 	// testing, dumpapi, note that path has to end with '/'
 	virtual void dumpAPI( const char *path )
 	{
@@ -423,6 +489,7 @@ public:
 	virtual void buildReset( asIScriptModule *module )
 	{
 		if( engine && module ) {
+			pendingScripts.erase( module );
 			module->Discard();
 		}
 		garbageCollectFullCycle();
@@ -47,6 +47,10 @@ FIXME:  This will be remidied once a native Mac port is complete
 #include <machine/param.h>
 #endif
 
+#if defined ( __linux__ )
+#include <sys/prctl.h>
+#endif
+
 #include "../qcommon/qcommon.h"
 #include "glob.h"
 
@@ -259,6 +263,105 @@ int Sys_GetCurrentProcessId( void )
 	return getpid();
 }
 
+/*
+* Sys_GetMemoryUsage
+*
+* Resident set size of this process, the part of it no other process maps
+* and the amount of physical memory, in bytes. Pages shared with the binary,
+* libraries or other server instances are not unique. Returns false if the
+* numbers are not available.
+*/
+bool Sys_GetMemoryUsage( size_t *resident, size_t *unique, size_t *physical )
+{
+	FILE *f;
+	long pageSize, physPages;
+	unsigned long size, rss, shr, kb;
+	unsigned long rssKb, privateKb;
+	char line[256];
+	int n;
+
+	pageSize = sysconf( _SC_PAGESIZE );
+	physPages = sysconf( _SC_PHYS_PAGES );
+	if( pageSize <= 0 || physPages <= 0 ) {
+		return false;
+	}
+	*physical = ( size_t )physPages * pageSize;
+
+	// private pages are only accounted for in smaps, smaps_rollup has the
+	// totals since Linux 4.14
+	f = fopen( "/proc/self/smaps_rollup", "r" );
+	if( f ) {
+		rssKb = privateKb = 0;
+		while( fgets( line, sizeof( line ), f ) ) {
+			if( sscanf( line, "Rss: %lu kB", &kb ) == 1 ) {
+				rssKb = kb;
+			} else if( sscanf( line, "Private_Clean: %lu kB", &kb ) == 1 || sscanf( line, "Private_Dirty: %lu kB", &kb ) == 1 ) {
+				privateKb += kb;
+			}
+		}
+		fclose( f );
+
+		if( rssKb ) {
+			*resident = ( size_t )rssKb * 1024;
+			*unique = ( size_t )privateKb * 1024;
+			return true;
+		}
+	}
+
+	// statm only knows about file backed shared pages, so anonymous memory
+	// still shared with the parent after fork is counted as unique
+	f = fopen( "/proc/self/statm", "r" );
+	if( !f ) {
+		return false;
+	}
+	n = fscanf( f, "%lu %lu %lu", &size, &rss, &shr );
+	fclose( f );
+	if( n != 3 ) {
+		return false;
+	}
+
+	*resident = ( size_t )rss * pageSize;
+	*unique = ( size_t )( rss - min( shr, rss ) ) * pageSize;
+	return true;
+}
+
+/*
+* Sys_ForkInstance
+*
+* Starts a copy of this process that shares all memory with it until either
+* side writes to a page. Returns the pid of the copy to the caller, 0 in the
+* copy and -1 on failure. Only the calling thread exists in the copy.
+*/
+int Sys_ForkInstance( void )
+{
+	pid_t pid;
+	int fd;
+
+	fflush( stdout );
+	fflush( stderr );
+
+	pid = fork();
+	if( pid < 0 ) {
+		return -1;
+	}
+
+	if( !pid ) {
+		// the terminal belongs to the first instance
+		fd = open( "/dev/null", O_RDONLY );
+		if( fd >= 0 ) {
+			dup2( fd, 0 );
+			close( fd );
+		}
+
+#ifdef __linux__
+		// don't keep running if the first instance is gone
+		prctl( PR_SET_PDEATHSIG, SIGTERM );
+#endif
+	}
+
+	return ( int )pid;
+}
+
 /*
 * Sys_GetPreferredLanguage
 */
@@ -336,13 +439,16 @@ int main( int argc, char **argv )
 		// find time spent rendering last frame
 		do
 		{
-			newtime = Sys_Milliseconds();
+			uint64_t usec = Sys_Microseconds();
+
+			newtime = usec / 1000;
 			time = newtime - oldtime;
 			if( time > 0 )
 				break;
-#ifdef PUTCPU2SLEEP
-			Sys_Sleep( 0 );
-#endif
+
+			// sleep until the next millisecond instead of spinning on the clock, the
+			// server has already slept on its sockets until its next deadline
+			usleep( ( usec / 1000 + 1 ) * 1000 - usec );
 		}
 		while( 1 );
 		oldtime = newtime;
@@ -23,6 +23,7 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 #include <pthread.h>
 #include <sched.h>
 #include <sys/time.h>
+#include <unistd.h>
 
 struct qthread_s {
 	pthread_t t;
@@ -127,6 +128,15 @@ void Sys_Thread_Yield( void )
 	sched_yield();
 }
 
+/*
+* Sys_Thread_NumProcessors
+*/
+int Sys_Thread_NumProcessors( void )
+{
+	long num = sysconf( _SC_NPROCESSORS_ONLN );
+	return num > 0 ? (int)num : 1;
+}
+
 /*
 * Sys_Atomic_Add
 */
@@ -226,6 +226,68 @@ int Sys_GetCurrentProcessId( void )
 	return GetCurrentProcessId();
 }
 
+/*
+* Sys_GetMemoryUsage
+*
+* K32GetProcessMemoryInfo is only exported by kernel32 on Windows 7 and newer.
+* The private commit charge stands in for the unique part of the working set.
+*/
+bool Sys_GetMemoryUsage( size_t *resident, size_t *unique, size_t *physical )
+{
+	typedef struct {
+		DWORD cb;
+		DWORD PageFaultCount;
+		SIZE_T PeakWorkingSetSize;
+		SIZE_T WorkingSetSize;
+		SIZE_T QuotaPeakPagedPoolUsage;
+		SIZE_T QuotaPagedPoolUsage;
+		SIZE_T QuotaPeakNonPagedPoolUsage;
+		SIZE_T QuotaNonPagedPoolUsage;
+		SIZE_T PagefileUsage;
+		SIZE_T PeakPagefileUsage;
+	} memcounters_t;
+	typedef BOOL (WINAPI *K32GetProcessMemoryInfo_t)(HANDLE, memcounters_t *, DWORD);
+	HINSTANCE kernel32Dll;
+	K32GetProcessMemoryInfo_t K32GetProcessMemoryInfo_f;
+	memcounters_t counters;
+	MEMORYSTATUSEX status;
+	BOOL hr;
+
+	kernel32Dll = LoadLibrary( "kernel32.dll" );
+
+	hr = FALSE;
+	K32GetProcessMemoryInfo_f = (void *)GetProcAddress( kernel32Dll, "K32GetProcessMemoryInfo" );
+	if( K32GetProcessMemoryInfo_f ) {
+		memset( &counters, 0, sizeof( counters ) );
+		counters.cb = sizeof( counters );
+		hr = K32GetProcessMemoryInfo_f( GetCurrentProcess(), &counters, sizeof( counters ) );
+	}
+
+	FreeLibrary( kernel32Dll );
+
+	if( !hr ) {
+		return false;
+	}
+
+	status.dwLength = sizeof( status );
+	if( !GlobalMemoryStatusEx( &status ) ) {
+		return false;
+	}
+
+	*resident = counters.WorkingSetSize;
+	*unique = min( counters.PagefileUsage, counters.WorkingSetSize );
+	*physical = ( size_t )status.ullTotalPhys;
+	return true;
+}
+
+/*
+* Sys_ForkInstance
+*/
+int Sys_ForkInstance( void )
+{
+	return -1;
+}
+
 /*
 * Sys_GetPreferredLanguage
 * Get the preferred language through the MUI API. Works on Vista and newer.
@@ -184,6 +184,17 @@ void Sys_Thread_Yield( void )
 	Sys_Sleep( 0 );
 }
 
+/*
+* Sys_Thread_NumProcessors
+*/
+int Sys_Thread_NumProcessors( void )
+{
+	SYSTEM_INFO info;
+
+	GetSystemInfo( &info );
+	return info.dwNumberOfProcessors > 0 ? (int)info.dwNumberOfProcessors : 1;
+}
+
 /*
 * Sys_Atomic_Add
 */